@@ -0,0 +1,181 @@
+#include "../../include/renderer.h"
+
+/*
+ * Compares starting up from an asset pack against loading the same sprites onto the heap.
+ * Heap loading reads every sprite file into malloc'd bitmaps, the pack is mapped and every sprite looked up by name.
+ * Reports the median startup time and the resident memory after startup and after drawing a few of the sprites,
+ * which only faults in the pages of those sprites when they come from the pack.
+ */
+
+#define RUNS 21
+#define SPRITES 200
+#define SPRITE_SIZE 256
+#define DRAWN 10
+#define PACK_PATH "bench/build/sprites.pak"
+#define SPRITE_DIR "bench/build/sprite_"
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Resident memory of the process in KB, 0 where it can't be read
+static long resident_kb(void)
+{
+#ifdef __linux__
+    long size = 0, resident = 0;
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file)
+    {
+        if (fscanf(file, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose(file);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
+
+static void sprite_path(char *path, size_t size, int sprite)
+{
+    snprintf(path, size, "%s%03d.raw", SPRITE_DIR, sprite);
+}
+
+// One file per sprite, a width, a height and the pixels, like a decoded image cache
+static int load_heap(Bitmap *bitmaps)
+{
+    for (int i = 0; i < SPRITES; i++)
+    {
+        char path[64];
+        int size[2];
+        sprite_path(path, sizeof(path), i);
+        FILE *file = fopen(path, "rb");
+        if (!file || fread(size, sizeof(int), 2, file) != 2)
+        {
+            if (file)
+                fclose(file);
+            return 1;
+        }
+        bitmaps[i] = (Bitmap){size[0], size[1], malloc((size_t)size[0] * size[1] * sizeof(uint32_t))};
+        size_t read = fread(bitmaps[i].bitmap_argb, sizeof(uint32_t), (size_t)size[0] * size[1], file);
+        fclose(file);
+        if (read != (size_t)size[0] * size[1])
+            return 1;
+    }
+    return 0;
+}
+
+static int load_pack(AssetPack *pack, char names[SPRITES][16], Bitmap *bitmaps)
+{
+    if (asset_pack_open(pack, PACK_PATH) != 0)
+        return 1;
+    for (int i = 0; i < SPRITES; i++)
+    {
+        int index = asset_pack_find(pack, names[i]);
+        if (index < 0)
+            return 1;
+        bitmaps[i] = asset_pack_bitmap(pack, index);
+    }
+    return 0;
+}
+
+static void draw_some(Framebuffer *fb, const Bitmap *bitmaps)
+{
+    for (int i = 0; i < DRAWN; i++)
+        enqueue_draw_job(fb, create_bitmap_draw_job(bitmaps[i * (SPRITES / DRAWN)], (i % 5) * 150, (i / 5) * 300));
+    process_queue_safe(fb);
+}
+
+int main(void)
+{
+    static char names[SPRITES][16];
+    const char *name_list[SPRITES];
+    static Bitmap bitmaps[SPRITES];
+    double heap_times[RUNS], pack_times[RUNS];
+    Framebuffer fb;
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+
+    // Write the same sprites as separate files and as a pack
+    srand(5);
+    for (int i = 0; i < SPRITES; i++)
+    {
+        char path[64];
+        int size[2] = {SPRITE_SIZE, SPRITE_SIZE};
+        bitmaps[i] = (Bitmap){SPRITE_SIZE, SPRITE_SIZE, malloc(SPRITE_SIZE * SPRITE_SIZE * sizeof(uint32_t))};
+        for (int p = 0; p < SPRITE_SIZE * SPRITE_SIZE; p++)
+            bitmaps[i].bitmap_argb[p] = 0xFF000000 | (uint32_t)rand();
+
+        snprintf(names[i], sizeof(names[i]), "sprite_%03d", i);
+        name_list[i] = names[i];
+        sprite_path(path, sizeof(path), i);
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return 1;
+        fwrite(size, sizeof(int), 2, file);
+        fwrite(bitmaps[i].bitmap_argb, sizeof(uint32_t), SPRITE_SIZE * SPRITE_SIZE, file);
+        fclose(file);
+    }
+    if (asset_pack_write(PACK_PATH, name_list, bitmaps, SPRITES) != 0)
+        return 1;
+    for (int i = 0; i < SPRITES; i++)
+        free(bitmaps[i].bitmap_argb);
+
+    // Memory is measured on the first run, before the allocator holds on to freed sprites
+    long base = resident_kb(), heap_started = 0, heap_drawn = 0, pack_started = 0, pack_drawn = 0;
+    for (int run = 0; run < RUNS; run++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (load_heap(bitmaps) != 0)
+            return 1;
+        heap_times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+        if (run == 0)
+        {
+            heap_started = resident_kb() - base;
+            draw_some(&fb, bitmaps);
+            heap_drawn = resident_kb() - base;
+        }
+        for (int i = 0; i < SPRITES; i++)
+            free(bitmaps[i].bitmap_argb);
+    }
+
+    base = resident_kb();
+    for (int run = 0; run < RUNS; run++)
+    {
+        AssetPack pack;
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (load_pack(&pack, names, bitmaps) != 0)
+            return 1;
+        pack_times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+        if (run == 0)
+        {
+            pack_started = resident_kb() - base;
+            draw_some(&fb, bitmaps);
+            pack_drawn = resident_kb() - base;
+        }
+        asset_pack_close(&pack);
+    }
+
+    qsort(heap_times, RUNS, sizeof(double), compare_doubles);
+    qsort(pack_times, RUNS, sizeof(double), compare_doubles);
+    printf("%d sprites of %dx%d, %.1f MB, %d of them drawn\n", SPRITES, SPRITE_SIZE, SPRITE_SIZE,
+           SPRITES * SPRITE_SIZE * SPRITE_SIZE * 4 / 1048576.0, DRAWN);
+    printf("  heap  startup %8.3f ms, resident %7.1f MB after startup, %7.1f MB after drawing\n", heap_times[RUNS / 2] * 1e3,
+           heap_started / 1024.0, heap_drawn / 1024.0);
+    printf("  pack  startup %8.3f ms, resident %7.1f MB after startup, %7.1f MB after drawing\n", pack_times[RUNS / 2] * 1e3,
+           pack_started / 1024.0, pack_drawn / 1024.0);
+    printf("  pack startup is %.0fx faster\n", heap_times[RUNS / 2] / pack_times[RUNS / 2]);
+
+    for (int i = 0; i < SPRITES; i++)
+    {
+        char path[64];
+        sprite_path(path, sizeof(path), i);
+        remove(path);
+    }
+    remove(PACK_PATH);
+    framebuffer_destroy(&fb);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "../../include/renderer.h"
+
+/*
+ * Throughput of a full screen bitmap drawn with every blend mode, at every instruction set the CPU supports.
+ * Reports the median of several runs in megapixels per second.
+ */
+
+#define RUNS 15
+
+static uint32_t source_pixels[WIDTH * HEIGHT];
+static uint32_t destination_pixels[WIDTH * HEIGHT];
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    const char *mode_names[] = {"opaque", "src-over", "add", "multiply"};
+    double times[RUNS];
+
+    for (int i = 0; i < WIDTH * HEIGHT; i++)
+    {
+        source_pixels[i] = color_premultiply((uint32_t)i * 2654435761u);
+        destination_pixels[i] = 0xFF000000 | (uint32_t)i * 40503u;
+    }
+
+    Bitmap bitmap = {WIDTH, HEIGHT, source_pixels};
+    DrawJob job = create_bitmap_draw_job(bitmap, 0, 0);
+
+    printf("%dx%d bitmap\n", WIDTH, HEIGHT);
+    for (int level = SIMD_SCALAR; level <= (int)simd_detect(); level++)
+    {
+        simd_select((SimdLevel)level);
+        for (int mode = BLEND_OPAQUE; mode <= BLEND_MULTIPLY; mode++)
+        {
+            job.blend = (BlendMode)mode;
+            for (int run = 0; run < RUNS; run++)
+            {
+                Uint64 start = SDL_GetPerformanceCounter();
+                for (int y = 0; y < HEIGHT; y++)
+                    drawjob_draw_span(&job, y, 0, WIDTH, destination_pixels + y * WIDTH);
+                times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+            }
+
+            qsort(times, RUNS, sizeof(double), compare_doubles);
+            printf("  level %d %-8s %8.1f Mpix/s\n", level, mode_names[mode], (double)WIDTH * HEIGHT / times[RUNS / 2] / 1e6);
+        }
+    }
+    simd_select(simd_detect());
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "../../include/renderer.h"
+
+/*
+ * Captures an animated full screen scene in every format, drawing frames as fast as possible.
+ * Reports the median time capture_frame takes on the render thread to queue a frame, how many frames per second are
+ * written, how many frames were dropped and the bytes per written frame.
+ */
+
+#define FRAMES 120
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void draw_scene(Framebuffer *fb, int frame)
+{
+    draw(fb, drawjob_linear_gradient((Recti){{0, 0}, {fb->width, fb->height}}, (Pointf){0, 0}, 0xFF101830,
+                                     (Pointf){0, fb->height}, 0xFF305070));
+    for (int i = 0; i < 16; i++)
+    {
+        double angle = frame * 0.02 + i * 0.4;
+        Pointf center = {fb->width / 2 + cos(angle) * (100 + i * 15), fb->height / 2 + sin(angle) * (80 + i * 10)};
+        enqueue_draw_job(fb, drawjob_circle(center, 10 + i, 0xFF000000 | (uint32_t)(i * 0x0F0B07)));
+    }
+    process_queue_safe(fb);
+}
+
+int main(void)
+{
+    const char *names[] = {"raw", "delta", "png"};
+    const char *paths[] = {"bench/build/capture.raw", "bench/build/capture.delta", "bench/build/capture_"};
+    double times[FRAMES];
+    Framebuffer fb;
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+
+    printf("%d frames of %dx%d, drawn as fast as possible\n", FRAMES, WIDTH, HEIGHT);
+    for (int format = CAPTURE_RAW; format <= CAPTURE_PNG; format++)
+    {
+        Capture capture;
+        CaptureStats stats;
+        if (capture_init(&capture, &(CaptureConfig){paths[format], (CaptureFormat)format, 0, 0}, WIDTH, HEIGHT) != 0)
+            return 1;
+
+        int queued = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int frame = 0; frame < FRAMES; frame++)
+        {
+            draw_scene(&fb, frame);
+            Uint64 before = SDL_GetPerformanceCounter();
+            if (capture_frame(&capture, &fb) == 0)
+                times[queued++] = (double)(SDL_GetPerformanceCounter() - before) / (double)SDL_GetPerformanceFrequency();
+        }
+        capture_shutdown(&capture, &stats);
+        double seconds = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+
+        qsort(times, queued, sizeof(double), compare_doubles);
+        printf("  %-5s capture_frame %7.1f us, %6.1f frames/s written, %3llu dropped, %8.1f KB per frame\n",
+               names[format], times[queued / 2] * 1e6, stats.written / seconds, (unsigned long long)stats.dropped,
+               stats.written ? stats.bytes / 1024.0 / stats.written : 0.0);
+    }
+
+    // PNG sequences are one file per frame, remove them again
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%s%06d.png", paths[CAPTURE_PNG], frame);
+        remove(name);
+    }
+    remove(paths[CAPTURE_RAW]);
+    remove(paths[CAPTURE_DELTA]);
+
+    framebuffer_destroy(&fb);
+    return 0;
+}
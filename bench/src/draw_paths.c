@@ -0,0 +1,370 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless benchmark of every draw path across job counts, job sizes, overlap and thread counts.
+ * Reports the median and 99th percentile time per pixel, writes all results as JSON and compares them
+ * against a saved baseline, failing if any scenario got slower than the tolerance.
+ *
+ *   draw_paths [--json FILE] [--baseline FILE] [--tolerance PERCENT] [--filter TEXT]
+ *
+ * Defaults write bench/build/draw_paths.json and compare against bench/baseline.json if it exists.
+ * `make bench-baseline` saves the last results as the baseline.
+ */
+
+#define MIN_RUNS 11
+#define MAX_RUNS 201
+#define SECONDS_PER_SCENARIO 0.2
+#define MAX_JOBS 1024
+#define MAX_PIXELS_PER_RUN (8 * WIDTH * HEIGHT)
+#define MAX_RESULTS 512
+
+typedef enum DrawPath
+{
+    PATH_DRAW,
+    PATH_DRAW_BOUNDED,
+    PATH_DRAW_MULTIPLE_BOUNDED,
+    PATH_DRAW_MULTIPLE_BOUNDED_SAFE,
+    PATH_PROCESS_QUEUE,
+    PATH_PROCESS_QUEUE_SAFE,
+    PATH_SAFE_DRAW_PIXEL,
+    PATH_UPDATE,
+    PATH_COUNT
+} DrawPath;
+
+static const char *path_names[PATH_COUNT] = {
+    "draw", "draw_bounded", "draw_multiple_bounded", "draw_multiple_bounded_safe",
+    "process_queue", "process_queue_safe", "safe_draw_pixel", "update"};
+
+/// @brief One measured configuration
+/// @param jobs Jobs drawn per run, pixels plotted for safe_draw_pixel and dirty areas uploaded for update
+/// @param size Side of the square jobs
+/// @param overlap Fraction of their side by which neighbouring jobs overlap
+typedef struct Scenario
+{
+    DrawPath path;
+    int jobs;
+    int size;
+    double overlap;
+    int threads;
+} Scenario;
+
+typedef struct Result
+{
+    char name[96];
+    Scenario scenario;
+    int64_t pixels;
+    int runs;
+    double median_ns_per_pixel;
+    double p99_ns_per_pixel;
+    double mpix_per_s;
+} Result;
+
+static DrawJob jobs[MAX_JOBS];
+static Pointi plots[WIDTH * HEIGHT / 4];
+static Result results[MAX_RESULTS];
+static int result_count;
+static int max_threads;
+
+static uint32_t xor_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (uint32_t)(x ^ y) * 0x010101u;
+}
+
+// Lays the jobs out left to right and top to bottom, wrapping around when the screen is full.
+// Returns the pixels they cover, counting overdraw
+static int64_t make_jobs(int count, int size, double overlap)
+{
+    int step = (int)(size * (1.0 - overlap) + 0.5);
+    if (step < 1)
+        step = 1;
+    int columns = size < WIDTH ? (WIDTH - size) / step + 1 : 1;
+    int rows = size < HEIGHT ? (HEIGHT - size) / step + 1 : 1;
+    int64_t pixels = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        int x = i % columns * step;
+        int y = i / columns % rows * step;
+        Recti area = {{x, y}, {x + size, y + size}};
+
+        // Half callbacks, half solid fills, so both the per pixel and the vector paths are measured
+        if (i % 2)
+            jobs[i] = drawjob_solid(area, 0xFF000000 | (uint32_t)i * 2654435761u);
+        else
+            jobs[i] = (DrawJob){.area = area, .callback = xor_callback};
+
+        Recti visible = recti_clamp(area, WIDTH, HEIGHT);
+        pixels += (int64_t)(visible.bottom_right.x - visible.top_left.x) * (visible.bottom_right.y - visible.top_left.y);
+    }
+    return pixels;
+}
+
+static void run_once(SDLContext *ctx, const Scenario *scenario)
+{
+    Framebuffer *fb = &ctx->framebuffer;
+
+    switch (scenario->path)
+    {
+    case PATH_DRAW:
+        draw(fb, jobs[0]);
+        break;
+    case PATH_DRAW_BOUNDED:
+        for (int j = 0; j < scenario->jobs; j++)
+            draw_bounded(fb, jobs[j]);
+        break;
+    case PATH_DRAW_MULTIPLE_BOUNDED:
+        draw_multiple_bounded(fb, jobs, scenario->jobs);
+        break;
+    case PATH_DRAW_MULTIPLE_BOUNDED_SAFE:
+        draw_multiple_bounded_safe(fb, jobs, scenario->jobs);
+        break;
+    case PATH_PROCESS_QUEUE:
+    case PATH_PROCESS_QUEUE_SAFE:
+        for (int j = 0; j < scenario->jobs; j++)
+            enqueue_draw_job(fb, jobs[j]);
+        if (scenario->path == PATH_PROCESS_QUEUE)
+            process_queue(fb);
+        else
+            process_queue_safe(fb);
+        break;
+    case PATH_SAFE_DRAW_PIXEL:
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < scenario->jobs; i++)
+            safe_draw_pixel(fb, plots[i].x, plots[i].y, 0xFF000000 | (uint32_t)i);
+        break;
+    case PATH_UPDATE:
+        update(ctx);
+        break;
+    default:
+        break;
+    }
+}
+
+// Untimed work before every run, so that each run does the same amount of work
+static void prepare_run(SDLContext *ctx, const Scenario *scenario)
+{
+    Framebuffer *fb = &ctx->framebuffer;
+
+    framebuffer_clear_dirty(fb);
+    if (scenario->path == PATH_UPDATE)
+        for (int j = 0; j < scenario->jobs; j++)
+            framebuffer_mark_dirty(fb, jobs[j].area);
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(SDLContext *ctx, Scenario scenario, const char *filter)
+{
+    Result *result = &results[result_count];
+    static double times[MAX_RUNS];
+
+    snprintf(result->name, sizeof(result->name), "%s/jobs=%d/size=%d/overlap=%.2f/threads=%d",
+             path_names[scenario.path], scenario.jobs, scenario.size, scenario.overlap, scenario.threads);
+    if ((filter && !strstr(result->name, filter)) || result_count == MAX_RESULTS)
+        return;
+
+    result->scenario = scenario;
+    if (scenario.path == PATH_SAFE_DRAW_PIXEL)
+        result->pixels = scenario.jobs;
+    else
+        result->pixels = make_jobs(scenario.jobs, scenario.size, scenario.overlap);
+    omp_set_num_threads(scenario.threads);
+
+    // The first run warms caches and grows the framebuffer's scratch buffers
+    prepare_run(ctx, &scenario);
+    run_once(ctx, &scenario);
+    if (scenario.path == PATH_UPDATE)
+        result->pixels = (int64_t)(ctx->upload_stats.bytes_last_frame / sizeof(uint32_t));
+
+    double elapsed = 0;
+    int runs = 0;
+    while (runs < MAX_RUNS && (runs < MIN_RUNS || elapsed < SECONDS_PER_SCENARIO))
+    {
+        prepare_run(ctx, &scenario);
+        Uint64 start = SDL_GetPerformanceCounter();
+        run_once(ctx, &scenario);
+        times[runs] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+        elapsed += times[runs++];
+    }
+
+    qsort(times, runs, sizeof(double), compare_doubles);
+    double pixels = result->pixels > 0 ? (double)result->pixels : 1.0;
+    result->runs = runs;
+    result->median_ns_per_pixel = times[runs / 2] * 1e9 / pixels;
+    result->p99_ns_per_pixel = times[(runs * 99 + 99) / 100 - 1] * 1e9 / pixels;
+    result->mpix_per_s = pixels / times[runs / 2] / 1e6;
+    result_count++;
+}
+
+static int write_json(const char *file_name)
+{
+    FILE *file = fopen(file_name, "w");
+    if (!file)
+        return 1;
+
+    fprintf(file, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"max_threads\": %d,\n  \"results\": [\n",
+            WIDTH, HEIGHT, max_threads);
+    for (int i = 0; i < result_count; i++)
+    {
+        const Result *r = &results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"path\": \"%s\", \"jobs\": %d, \"size\": %d, \"overlap\": %.2f, \"threads\": %d, "
+                "\"pixels\": %lld, \"runs\": %d, \"median_ns_per_pixel\": %.6f, \"p99_ns_per_pixel\": %.6f, \"mpix_per_s\": %.3f}%s\n",
+                r->name, path_names[r->scenario.path], r->scenario.jobs, r->scenario.size, r->scenario.overlap,
+                r->scenario.threads, (long long)r->pixels, r->runs, r->median_ns_per_pixel, r->p99_ns_per_pixel,
+                r->mpix_per_s, i + 1 < result_count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) != 0;
+}
+
+static char *read_file(const char *file_name)
+{
+    FILE *file = fopen(file_name, "rb");
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc((size_t)size + 1);
+    if (text)
+        text[fread(text, 1, (size_t)size, file)] = 0;
+    fclose(file);
+    return text;
+}
+
+// Finds the median time per pixel of a scenario in a file written by write_json
+static int baseline_median(const char *baseline, const char *name, double *median)
+{
+    char key[128];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+
+    const char *entry = strstr(baseline, key);
+    if (!entry)
+        return 1;
+    const char *value = strstr(entry, "\"median_ns_per_pixel\": ");
+    const char *next = strstr(entry + 1, "\"name\": ");
+    if (!value || (next && value > next))
+        return 1;
+    return sscanf(value + strlen("\"median_ns_per_pixel\": "), "%lf", median) != 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *json_file = "bench/build/draw_paths.json";
+    const char *baseline_file = "bench/baseline.json";
+    const char *filter = NULL;
+    double tolerance = 10.0;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--json"))
+            json_file = argv[i + 1];
+        else if (!strcmp(argv[i], "--baseline"))
+            baseline_file = argv[i + 1];
+        else if (!strcmp(argv[i], "--tolerance"))
+            tolerance = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--filter"))
+            filter = argv[i + 1];
+        else
+        {
+            printf("unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // update needs a renderer. The dummy driver has no window, and only a software renderer
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+    SDLContext ctx = {0};
+    int have_renderer = 0;
+    if (SDL_Init(SDL_INIT_VIDEO) == 0 &&
+        (ctx.window = SDL_CreateWindow("bench", 0, 0, WIDTH, HEIGHT, SDL_WINDOW_HIDDEN)))
+    {
+        ctx.renderer = SDL_CreateRenderer(ctx.window, -1, SDL_RENDERER_SOFTWARE);
+        if (ctx.renderer)
+            ctx.texture = SDL_CreateTexture(ctx.renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, WIDTH, HEIGHT);
+        have_renderer = ctx.texture != NULL;
+    }
+    if (framebuffer_init(&ctx.framebuffer, WIDTH, HEIGHT))
+        return 1;
+
+    srand(1);
+    for (int i = 0; i < WIDTH * HEIGHT / 4; i++)
+        plots[i] = (Pointi){rand() % WIDTH, rand() % HEIGHT};
+
+    max_threads = omp_get_max_threads();
+    int thread_counts[] = {1, max_threads};
+    int thread_variants = thread_counts[1] > 1 ? 2 : 1;
+    int counts[] = {4, 64, 1024};
+    int sizes[] = {16, 64, 256};
+    double overlaps[] = {0.0, 0.5, 0.9};
+
+    for (int t = 0; t < thread_variants; t++)
+    {
+        int threads = thread_counts[t];
+        measure(&ctx, (Scenario){PATH_DRAW, 1, WIDTH, 0, threads}, filter);
+
+        for (int path = PATH_DRAW_BOUNDED; path <= PATH_PROCESS_QUEUE_SAFE; path++)
+            for (int c = 0; c < 3; c++)
+                for (int s = 0; s < 3; s++)
+                    for (int o = 0; o < 3; o++)
+                        if ((int64_t)counts[c] * sizes[s] * sizes[s] <= MAX_PIXELS_PER_RUN)
+                            measure(&ctx, (Scenario){(DrawPath)path, counts[c], sizes[s], overlaps[o], threads}, filter);
+
+        measure(&ctx, (Scenario){PATH_SAFE_DRAW_PIXEL, WIDTH * HEIGHT / 4, 1, 0, threads}, filter);
+    }
+
+    if (have_renderer)
+    {
+        measure(&ctx, (Scenario){PATH_UPDATE, 1, WIDTH, 0, 1}, filter);
+        measure(&ctx, (Scenario){PATH_UPDATE, 64, 64, 0, 1}, filter);
+        measure(&ctx, (Scenario){PATH_UPDATE, 1024, 16, 0.5, 1}, filter);
+    }
+    else
+        printf("no renderer with the dummy video driver, update is not measured\n");
+
+    char *baseline = read_file(baseline_file);
+    int regressions = 0;
+
+    printf("%-62s %10s %10s %10s %9s\n", "scenario", "ns/pixel", "p99", "Mpix/s", "baseline");
+    for (int i = 0; i < result_count; i++)
+    {
+        const Result *r = &results[i];
+        printf("%-62s %10.4f %10.4f %10.1f", r->name, r->median_ns_per_pixel, r->p99_ns_per_pixel, r->mpix_per_s);
+
+        double before;
+        if (baseline && !baseline_median(baseline, r->name, &before) && before > 0)
+        {
+            double change = (r->median_ns_per_pixel / before - 1.0) * 100.0;
+            int regressed = change > tolerance;
+            regressions += regressed;
+            printf(" %+8.1f%%%s", change, regressed ? "  REGRESSION" : "");
+        }
+        printf("\n");
+    }
+
+    if (write_json(json_file))
+        printf("could not write %s\n", json_file);
+    else
+        printf("results written to %s\n", json_file);
+    if (baseline)
+        printf("%d of %d scenarios more than %.0f%% slower than %s\n", regressions, result_count, tolerance, baseline_file);
+    else
+        printf("no baseline at %s, save one with make bench-baseline\n", baseline_file);
+
+    free(baseline);
+    framebuffer_destroy(&ctx.framebuffer);
+    if (ctx.window)
+    {
+        destroy_sdl_renderer(&ctx);
+        SDL_DestroyWindow(ctx.window);
+    }
+    SDL_Quit();
+    return regressions != 0;
+}
@@ -0,0 +1,70 @@
+#include "../../include/renderer.h"
+
+/*
+ * Static UI frame: panels drawn by an expensive callback that don't change between frames, under a few moving sprites.
+ * Reports the median frame time with and without the job cache.
+ */
+
+#define RUNS 21
+#define PANELS 24
+
+static uint32_t plasma_callback(int x, int y, void *userdata)
+{
+    double phase = (double)(uintptr_t)userdata;
+    double v = sin(x * 0.031 + phase) + sin(y * 0.047) + sin((x + y) * 0.019);
+    uint32_t c = (uint32_t)((v + 3.0) * 42.0);
+    return 0xFF000000 | c << 16 | (255 - c) << 8 | c / 2;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    Framebuffer fb;
+    DrawJob jobs[PANELS + 8];
+    double times[RUNS];
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+
+    for (int i = 0; i < PANELS; i++)
+    {
+        int x = i % 6 * (WIDTH / 6), y = i / 6 * (HEIGHT / 4);
+        jobs[i] = (DrawJob){.area = {{x + 4, y + 4}, {x + WIDTH / 6 - 4, y + HEIGHT / 4 - 4}},
+                            .callback = plasma_callback,
+                            .userdata = (void *)(uintptr_t)i,
+                            .cacheable = 1};
+    }
+
+    printf("%d cached panels and 8 moving sprites, %d threads\n", PANELS, omp_get_max_threads());
+    for (int cached = 0; cached <= 1; cached++)
+    {
+        job_cache_set_budget(&fb.job_cache, cached ? JOB_CACHE_DEFAULT_BUDGET : 0);
+        fb.job_cache.stats = (JobCacheStats){0};
+        for (int run = 0; run < RUNS; run++)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                int x = (run * 37 + i * 150) % WIDTH, y = (run * 23 + i * 90) % HEIGHT;
+                jobs[PANELS + i] = drawjob_solid((Recti){{x, y}, {x + 64, y + 64}}, color_premultiply(0x80FFFFFF));
+                jobs[PANELS + i].blend = BLEND_SRC_OVER;
+            }
+
+            Uint64 start = SDL_GetPerformanceCounter();
+            draw_multiple_bounded_safe(&fb, jobs, PANELS + 8);
+            times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+        }
+
+        qsort(times, RUNS, sizeof(double), compare_doubles);
+        JobCacheStats *stats = &fb.job_cache.stats;
+        printf("  cache %-3s %8.3f ms, %llu hits, %llu misses\n", cached ? "on" : "off", times[RUNS / 2] * 1e3,
+               (unsigned long long)stats->hits, (unsigned long long)stats->misses);
+    }
+
+    framebuffer_destroy(&fb);
+    return 0;
+}
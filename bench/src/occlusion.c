@@ -0,0 +1,120 @@
+#include "../../include/renderer.h"
+
+/*
+ * Overdraw heavy frame: a full screen callback background, then opaque panels and sprites covering most of it,
+ * then a few translucent ones. Reports the median frame time with and without occlusion culling. With culling it also
+ * draws the callback panels as span callbacks with and without `opaque`, and the background with draw() before the batch.
+ */
+
+#define RUNS 21
+#define PANELS 400
+
+static uint32_t plasma_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    double v = sin(x * 0.031) + sin(y * 0.047) + sin((x + y) * 0.019);
+    uint32_t c = (uint32_t)((v + 3.0) * 42.0);
+    return 0xFF000000 | c << 16 | (255 - c) << 8 | c / 2;
+}
+
+static void plasma_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+        dst[x - x0] = plasma_callback(x, y, userdata);
+}
+
+/* How the frame is drawn. `panel` is the job drawn by the callback panels, with its area set per panel.
+ * `draw_first` draws the background with draw() instead of putting it in the batch */
+typedef struct Scenario
+{
+    const char *name;
+    int culling;
+    DrawJob panel;
+    int draw_first;
+} Scenario;
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    Framebuffer fb;
+    static DrawJob jobs[PANELS + 1];
+    double times[RUNS];
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+
+    srand(7);
+    jobs[0] = (DrawJob){.area = {{0, 0}, {WIDTH, HEIGHT}}, .callback = plasma_callback};
+    for (int i = 1; i <= PANELS; i++)
+    {
+        int x = rand() % WIDTH, y = rand() % HEIGHT;
+        Recti area = {{x - 60, y - 40}, {x + 60, y + 40}};
+        if (i % 10 == 0)
+        {
+            jobs[i] = drawjob_solid(area, color_premultiply(0x60FFFFFF));
+            jobs[i].blend = BLEND_SRC_OVER;
+        }
+        else if (i % 2)
+            jobs[i] = (DrawJob){.area = area, .callback = plasma_callback};
+        else
+            jobs[i] = drawjob_solid(area, 0xFF000000 | (uint32_t)rand());
+    }
+
+    DrawJob callback_panel = {.callback = plasma_callback};
+    Scenario scenarios[] = {
+        {"culling off", 0, callback_panel, 0},
+        {"culling on", 1, callback_panel, 0},
+        {"span panels", 1, {.span_callback = plasma_span}, 0},
+        {"opaque span panels", 1, {.span_callback = plasma_span, .opaque = 1}, 0},
+        {"background drawn first", 1, callback_panel, 1},
+    };
+
+    printf("%d jobs over a full screen background, %d threads\n", PANELS, omp_get_max_threads());
+    for (int s = 0; s < (int)(sizeof(scenarios) / sizeof(scenarios[0])); s++)
+    {
+        Scenario *scenario = &scenarios[s];
+        fb.occlusion_culling = scenario->culling;
+        fb.occlusion_stats = (OcclusionStats){0};
+        for (int i = 1; i <= PANELS; i++)
+        {
+            if (jobs[i].callback || jobs[i].span_callback)
+            {
+                Recti area = jobs[i].area;
+                jobs[i] = scenario->panel;
+                jobs[i].area = area;
+            }
+        }
+
+        for (int run = 0; run < RUNS; run++)
+        {
+            Uint64 start = SDL_GetPerformanceCounter();
+            if (scenario->draw_first)
+            {
+                draw(&fb, jobs[0]);
+                draw_multiple_bounded_safe(&fb, jobs + 1, PANELS);
+            }
+            else
+                draw_multiple_bounded_safe(&fb, jobs, PANELS + 1);
+            times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+        }
+
+        qsort(times, RUNS, sizeof(double), compare_doubles);
+        printf("  %-24s %8.3f ms", scenario->name, times[RUNS / 2] * 1e3);
+        if (scenario->culling)
+        {
+            OcclusionStats *stats = &fb.occlusion_stats;
+            printf(", %.1f%% of job pixels culled, %.1f%% of job tiles skipped",
+                   100.0 * stats->pixels_culled / (double)(stats->pixels_culled + stats->pixels_drawn),
+                   100.0 * stats->job_tiles_culled / (double)stats->job_tiles);
+        }
+        printf("\n");
+    }
+
+    framebuffer_destroy(&fb);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "../../include/renderer.h"
+
+/*
+ * Full screen fills of a 1920x1080 framebuffer in every pixel format: a solid clear, a gradient and a tiled sprite.
+ * Reports the median time per fill, the framebuffer bytes written per second and the time converting the whole frame
+ * to ARGB takes, which update does once per frame for RGB332.
+ */
+
+#define RUNS 21
+#define FB_WIDTH 1920
+#define FB_HEIGHT 1080
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t tile[64 * 64];
+
+static void tiled_sprite(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    (void)userdata;
+    for (int x = x0; x < x1; x++)
+        *dst++ = tile[(y & 63) * 64 + (x & 63)];
+}
+
+static double median_seconds(Framebuffer *fb, DrawJob job, uint32_t *argb)
+{
+    double times[RUNS];
+    for (int run = 0; run < RUNS; run++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (argb)
+            framebuffer_read_argb(fb, (Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, argb, FB_WIDTH);
+        else
+            draw(fb, job);
+        times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    }
+    qsort(times, RUNS, sizeof(double), compare_doubles);
+    return times[RUNS / 2];
+}
+
+int main(void)
+{
+    const char *format_names[] = {"argb8888", "rgb565", "rgb332"};
+    const char *fill_names[] = {"solid", "gradient", "sprite"};
+    Recti screen = {{0, 0}, {FB_WIDTH, FB_HEIGHT}};
+    DrawJob fills[3] = {
+        drawjob_solid(screen, 0xFF336699),
+        drawjob_linear_gradient(screen, (Pointf){0, 0}, 0xFF000000, (Pointf){FB_WIDTH, FB_HEIGHT}, 0xFFFFFFFF),
+        {.area = screen, .span_callback = tiled_sprite},
+    };
+    uint32_t *argb = malloc((size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+    if (!argb)
+        return 1;
+    for (int i = 0; i < 64 * 64; i++)
+        tile[i] = 0xFF000000 | (uint32_t)i * 2654435761u;
+
+    printf("%dx%d, %d threads, median of %d runs\n", FB_WIDTH, FB_HEIGHT, omp_get_max_threads(), RUNS);
+    for (int format = PIXEL_FORMAT_ARGB8888; format <= PIXEL_FORMAT_RGB332; format++)
+    {
+        Framebuffer fb;
+        if (framebuffer_init_format(&fb, FB_WIDTH, FB_HEIGHT, (PixelFormat)format) != 0)
+            return 1;
+
+        double frame_bytes = (double)FB_WIDTH * FB_HEIGHT * pixel_format_bytes((PixelFormat)format);
+        printf("  %-8s %5.2f MB per frame\n", format_names[format], frame_bytes / 1048576.0);
+        for (int f = 0; f < 3; f++)
+        {
+            double seconds = median_seconds(&fb, fills[f], NULL);
+            printf("    %-8s %7.3f ms, %6.2f GB/s written\n", fill_names[f], seconds * 1e3, frame_bytes / seconds / 1e9);
+        }
+        printf("    to argb  %7.3f ms\n", median_seconds(&fb, fills[0], argb) * 1e3);
+        framebuffer_destroy(&fb);
+    }
+
+    free(argb);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "../../include/renderer.h"
+
+/*
+ * Scattered pixel plotting from 1 up to all threads: the mutex safe_draw_pixel used to take, the atomic safe_draw_pixel,
+ * safe_plot_pixel blending, and plot_pixels batches. Reports the median of several runs in megapixels per second.
+ */
+
+#define RUNS 11
+#define POINTS (1 << 20)
+
+static PlotPoint points[POINTS];
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// What safe_draw_pixel did before it became lock free
+static void mutex_draw_pixel(Framebuffer *fb, SDL_mutex *mutex, int x, int y, uint32_t color)
+{
+    if ((unsigned)x >= (unsigned)fb->width || (unsigned)y >= (unsigned)fb->height)
+        return;
+
+    SDL_LockMutex(mutex);
+    *framebuffer_pixel(fb, x, y) = color;
+    SDL_UnlockMutex(mutex);
+    framebuffer_mark_pixel_dirty(fb, x, y);
+}
+
+int main(void)
+{
+    const char *method_names[] = {"mutex", "safe_draw_pixel", "safe_plot_pixel add", "plot_pixels add"};
+    double times[RUNS];
+    Framebuffer fb;
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+    SDL_mutex *mutex = SDL_CreateMutex();
+
+    srand(5);
+    for (int i = 0; i < POINTS; i++)
+        points[i] = (PlotPoint){rand() % WIDTH, rand() % HEIGHT, 0x01010101u * (uint32_t)(rand() % 4)};
+
+    // Powers of two up to all threads
+    int thread_counts[16];
+    int variants = 0;
+    for (int threads = 1; threads < omp_get_max_threads() && variants < 15; threads *= 2)
+        thread_counts[variants++] = threads;
+    thread_counts[variants++] = omp_get_max_threads();
+
+    printf("%d scattered points\n", POINTS);
+    for (int method = 0; method < 4; method++)
+    {
+        for (int v = 0; v < variants; v++)
+        {
+            int threads = thread_counts[v];
+            omp_set_num_threads(threads);
+            for (int run = 0; run < RUNS; run++)
+            {
+                Uint64 start = SDL_GetPerformanceCounter();
+                switch (method)
+                {
+                case 0:
+#pragma omp parallel for schedule(static)
+                    for (int i = 0; i < POINTS; i++)
+                        mutex_draw_pixel(&fb, mutex, points[i].x, points[i].y, points[i].color);
+                    break;
+                case 1:
+#pragma omp parallel for schedule(static)
+                    for (int i = 0; i < POINTS; i++)
+                        safe_draw_pixel(&fb, points[i].x, points[i].y, points[i].color);
+                    break;
+                case 2:
+#pragma omp parallel for schedule(static)
+                    for (int i = 0; i < POINTS; i++)
+                        safe_plot_pixel(&fb, points[i].x, points[i].y, points[i].color, PLOT_ADD);
+                    break;
+                default:
+                    plot_pixels(&fb, points, POINTS, PLOT_ADD);
+                    break;
+                }
+                times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+            }
+
+            qsort(times, RUNS, sizeof(double), compare_doubles);
+            printf("  %-20s %3d threads %8.1f Mpix/s\n", method_names[method], threads, POINTS / times[RUNS / 2] / 1e6);
+        }
+    }
+
+    SDL_DestroyMutex(mutex);
+    framebuffer_destroy(&fb);
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "../../include/renderer.h"
+
+/*
+ * Thousands of small shaded triangles drawn through the queue: as per pixel callbacks over the bounding box, returning
+ * transparent outside the triangle and blended over the framebuffer, as span callbacks testing every pixel of the
+ * bounding box, and as native triangle jobs. The same jobs with their third vertex moved onto the first draw nothing,
+ * which gives the cost of queueing and scheduling them. Also times native lines and circles. Reports the median frame time of each.
+ */
+
+#define RUNS 21
+#define TRIANGLES 20000
+#define SHAPES 5000
+
+typedef struct CallbackTriangle
+{
+    Pointf v[3];
+    uint32_t colors[3];
+} CallbackTriangle;
+
+static CallbackTriangle triangles[TRIANGLES];
+static DrawJob jobs[TRIANGLES];
+
+/* What drawing a triangle takes without native support: barycentric coordinates of every pixel of the bounding box.
+ * Gives 0, transparent, outside the triangle */
+static uint32_t triangle_pixel(int x, int y, void *userdata)
+{
+    const CallbackTriangle *t = userdata;
+    double area = (t->v[1].x - t->v[0].x) * (t->v[2].y - t->v[0].y) - (t->v[2].x - t->v[0].x) * (t->v[1].y - t->v[0].y);
+    double px = x + 0.5, py = y + 0.5;
+    double w0 = ((t->v[1].x - px) * (t->v[2].y - py) - (t->v[2].x - px) * (t->v[1].y - py)) / area;
+    double w1 = ((t->v[2].x - px) * (t->v[0].y - py) - (t->v[0].x - px) * (t->v[2].y - py)) / area;
+    double w2 = 1 - w0 - w1;
+    if (area == 0 || w0 < 0 || w1 < 0 || w2 < 0)
+        return 0;
+
+    uint32_t color = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        double channel = w0 * (t->colors[0] >> shift & 0xFF) + w1 * (t->colors[1] >> shift & 0xFF) +
+                         w2 * (t->colors[2] >> shift & 0xFF);
+        color |= (uint32_t)(channel + 0.5) << shift;
+    }
+    return color;
+}
+
+/* The same as a span callback, which can leave the pixels outside unwritten and skip blending */
+static void triangle_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+    {
+        uint32_t color = triangle_pixel(x, y, userdata);
+        if (color)
+            dst[x - x0] = color;
+    }
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double time_jobs(Framebuffer *fb, int count)
+{
+    double times[RUNS];
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < count; i++)
+            enqueue_draw_job(fb, jobs[i]);
+        process_queue_safe(fb);
+        times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    }
+
+    qsort(times, RUNS, sizeof(double), compare_doubles);
+    return times[RUNS / 2] * 1e3;
+}
+
+int main(void)
+{
+    Framebuffer fb;
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+
+    srand(11);
+    for (int i = 0; i < TRIANGLES; i++)
+    {
+        double x = rand() % WIDTH, y = rand() % HEIGHT;
+        CallbackTriangle *t = &triangles[i];
+        for (int v = 0; v < 3; v++)
+        {
+            t->v[v] = (Pointf){x + rand() % 1600 / 100.0, y + rand() % 1600 / 100.0};
+            t->colors[v] = 0xFF000000 | (uint32_t)rand();
+        }
+    }
+
+    printf("%d triangles up to 16 pixels across, %d threads\n", TRIANGLES, omp_get_max_threads());
+
+    for (int i = 0; i < TRIANGLES; i++)
+    {
+        CallbackTriangle *t = &triangles[i];
+        Rectf bounds = {
+            {fmin(t->v[0].x, fmin(t->v[1].x, t->v[2].x)), fmin(t->v[0].y, fmin(t->v[1].y, t->v[2].y))},
+            {ceil(fmax(t->v[0].x, fmax(t->v[1].x, t->v[2].x))), ceil(fmax(t->v[0].y, fmax(t->v[1].y, t->v[2].y)))}};
+        jobs[i] = (DrawJob){.area = Rectf_to_i(bounds), .callback = triangle_pixel, .userdata = t, .blend = BLEND_SRC_OVER};
+    }
+    double callback_ms = time_jobs(&fb, TRIANGLES);
+    printf("  blended callback over bounding box %8.3f ms\n", callback_ms);
+
+    for (int i = 0; i < TRIANGLES; i++)
+    {
+        jobs[i].callback = NULL;
+        jobs[i].span_callback = triangle_span;
+        jobs[i].blend = BLEND_OPAQUE;
+    }
+    double span_ms = time_jobs(&fb, TRIANGLES);
+    printf("  span callback over bounding box    %8.3f ms\n", span_ms);
+
+    for (int i = 0; i < TRIANGLES; i++)
+    {
+        CallbackTriangle *t = &triangles[i];
+        jobs[i] = drawjob_shaded_triangle(t->v[0], t->colors[0], t->v[1], t->colors[1], t->v[2], t->colors[2]);
+    }
+    double shaded_ms = time_jobs(&fb, TRIANGLES);
+    printf("  shaded triangle jobs               %8.3f ms, %.1fx faster than callbacks, %.1fx than span callbacks\n",
+           shaded_ms, callback_ms / shaded_ms, span_ms / shaded_ms);
+
+    for (int i = 0; i < TRIANGLES; i++)
+        jobs[i] = drawjob_triangle(triangles[i].v[0], triangles[i].v[1], triangles[i].v[2], triangles[i].colors[0]);
+    double solid_ms = time_jobs(&fb, TRIANGLES);
+    printf("  solid triangle jobs                %8.3f ms, %.1fx faster than callbacks, %.1fx than span callbacks\n", solid_ms,
+           callback_ms / solid_ms, span_ms / solid_ms);
+
+    // Flat triangles with the same bounding boxes: everything but binning and drawing
+    for (int i = 0; i < TRIANGLES; i++)
+    {
+        jobs[i].params.triangle.x[2] = jobs[i].params.triangle.x[0];
+        jobs[i].params.triangle.y[2] = jobs[i].params.triangle.y[0];
+    }
+    printf("  queueing the same jobs, drawn empty %7.3f ms\n", time_jobs(&fb, TRIANGLES));
+
+    for (int i = 0; i < SHAPES; i++)
+    {
+        Pointf from = {rand() % WIDTH, rand() % HEIGHT};
+        Pointf to = {from.x + rand() % 200 - 100, from.y + rand() % 200 - 100};
+        jobs[i] = drawjob_line(from, 0xFFFFFFFF, to, color_premultiply(0x80FF8000), 1 + rand() % 4);
+    }
+    printf("%d anti-aliased lines up to 100 pixels long %8.3f ms\n", SHAPES, time_jobs(&fb, SHAPES));
+
+    for (int i = 0; i < SHAPES; i++)
+        jobs[i] = drawjob_circle((Pointf){rand() % WIDTH, rand() % HEIGHT}, 2 + rand() % 20, 0xFF000000 | (uint32_t)rand());
+    printf("%d anti-aliased circles up to 22 pixels across %8.3f ms\n", SHAPES, time_jobs(&fb, SHAPES));
+
+    framebuffer_destroy(&fb);
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../../include/renderer.h"
+
+/*
+ * Throughput of scale_bitmap_into for every mode, and of bitmap blits against a per pixel callback.
+ * Reports the median of several runs in megapixels written per second.
+ */
+
+#define RUNS 15
+#define SOURCE_SIZE 512
+
+static uint32_t source_pixels[SOURCE_SIZE * SOURCE_SIZE];
+static uint32_t destination_pixels[2048 * 2048];
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double seconds_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+static double median(double *values, int count)
+{
+    qsort(values, count, sizeof(double), compare_doubles);
+    return values[count / 2];
+}
+
+static uint32_t bitmap_callback(int x, int y, void *userdata)
+{
+    return source_pixels[y * SOURCE_SIZE + x] + (userdata != NULL);
+}
+
+int main(void)
+{
+    const char *mode_names[] = {"nearest", "bilinear", "box"};
+    int sizes[] = {2048, 1024, 256, 100};
+    double times[RUNS];
+
+    for (int i = 0; i < SOURCE_SIZE * SOURCE_SIZE; i++)
+        source_pixels[i] = (uint32_t)i * 2654435761u;
+    Bitmap source = {SOURCE_SIZE, SOURCE_SIZE, source_pixels};
+
+    printf("scale %dx%d, %d threads\n", SOURCE_SIZE, SOURCE_SIZE, omp_get_max_threads());
+    for (int mode = SCALE_NEAREST; mode <= SCALE_BOX; mode++)
+    {
+        for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++)
+        {
+            Bitmap destination = {sizes[s], sizes[s], destination_pixels};
+            for (int run = 0; run < RUNS; run++)
+            {
+                Uint64 start = SDL_GetPerformanceCounter();
+                scale_bitmap_into(source, destination, (ScaleMode)mode);
+                times[run] = seconds_since(start);
+            }
+
+            double pixels = (double)sizes[s] * sizes[s];
+            printf("  %-8s -> %4dx%-4d %8.1f Mpix/s\n", mode_names[mode], sizes[s], sizes[s], pixels / median(times, RUNS) / 1e6);
+        }
+    }
+
+    /* Blits: one span per row through the bitmap kind against the per pixel callback path */
+    DrawJob blit = create_bitmap_draw_job(source, 0, 0);
+    DrawJob callback = {.area = blit.area, .callback = bitmap_callback};
+    DrawJob *jobs[] = {&blit, &callback};
+    const char *blit_names[] = {"bitmap", "callback"};
+
+    printf("blit %dx%d\n", SOURCE_SIZE, SOURCE_SIZE);
+    for (int j = 0; j < 2; j++)
+    {
+        for (int run = 0; run < RUNS; run++)
+        {
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int y = 0; y < SOURCE_SIZE; y++)
+                drawjob_draw_span(jobs[j], y, 0, SOURCE_SIZE, destination_pixels + y * SOURCE_SIZE);
+            times[run] = seconds_since(start);
+        }
+        printf("  %-8s %8.1f Mpix/s\n", blit_names[j], (double)SOURCE_SIZE * SOURCE_SIZE / median(times, RUNS) / 1e6);
+    }
+    return 0;
+}
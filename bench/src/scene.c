@@ -0,0 +1,96 @@
+#include "../../include/renderer.h"
+
+/*
+ * Scenes of small sprites over a background where a few sprites move every frame. Compares rebuilding the whole job list
+ * with enqueue_draw_job and process_queue_safe every frame against a retained Scene redrawing what changed.
+ * Reports the median time per frame and the pixels the scene redrew.
+ */
+
+#define RUNS 21
+#define SPRITE 16
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t sprite[SPRITE * SPRITE];
+
+static Pointi random_position(void)
+{
+    return (Pointi){rand() % (WIDTH - SPRITE), rand() % (HEIGHT - SPRITE)};
+}
+
+int main(void)
+{
+    const int node_counts[] = {1000, 10000, 100000};
+    const int moving_counts[] = {1, 10};
+    Framebuffer fb;
+
+    if (framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+    for (int i = 0; i < SPRITE * SPRITE; i++)
+        sprite[i] = 0xFF000000 | (uint32_t)i * 2654435761u;
+
+    printf("%dx%d, %dx%d sprites, median of %d frames\n", WIDTH, HEIGHT, SPRITE, SPRITE, RUNS);
+    for (int n = 0; n < 3; n++)
+    {
+        int count = node_counts[n];
+        Pointi *positions = malloc(count * sizeof(Pointi));
+        SceneHandle *handles = malloc(count * sizeof(SceneHandle));
+        Scene scene;
+        if (!positions || !handles || scene_init(&scene, WIDTH, HEIGHT, 0xFF000000))
+            return 1;
+
+        srand(7);
+        for (int i = 0; i < count; i++)
+        {
+            positions[i] = random_position();
+            handles[i] = scene_add(&scene, create_bitmap_draw_job((Bitmap){SPRITE, SPRITE, sprite}, 0, 0), i % 4);
+            scene_move(&scene, handles[i], positions[i]);
+        }
+        scene_render(&scene, &fb);
+
+        for (int m = 0; m < 2; m++)
+        {
+            double rebuild[RUNS], retained[RUNS];
+            long long pixels = 0;
+            for (int run = 0; run < RUNS; run++)
+            {
+                for (int i = 0; i < moving_counts[m]; i++)
+                {
+                    int moved = rand() % count;
+                    positions[moved] = random_position();
+                    scene_move(&scene, handles[moved], positions[moved]);
+                }
+
+                Uint64 start = SDL_GetPerformanceCounter();
+                scene_render(&scene, &fb);
+                retained[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+                pixels += scene.stats.damage_pixels;
+
+                // The same frame rebuilt from scratch, ignoring z-order, which only makes it cheaper
+                start = SDL_GetPerformanceCounter();
+                enqueue_draw_job(&fb, drawjob_solid((Recti){{0, 0}, {WIDTH, HEIGHT}}, 0xFF000000));
+                for (int i = 0; i < count; i++)
+                    enqueue_draw_job(&fb, create_bitmap_draw_job((Bitmap){SPRITE, SPRITE, sprite}, positions[i].x, positions[i].y));
+                process_queue_safe(&fb);
+                rebuild[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+            }
+
+            qsort(rebuild, RUNS, sizeof(double), compare_doubles);
+            qsort(retained, RUNS, sizeof(double), compare_doubles);
+            printf("  %6d nodes, %2d moving: rebuild %8.3f ms, scene %8.3f ms (%5.0fx), %7lld pixels redrawn\n", count,
+                   moving_counts[m], rebuild[RUNS / 2] * 1e3, retained[RUNS / 2] * 1e3, rebuild[RUNS / 2] / retained[RUNS / 2],
+                   pixels / RUNS);
+        }
+
+        scene_free(&scene);
+        free(positions);
+        free(handles);
+    }
+
+    framebuffer_destroy(&fb);
+    return 0;
+}
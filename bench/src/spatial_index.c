@@ -0,0 +1,97 @@
+#include "../../include/renderer.h"
+
+/*
+ * Small jobs scattered over the screen at several job counts. Reports the median time to build the spatial index,
+ * and the mean time of a hit test at a random pixel and of an overlap query over a random 64x64 area with the jobs it finds,
+ * against a linear scan of the jobs for the same hit tests.
+ */
+
+#define RUNS 21
+#define QUERIES 100000
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double seconds_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+int main(void)
+{
+    const int job_counts[] = {1000, 10000, 100000};
+    static Pointi points[QUERIES];
+    static int found[1 << 16];
+
+    srand(5);
+    for (int q = 0; q < QUERIES; q++)
+        points[q] = (Pointi){rand() % WIDTH, rand() % HEIGHT};
+
+    printf("%dx%d, %d px cells, jobs of 8 to 48 px\n", WIDTH, HEIGHT, SPATIAL_INDEX_CELL_SIZE);
+    for (int n = 0; n < 3; n++)
+    {
+        int count = job_counts[n];
+        DrawJob *jobs = malloc(count * sizeof(DrawJob));
+        SpatialIndex index = {0};
+        double build[RUNS];
+        if (!jobs)
+            return 1;
+
+        for (int j = 0; j < count; j++)
+        {
+            int x = rand() % WIDTH - 8, y = rand() % HEIGHT - 8;
+            jobs[j] = drawjob_solid((Recti){{x, y}, {x + 8 + rand() % 41, y + 8 + rand() % 41}}, 0xFF000000 | (uint32_t)rand());
+        }
+
+        for (int run = 0; run < RUNS; run++)
+        {
+            Uint64 start = SDL_GetPerformanceCounter();
+            if (spatial_index_build(&index, jobs, count, WIDTH, HEIGHT) != 0)
+                return 1;
+            build[run] = seconds_since(start);
+        }
+        qsort(build, RUNS, sizeof(double), compare_doubles);
+
+        // Checksums keep the loops from being optimized away
+        long long checksum = 0;
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < QUERIES; q++)
+            checksum += spatial_index_hit(&index, points[q]);
+        double hit = seconds_since(start) / QUERIES;
+
+        long long results = 0;
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < QUERIES; q++)
+        {
+            Pointi p = points[q];
+            results += spatial_index_query(&index, (Recti){p, {p.x + 64, p.y + 64}}, found, 1 << 16);
+        }
+        double query = seconds_since(start) / QUERIES;
+
+        int scans = QUERIES / 100;
+        start = SDL_GetPerformanceCounter();
+        for (int q = 0; q < scans; q++)
+        {
+            int top = -1;
+            for (int j = count - 1; j >= 0 && top < 0; j--)
+            {
+                Recti area = jobs[j].area;
+                if (points[q].x >= area.top_left.x && points[q].x < area.bottom_right.x && points[q].y >= area.top_left.y &&
+                    points[q].y < area.bottom_right.y)
+                    top = j;
+            }
+            checksum -= top;
+        }
+        double scan = seconds_since(start) / scans;
+
+        printf("  %6d jobs: build %7.3f ms, hit %6.0f ns (linear scan %8.0f ns), 64x64 query %7.0f ns for %4lld jobs  [%lld]\n",
+               count, build[RUNS / 2] * 1e3, hit * 1e9, scan * 1e9, query * 1e9, results / QUERIES, checksum);
+
+        spatial_index_free(&index);
+        free(jobs);
+    }
+    return 0;
+}
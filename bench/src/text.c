@@ -0,0 +1,64 @@
+#include "../../include/renderer.h"
+
+/*
+ * Debug overlay load: 2000 labels per frame, of which a few change every frame.
+ * Reports the median time to look up and enqueue the labels, and to draw them.
+ */
+
+#define FRAMES 61
+#define LABELS 2000
+#define CHANGING_LABELS 50
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double seconds_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+int main(void)
+{
+    Framebuffer framebuffer;
+    Font font;
+    TextCache cache;
+    static double layout_times[FRAMES], draw_times[FRAMES];
+    char label[64];
+
+    if (framebuffer_init(&framebuffer, WIDTH, HEIGHT) || font_init_builtin(&font) || text_cache_init(&cache))
+        return 1;
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < LABELS; i++)
+        {
+            int value = i < CHANGING_LABELS ? frame * 7 + i : i * 13;
+            snprintf(label, sizeof(label), "node %d: %d", i, value);
+            DrawJob job = text_draw_job(&cache, &font, label, (i % 10) * 100, (i / 10) * 3 % HEIGHT, 0xFFFFFFFF);
+            enqueue_draw_job(&framebuffer, job);
+        }
+        layout_times[frame] = seconds_since(start);
+
+        start = SDL_GetPerformanceCounter();
+        process_queue_safe(&framebuffer);
+        text_cache_end_frame(&cache);
+        draw_times[frame] = seconds_since(start);
+        framebuffer_clear_dirty(&framebuffer);
+    }
+
+    qsort(layout_times, FRAMES, sizeof(double), compare_doubles);
+    qsort(draw_times, FRAMES, sizeof(double), compare_doubles);
+    printf("%d labels, %d changing per frame, %d threads\n", LABELS, CHANGING_LABELS, omp_get_max_threads());
+    printf("  layout and enqueue %8.3f ms\n", layout_times[FRAMES / 2] * 1e3);
+    printf("  draw               %8.3f ms\n", draw_times[FRAMES / 2] * 1e3);
+    printf("  cache hits %llu, misses %llu\n", (unsigned long long)cache.stats.hits, (unsigned long long)cache.stats.misses);
+
+    text_cache_free(&cache);
+    font_free(&font);
+    framebuffer_destroy(&framebuffer);
+    return 0;
+}
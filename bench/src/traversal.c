@@ -0,0 +1,126 @@
+#include "../../include/renderer.h"
+
+/*
+ * Full screen draw with a cheap callback, a noise field whose cost grows towards the bottom of the screen, and a
+ * texture read across its rows, in every traversal order and schedule. Also times the old per pixel loop over the
+ * screen with collapse(2), default static scheduling and bounds checked draw_pixel. Reports the median frame time of each.
+ */
+
+#define RUNS 21
+#define TEXTURE_SIZE 2048
+
+static uint32_t *texture;
+
+static uint32_t cheap_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (uint32_t)(x ^ y) * 0x010101u;
+}
+
+static uint32_t lattice(int x, int y)
+{
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return h ^ (h >> 16);
+}
+
+// Value noise with more octaves further down, so rows cost very different amounts
+static uint32_t noise_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    int octaves = 1 + y * 8 / HEIGHT;
+    double value = 0, amplitude = 0.5;
+    for (int o = 0; o < octaves; o++)
+    {
+        double fx = x / (64.0 / (1 << o)), fy = y / (64.0 / (1 << o));
+        int ix = (int)fx, iy = (int)fy;
+        double tx = fx - ix, ty = fy - iy;
+        double top = (lattice(ix, iy) & 0xFF) * (1 - tx) + (lattice(ix + 1, iy) & 0xFF) * tx;
+        double bottom = (lattice(ix, iy + 1) & 0xFF) * (1 - tx) + (lattice(ix + 1, iy + 1) & 0xFF) * tx;
+        value += amplitude * (top * (1 - ty) + bottom * ty);
+        amplitude *= 0.5;
+    }
+    return 0xFF000000 | (uint32_t)value * 0x010101u;
+}
+
+// Reads the texture transposed, so walking a row of the screen walks a column of the texture
+static uint32_t texture_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return texture[(size_t)(x * 2) * TEXTURE_SIZE + y * 2];
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double time_draw(Framebuffer *fb, uint32_t (*callback)(int, int, void *), int per_pixel)
+{
+    double times[RUNS];
+    DrawJob job = {.callback = callback};
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (per_pixel)
+        {
+#pragma omp parallel for collapse(2)
+            for (int y = 0; y < fb->height; y++)
+                for (int x = 0; x < fb->width; x++)
+                    draw_pixel(fb, x, y, callback(x, y, NULL));
+        }
+        else
+            draw(fb, job);
+        times[run] = (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    }
+
+    qsort(times, RUNS, sizeof(double), compare_doubles);
+    return times[RUNS / 2] * 1e3;
+}
+
+int main(void)
+{
+    uint32_t (*callbacks[])(int, int, void *) = {cheap_callback, noise_callback, texture_callback};
+    const char *order_names[] = {"rows", "tiles", "morton"};
+    const char *schedule_names[] = {"dynamic", "guided", "static"};
+    Framebuffer fb;
+
+    texture = malloc((size_t)TEXTURE_SIZE * TEXTURE_SIZE * sizeof(uint32_t));
+    if (!texture || framebuffer_init(&fb, WIDTH, HEIGHT))
+        return 1;
+    for (size_t i = 0; i < (size_t)TEXTURE_SIZE * TEXTURE_SIZE; i++)
+        texture[i] = 0xFF000000 | (uint32_t)i * 2654435761u;
+
+    printf("%dx%d, %d threads, median ms            cheap    noise  texture\n", WIDTH, HEIGHT, omp_get_max_threads());
+
+    printf("  per pixel collapse(2) static    ");
+    for (int c = 0; c < 3; c++)
+        printf(" %8.3f", time_draw(&fb, callbacks[c], 1));
+    printf("\n");
+
+    for (int order = TRAVERSAL_ROWS; order <= TRAVERSAL_MORTON; order++)
+        for (int schedule = TRAVERSAL_DYNAMIC; schedule <= TRAVERSAL_STATIC; schedule++)
+        {
+            fb.traversal = (Traversal){(TraversalOrder)order, (TraversalSchedule)schedule, 0};
+            printf("  %-7s %-7s                 ", order_names[order], schedule_names[schedule]);
+            for (int c = 0; c < 3; c++)
+                printf(" %8.3f", time_draw(&fb, callbacks[c], 0));
+            printf("\n");
+        }
+
+    // Square blocks of several sizes, with the texture read the block size matters most
+    for (int size = 8; size <= 128; size *= 2)
+    {
+        fb.traversal = (Traversal){TRAVERSAL_MORTON, TRAVERSAL_DYNAMIC, size};
+        printf("  morton dynamic, %3d pixel blocks", size);
+        for (int c = 0; c < 3; c++)
+            printf(" %8.3f", time_draw(&fb, callbacks[c], 0));
+        printf("\n");
+    }
+
+    framebuffer_destroy(&fb);
+    free(texture);
+    return 0;
+}
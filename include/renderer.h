@@ -1,83 +1,208 @@
 #pragma once
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #define SDL_MAIN_HANDLED
 #include <SDL2/SDL.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include <math.h>
 #include <omp.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../src/profile.h"
+#include "../src/span_kernels.h"
+#include "../src/plot.h"
+#ifdef RENDERER_X86
+#include <immintrin.h>
+#endif
 
 #include "../src/text.h"
 #include "../src/drawjob.h"
 #include "../src/drawjob_modifier.h"
+#include "../src/primitives.h"
+#include "../src/tile_bins.h"
+#include "../src/spatial_index.h"
+#include "../src/occlusion.h"
+#include "../src/dirty_rects.h"
+#include "../src/frame_ring.h"
+#include "../src/worker_pool.h"
+#include "../src/draw_queue.h"
+#include "../src/job_cache.h"
+#include "../src/traversal.h"
+#include "../src/pixel_format.h"
+#include "../src/framebuffer.h"
+#include "../src/png.h"
+#include "../src/capture.h"
+#include "../src/asset_pack.h"
+#include "../src/scene.h"
 
+// Size of the window created by init_sdl. Offscreen framebuffers can have any size
 #define WIDTH 1000
 #define HEIGHT 700
 
+/// @brief Texture upload counters kept by update
+/// @param bytes_last_frame Bytes uploaded by the last call to update
+/// @param bytes_total Bytes uploaded since init_sdl
+/// @param frames Number of calls to update
+/// @param frames_skipped Number of calls to update that skipped an unchanged frame
+typedef struct UploadStats
+{
+    uint64_t bytes_last_frame;
+    uint64_t bytes_total;
+    uint64_t frames;
+    uint64_t frames_skipped;
+} UploadStats;
+
+/// @param skip_unchanged_frames When nonzero, update neither uploads nor presents if nothing was drawn since the last frame
 typedef struct SDLContext
 {
     SDL_Window *window;
     SDL_Renderer *renderer;
     SDL_Texture *texture;
+    Framebuffer framebuffer;
+    int skip_unchanged_frames;
+    UploadStats upload_stats;
 } SDLContext;
 
-/// @brief SDL initialization
+/// @brief SDL initialization. Creates a WIDTH by HEIGHT window and `ctx->framebuffer` to draw to it
 /// @param ctx empty SDLContext object to populate
 /// @return return 0 for successful initialization and 1 for failure
 int init_sdl(SDLContext *ctx);
 
+/// @brief SDL initialization with `ctx->framebuffer` storing its pixels in a smaller format, see framebuffer_init_format.
+/// The pixels are converted for the window once per frame, in update
+/// @param ctx empty SDLContext object to populate
+/// @param format Format of the framebuffer's pixels
+/// @return return 0 for successful initialization and 1 for failure
+int init_sdl_format(SDLContext *ctx, PixelFormat format);
+
 /// @brief Shuts down SDLContext
 /// @param ctx SDLContext to shut down
 void shutdown_sdl(SDLContext *ctx);
 
-/// @brief Draws to the buffer using callback as a function of pixel coordinates for pixel color values
+/// @brief Draws to the framebuffer using callback as a function of pixel coordinates for pixel color values
+/// @param fb framebuffer to draw to
 /// @param callback Callback to create pixel color values based on x and y coordinate.
-/// Must be a pure function to ensure multi threaded drawing will work
-void draw(DrawJob job);
+/// Must be a pure function to ensure multi threaded drawing will work.
+/// If the job has a span_callback it is called once per row instead
+void draw(Framebuffer *fb, DrawJob job);
 
-/// @brief Limited area parallel buffer fill using a callback.
+/// @brief Limited area parallel framebuffer fill using a callback.
 /// Recommend using draw_multiple_bounded with a custom queue or enqueue_draw_job
 /// with process_queue
+/// @param fb framebuffer to draw to
 /// @param callback function to be called whose return is the value for every pixel in the area, given the pixels x and y coordinate as input
 /// @param area bounding area
-void draw_bounded(DrawJob job);
+void draw_bounded(Framebuffer *fb, DrawJob job);
 
-/// @brief Not thread safe pixel drawing function. Does not prevent drawing to the same pixel from multiple threads.
-/// Significiantly faster than its safe counterpart, aswell as very usefull in drawing in parallel, '
-/// since it does not lock the mutex, if one ensures no pixels are drawn to twice
+/// @brief Not thread safe pixel drawing function. Nothing synchronises it: ARGB8888 pixels are written with a plain store,
+/// so threads drawing the same pixel at the same time race. Drawing in parallel is fine as long as no pixel is drawn
+/// by two threads at once. Use safe_draw_pixel otherwise
+/// @param fb framebuffer to draw to
 /// @param x pixel x-coordinate
 /// @param y pixel y-coordinate
 /// @param color pixel color
-void draw_pixel(int x, int y, uint32_t color);
+void draw_pixel(Framebuffer *fb, int x, int y, uint32_t color);
 
-/// @brief Safe pixel drawing function. Locks the pixel mutex every time,
-/// preventing multiple attempts at drawing to the same pixel happening at the same time in different threads.
-/// Significantly slower than `draw_pixel`, and not particularly useful for parallel operation,
-/// due to preventing parallel access to the mutex
+/// @brief Thread safe pixel drawing function. Writes the pixel with a single atomic store, so when several threads
+/// draw to the same pixel at the same time one of the colors wins whole. Takes no lock, so it scales with threads
+/// @param fb framebuffer to draw to
 /// @param x pixel x-coordinate
 /// @param y pixel y-coordinate
 /// @param color pixel color
-void safe_draw_pixel(int x, int y, uint32_t color);
+void safe_draw_pixel(Framebuffer *fb, int x, int y, uint32_t color);
 
-/// @brief buffer to SDL texture and draw it
+/// @brief Thread safe pixel plotting that combines the color with the pixel, see PlotOp.
+/// Ops reading the pixel retry with compare and swap, so concurrent plots to the same pixel are never lost
+/// @param fb framebuffer to draw to
+/// @param x pixel x-coordinate
+/// @param y pixel y-coordinate
+/// @param color plotted color
+/// @param op how the color combines with the pixel
+void safe_plot_pixel(Framebuffer *fb, int x, int y, uint32_t color, PlotOp op);
+
+/// @brief Plots many pixels in parallel. Points are sorted by tile and every tile is plotted by one thread,
+/// so no atomics are needed and every pixel sees its plots in the order given, just like plotting them one by one.
+/// Points outside the framebuffer are skipped. Faster than safe_plot_pixel for more than a few thousand points
+/// @param fb framebuffer to draw to
+/// @param points points to plot
+/// @param count number of points
+/// @param op how the colors combine with the pixels
+void plot_pixels(Framebuffer *fb, const PlotPoint *points, int count, PlotOp op);
+
+/// @brief `ctx->framebuffer` to SDL texture and draw it. Only the areas changed since the last update are uploaded
 /// @param ctx SDLContext to update
 void update(SDLContext *ctx);
 
+/// @brief Uploads the given areas of a framebuffer to the SDL texture and draws it. Used by update and by frame rings.
+/// Must be called from the thread that created the renderer
+/// @param ctx SDLContext to present to
+/// @param fb framebuffer of the same size as the window
+/// @param dirty areas of `fb` to upload
+void present_framebuffer(SDLContext *ctx, Framebuffer *fb, const DirtyRects *dirty);
+
+/// @brief Creates the renderer and texture of an SDLContext whose window already exists.
+/// init_sdl does this. Frame rings use it to move rendering to their present thread
+/// @param ctx SDLContext to create the renderer for
+/// @return 0 for success and 1 for failure
+int create_sdl_renderer(SDLContext *ctx);
+
+/// @brief Destroys the renderer and texture of an SDLContext, keeping its window
+/// @param ctx SDLContext to destroy the renderer of
+void destroy_sdl_renderer(SDLContext *ctx);
+
 /// @brief Draws multiple draw jobs in parallel. Recommend using inbuilt draw queue with enqueue_draw_job
-/// unless multiple queues must be maintaned seperately. Draw jobs should not overlap  in area
+/// unless multiple queues must be maintaned seperately. Draw jobs should not overlap  in area.
+/// Blended jobs read the pixels under them, so if any job blends this draws with draw_multiple_bounded_safe instead
+/// @param fb framebuffer to draw to
 /// @param jobs list of jobs to complete.
 /// @param job_count length of `jobs`
-void draw_multiple_bounded(DrawJob *jobs, int job_count);
+void draw_multiple_bounded(Framebuffer *fb, DrawJob *jobs, int job_count);
 
-/// @brief Same as draw_multiple_bounded, but allows overlapping areas. Later areas will override earlyer ones upon overlap
+/// @brief Same as draw_multiple_bounded, but allows overlapping areas. Later areas will override earlyer ones upon overlap.
+/// Jobs are sorted into TILE_SIZE by TILE_SIZE tiles keeping their order, and the tiles are drawn in parallel,
+/// so overlapping jobs still run in parallel with each other
+/// @param fb framebuffer to draw to
 /// @param jobs list of jobs to complete.
 /// @param job_count length of `jobs`
-void draw_multiple_bounded_safe(DrawJob *jobs, int job_count);
+void draw_multiple_bounded_safe(Framebuffer *fb, DrawJob *jobs, int job_count);
+
+/// @brief Add draw job to the framebuffer's draw queue. Safe to call from multiple threads at once, without locking.
+/// Jobs enqueued from different threads at the same time are drawn in the order their slots were claimed
+/// @param fb framebuffer whose queue to add to
+/// @param job draw job to add to the queue
+void enqueue_draw_job(Framebuffer *fb, DrawJob job);
 
-/// @brief Add draw job to the draw queue
+/// @brief Same as enqueue_draw_job, but copies `size` bytes of userdata into the queue's arena and points the job at the copy,
+/// so the caller does not need to keep it alive. The copy is freed when the queue is processed
+/// @param fb framebuffer whose queue to add to
 /// @param job draw job to add to the queue
-void enqueue_draw_job(DrawJob job);
+/// @param userdata data to copy
+/// @param size number of bytes to copy
+/// @return the copy of the userdata, or NULL if it could not be allocated, in which case the job is not enqueued
+void *enqueue_draw_job_with_data(Framebuffer *fb, DrawJob job, const void *userdata, size_t size);
 
-/// @brief calls draw_multiple_bounded on the inbuilt draw_queue. No guarantee this will work if drawjob areas overlap
-void process_queue();
+/// @brief calls draw_multiple_bounded on the framebuffer's draw queue and empties it. No guarantee this will work if drawjob areas overlap.
+/// Threads enqueueing jobs must be done before the queue is processed
+/// @param fb framebuffer whose queue to draw
+void process_queue(Framebuffer *fb);
 
-/// @brief calls draw_multiple_bounded_safe on the inbuilt draw_queue. Guaranteed to work with overlapping drawjob areas
-void process_queue_safe();
\ No newline at end of file
+/// @brief calls draw_multiple_bounded_safe on the framebuffer's draw queue and empties it. Guaranteed to work with overlapping drawjob areas.
+/// Threads enqueueing jobs must be done before the queue is processed
+/// @param fb framebuffer whose queue to draw
+void process_queue_safe(Framebuffer *fb);
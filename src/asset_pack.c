@@ -0,0 +1,193 @@
+#include "../include/renderer.h"
+
+#define ASSET_PACK_MAGIC "SDLTPAK1"
+
+static size_t align_offset(size_t offset)
+{
+    return (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+}
+
+static const char *const *sort_names;
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(sort_names[*(const int *)a], sort_names[*(const int *)b]);
+}
+
+int asset_pack_write(const char *path, const char *const *names, const Bitmap *bitmaps, int count)
+{
+    if (count < 0)
+        return 1;
+
+    AssetPackEntry *entries = calloc(count ? count : 1, sizeof(AssetPackEntry));
+    int *order = malloc((count ? count : 1) * sizeof(int));
+    if (!entries || !order)
+    {
+        free(entries);
+        free(order);
+        return 1;
+    }
+
+    // The index is sorted by name so lookups can search it. Not thread safe because of sort_names
+    for (int i = 0; i < count; i++)
+        order[i] = i;
+    sort_names = names;
+    qsort(order, count, sizeof(int), compare_names);
+
+    int failed = 0;
+    size_t offset = align_offset(sizeof(AssetPackHeader) + (size_t)count * sizeof(AssetPackEntry));
+    for (int i = 0; i < count && !failed; i++)
+    {
+        const Bitmap *bitmap = &bitmaps[order[i]];
+        const char *name = names[order[i]];
+        if (strlen(name) >= ASSET_PACK_NAME_SIZE || bitmap->width <= 0 || bitmap->height <= 0 || !bitmap->bitmap_argb ||
+            (i > 0 && strcmp(name, names[order[i - 1]]) == 0))
+        {
+            failed = 1;
+            break;
+        }
+
+        strcpy(entries[i].name, name);
+        entries[i].width = (uint32_t)bitmap->width;
+        entries[i].height = (uint32_t)bitmap->height;
+        entries[i].offset = offset;
+        offset = align_offset(offset + (size_t)bitmap->width * bitmap->height * sizeof(uint32_t));
+    }
+
+    FILE *file = failed ? NULL : fopen(path, "wb");
+    if (!file)
+        failed = 1;
+
+    AssetPackHeader header = {
+        .version = ASSET_PACK_VERSION, .count = (uint32_t)count, .index_offset = sizeof(AssetPackHeader), .file_size = offset};
+    memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    static const uint8_t padding[ASSET_PACK_ALIGNMENT];
+    size_t written = sizeof(header) + (size_t)count * sizeof(AssetPackEntry);
+    if (!failed && (fwrite(&header, sizeof(header), 1, file) != 1 ||
+                    fwrite(entries, sizeof(AssetPackEntry), count, file) != (size_t)count))
+        failed = 1;
+
+    for (int i = 0; i < count && !failed; i++)
+    {
+        const Bitmap *bitmap = &bitmaps[order[i]];
+        size_t bytes = (size_t)bitmap->width * bitmap->height * sizeof(uint32_t);
+        if (fwrite(padding, 1, entries[i].offset - written, file) != entries[i].offset - written ||
+            fwrite(bitmap->bitmap_argb, 1, bytes, file) != bytes)
+            failed = 1;
+        written = entries[i].offset + bytes;
+    }
+    if (!failed && fwrite(padding, 1, offset - written, file) != offset - written)
+        failed = 1;
+
+    if (file && fclose(file) != 0)
+        failed = 1;
+    free(entries);
+    free(order);
+    return failed;
+}
+
+// Checks everything the lookups and bitmaps rely on, so a damaged file fails to open instead of crashing later
+static int asset_pack_valid(const uint8_t *data, size_t size)
+{
+    const AssetPackHeader *header = (const AssetPackHeader *)data;
+    if (size < sizeof(AssetPackHeader) || memcmp(header->magic, ASSET_PACK_MAGIC, 8) != 0 ||
+        header->version != ASSET_PACK_VERSION || header->file_size != size || header->count > INT_MAX ||
+        header->index_offset % sizeof(uint64_t) != 0 || header->index_offset > size ||
+        header->count > (size - header->index_offset) / sizeof(AssetPackEntry))
+        return 0;
+
+    const AssetPackEntry *entries = (const AssetPackEntry *)(data + header->index_offset);
+    for (uint32_t i = 0; i < header->count; i++)
+    {
+        const AssetPackEntry *entry = &entries[i];
+        if (memchr(entry->name, 0, ASSET_PACK_NAME_SIZE) == NULL || entry->width == 0 || entry->height == 0 ||
+            entry->width > INT_MAX || entry->height > INT_MAX / entry->width || entry->offset % ASSET_PACK_ALIGNMENT != 0 ||
+            entry->offset > size || (uint64_t)entry->width * entry->height * sizeof(uint32_t) > size - entry->offset ||
+            (i > 0 && strcmp(entries[i - 1].name, entry->name) >= 0))
+            return 0;
+    }
+    return 1;
+}
+
+int asset_pack_open(AssetPack *pack, const char *path)
+{
+    *pack = (AssetPack){0};
+
+#if defined(_WIN32)
+    pack->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (pack->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(pack->file, &size) || size.QuadPart <= 0)
+    {
+        asset_pack_close(pack);
+        return 1;
+    }
+    pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    pack->data = pack->mapping ? MapViewOfFile(pack->mapping, FILE_MAP_COPY, 0, 0, 0) : NULL;
+    pack->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return 1;
+    }
+
+    // Private writable mapping: pages stay shared with the page cache and other processes until written
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    pack->data = data == MAP_FAILED ? NULL : data;
+    pack->size = (size_t)info.st_size;
+#endif
+
+    if (!pack->data || !asset_pack_valid(pack->data, pack->size))
+    {
+        asset_pack_close(pack);
+        return 1;
+    }
+
+    const AssetPackHeader *header = (const AssetPackHeader *)pack->data;
+    pack->entries = (const AssetPackEntry *)(pack->data + header->index_offset);
+    pack->count = (int)header->count;
+    return 0;
+}
+
+int asset_pack_find(const AssetPack *pack, const char *name)
+{
+    int low = 0, high = pack->count;
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        int order = strcmp(pack->entries[middle].name, name);
+        if (order == 0)
+            return middle;
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return -1;
+}
+
+Bitmap asset_pack_bitmap(const AssetPack *pack, int index)
+{
+    const AssetPackEntry *entry = &pack->entries[index];
+    return (Bitmap){(int)entry->width, (int)entry->height, (uint32_t *)(pack->data + entry->offset)};
+}
+
+void asset_pack_close(AssetPack *pack)
+{
+#if defined(_WIN32)
+    if (pack->data)
+        UnmapViewOfFile(pack->data);
+    if (pack->mapping)
+        CloseHandle(pack->mapping);
+    if (pack->file && pack->file != INVALID_HANDLE_VALUE)
+        CloseHandle(pack->file);
+#else
+    if (pack->data)
+        munmap(pack->data, pack->size);
+#endif
+    *pack = (AssetPack){0};
+}
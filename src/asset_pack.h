@@ -0,0 +1,82 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "text.h"
+
+#define ASSET_PACK_VERSION 1
+// Pixel data of every asset starts at a multiple of this many bytes
+#define ASSET_PACK_ALIGNMENT 64
+#define ASSET_PACK_NAME_SIZE 48
+
+/// @brief Start of an asset pack file. Values are in the byte order of the machine that wrote the file
+/// @param magic "SDLTPAK1"
+/// @param count Number of assets
+/// @param index_offset Offset of the index, `count` entries sorted by name
+/// @param file_size Size of the whole file, to detect truncated files
+typedef struct AssetPackHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t index_offset;
+    uint64_t file_size;
+} AssetPackHeader;
+
+/// @brief Index entry of an asset, a bitmap of premultiplied ARGB pixels stored row after row
+/// @param name NUL terminated name
+/// @param offset Offset of the first pixel, a multiple of ASSET_PACK_ALIGNMENT
+typedef struct AssetPackEntry
+{
+    char name[ASSET_PACK_NAME_SIZE];
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+} AssetPackEntry;
+
+/// @brief An asset pack file mapped into memory. Opening reads only the header and index, the pixels of an asset
+/// are read from disk when first drawn. The mapping is copy on write, so processes opening the same file share
+/// its pages in the page cache until one of them writes to a bitmap
+/// @param data Start of the mapped file
+/// @param entries Index, sorted by name
+typedef struct AssetPack
+{
+    uint8_t *data;
+    size_t size;
+    const AssetPackEntry *entries;
+    int count;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} AssetPack;
+
+/// @brief Writes bitmaps to an asset pack file
+/// @param path File to write
+/// @param names Name of every bitmap, shorter than ASSET_PACK_NAME_SIZE and all different
+/// @param bitmaps Bitmaps to write
+/// @param count Number of bitmaps
+/// @return 0 for success and 1 for failure
+int asset_pack_write(const char *path, const char *const *names, const Bitmap *bitmaps, int count);
+
+/// @brief Maps an asset pack file and checks its header and index
+/// @param pack AssetPack to open
+/// @param path File to open
+/// @return 0 for success and 1 if the file can't be mapped or is not a valid asset pack
+int asset_pack_open(AssetPack *pack, const char *path);
+
+/// @brief Looks up an asset by name with a binary search of the index
+/// @param pack Open pack
+/// @param name Name of the asset
+/// @return Index of the asset, or -1 if there is none of that name
+int asset_pack_find(const AssetPack *pack, const char *name);
+
+/// @brief Gives a bitmap whose pixels point into the mapped file, without copying them.
+/// Valid until the pack is closed
+/// @param pack Open pack
+/// @param index Index of the asset, see asset_pack_find
+/// @return The asset's bitmap
+Bitmap asset_pack_bitmap(const AssetPack *pack, int index);
+
+/// @brief Unmaps the file. Bitmaps of the pack must not be used afterwards
+/// @param pack Pack to close
+void asset_pack_close(AssetPack *pack);
@@ -0,0 +1,368 @@
+#include "../include/renderer.h"
+
+// Stream files start with the magic, width and height, followed by a record per frame: kind, payload size in bytes
+// and frame number, then the payload. Values are in the byte order of the machine that wrote them
+#define CAPTURE_MAGIC "SDLTCAP1"
+#define CAPTURE_RECORD_RAW 0
+#define CAPTURE_RECORD_DELTA 1
+
+// A delta run ends after this many unchanged pixels, since a new run costs two words
+#define CAPTURE_RUN_GAP 3
+
+enum
+{
+    CAPTURE_SLOT_FREE = 0,
+    CAPTURE_SLOT_FILLING,
+    CAPTURE_SLOT_QUEUED,
+    CAPTURE_SLOT_ENCODING
+};
+
+// Delta payloads are runs of changed pixels, each as the number of pixels skipped since the last run, the number of
+// pixels in the run and the pixels. Gives the payload's length in words, or `count` if it would not be smaller than a
+// raw frame
+static size_t encode_delta(const uint32_t *pixels, const uint32_t *previous, size_t count, uint32_t *out)
+{
+    size_t length = 0;
+    size_t last = 0;
+    size_t i = 0;
+
+    for (;;)
+    {
+        while (i < count && pixels[i] == previous[i])
+            i++;
+        if (i == count)
+            return length;
+
+        size_t start = i;
+        size_t end = ++i;
+        while (i < count && i - end < CAPTURE_RUN_GAP)
+        {
+            if (pixels[i] != previous[i])
+                end = i + 1;
+            i++;
+        }
+        i = end;
+
+        if (length + 2 + (end - start) >= count)
+            return count;
+        out[length++] = (uint32_t)(start - last);
+        out[length++] = (uint32_t)(end - start);
+        memcpy(out + length, pixels + start, (end - start) * sizeof(uint32_t));
+        length += end - start;
+        last = end;
+    }
+}
+
+static int write_record(FILE *file, uint32_t kind, const void *payload, size_t size, uint64_t frame)
+{
+    uint32_t header[4] = {kind, (uint32_t)size, (uint32_t)frame, (uint32_t)(frame >> 32)};
+    return fwrite(header, sizeof(header), 1, file) != 1 || fwrite(payload, 1, size, file) != size;
+}
+
+// Writes a frame and gives the bytes written, or 0 on failure
+static size_t write_frame(CaptureEncoder *encoder, const CaptureSlot *slot)
+{
+    Capture *capture = encoder->capture;
+    size_t count = (size_t)capture->width * capture->height;
+
+    if (capture->config.format == CAPTURE_PNG)
+    {
+        char name[FILENAME_MAX + 32];
+        snprintf(name, sizeof(name), "%s%06llu.png", capture->path, (unsigned long long)slot->frame);
+
+        size_t size;
+        const uint8_t *data = png_encode(&encoder->png, slot->pixels, capture->width, &size);
+        FILE *file = fopen(name, "wb");
+        int failed = !file || fwrite(data, 1, size, file) != size;
+        if (file && fclose(file) != 0)
+            failed = 1;
+        return failed ? 0 : size;
+    }
+
+    uint32_t kind = CAPTURE_RECORD_RAW;
+    const void *payload = slot->pixels;
+    size_t size = count * sizeof(uint32_t);
+    if (capture->config.format == CAPTURE_DELTA)
+    {
+        size_t words = encode_delta(slot->pixels, capture->previous, count, capture->scratch);
+        if (words < count)
+        {
+            kind = CAPTURE_RECORD_DELTA;
+            payload = capture->scratch;
+            size = words * sizeof(uint32_t);
+        }
+        memcpy(capture->previous, slot->pixels, count * sizeof(uint32_t));
+    }
+
+    if (write_record(capture->file, kind, payload, size, slot->frame) != 0)
+        return 0;
+    return 4 * sizeof(uint32_t) + size;
+}
+
+// Queued frame with the lowest number, so a single encoder writes frames in order
+static CaptureSlot *next_queued(Capture *capture)
+{
+    CaptureSlot *next = NULL;
+    for (int i = 0; i < capture->slot_count; i++)
+    {
+        CaptureSlot *slot = &capture->slots[i];
+        if (slot->state == CAPTURE_SLOT_QUEUED && (!next || slot->frame < next->frame))
+            next = slot;
+    }
+    return next;
+}
+
+static int capture_encoder_thread(void *data)
+{
+    CaptureEncoder *encoder = data;
+    Capture *capture = encoder->capture;
+
+    for (;;)
+    {
+        SDL_LockMutex(capture->lock);
+        CaptureSlot *slot;
+        while (!(slot = next_queued(capture)) && capture->running)
+            SDL_CondWait(capture->cond, capture->lock);
+
+        if (!slot)
+        {
+            SDL_UnlockMutex(capture->lock);
+            break;
+        }
+        slot->state = CAPTURE_SLOT_ENCODING;
+        SDL_UnlockMutex(capture->lock);
+
+        size_t bytes = write_frame(encoder, slot);
+
+        SDL_LockMutex(capture->lock);
+        slot->state = CAPTURE_SLOT_FREE;
+        if (bytes > 0)
+        {
+            capture->stats.written++;
+            capture->stats.bytes += bytes;
+        }
+        else
+            capture->stats.failed++;
+        SDL_CondBroadcast(capture->cond);
+        SDL_UnlockMutex(capture->lock);
+    }
+
+    return 0;
+}
+
+int capture_init(Capture *capture, const CaptureConfig *config, int width, int height)
+{
+    *capture = (Capture){0};
+    if (!config->path || strlen(config->path) >= FILENAME_MAX || width <= 0 || height <= 0 ||
+        config->buffer_count < 0 || config->encoder_threads < 0 || config->encoder_threads > CAPTURE_MAX_ENCODERS)
+        return 1;
+
+    capture->config = *config;
+    capture->width = width;
+    capture->height = height;
+    capture->slot_count = config->buffer_count ? config->buffer_count : CAPTURE_DEFAULT_BUFFERS;
+    capture->encoder_count = config->format != CAPTURE_PNG ? 1
+                             : config->encoder_threads ? config->encoder_threads
+                                                       : CAPTURE_DEFAULT_ENCODERS;
+    capture->running = 1;
+
+    size_t count = (size_t)width * height;
+    capture->path = malloc(strlen(config->path) + 1);
+    capture->slots = calloc(capture->slot_count, sizeof(CaptureSlot));
+    capture->lock = SDL_CreateMutex();
+    capture->cond = SDL_CreateCond();
+    if (!capture->path || !capture->slots || !capture->lock || !capture->cond)
+        goto fail;
+    strcpy(capture->path, config->path);
+    capture->config.path = capture->path;
+
+    for (int i = 0; i < capture->slot_count; i++)
+    {
+        capture->slots[i].pixels = malloc(count * sizeof(uint32_t));
+        if (!capture->slots[i].pixels)
+            goto fail;
+        // Touched now, so the first captures don't pay for faulting the pages in
+        memset(capture->slots[i].pixels, 0, count * sizeof(uint32_t));
+    }
+
+    if (config->format == CAPTURE_PNG)
+    {
+        for (int i = 0; i < capture->encoder_count; i++)
+        {
+            if (png_encoder_init(&capture->encoders[i].png, width, height) != 0)
+                goto fail;
+        }
+    }
+    else
+    {
+        // The first delta is against a frame of zeros, which is where the reader starts too
+        capture->previous = calloc(count, sizeof(uint32_t));
+        capture->scratch = malloc(count * sizeof(uint32_t));
+        capture->file = fopen(capture->path, "wb");
+        uint32_t size[2] = {(uint32_t)width, (uint32_t)height};
+        if (!capture->previous || !capture->scratch || !capture->file ||
+            fwrite(CAPTURE_MAGIC, 8, 1, capture->file) != 1 || fwrite(size, sizeof(size), 1, capture->file) != 1)
+            goto fail;
+    }
+
+    for (int i = 0; i < capture->encoder_count; i++)
+    {
+        capture->encoders[i].capture = capture;
+        capture->encoders[i].thread = SDL_CreateThread(capture_encoder_thread, "capture_encoder", &capture->encoders[i]);
+        if (!capture->encoders[i].thread)
+            goto fail;
+    }
+
+    return 0;
+
+fail:
+    capture_shutdown(capture, NULL);
+    return 1;
+}
+
+int capture_frame(Capture *capture, const Framebuffer *fb)
+{
+    PROFILE_SCOPE("capture_frame");
+    if (fb->width != capture->width || fb->height != capture->height)
+        return 1;
+
+    uint64_t frame = capture->next_frame++;
+    CaptureSlot *slot = NULL;
+
+    SDL_LockMutex(capture->lock);
+    for (int i = 0; i < capture->slot_count && !slot; i++)
+    {
+        if (capture->slots[i].state == CAPTURE_SLOT_FREE)
+            slot = &capture->slots[i];
+    }
+    if (!slot)
+    {
+        capture->stats.dropped++;
+        SDL_UnlockMutex(capture->lock);
+        return 1;
+    }
+    slot->state = CAPTURE_SLOT_FILLING;
+    SDL_UnlockMutex(capture->lock);
+
+    framebuffer_read_argb(fb, (Recti){{0, 0}, {fb->width, fb->height}}, slot->pixels, fb->width);
+
+    SDL_LockMutex(capture->lock);
+    slot->frame = frame;
+    slot->state = CAPTURE_SLOT_QUEUED;
+    capture->stats.captured++;
+    SDL_CondBroadcast(capture->cond);
+    SDL_UnlockMutex(capture->lock);
+    return 0;
+}
+
+void capture_stats(Capture *capture, CaptureStats *stats)
+{
+    SDL_LockMutex(capture->lock);
+    *stats = capture->stats;
+    SDL_UnlockMutex(capture->lock);
+}
+
+void capture_shutdown(Capture *capture, CaptureStats *stats)
+{
+    if (capture->lock)
+    {
+        SDL_LockMutex(capture->lock);
+        capture->running = 0;
+        SDL_CondBroadcast(capture->cond);
+        SDL_UnlockMutex(capture->lock);
+    }
+
+    for (int i = 0; i < capture->encoder_count; i++)
+    {
+        if (capture->encoders[i].thread)
+            SDL_WaitThread(capture->encoders[i].thread, NULL);
+        png_encoder_free(&capture->encoders[i].png);
+    }
+
+    if (capture->file && fclose(capture->file) != 0)
+        capture->stats.failed++;
+    if (stats)
+        *stats = capture->stats;
+
+    for (int i = 0; capture->slots && i < capture->slot_count; i++)
+        free(capture->slots[i].pixels);
+    free(capture->slots);
+    free(capture->previous);
+    free(capture->scratch);
+    free(capture->path);
+    if (capture->cond)
+        SDL_DestroyCond(capture->cond);
+    if (capture->lock)
+        SDL_DestroyMutex(capture->lock);
+
+    *capture = (Capture){0};
+}
+
+int capture_reader_open(CaptureReader *reader, const char *path)
+{
+    *reader = (CaptureReader){0};
+    char magic[8];
+    uint32_t size[2];
+
+    reader->file = fopen(path, "rb");
+    if (!reader->file || fread(magic, sizeof(magic), 1, reader->file) != 1 || memcmp(magic, CAPTURE_MAGIC, 8) != 0 ||
+        fread(size, sizeof(size), 1, reader->file) != 1 || size[0] == 0 || size[1] == 0 || size[0] > INT_MAX / size[1])
+    {
+        capture_reader_close(reader);
+        return 1;
+    }
+
+    reader->width = (int)size[0];
+    reader->height = (int)size[1];
+    reader->pixels = calloc((size_t)size[0] * size[1], sizeof(uint32_t));
+    reader->payload = malloc((size_t)size[0] * size[1] * sizeof(uint32_t));
+    if (!reader->pixels || !reader->payload)
+    {
+        capture_reader_close(reader);
+        return 1;
+    }
+    return 0;
+}
+
+int capture_reader_next(CaptureReader *reader)
+{
+    size_t count = (size_t)reader->width * reader->height;
+    uint32_t header[4];
+
+    if (fread(header, sizeof(header), 1, reader->file) != 1 || header[1] > count * sizeof(uint32_t) ||
+        header[1] % sizeof(uint32_t) != 0 || (header[0] == CAPTURE_RECORD_RAW && header[1] != count * sizeof(uint32_t)) ||
+        header[0] > CAPTURE_RECORD_DELTA || fread(reader->payload, 1, header[1], reader->file) != header[1])
+        return 1;
+
+    reader->frame = header[2] | (uint64_t)header[3] << 32;
+    if (header[0] == CAPTURE_RECORD_RAW)
+    {
+        memcpy(reader->pixels, reader->payload, header[1]);
+        return 0;
+    }
+
+    const uint32_t *words = (const uint32_t *)reader->payload;
+    size_t length = header[1] / sizeof(uint32_t);
+    size_t pos = 0;
+    for (size_t i = 0; i + 2 <= length;)
+    {
+        size_t skip = words[i++];
+        size_t run = words[i++];
+        if (skip > count - pos || run > count - pos - skip || run > length - i)
+            return 1;
+        pos += skip;
+        memcpy(reader->pixels + pos, words + i, run * sizeof(uint32_t));
+        pos += run;
+        i += run;
+    }
+    return 0;
+}
+
+void capture_reader_close(CaptureReader *reader)
+{
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->pixels);
+    free(reader->payload);
+    *reader = (CaptureReader){0};
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include "framebuffer.h"
+#include "png.h"
+
+#define CAPTURE_DEFAULT_BUFFERS 4
+#define CAPTURE_DEFAULT_ENCODERS 2
+#define CAPTURE_MAX_ENCODERS 16
+
+/// @brief How captured frames are stored. CAPTURE_RAW and CAPTURE_DELTA append every frame to one stream file,
+/// read back with capture_reader_open. CAPTURE_DELTA stores only the pixels that changed since the frame before,
+/// or the whole frame when that is smaller. CAPTURE_PNG writes every frame to its own PNG file
+typedef enum CaptureFormat
+{
+    CAPTURE_RAW = 0,
+    CAPTURE_DELTA,
+    CAPTURE_PNG
+} CaptureFormat;
+
+/// @brief Capture settings
+/// @param path Stream file for CAPTURE_RAW and CAPTURE_DELTA. For CAPTURE_PNG a prefix, frame 12 goes to `<path>000012.png`
+/// @param format How frames are stored
+/// @param buffer_count Frames that can wait to be written. 0 uses CAPTURE_DEFAULT_BUFFERS
+/// @param encoder_threads Threads compressing PNG files, at most CAPTURE_MAX_ENCODERS. 0 uses CAPTURE_DEFAULT_ENCODERS.
+/// Stream formats are written by one thread in order
+typedef struct CaptureConfig
+{
+    const char *path;
+    CaptureFormat format;
+    int buffer_count;
+    int encoder_threads;
+} CaptureConfig;
+
+/// @brief Counters of a capture
+/// @param captured Frames copied into a capture buffer
+/// @param dropped Frames skipped because every capture buffer was still waiting to be written
+/// @param written Frames written to disk
+/// @param failed Frames that could not be written
+/// @param bytes Bytes written
+typedef struct CaptureStats
+{
+    uint64_t captured;
+    uint64_t dropped;
+    uint64_t written;
+    uint64_t failed;
+    uint64_t bytes;
+} CaptureStats;
+
+/// @brief A capture buffer. Free buffers are filled by capture_frame and written by an encoder thread
+typedef struct CaptureSlot
+{
+    uint32_t *pixels;
+    uint64_t frame;
+    int state;
+} CaptureSlot;
+
+struct Capture;
+
+/// @brief An encoder thread and its scratch memory
+typedef struct CaptureEncoder
+{
+    struct Capture *capture;
+    SDL_Thread *thread;
+    PngEncoder png;
+} CaptureEncoder;
+
+/// @brief Streams frames to disk from separate threads. Frames are copied into a bounded ring of buffers allocated up
+/// front, so capturing never allocates and never waits for disk: when every buffer is still waiting to be written
+/// the frame is dropped and counted instead
+/// @param previous Last frame written, for CAPTURE_DELTA
+/// @param scratch Encoded frame, for CAPTURE_DELTA
+typedef struct Capture
+{
+    CaptureConfig config;
+    char *path;
+    int width;
+    int height;
+    FILE *file;
+    CaptureSlot *slots;
+    int slot_count;
+    CaptureEncoder encoders[CAPTURE_MAX_ENCODERS];
+    int encoder_count;
+    uint32_t *previous;
+    uint32_t *scratch;
+    uint64_t next_frame;
+    CaptureStats stats;
+    int running;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+} Capture;
+
+/// @brief Allocates the capture buffers and starts the encoder threads. Stream formats create their file here
+/// @param capture Capture to initialize
+/// @param config Capture settings. The path is copied
+/// @param width Width of the captured framebuffers
+/// @param height Height of the captured framebuffers
+/// @return 0 for success and 1 for failure
+int capture_init(Capture *capture, const CaptureConfig *config, int width, int height);
+
+/// @brief Copies a finished frame into a free capture buffer and hands it to the encoder threads. Never waits for
+/// disk. Every call takes the next frame number, so dropped frames leave gaps in the numbers
+/// @param capture Capture to add to
+/// @param fb Framebuffer of the size given to capture_init, in any pixel format
+/// @return 0 if the frame was queued, 1 if it was dropped because no buffer was free or its size is wrong
+int capture_frame(Capture *capture, const Framebuffer *fb);
+
+/// @brief Reads the counters of a capture. Safe to call while encoder threads are running
+/// @param capture Capture to read
+/// @param stats Set to the counters
+void capture_stats(Capture *capture, CaptureStats *stats);
+
+/// @brief Writes every queued frame, stops the encoder threads and closes the stream file
+/// @param capture Capture to shut down
+/// @param stats Set to the final counters if not NULL
+void capture_shutdown(Capture *capture, CaptureStats *stats);
+
+/// @brief Reads frames back from a CAPTURE_RAW or CAPTURE_DELTA stream
+/// @param pixels Last frame read, `width * height` ARGB pixels
+/// @param frame Frame number of the last frame read
+typedef struct CaptureReader
+{
+    FILE *file;
+    int width;
+    int height;
+    uint32_t *pixels;
+    uint64_t frame;
+    uint8_t *payload;
+} CaptureReader;
+
+/// @brief Opens a capture stream
+/// @param reader Reader to initialize
+/// @param path Stream file
+/// @return 0 for success and 1 if the file can't be read or is not a capture stream
+int capture_reader_open(CaptureReader *reader, const char *path);
+
+/// @brief Reads the next frame into `reader->pixels`
+/// @param reader Open reader
+/// @return 0 if a frame was read, 1 at the end of the stream or if it is damaged
+int capture_reader_next(CaptureReader *reader);
+
+/// @brief Closes a capture stream
+/// @param reader Reader to close
+void capture_reader_close(CaptureReader *reader);
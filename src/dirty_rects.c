@@ -0,0 +1,84 @@
+#include "../include/renderer.h"
+
+static Recti recti_union(Recti a, Recti b)
+{
+    return (Recti){
+        .top_left = {a.top_left.x < b.top_left.x ? a.top_left.x : b.top_left.x,
+                     a.top_left.y < b.top_left.y ? a.top_left.y : b.top_left.y},
+        .bottom_right = {a.bottom_right.x > b.bottom_right.x ? a.bottom_right.x : b.bottom_right.x,
+                         a.bottom_right.y > b.bottom_right.y ? a.bottom_right.y : b.bottom_right.y}};
+}
+
+static long long recti_area(Recti rect)
+{
+    return (long long)(rect.bottom_right.x - rect.top_left.x) * (rect.bottom_right.y - rect.top_left.y);
+}
+
+// Whether the areas share any pixel. Touching edges don't count
+static int recti_overlaps(Recti a, Recti b)
+{
+    return a.top_left.x < b.bottom_right.x && b.top_left.x < a.bottom_right.x &&
+           a.top_left.y < b.bottom_right.y && b.top_left.y < a.bottom_right.y;
+}
+
+void dirty_rects_add(DirtyRects *dirty, Recti rect)
+{
+    if (recti_is_empty(rect))
+        return;
+
+    // Merging can make the merged area touch other areas, so keep merging until nothing is gained
+    int merged = 1;
+    while (merged)
+    {
+        merged = 0;
+        for (int i = 0; i < dirty->count; i++)
+        {
+            Recti joined = recti_union(dirty->rects[i], rect);
+
+            // Merge when the union covers no more than the two areas would separately, and always when they overlap,
+            // so no pixel is in two areas and uploaded twice
+            if (recti_overlaps(dirty->rects[i], rect) || recti_area(joined) <= recti_area(dirty->rects[i]) + recti_area(rect))
+            {
+                rect = joined;
+                dirty->rects[i] = dirty->rects[--dirty->count];
+                merged = 1;
+                break;
+            }
+        }
+    }
+
+    if (dirty->count < DIRTY_RECT_MAX)
+    {
+        dirty->rects[dirty->count++] = rect;
+        return;
+    }
+
+    int best = 0;
+    long long best_growth = -1;
+    for (int i = 0; i < dirty->count; i++)
+    {
+        long long growth = recti_area(recti_union(dirty->rects[i], rect)) - recti_area(dirty->rects[i]);
+        if (best_growth < 0 || growth < best_growth)
+        {
+            best = i;
+            best_growth = growth;
+        }
+    }
+
+    Recti joined = recti_union(dirty->rects[best], rect);
+    dirty->rects[best] = dirty->rects[--dirty->count];
+    dirty_rects_add(dirty, joined);
+}
+
+void dirty_rects_clear(DirtyRects *dirty)
+{
+    dirty->count = 0;
+}
+
+long long dirty_rects_pixels(const DirtyRects *dirty)
+{
+    long long pixels = 0;
+    for (int i = 0; i < dirty->count; i++)
+        pixels += recti_area(dirty->rects[i]);
+    return pixels;
+}
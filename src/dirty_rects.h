@@ -0,0 +1,28 @@
+#pragma once
+#include "drawjob.h"
+
+#define DIRTY_RECT_MAX 16
+
+/// @brief A short list of damaged areas. Overlapping areas are always merged when added, touching areas when their
+/// union is no larger than they are, and once the list is full new areas are merged into the area growing the least
+/// @param rects Damaged areas, none of them empty and no two overlapping
+/// @param count Number of areas in `rects`
+typedef struct DirtyRects
+{
+    Recti rects[DIRTY_RECT_MAX];
+    int count;
+} DirtyRects;
+
+/// @brief Adds a damaged area, merging it with the areas already in the list
+/// @param dirty List to add to
+/// @param rect Damaged area. Empty areas are ignored
+void dirty_rects_add(DirtyRects *dirty, Recti rect);
+
+/// @brief Removes all areas from the list
+/// @param dirty List to clear
+void dirty_rects_clear(DirtyRects *dirty);
+
+/// @brief Total number of pixels covered by the list
+/// @param dirty List to measure
+/// @return Sum of the areas in the list, which never overlap
+long long dirty_rects_pixels(const DirtyRects *dirty);
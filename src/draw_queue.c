@@ -0,0 +1,118 @@
+#include "../include/renderer.h"
+
+// Chunk holding element `index` when chunk k holds `first << k` elements
+static int draw_queue_chunk(size_t index, size_t first, size_t *chunk_start)
+{
+    size_t n = index / first + 1;
+    int chunk = 63 - __builtin_clzll((unsigned long long)n);
+    *chunk_start = first * (((size_t)1 << chunk) - 1);
+    return chunk;
+}
+
+// Returns chunk k, allocating it if no thread has yet. Threads losing the race free their allocation
+static void *draw_queue_get_chunk(void **chunks, int chunk, size_t bytes)
+{
+    void *existing = __atomic_load_n(&chunks[chunk], __ATOMIC_ACQUIRE);
+    if (existing)
+        return existing;
+
+    PROFILE_SCOPE("draw_queue_grow");
+    void *allocated = malloc(bytes);
+    if (!allocated)
+        return NULL;
+
+    if (__atomic_compare_exchange_n(&chunks[chunk], &existing, allocated, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        return allocated;
+
+    free(allocated);
+    return existing;
+}
+
+void draw_queue_push(DrawQueue *queue, DrawJob job)
+{
+    int index = __atomic_fetch_add(&queue->length, 1, __ATOMIC_RELAXED);
+
+    size_t start;
+    int chunk = draw_queue_chunk((size_t)index, DRAW_QUEUE_FIRST_CHUNK, &start);
+    DrawJob *jobs = chunk < DRAW_QUEUE_MAX_CHUNKS
+                        ? draw_queue_get_chunk((void **)queue->chunks, chunk, (DRAW_QUEUE_FIRST_CHUNK * sizeof(DrawJob)) << chunk)
+                        : NULL;
+
+    // Out of memory: keep the slot but make it draw nothing
+    if (!jobs)
+        return;
+
+    jobs[index - start] = job;
+}
+
+void *draw_queue_alloc(DrawQueue *queue, size_t size)
+{
+    size = (size + 15) & ~(size_t)15;
+
+    for (;;)
+    {
+        size_t offset = __atomic_fetch_add(&queue->arena_used, size, __ATOMIC_RELAXED);
+
+        size_t start;
+        int chunk = draw_queue_chunk(offset, DRAW_ARENA_FIRST_CHUNK, &start);
+        if (chunk >= DRAW_QUEUE_MAX_CHUNKS)
+            return NULL;
+
+        size_t chunk_size = (size_t)DRAW_ARENA_FIRST_CHUNK << chunk;
+
+        // An allocation crossing the end of a chunk is abandoned, and the next try lands in a later, larger chunk
+        if (offset - start + size > chunk_size)
+            continue;
+
+        unsigned char *memory = draw_queue_get_chunk((void **)queue->arena_chunks, chunk, chunk_size);
+        return memory ? memory + (offset - start) : NULL;
+    }
+}
+
+DrawJob *draw_queue_jobs(DrawQueue *queue, int *count)
+{
+    int length = __atomic_load_n(&queue->length, __ATOMIC_ACQUIRE);
+    *count = queue->chunks[0] ? length : 0;
+
+    if (length <= DRAW_QUEUE_FIRST_CHUNK)
+        return queue->chunks[0];
+
+    if (length > queue->flat_capacity)
+    {
+        queue->flat_capacity = length * 2;
+        queue->flat = realloc(queue->flat, queue->flat_capacity * sizeof(DrawJob));
+    }
+
+    // Jobs span several chunks, copy them into one array
+    int copied = 0;
+    for (int chunk = 0; copied < length; chunk++)
+    {
+        int chunk_length = DRAW_QUEUE_FIRST_CHUNK << chunk;
+        int n = length - copied < chunk_length ? length - copied : chunk_length;
+
+        if (queue->chunks[chunk])
+            memcpy(queue->flat + copied, queue->chunks[chunk], n * sizeof(DrawJob));
+        else
+            memset(queue->flat + copied, 0, n * sizeof(DrawJob));
+        copied += n;
+    }
+
+    return queue->flat;
+}
+
+void draw_queue_reset(DrawQueue *queue)
+{
+    __atomic_store_n(&queue->length, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&queue->arena_used, 0, __ATOMIC_RELEASE);
+}
+
+void draw_queue_free(DrawQueue *queue)
+{
+    for (int i = 0; i < DRAW_QUEUE_MAX_CHUNKS; i++)
+    {
+        free(queue->chunks[i]);
+        free(queue->arena_chunks[i]);
+    }
+    free(queue->flat);
+    memset(queue, 0, sizeof(*queue));
+}
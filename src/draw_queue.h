@@ -0,0 +1,51 @@
+#pragma once
+#include <stddef.h>
+#include "drawjob.h"
+
+#define DRAW_QUEUE_FIRST_CHUNK 1024
+#define DRAW_ARENA_FIRST_CHUNK (64 * 1024)
+#define DRAW_QUEUE_MAX_CHUNKS 20
+
+/// @brief Draw queue that any number of threads can append to at the same time without locks,
+/// with an arena for per job userdata.
+/// Jobs and arena bytes are stored in chunks growing geometrically, chunk `k` being `2^k` times the size of the first.
+/// A slot is claimed with one atomic add, and chunks are kept when the queue is reset,
+/// so a queue of steady size does no heap allocations
+/// @param length Number of claimed job slots
+/// @param arena_used Number of claimed arena bytes
+typedef struct DrawQueue
+{
+    DrawJob *chunks[DRAW_QUEUE_MAX_CHUNKS];
+    unsigned char *arena_chunks[DRAW_QUEUE_MAX_CHUNKS];
+    int length;
+    size_t arena_used;
+    DrawJob *flat;
+    int flat_capacity;
+} DrawQueue;
+
+/// @brief Appends a job. Safe to call from multiple threads at once
+/// @param queue Queue to append to
+/// @param job Job to append
+void draw_queue_push(DrawQueue *queue, DrawJob job);
+
+/// @brief Allocates memory from the queue's arena. Safe to call from multiple threads at once.
+/// The memory stays valid until the queue is reset
+/// @param queue Queue whose arena to allocate from
+/// @param size Number of bytes
+/// @return 16 byte aligned memory, or NULL if `size` is larger than the biggest arena chunk
+void *draw_queue_alloc(DrawQueue *queue, size_t size);
+
+/// @brief Gives all queued jobs as one array, in the order their slots were claimed.
+/// Must not be called while other threads are appending
+/// @param queue Queue to read
+/// @param count Set to the number of jobs
+/// @return Array of `count` jobs, valid until the queue is appended to or reset
+DrawJob *draw_queue_jobs(DrawQueue *queue, int *count);
+
+/// @brief Empties the queue and its arena in constant time, keeping all memory for reuse
+/// @param queue Queue to reset
+void draw_queue_reset(DrawQueue *queue);
+
+/// @brief Frees all memory held by the queue
+/// @param queue Queue to free
+void draw_queue_free(DrawQueue *queue);
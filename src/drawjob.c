@@ -5,4 +5,205 @@ Recti Rectf_to_i(Rectf rectf)
     return (Recti){
         .top_left = {(int)rectf.top_left.x, (int)rectf.top_left.y},
         .bottom_right = {(int)rectf.bottom_right.x, (int)rectf.bottom_right.y}};
-}
\ No newline at end of file
+}
+static int64_t clamp_i64(double value, double limit)
+{
+    if (value > limit)
+        return (int64_t)limit;
+    if (value < -limit)
+        return (int64_t)-limit;
+    return (int64_t)llround(value);
+}
+
+DrawJob drawjob_solid(Recti area, uint32_t color)
+{
+    return (DrawJob){.area = area, .kind = DRAWJOB_SOLID, .params.color = color};
+}
+
+DrawJob drawjob_linear_gradient(Recti area, Pointf start, uint32_t start_color, Pointf end, uint32_t end_color)
+{
+    double dx = end.x - start.x;
+    double dy = end.y - start.y;
+    double length_squared = dx * dx + dy * dy;
+    GradientParams gradient = {.start_color = start_color, .end_color = end_color};
+
+    // A zero length gradient stays at the start color
+    if (length_squared > 0)
+    {
+        double scale = 65536.0 / length_squared;
+        gradient.step_x = (int32_t)clamp_i64(dx * scale, INT32_MAX);
+        gradient.step_y = (int32_t)clamp_i64(dy * scale, INT32_MAX);
+        gradient.offset = clamp_i64(-(start.x * dx + start.y * dy) * scale, (double)(INT64_C(1) << 50));
+    }
+
+    return (DrawJob){.area = area, .kind = DRAWJOB_LINEAR_GRADIENT, .params.gradient = gradient};
+}
+
+static void draw_gradient_span(const GradientParams *gradient, int y, int x0, int x1, uint32_t *dst)
+{
+    int64_t t_first = gradient->offset + (int64_t)gradient->step_y * y + (int64_t)gradient->step_x * x0;
+    int64_t t_last = t_first + (int64_t)gradient->step_x * (x1 - 1 - x0);
+
+    // The kernels step in 32 bits. Positions are linear along the span, so checking both ends is enough
+    if (t_first >= INT32_MIN && t_first <= INT32_MAX && t_last >= INT32_MIN && t_last <= INT32_MAX)
+    {
+        span_kernels.fill_gradient(dst, x1 - x0, (int32_t)t_first, gradient->step_x, gradient->start_color, gradient->end_color);
+        return;
+    }
+
+    for (int x = x0; x < x1; x++)
+        *dst++ = gradient_color(t_first + (int64_t)gradient->step_x * (x - x0), gradient->start_color, gradient->end_color);
+}
+
+static void draw_bitmap_span(const BitmapParams *bitmap, int y, int x0, int x1, uint32_t *dst)
+{
+    int row = y - bitmap->position.y;
+    if (row < 0 || row >= bitmap->height)
+        return;
+
+    int start = x0 > bitmap->position.x ? x0 : bitmap->position.x;
+    int end = x1 < bitmap->position.x + bitmap->width ? x1 : bitmap->position.x + bitmap->width;
+    if (start >= end)
+        return;
+
+    const uint32_t *src = bitmap->pixels + (size_t)row * bitmap->width + (start - bitmap->position.x);
+    memcpy(dst + (start - x0), src, (size_t)(end - start) * sizeof(uint32_t));
+}
+
+// Pixels blended per chunk. The chunk lives on the stack, so spans of any length need no allocation
+#define BLEND_CHUNK 256
+
+static void draw_blended_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    uint32_t src[BLEND_CHUNK];
+
+    // Jobs that may leave pixels unwritten start from transparent, which every mode leaves unchanged
+    int fills_span = !job->transform.active &&
+                     (job->kind == DRAWJOB_SOLID || job->kind == DRAWJOB_LINEAR_GRADIENT ||
+                      (job->kind == DRAWJOB_CALLBACK && (!job->span_callback || job->opaque)));
+
+    for (int x = x0; x < x1; x += BLEND_CHUNK)
+    {
+        int end = x + BLEND_CHUNK < x1 ? x + BLEND_CHUNK : x1;
+        if (!fills_span)
+            memset(src, 0, (size_t)(end - x) * sizeof(uint32_t));
+
+        if (job->transform.active)
+            drawjob_draw_transformed_span(job, y, x, end, src);
+        else
+            drawjob_draw_source_span(job, y, x, end, src);
+        span_kernels.blend(dst + (x - x0), src, end - x, job->blend);
+    }
+}
+
+void drawjob_draw_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    if (job->blend != BLEND_OPAQUE)
+    {
+        draw_blended_span(job, y, x0, x1, dst);
+        return;
+    }
+
+    if (job->transform.active)
+    {
+        drawjob_draw_transformed_span(job, y, x0, x1, dst);
+        return;
+    }
+    drawjob_draw_source_span(job, y, x0, x1, dst);
+}
+
+void drawjob_draw_source_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    switch (job->kind)
+    {
+    case DRAWJOB_SOLID:
+        span_kernels.fill_solid(dst, x1 - x0, job->params.color);
+        return;
+    case DRAWJOB_LINEAR_GRADIENT:
+        draw_gradient_span(&job->params.gradient, y, x0, x1, dst);
+        return;
+    case DRAWJOB_BITMAP:
+        draw_bitmap_span(&job->params.bitmap, y, x0, x1, dst);
+        return;
+    case DRAWJOB_TRIANGLE:
+    case DRAWJOB_LINE:
+    case DRAWJOB_CIRCLE:
+        primitive_draw_span(job, y, x0, x1, dst);
+        return;
+    case DRAWJOB_TEXT:
+        text_draw_span(&job->params.text, y, x0, x1, dst);
+        return;
+    default:
+        break;
+    }
+
+    if (job->span_callback)
+    {
+        job->span_callback(y, x0, x1, dst, job->userdata);
+        return;
+    }
+
+    uint32_t (*callback)(int, int, void *) = job->callback;
+    void *userdata = job->userdata;
+
+    for (int x = x0; x < x1; x++)
+        *dst++ = callback(x, y, userdata);
+}
+
+void drawjob_draw_area(const DrawJob *job, Recti area, uint32_t *dst, int stride)
+{
+    if (drawjob_is_primitive(job) && !job->transform.active)
+    {
+        primitive_draw_area(job, area, dst, stride, job->blend);
+        return;
+    }
+
+    for (int y = area.top_left.y; y < area.bottom_right.y; y++, dst += stride)
+        drawjob_draw_span(job, y, area.top_left.x, area.bottom_right.x, dst);
+}
+
+int drawjob_is_opaque(const DrawJob *job)
+{
+    if (job->blend != BLEND_OPAQUE || job->transform.active)
+        return 0;
+
+    switch (job->kind)
+    {
+    case DRAWJOB_SOLID:
+    case DRAWJOB_LINEAR_GRADIENT:
+        return 1;
+    case DRAWJOB_BITMAP:
+    {
+        const BitmapParams *bitmap = &job->params.bitmap;
+        return job->area.top_left.x >= bitmap->position.x && job->area.top_left.y >= bitmap->position.y &&
+               job->area.bottom_right.x <= bitmap->position.x + bitmap->width &&
+               job->area.bottom_right.y <= bitmap->position.y + bitmap->height;
+    }
+    case DRAWJOB_TRIANGLE:
+    case DRAWJOB_LINE:
+    case DRAWJOB_CIRCLE:
+    case DRAWJOB_TEXT:
+        return 0;
+    default:
+        return job->span_callback ? job->opaque : job->callback != NULL;
+    }
+}
+
+Recti recti_clamp(Recti rect, int width, int height)
+{
+    if (rect.top_left.x < 0)
+        rect.top_left.x = 0;
+    if (rect.top_left.y < 0)
+        rect.top_left.y = 0;
+    if (rect.bottom_right.x > width)
+        rect.bottom_right.x = width;
+    if (rect.bottom_right.y > height)
+        rect.bottom_right.y = height;
+
+    return rect;
+}
+
+int recti_is_empty(Recti rect)
+{
+    return rect.top_left.x >= rect.bottom_right.x || rect.top_left.y >= rect.bottom_right.y;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include "span_kernels.h"
 
 typedef struct Pointi
 {
@@ -25,11 +26,180 @@ typedef struct Rectf
     Pointf bottom_right;
 } Rectf;
 
+/// @brief Built in kinds of draw jobs. Built in kinds are drawn by vectorized kernels instead of callbacks
+typedef enum DrawJobKind
+{
+    DRAWJOB_CALLBACK = 0,
+    DRAWJOB_SOLID,
+    DRAWJOB_LINEAR_GRADIENT,
+    DRAWJOB_BITMAP,
+    DRAWJOB_TRIANGLE,
+    DRAWJOB_LINE,
+    DRAWJOB_CIRCLE,
+    DRAWJOB_TEXT
+} DrawJobKind;
+
+/// @brief Precomputed linear gradient. The 16.16 fixed point gradient position of pixel (x,y) is `offset + step_x * x + step_y * y`
+typedef struct GradientParams
+{
+    int64_t offset;
+    int32_t step_x;
+    int32_t step_y;
+    uint32_t start_color;
+    uint32_t end_color;
+} GradientParams;
+
+/// @brief Pixels copied by a DRAWJOB_BITMAP job, with the top left pixel placed at `position`
+typedef struct BitmapParams
+{
+    const uint32_t *pixels;
+    int width;
+    int height;
+    Pointi position;
+} BitmapParams;
+
+/// @brief Filled triangle with a color per vertex, interpolated across the triangle. Created by drawjob_triangle
+typedef struct TriangleParams
+{
+    float x[3];
+    float y[3];
+    uint32_t colors[3];
+} TriangleParams;
+
+/// @brief Anti-aliased line with round caps, fading from `colors[0]` at the start to `colors[1]` at the end. Created by drawjob_line
+typedef struct LineParams
+{
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    float half_width;
+    uint32_t colors[2];
+} LineParams;
+
+/// @brief Anti-aliased disc, or ring when `inner_radius` is above 0. Created by drawjob_circle and drawjob_ring
+typedef struct CircleParams
+{
+    float center_x;
+    float center_y;
+    float radius;
+    float inner_radius;
+    uint32_t color;
+} CircleParams;
+
+/// @brief Laid out text drawn by a DRAWJOB_TEXT job, with the top left of the line placed at `position`. Created by text_draw_job
+typedef struct TextParams
+{
+    const struct ShapedLine *line;
+    Pointi position;
+} TextParams;
+
+/// @brief Affine mapping from destination pixels back to the coordinates of the untransformed job.
+/// The center of destination pixel (x,y) maps to `inverse * (x + 0.5, y + 0.5, 1)`, and only points inside `source`,
+/// the area of the untransformed job, are drawn. Set up by the functions in drawjob_modifier.h
+typedef struct JobTransform
+{
+    int active;
+    double inverse[2][3];
+    Recti source;
+} JobTransform;
+
+/// @brief A job drawing to a rectangular area of the buffer.
+/// @param area Area to draw to
+/// @param callback Per pixel callback returning the color of the pixel at (x,y)
+/// @param userdata Passed to the callbacks
+/// @param span_callback Optional per row callback filling the pixels x0 up to x1 of row y.
+/// `dst` points to the pixel at (x0,y). Used instead of `callback` when set, saving one indirect call per pixel
+/// @param opaque Set on span callback jobs whose callback writes every pixel it is given. Span callbacks may leave pixels
+/// unwritten, so without it they never hide the jobs under them from occlusion culling and are never cached unblended
+/// @param kind Built in kind of the job. Callbacks are only used for DRAWJOB_CALLBACK jobs
+/// @param params Parameters of built in kinds. Create built in jobs with drawjob_solid, drawjob_linear_gradient, create_bitmap_draw_job,
+/// text_draw_job or the functions in primitives.h
+/// @param transform Transformation applied by the functions in drawjob_modifier.h. Callbacks and params always see untransformed coordinates
+/// @param blend How the job's pixels combine with the framebuffer. Blended jobs produce premultiplied ARGB colors,
+/// and pixels a blended span callback leaves unwritten are transparent
+/// @param cacheable Set to keep the drawn pixels in the framebuffer's JobCache and copy them instead of drawing the job again
+/// while it stays the same. Jobs are told apart by callbacks, userdata, kind, params, area, transform, blend and `version`
+/// @param version Increase when the output of a cacheable job changes without any of the above changing
 typedef struct DrawJob
 {
     Recti area;
     uint32_t (*callback)(int x, int y, void *userdata);
     void *userdata;
+    void (*span_callback)(int y, int x0, int x1, uint32_t *dst, void *userdata);
+    int opaque;
+    DrawJobKind kind;
+    union
+    {
+        uint32_t color;
+        GradientParams gradient;
+        BitmapParams bitmap;
+        TriangleParams triangle;
+        LineParams line;
+        CircleParams circle;
+        TextParams text;
+    } params;
+    JobTransform transform;
+    BlendMode blend;
+    int cacheable;
+    uint32_t version;
 } DrawJob;
 
-Recti Rectf_to_i(Rectf rectf);
\ No newline at end of file
+Recti Rectf_to_i(Rectf rectf);
+
+/// @brief Creates a job filling its area with a single color
+/// @param area Area to fill
+/// @param color Fill color
+/// @return A DRAWJOB_SOLID job
+DrawJob drawjob_solid(Recti area, uint32_t color);
+
+/// @brief Creates a job filling its area with a linear gradient. Pixels before `start` get `start_color`
+/// and pixels past `end` get `end_color`
+/// @param area Area to fill
+/// @param start Point where the gradient starts
+/// @param start_color Color at `start`
+/// @param end Point where the gradient ends
+/// @param end_color Color at `end`
+/// @return A DRAWJOB_LINEAR_GRADIENT job
+DrawJob drawjob_linear_gradient(Recti area, Pointf start, uint32_t start_color, Pointf end, uint32_t end_color);
+
+/// @brief Draws the pixels x0 up to x1 of row y of a job into dst.
+/// Built in kinds run their vectorized kernel. Otherwise calls the span callback once if the job has one,
+/// and the per pixel callback for every pixel if it does not
+/// @param job Job to draw
+/// @param y Row to draw
+/// @param x0 First pixel to draw
+/// @param x1 One past the last pixel to draw
+/// @param dst Pointer to the pixel at (x0,y)
+void drawjob_draw_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst);
+
+/// @brief Draws an area of a job, the same as drawjob_draw_span for every row of it. Untransformed primitives
+/// set up their edges once for the whole area instead of once per row
+/// @param job Job to draw
+/// @param area Area to draw
+/// @param dst Pointer to the pixel at the top left of `area`
+/// @param stride Pixels from one row of `dst` to the next
+void drawjob_draw_area(const DrawJob *job, Recti area, uint32_t *dst, int stride);
+
+/// @brief Whether drawing the job overwrites every pixel of its area, so jobs under it can be skipped.
+/// True for untransformed opaque solid, gradient and per pixel callback jobs, bitmaps covering their whole area,
+/// and span callback jobs with `opaque` set. Other span callbacks may leave pixels unwritten, so they never count as opaque
+/// @param job Job to check
+/// @return 1 if the job is opaque, 0 otherwise
+int drawjob_is_opaque(const DrawJob *job);
+
+/// @brief Same as drawjob_draw_span but ignores the job's transform and blend mode, so (x,y) are untransformed coordinates
+/// and the pixels are overwritten
+void drawjob_draw_source_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst);
+
+/// @brief Clamps a rectangle to the area from (0,0) to (width,height)
+/// @param rect Rectangle to clamp
+/// @param width Width of the area to clamp to
+/// @param height Height of the area to clamp to
+/// @return The clamped rectangle. May be empty
+Recti recti_clamp(Recti rect, int width, int height);
+
+/// @brief Checks if a rectangle contains no pixels
+/// @param rect Rectangle to check
+/// @return 1 if the rectangle is empty and 0 otherwise
+int recti_is_empty(Recti rect);
\ No newline at end of file
@@ -1 +1,335 @@
 #include "../include/renderer.h"
+
+// Affine maps are stored as 2x3 matrices, (x,y) -> (m[0][0] x + m[0][1] y + m[0][2], m[1][0] x + m[1][1] y + m[1][2])
+typedef double Affine[2][3];
+
+static int affine_invert(const Affine m, Affine out)
+{
+    double det = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    if (det == 0 || !isfinite(det))
+        return 1;
+
+    double inv_det = 1.0 / det;
+    out[0][0] = m[1][1] * inv_det;
+    out[0][1] = -m[0][1] * inv_det;
+    out[1][0] = -m[1][0] * inv_det;
+    out[1][1] = m[0][0] * inv_det;
+    out[0][2] = -(out[0][0] * m[0][2] + out[0][1] * m[1][2]);
+    out[1][2] = -(out[1][0] * m[0][2] + out[1][1] * m[1][2]);
+    return 0;
+}
+
+// out = a after b
+static void affine_multiply(const Affine a, const Affine b, Affine out)
+{
+    Affine result;
+    for (int row = 0; row < 2; row++)
+    {
+        result[row][0] = a[row][0] * b[0][0] + a[row][1] * b[1][0];
+        result[row][1] = a[row][0] * b[0][1] + a[row][1] * b[1][1];
+        result[row][2] = a[row][0] * b[0][2] + a[row][1] * b[1][2] + a[row][2];
+    }
+    memcpy(out, result, sizeof(Affine));
+}
+
+static int clamp_to_int(double value)
+{
+    if (value > INT_MAX / 2)
+        return INT_MAX / 2;
+    if (value < INT_MIN / 2)
+        return INT_MIN / 2;
+    return (int)value;
+}
+
+// Applies the forward map to the job. The inverse of the combined map is stored, so any number of modifiers costs one matrix
+static DrawJob drawjob_apply(DrawJob job, const Affine forward)
+{
+    Affine inverse;
+    if (affine_invert(forward, inverse))
+    {
+        // A singular map squashes the job to a line, which covers no pixel centers
+        job.area = (Recti){{0, 0}, {0, 0}};
+        return job;
+    }
+
+    if (!job.transform.active)
+    {
+        Recti source = job.area;
+
+        // Bitmaps draw nothing outside their pixels, so they don't need to be sampled there
+        if (job.kind == DRAWJOB_BITMAP)
+        {
+            const BitmapParams *bitmap = &job.params.bitmap;
+            if (source.top_left.x < bitmap->position.x)
+                source.top_left.x = bitmap->position.x;
+            if (source.top_left.y < bitmap->position.y)
+                source.top_left.y = bitmap->position.y;
+            if (source.bottom_right.x > bitmap->position.x + bitmap->width)
+                source.bottom_right.x = bitmap->position.x + bitmap->width;
+            if (source.bottom_right.y > bitmap->position.y + bitmap->height)
+                source.bottom_right.y = bitmap->position.y + bitmap->height;
+        }
+
+        job.transform = (JobTransform){
+            .active = 1,
+            .inverse = {{1, 0, 0}, {0, 1, 0}},
+            .source = source};
+    }
+
+    affine_multiply(job.transform.inverse, inverse, job.transform.inverse);
+
+    Affine total;
+    Recti source = job.transform.source;
+    if (recti_is_empty(source) || affine_invert(job.transform.inverse, total))
+    {
+        job.area = (Recti){{0, 0}, {0, 0}};
+        return job;
+    }
+
+    // The transformed area is a parallelogram. Its bounding box is spanned by the four transformed corners
+    double corners[4][2] = {
+        {source.top_left.x, source.top_left.y},
+        {source.bottom_right.x, source.top_left.y},
+        {source.top_left.x, source.bottom_right.y},
+        {source.bottom_right.x, source.bottom_right.y}};
+    double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+
+    for (int i = 0; i < 4; i++)
+    {
+        double x = total[0][0] * corners[i][0] + total[0][1] * corners[i][1] + total[0][2];
+        double y = total[1][0] * corners[i][0] + total[1][1] * corners[i][1] + total[1][2];
+        min_x = fmin(min_x, x);
+        min_y = fmin(min_y, y);
+        max_x = fmax(max_x, x);
+        max_y = fmax(max_y, y);
+    }
+
+    // Pixels are drawn when their center lies inside, so the box shrinks to the pixel centers it contains
+    job.area = (Recti){
+        .top_left = {clamp_to_int(ceil(min_x - 0.5)), clamp_to_int(ceil(min_y - 0.5))},
+        .bottom_right = {clamp_to_int(ceil(max_x - 0.5)), clamp_to_int(ceil(max_y - 0.5))}};
+    return job;
+}
+
+DrawJob drawjob_shift(DrawJob job, Pointi position)
+{
+    // Shifting an untransformed job needs no inversion, which keeps per frame labels and sprites cheap
+    if (!job.transform.active && job.kind != DRAWJOB_BITMAP)
+    {
+        job.transform = (JobTransform){
+            .active = 1,
+            .inverse = {{1, 0, -position.x}, {0, 1, -position.y}},
+            .source = job.area};
+        job.area.top_left.x += position.x;
+        job.area.top_left.y += position.y;
+        job.area.bottom_right.x += position.x;
+        job.area.bottom_right.y += position.y;
+        return job;
+    }
+
+    Affine forward = {{1, 0, position.x}, {0, 1, position.y}};
+    return drawjob_apply(job, forward);
+}
+
+DrawJob drawjob_rotate(DrawJob job, double angle_rad)
+{
+    double c = cos(angle_rad);
+    double s = sin(angle_rad);
+    Affine forward = {{c, -s, 0}, {s, c, 0}};
+    return drawjob_apply(job, forward);
+}
+
+DrawJob drawjob_rotate_around_point(DrawJob job, double angle_rad, Pointf center_of_rotation)
+{
+    double c = cos(angle_rad);
+    double s = sin(angle_rad);
+    double cx = center_of_rotation.x;
+    double cy = center_of_rotation.y;
+    Affine forward = {
+        {c, -s, cx - c * cx + s * cy},
+        {s, c, cy - s * cx - c * cy}};
+    return drawjob_apply(job, forward);
+}
+
+DrawJob drawjob_shear(DrawJob job, double shear_x, double shear_y)
+{
+    Affine forward = {{1, shear_x, 0}, {shear_y, 1, 0}};
+    return drawjob_apply(job, forward);
+}
+
+DrawJob drawjob_transform(DrawJob job, TransformationMatrix matrix)
+{
+    Affine forward = {
+        {matrix.M[0][0], matrix.M[0][1], 0},
+        {matrix.M[1][0], matrix.M[1][1], 0}};
+    return drawjob_apply(job, forward);
+}
+
+// Narrows [x0,x1) to the integers x with lo <= a*x + b < hi
+static void clip_axis(double a, double b, double lo, double hi, int *x0, int *x1)
+{
+    if (a == 0)
+    {
+        if (b < lo || b >= hi)
+            *x1 = *x0;
+        return;
+    }
+
+    double first, end;
+    if (a > 0)
+    {
+        first = ceil((lo - b) / a);
+        end = ceil((hi - b) / a);
+    }
+    else
+    {
+        first = floor((hi - b) / a) + 1;
+        end = floor((lo - b) / a) + 1;
+    }
+
+    if (first > *x0)
+        *x0 = first < *x1 ? (int)first : *x1;
+    if (end < *x1)
+        *x1 = end > *x0 ? (int)end : *x0;
+}
+
+static inline int clamp_int(int value, int low, int high)
+{
+    return value < low ? low : value > high ? high : value;
+}
+
+// Samples one pixel of the untransformed job. Kinds that may leave the pixel unwritten return `under` there
+static inline uint32_t sample_source(const DrawJob *job, int x, int y, uint32_t under)
+{
+    switch (job->kind)
+    {
+    case DRAWJOB_SOLID:
+        return job->params.color;
+    case DRAWJOB_LINEAR_GRADIENT:
+    {
+        const GradientParams *gradient = &job->params.gradient;
+        return gradient_color(gradient->offset + (int64_t)gradient->step_y * y + (int64_t)gradient->step_x * x,
+                              gradient->start_color, gradient->end_color);
+    }
+    case DRAWJOB_BITMAP:
+    {
+        const BitmapParams *bitmap = &job->params.bitmap;
+        return bitmap->pixels[(size_t)(y - bitmap->position.y) * bitmap->width + (x - bitmap->position.x)];
+    }
+    case DRAWJOB_TRIANGLE:
+    case DRAWJOB_LINE:
+    case DRAWJOB_CIRCLE:
+    {
+        uint32_t color = under;
+        primitive_draw_span(job, y, x, x + 1, &color);
+        return color;
+    }
+    case DRAWJOB_TEXT:
+    {
+        uint32_t color = under;
+        text_draw_span(&job->params.text, y, x, x + 1, &color);
+        return color;
+    }
+    default:
+        break;
+    }
+
+    if (job->span_callback)
+    {
+        uint32_t color = under;
+        job->span_callback(y, x, x + 1, &color, job->userdata);
+        return color;
+    }
+    return job->callback(x, y, job->userdata);
+}
+
+// Rotated sprites are the common case, so bitmaps index their pixels straight from the stepped positions
+static void draw_transformed_bitmap(const DrawJob *job, int64_t u, int64_t v, int64_t du, int64_t dv, int count, uint32_t *dst)
+{
+    const BitmapParams *bitmap = &job->params.bitmap;
+    const Recti *source = &job->transform.source;
+    int max_u = source->bottom_right.x - source->top_left.x - 1;
+    int max_v = source->bottom_right.y - source->top_left.y - 1;
+    const uint32_t *origin = bitmap->pixels +
+                             (size_t)(source->top_left.y - bitmap->position.y) * bitmap->width +
+                             (source->top_left.x - bitmap->position.x);
+
+    for (int i = 0; i < count; i++)
+    {
+        // The clip interval is exact in doubles, the clamp only absorbs rounding at its ends
+        int column = clamp_int((int)(u >> 16), 0, max_u);
+        int row = clamp_int((int)(v >> 16), 0, max_v);
+        dst[i] = origin[(size_t)row * bitmap->width + column];
+        u += du;
+        v += dv;
+    }
+}
+
+void drawjob_draw_transformed_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    const double (*m)[3] = job->transform.inverse;
+    const Recti *source = &job->transform.source;
+
+    // Integer shifts map whole spans onto the untransformed job, which keeps its span kernels
+    if (m[0][0] == 1 && m[0][1] == 0 && m[1][0] == 0 && m[1][1] == 1 &&
+        m[0][2] == floor(m[0][2]) && m[1][2] == floor(m[1][2]))
+    {
+        int shift_x = (int)m[0][2];
+        int sy = y + (int)m[1][2];
+        if (sy < source->top_left.y || sy >= source->bottom_right.y)
+            return;
+
+        int start = x0 + shift_x > source->top_left.x ? x0 + shift_x : source->top_left.x;
+        int end = x1 + shift_x < source->bottom_right.x ? x1 + shift_x : source->bottom_right.x;
+        if (start >= end)
+            return;
+
+        drawjob_draw_source_span(job, sy, start, end, dst + (start - shift_x - x0));
+        return;
+    }
+
+    // Source coordinates are linear along the row: s(x) = s(0) + x * (m[0][0], m[1][0])
+    double row_x = m[0][0] * 0.5 + m[0][1] * (y + 0.5) + m[0][2];
+    double row_y = m[1][0] * 0.5 + m[1][1] * (y + 0.5) + m[1][2];
+
+    int start = x0;
+    int end = x1;
+    clip_axis(m[0][0], row_x, source->top_left.x, source->bottom_right.x, &start, &end);
+    clip_axis(m[1][0], row_y, source->top_left.y, source->bottom_right.y, &start, &end);
+    if (start >= end)
+        return;
+
+    // Positions relative to the source corner step in 16.16 fixed point from `anchor`, the row's first pixel inside the source,
+    // rather than from `start`, so a pixel samples the same source position however the row is split into spans
+    int anchor = INT_MIN / 2;
+    int anchor_end = INT_MAX / 2;
+    clip_axis(m[0][0], row_x, source->top_left.x, source->bottom_right.x, &anchor, &anchor_end);
+    clip_axis(m[1][0], row_y, source->top_left.y, source->bottom_right.y, &anchor, &anchor_end);
+    int64_t du = llround(m[0][0] * 65536.0);
+    int64_t dv = llround(m[1][0] * 65536.0);
+    int64_t u = llround((row_x + m[0][0] * anchor - source->top_left.x) * 65536.0) + du * (start - anchor);
+    int64_t v = llround((row_y + m[1][0] * anchor - source->top_left.y) * 65536.0) + dv * (start - anchor);
+    dst += start - x0;
+    int count = end - start;
+
+    if (job->kind == DRAWJOB_SOLID)
+    {
+        span_kernels.fill_solid(dst, count, job->params.color);
+        return;
+    }
+    if (job->kind == DRAWJOB_BITMAP)
+    {
+        draw_transformed_bitmap(job, u, v, du, dv, count, dst);
+        return;
+    }
+
+    int max_u = source->bottom_right.x - source->top_left.x - 1;
+    int max_v = source->bottom_right.y - source->top_left.y - 1;
+    for (int i = 0; i < count; i++)
+    {
+        dst[i] = sample_source(job, source->top_left.x + clamp_int((int)(u >> 16), 0, max_u),
+                               source->top_left.y + clamp_int((int)(v >> 16), 0, max_v), dst[i]);
+        u += du;
+        v += dv;
+    }
+}
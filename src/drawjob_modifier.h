@@ -5,9 +5,13 @@
 /// @param M two by two double list representing the matrix
 typedef struct
 {
-    double M[2][2]
+    double M[2][2];
 } TransformationMatrix;
 
+/// All modifiers return a job drawing the original job's area transformed, with `area` set to the bounding box of the result.
+/// Modifying an already modified job combines both transformations into one, so chains of modifiers cost no more than one.
+/// Pixels are sampled at their centers, so integer shifts reproduce the original exactly
+
 /// @brief Modifies a draw job to have the origin placed at `position`
 /// @param job The job to modify
 /// @param position The position to place the origin at
@@ -38,4 +42,13 @@ DrawJob drawjob_shear(DrawJob job, double shear_x, double shear_y);
 /// @param job Job to return with the transformed coordinate system
 /// @param matrix Matrix to transform the coordinate system with
 /// @return A job with a transformed coordinate system
-DrawJob drawjob_transform(DrawJob job, TransformationMatrix matrix);
\ No newline at end of file
+DrawJob drawjob_transform(DrawJob job, TransformationMatrix matrix);
+
+/// @brief Draws the pixels x0 up to x1 of row y of a transformed job into dst. Called by drawjob_draw_span for jobs with an active transform.
+/// Only pixels mapping into the original area are written
+/// @param job Transformed job
+/// @param y Row to draw
+/// @param x0 First pixel to draw
+/// @param x1 One past the last pixel to draw
+/// @param dst Pointer to the pixel at (x0,y)
+void drawjob_draw_transformed_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst);
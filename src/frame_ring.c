@@ -0,0 +1,211 @@
+#include "../include/renderer.h"
+
+static int frame_ring_present_thread(void *data)
+{
+    FrameRing *ring = data;
+    SDLContext *ctx = ring->ctx;
+
+    // SDL renderers may only be used from the thread that created them
+    int created = create_sdl_renderer(ctx) == 0;
+
+    SDL_LockMutex(ring->lock);
+    ring->thread_state = created ? 1 : -1;
+    SDL_CondBroadcast(ring->cond);
+    SDL_UnlockMutex(ring->lock);
+
+    if (!created)
+        return 1;
+
+    for (;;)
+    {
+        SDL_LockMutex(ring->lock);
+        while (ring->running && ring->presented == ring->submitted)
+            SDL_CondWait(ring->cond, ring->lock);
+
+        if (ring->presented == ring->submitted)
+        {
+            SDL_UnlockMutex(ring->lock);
+            break;
+        }
+
+        int slot = (int)(ring->presented % ring->frame_count);
+        SDL_UnlockMutex(ring->lock);
+
+        present_framebuffer(ctx, &ring->frames[slot], &ring->submitted_dirty[slot]);
+
+        SDL_LockMutex(ring->lock);
+        ring->presented++;
+        SDL_CondBroadcast(ring->cond);
+        SDL_UnlockMutex(ring->lock);
+    }
+
+    destroy_sdl_renderer(ctx);
+    return 0;
+}
+
+int frame_ring_init(FrameRing *ring, SDLContext *ctx, int frame_count)
+{
+    *ring = (FrameRing){0};
+    if (frame_count < 2 || frame_count > FRAME_RING_MAX)
+        return 1;
+
+    ring->ctx = ctx;
+    ring->frame_count = frame_count;
+    ring->running = 1;
+
+    for (int i = 0; i < frame_count; i++)
+    {
+        if (framebuffer_init_format(&ring->frames[i], ctx->framebuffer.width, ctx->framebuffer.height, ctx->framebuffer.format) != 0)
+            goto fail;
+    }
+
+    ring->lock = SDL_CreateMutex();
+    ring->cond = SDL_CreateCond();
+    if (!ring->lock || !ring->cond)
+        goto fail;
+
+    destroy_sdl_renderer(ctx);
+    ring->thread = SDL_CreateThread(frame_ring_present_thread, "frame_ring_present", ring);
+    if (!ring->thread)
+        goto fail;
+
+    SDL_LockMutex(ring->lock);
+    while (ring->thread_state == 0)
+        SDL_CondWait(ring->cond, ring->lock);
+    SDL_UnlockMutex(ring->lock);
+
+    if (ring->thread_state < 0)
+        goto fail;
+
+    return 0;
+
+fail:
+    if (ring->thread)
+        SDL_WaitThread(ring->thread, NULL);
+    ring->thread = NULL;
+    frame_ring_shutdown(ring);
+    return 1;
+}
+
+Framebuffer *frame_ring_acquire(FrameRing *ring)
+{
+    uint64_t frame = ring->submitted;
+    int count = ring->frame_count;
+
+    // The framebuffer is free once the frame it held last has been presented
+    SDL_LockMutex(ring->lock);
+    while (frame >= (uint64_t)count && ring->presented < frame - count + 1)
+        SDL_CondWait(ring->cond, ring->lock);
+    SDL_UnlockMutex(ring->lock);
+
+    Framebuffer *fb = &ring->frames[frame % count];
+    framebuffer_clear_dirty(fb);
+
+    if (frame == 0)
+    {
+        framebuffer_mark_dirty(fb, (Recti){{0, 0}, {fb->width, fb->height}});
+        return fb;
+    }
+
+    // Bring the framebuffer up to date with the previous frame by copying every area changed since it was last used
+    Framebuffer *previous = &ring->frames[(frame - 1) % count];
+    uint64_t first = frame >= (uint64_t)count ? frame - count + 1 : 0;
+
+    for (uint64_t f = first; f < frame; f++)
+    {
+        const DirtyRects *changed = &ring->submitted_dirty[f % count];
+        for (int i = 0; i < changed->count; i++)
+        {
+            Recti area = changed->rects[i];
+            size_t bytes = (size_t)(area.bottom_right.x - area.top_left.x) * pixel_format_bytes(fb->format);
+
+            for (int y = area.top_left.y; y < area.bottom_right.y; y++)
+                memcpy(framebuffer_address(fb, area.top_left.x, y), framebuffer_address(previous, area.top_left.x, y), bytes);
+        }
+    }
+
+    return fb;
+}
+
+FrameFence frame_ring_submit(FrameRing *ring)
+{
+    int slot = (int)(ring->submitted % ring->frame_count);
+    ring->submitted_dirty[slot] = *framebuffer_dirty(&ring->frames[slot]);
+
+    SDL_LockMutex(ring->lock);
+    FrameFence fence = ++ring->submitted;
+    SDL_CondBroadcast(ring->cond);
+    SDL_UnlockMutex(ring->lock);
+
+    profile_end_frame();
+    return fence;
+}
+
+int frame_fence_reached(FrameRing *ring, FrameFence fence)
+{
+    SDL_LockMutex(ring->lock);
+    int reached = ring->presented >= fence;
+    SDL_UnlockMutex(ring->lock);
+    return reached;
+}
+
+int frame_fence_wait(FrameRing *ring, FrameFence fence, uint32_t timeout_ms)
+{
+    Uint32 start = SDL_GetTicks();
+
+    SDL_LockMutex(ring->lock);
+    while (ring->presented < fence)
+    {
+        if (timeout_ms == SDL_MUTEX_MAXWAIT)
+        {
+            SDL_CondWait(ring->cond, ring->lock);
+            continue;
+        }
+
+        Uint32 elapsed = SDL_GetTicks() - start;
+        if (elapsed >= timeout_ms)
+            break;
+        SDL_CondWaitTimeout(ring->cond, ring->lock, timeout_ms - elapsed);
+    }
+    int reached = ring->presented >= fence;
+    SDL_UnlockMutex(ring->lock);
+
+    return reached ? 0 : 1;
+}
+
+void frame_ring_shutdown(FrameRing *ring)
+{
+    if (ring->thread)
+    {
+        SDL_LockMutex(ring->lock);
+        ring->running = 0;
+        SDL_CondBroadcast(ring->cond);
+        SDL_UnlockMutex(ring->lock);
+
+        SDL_WaitThread(ring->thread, NULL);
+    }
+
+    // Hand rendering back to the calling thread, continuing from the last submitted frame
+    SDLContext *ctx = ring->ctx;
+    if (ctx && !ctx->renderer && create_sdl_renderer(ctx) == 0)
+    {
+        Framebuffer *fb = &ctx->framebuffer;
+        if (ring->submitted > 0)
+        {
+            Framebuffer *last = &ring->frames[(ring->submitted - 1) % ring->frame_count];
+            for (int y = 0; y < fb->height; y++)
+                memcpy(framebuffer_address(fb, 0, y), framebuffer_address(last, 0, y), (size_t)fb->width * pixel_format_bytes(fb->format));
+        }
+        framebuffer_mark_dirty(fb, (Recti){{0, 0}, {fb->width, fb->height}});
+    }
+
+    for (int i = 0; i < ring->frame_count; i++)
+        framebuffer_destroy(&ring->frames[i]);
+
+    if (ring->cond)
+        SDL_DestroyCond(ring->cond);
+    if (ring->lock)
+        SDL_DestroyMutex(ring->lock);
+
+    *ring = (FrameRing){0};
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "framebuffer.h"
+
+#define FRAME_RING_MAX 3
+
+/// @brief Identifies a submitted frame. A fence is reached once its frame has been presented
+typedef uint64_t FrameFence;
+
+struct SDLContext;
+
+/// @brief Two or three framebuffers presented by a separate thread, so the next frame can be drawn
+/// while the previous one is uploaded and presented.
+/// Frames keep single framebuffer semantics: an acquired framebuffer already holds the previous frame,
+/// so only changed areas need to be redrawn
+typedef struct FrameRing
+{
+    struct SDLContext *ctx;
+    Framebuffer frames[FRAME_RING_MAX];
+    DirtyRects submitted_dirty[FRAME_RING_MAX];
+    int frame_count;
+    uint64_t submitted;
+    uint64_t presented;
+    int running;
+    int thread_state;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+} FrameRing;
+
+/// @brief Starts presenting from a separate thread. The thread takes over the renderer and texture of `ctx`,
+/// so update must not be called until frame_ring_shutdown. Rendering from a thread other than the main thread
+/// is not supported by SDL on macOS
+/// @param ring FrameRing to initialize
+/// @param ctx Initialized SDLContext to present to
+/// @param frame_count Number of framebuffers, 2 or 3
+/// @return 0 for success and 1 for failure
+int frame_ring_init(FrameRing *ring, struct SDLContext *ctx, int frame_count);
+
+/// @brief Gives the framebuffer to draw the next frame to. Waits if every framebuffer is still waiting to be presented
+/// @param ring FrameRing to draw to
+/// @return Framebuffer holding the previous frame
+Framebuffer *frame_ring_acquire(FrameRing *ring);
+
+/// @brief Hands the acquired framebuffer to the present thread
+/// @param ring FrameRing to submit to
+/// @return Fence reached once the frame has been presented
+FrameFence frame_ring_submit(FrameRing *ring);
+
+/// @brief Checks if a frame has been presented without waiting
+/// @param ring FrameRing the fence belongs to
+/// @param fence Fence to check
+/// @return 1 if the frame has been presented and 0 otherwise
+int frame_fence_reached(FrameRing *ring, FrameFence fence);
+
+/// @brief Waits for a frame to be presented. Waiting for the fence of the frame before the last one
+/// bounds latency to a single frame in flight
+/// @param ring FrameRing the fence belongs to
+/// @param fence Fence to wait for
+/// @param timeout_ms Longest time to wait in milliseconds, or SDL_MUTEX_MAXWAIT to wait forever
+/// @return 0 if the frame has been presented and 1 on timeout
+int frame_fence_wait(FrameRing *ring, FrameFence fence, uint32_t timeout_ms);
+
+/// @brief Presents every submitted frame, stops the present thread and gives the renderer back to `ctx`
+/// @param ring FrameRing to shut down
+void frame_ring_shutdown(FrameRing *ring);
@@ -0,0 +1,129 @@
+#include "../include/renderer.h"
+
+// Sets up everything but the pixel storage
+static int framebuffer_setup(Framebuffer *fb, int width, int height, int stride)
+{
+    fb->width = width;
+    fb->height = height;
+    fb->stride = stride;
+
+    fb->dirty_tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    fb->dirty_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    fb->dirty_tiles = calloc((size_t)fb->dirty_tiles_x * fb->dirty_tiles_y, 1);
+
+    fb->plot_tile_start = malloc(((size_t)fb->dirty_tiles_x * fb->dirty_tiles_y + 1) * sizeof(int));
+    if (!fb->dirty_tiles || !fb->plot_tile_start || job_cache_init(&fb->job_cache, JOB_CACHE_DEFAULT_BUDGET) != 0)
+    {
+        framebuffer_destroy(fb);
+        return 1;
+    }
+
+    // Nothing has been shown yet, so everything counts as changed
+    framebuffer_mark_dirty(fb, (Recti){{0, 0}, {width, height}});
+    return 0;
+}
+
+int framebuffer_wrap(Framebuffer *fb, uint32_t *pixels, int width, int height, int stride)
+{
+    *fb = (Framebuffer){0};
+    if (!pixels || width <= 0 || height <= 0 || stride < width)
+        return 1;
+
+    fb->pixels = pixels;
+    return framebuffer_setup(fb, width, height, stride);
+}
+
+int framebuffer_init(Framebuffer *fb, int width, int height)
+{
+    return framebuffer_init_format(fb, width, height, PIXEL_FORMAT_ARGB8888);
+}
+
+int framebuffer_init_format(Framebuffer *fb, int width, int height, PixelFormat format)
+{
+    *fb = (Framebuffer){0};
+    if (width <= 0 || height <= 0 || format < PIXEL_FORMAT_ARGB8888 || format > PIXEL_FORMAT_RGB332)
+        return 1;
+
+    void *pixels = calloc((size_t)width * height, pixel_format_bytes(format));
+    if (!pixels)
+        return 1;
+
+    fb->format = format;
+    if (format == PIXEL_FORMAT_ARGB8888)
+        fb->pixels = pixels;
+    else
+        fb->packed_pixels = pixels;
+
+    if (framebuffer_setup(fb, width, height, width) != 0)
+    {
+        free(pixels);
+        return 1;
+    }
+
+    fb->owns_pixels = 1;
+    return 0;
+}
+
+void framebuffer_destroy(Framebuffer *fb)
+{
+    if (fb->owns_pixels)
+    {
+        free(fb->pixels);
+        free(fb->packed_pixels);
+    }
+    draw_queue_free(&fb->queue);
+    free(fb->dirty_tiles);
+    free(fb->task_offsets);
+    tile_bins_free(&fb->bins);
+    job_cache_free(&fb->job_cache);
+    free(fb->replay_jobs);
+    free(fb->plot_points);
+    free(fb->plot_tile_start);
+    traversal_plan_free(&fb->traversal_plan);
+    *fb = (Framebuffer){0};
+}
+
+void framebuffer_read_argb(const Framebuffer *fb, Recti area, uint32_t *dst, int dst_stride)
+{
+    const PixelFormatKernels *kernels = pixel_format_kernels(fb->format);
+    for (int y = area.top_left.y; y < area.bottom_right.y; y++, dst += dst_stride)
+        kernels->unpack(dst, framebuffer_address(fb, area.top_left.x, y), area.bottom_right.x - area.top_left.x);
+}
+
+void framebuffer_mark_dirty(Framebuffer *fb, Recti area)
+{
+    dirty_rects_add(&fb->dirty, recti_clamp(area, fb->width, fb->height));
+}
+
+const DirtyRects *framebuffer_dirty(Framebuffer *fb)
+{
+    // Fold runs of marked tiles into rows of dirty areas
+    for (int ty = 0; ty < fb->dirty_tiles_y; ty++)
+    {
+        uint8_t *row = &fb->dirty_tiles[ty * fb->dirty_tiles_x];
+        int tx = 0;
+        while (tx < fb->dirty_tiles_x)
+        {
+            if (!row[tx])
+            {
+                tx++;
+                continue;
+            }
+
+            int start = tx;
+            while (tx < fb->dirty_tiles_x && row[tx])
+                row[tx++] = 0;
+
+            framebuffer_mark_dirty(fb, (Recti){{start * TILE_SIZE, ty * TILE_SIZE}, {tx * TILE_SIZE, (ty + 1) * TILE_SIZE}});
+        }
+    }
+
+    return &fb->dirty;
+}
+
+void framebuffer_clear_dirty(Framebuffer *fb)
+{
+    if (fb->dirty_tiles)
+        memset(fb->dirty_tiles, 0, (size_t)fb->dirty_tiles_x * fb->dirty_tiles_y);
+    dirty_rects_clear(&fb->dirty);
+}
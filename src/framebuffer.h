@@ -0,0 +1,147 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "drawjob.h"
+#include "tile_bins.h"
+#include "occlusion.h"
+#include "dirty_rects.h"
+#include "worker_pool.h"
+#include "draw_queue.h"
+#include "job_cache.h"
+#include "plot.h"
+#include "traversal.h"
+#include "pixel_format.h"
+
+/// @brief A render target. Every draw and queue function takes the framebuffer to draw to,
+/// and framebuffers share no state, so separate framebuffers can be drawn to from separate threads at the same time
+/// @param width Width in pixels
+/// @param height Height in pixels
+/// @param stride Distance between the start of two rows, in pixels
+/// @param pixels ARGB pixels. Pixel (x,y) is `pixels[y * stride + x]`. NULL unless `format` is PIXEL_FORMAT_ARGB8888
+/// @param format Format the pixels are stored in, see framebuffer_init_format
+/// @param packed_pixels Pixels of the other formats, see framebuffer_address
+/// @param dirty Areas drawn to since the dirty areas were last cleared. Pixels drawn with draw_pixel, safe_draw_pixel and the plot functions
+/// are tracked per TILE_SIZE tile in `dirty_tiles` and folded into `dirty` by framebuffer_dirty
+/// @param pool Worker pool running the draw functions. NULL uses OpenMP
+/// @param occlusion_culling Set to skip the parts of jobs that later opaque jobs overwrite, see drawjob_is_opaque.
+/// Applies to draw_multiple_bounded_safe and process_queue_safe, and is tracked in 8x8 pixel cells
+/// @param occlusion_stats Counters of the occlusion culling. Reset by setting to zero
+/// @param job_cache Pixels of cacheable jobs, used by draw_multiple_bounded and draw_multiple_bounded_safe
+/// and so by the queue. Holds JOB_CACHE_DEFAULT_BUDGET bytes unless changed with job_cache_set_budget
+/// @param traversal Blocks, order and scheduling used by draw and draw_bounded. Zero draws bands of rows
+typedef struct Framebuffer
+{
+    int width;
+    int height;
+    int stride;
+    uint32_t *pixels;
+    PixelFormat format;
+    void *packed_pixels;
+    int owns_pixels;
+    DrawQueue queue;
+    TileBins bins;
+    DirtyRects dirty;
+    uint8_t *dirty_tiles;
+    int dirty_tiles_x;
+    int dirty_tiles_y;
+    WorkerPool *pool;
+    int *task_offsets;
+    int task_offsets_capacity;
+    int occlusion_culling;
+    OcclusionStats occlusion_stats;
+    JobCache job_cache;
+    DrawJob *replay_jobs;
+    int replay_capacity;
+    PlotPoint *plot_points;
+    int plot_capacity;
+    int *plot_tile_start;
+    Traversal traversal;
+    TraversalPlan traversal_plan;
+} Framebuffer;
+
+/// @brief Creates a framebuffer with its own pixel storage, initialized to black. Needs no window and no call to init_sdl,
+/// so it can be used for offscreen rendering
+/// @param fb Framebuffer to initialize
+/// @param width Width in pixels
+/// @param height Height in pixels
+/// @return 0 for success and 1 for failure
+int framebuffer_init(Framebuffer *fb, int width, int height);
+
+/// @brief Creates a framebuffer with its own pixel storage in a smaller pixel format, initialized to black.
+/// Jobs draw the same as into ARGB framebuffers, and every pixel is converted to the format once when it is stored.
+/// Stored colors lose alpha and precision, so blended jobs blend with the converted pixels.
+/// `pixels` and framebuffer_pixel are only usable for PIXEL_FORMAT_ARGB8888, use framebuffer_address or framebuffer_read_argb otherwise
+/// @param fb Framebuffer to initialize
+/// @param width Width in pixels
+/// @param height Height in pixels
+/// @param format Format to store the pixels in
+/// @return 0 for success and 1 for failure
+int framebuffer_init_format(Framebuffer *fb, int width, int height, PixelFormat format);
+
+/// @brief Creates a framebuffer drawing to caller owned pixels. The pixels are not freed by framebuffer_destroy
+/// @param fb Framebuffer to initialize
+/// @param pixels Pixel storage of at least `stride * height` pixels
+/// @param width Width in pixels
+/// @param height Height in pixels
+/// @param stride Distance between the start of two rows, in pixels
+/// @return 0 for success and 1 for failure
+int framebuffer_wrap(Framebuffer *fb, uint32_t *pixels, int width, int height, int stride);
+
+/// @brief Frees everything owned by the framebuffer
+/// @param fb Framebuffer to destroy
+void framebuffer_destroy(Framebuffer *fb);
+
+/// @brief Records an area as changed. The draw functions do this themselves,
+/// so this is only needed after writing to `pixels` directly. Not thread safe
+/// @param fb Framebuffer that changed
+/// @param area Changed area. Clamped to the framebuffer
+void framebuffer_mark_dirty(Framebuffer *fb, Recti area);
+
+/// @brief Gives the areas changed since framebuffer_clear_dirty was last called
+/// @param fb Framebuffer to check
+/// @return Merged list of changed areas. Valid until the framebuffer is drawn to again
+const DirtyRects *framebuffer_dirty(Framebuffer *fb);
+
+/// @brief Marks the whole framebuffer as unchanged
+/// @param fb Framebuffer to clear
+void framebuffer_clear_dirty(Framebuffer *fb);
+
+/// @brief Pointer to a pixel of the framebuffer. Does no bounds checking
+/// @param fb Framebuffer
+/// @param x Pixel x-coordinate
+/// @param y Pixel y-coordinate
+/// @return Pointer to pixel (x,y)
+static inline uint32_t *framebuffer_pixel(const Framebuffer *fb, int x, int y)
+{
+    return fb->pixels + (size_t)y * fb->stride + x;
+}
+
+/// @brief Address of a pixel in any pixel format. Does no bounds checking
+/// @param fb Framebuffer
+/// @param x Pixel x-coordinate
+/// @param y Pixel y-coordinate
+/// @return Address of pixel (x,y), pixel_format_bytes of the framebuffer's format long
+static inline void *framebuffer_address(const Framebuffer *fb, int x, int y)
+{
+    if (fb->format == PIXEL_FORMAT_ARGB8888)
+        return framebuffer_pixel(fb, x, y);
+    return (uint8_t *)fb->packed_pixels + ((size_t)y * fb->stride + x) * pixel_format_bytes(fb->format);
+}
+
+/// @brief Copies an area of the framebuffer out as ARGB pixels, converting them from the framebuffer's format
+/// @param fb Framebuffer to read
+/// @param area Area to read, inside the framebuffer
+/// @param dst Receives the pixel at the top left of `area`
+/// @param dst_stride Distance between the start of two rows of `dst`, in pixels
+void framebuffer_read_argb(const Framebuffer *fb, Recti area, uint32_t *dst, int dst_stride);
+
+/// @brief Records that a single pixel changed. Safe to call from multiple threads at once.
+/// Does no bounds checking
+/// @param fb Framebuffer that changed
+/// @param x Pixel x-coordinate
+/// @param y Pixel y-coordinate
+static inline void framebuffer_mark_pixel_dirty(Framebuffer *fb, int x, int y)
+{
+    uint8_t *tile = &fb->dirty_tiles[(y / TILE_SIZE) * fb->dirty_tiles_x + x / TILE_SIZE];
+    if (!__atomic_load_n(tile, __ATOMIC_RELAXED))
+        __atomic_store_n(tile, 1, __ATOMIC_RELAXED);
+}
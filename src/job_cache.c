@@ -0,0 +1,239 @@
+#include "../include/renderer.h"
+
+#define JOB_CACHE_FIRST_CAPACITY 64
+
+int job_cache_init(JobCache *cache, size_t budget)
+{
+    *cache = (JobCache){0};
+    cache->budget = budget;
+    cache->free_head = -1;
+    cache->lru_head = -1;
+    cache->lru_tail = -1;
+    cache->bucket_count = JOB_CACHE_FIRST_CAPACITY * 2;
+    cache->buckets = malloc(sizeof(int) * cache->bucket_count);
+    if (!cache->buckets)
+        return 1;
+
+    for (int b = 0; b < cache->bucket_count; b++)
+        cache->buckets[b] = -1;
+    return 0;
+}
+
+static void lru_unlink(JobCache *cache, int index)
+{
+    JobCacheEntry *entry = &cache->entries[index];
+    if (entry->lru_prev >= 0)
+        cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+    else
+        cache->lru_head = entry->lru_next;
+    if (entry->lru_next >= 0)
+        cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    else
+        cache->lru_tail = entry->lru_prev;
+}
+
+static void lru_push_front(JobCache *cache, int index)
+{
+    JobCacheEntry *entry = &cache->entries[index];
+    entry->lru_prev = -1;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head >= 0)
+        cache->entries[cache->lru_head].lru_prev = index;
+    cache->lru_head = index;
+    if (cache->lru_tail < 0)
+        cache->lru_tail = index;
+}
+
+static void remove_entry(JobCache *cache, int index)
+{
+    JobCacheEntry *entry = &cache->entries[index];
+    int *link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != index)
+        link = &cache->entries[*link].hash_next;
+    *link = entry->hash_next;
+
+    lru_unlink(cache, index);
+    free(entry->pixels);
+    cache->bytes -= entry->bytes;
+    cache->count--;
+
+    *entry = (JobCacheEntry){.hash_next = cache->free_head};
+    cache->free_head = index;
+}
+
+// Evicts least recently used entries not needed by the current batch until `needed` more bytes fit
+static int make_room(JobCache *cache, size_t needed)
+{
+    while (cache->bytes + needed > cache->budget)
+    {
+        int index = cache->lru_tail;
+        if (index < 0 || cache->entries[index].last_used == cache->batch)
+            return 1;
+
+        remove_entry(cache, index);
+        cache->stats.evictions++;
+    }
+    return 0;
+}
+
+void job_cache_set_budget(JobCache *cache, size_t budget)
+{
+    cache->budget = budget;
+    while (cache->bytes > cache->budget && cache->lru_tail >= 0)
+    {
+        remove_entry(cache, cache->lru_tail);
+        cache->stats.evictions++;
+    }
+}
+
+void job_cache_clear(JobCache *cache)
+{
+    while (cache->lru_tail >= 0)
+        remove_entry(cache, cache->lru_tail);
+}
+
+void job_cache_invalidate(JobCache *cache, const DrawJob *job)
+{
+    for (int i = 0; i < cache->capacity; i++)
+    {
+        const JobCacheKey *key = &cache->entries[i].key;
+        if (cache->entries[i].pixels && key->callback == job->callback &&
+            key->span_callback == job->span_callback && key->userdata == job->userdata)
+            remove_entry(cache, i);
+    }
+}
+
+void job_cache_free(JobCache *cache)
+{
+    for (int i = 0; i < cache->capacity; i++)
+        free(cache->entries[i].pixels);
+    free(cache->entries);
+    free(cache->buckets);
+    *cache = (JobCache){0};
+}
+
+int job_cache_supports(const DrawJob *job)
+{
+    return job->blend != BLEND_OPAQUE || drawjob_is_opaque(job);
+}
+
+void job_cache_begin_batch(JobCache *cache)
+{
+    cache->batch++;
+}
+
+static uint64_t hash_key(const JobCacheKey *key)
+{
+    uint64_t words[(sizeof(JobCacheKey) + 7) / 8] = {0};
+    uint64_t hash = 14695981039346656037ull;
+    memcpy(words, key, sizeof(JobCacheKey));
+
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+    {
+        hash ^= words[i];
+        hash *= 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// A slot for a new entry, growing the slot array and the hash table when full
+static int take_slot(JobCache *cache)
+{
+    if (cache->free_head < 0)
+    {
+        int capacity = cache->capacity ? cache->capacity * 2 : JOB_CACHE_FIRST_CAPACITY;
+        JobCacheEntry *entries = realloc(cache->entries, sizeof(JobCacheEntry) * capacity);
+        if (!entries)
+            return -1;
+
+        cache->entries = entries;
+        for (int i = capacity - 1; i >= cache->capacity; i--)
+        {
+            entries[i] = (JobCacheEntry){.hash_next = cache->free_head};
+            cache->free_head = i;
+        }
+        cache->capacity = capacity;
+    }
+
+    // Chains stay short with at most one entry per two buckets
+    if (cache->count * 2 >= cache->bucket_count)
+    {
+        int bucket_count = cache->bucket_count * 2;
+        int *buckets = malloc(sizeof(int) * bucket_count);
+        if (buckets)
+        {
+            for (int b = 0; b < bucket_count; b++)
+                buckets[b] = -1;
+            for (int i = cache->lru_head; i >= 0; i = cache->entries[i].lru_next)
+            {
+                int *bucket = &buckets[cache->entries[i].hash & (bucket_count - 1)];
+                cache->entries[i].hash_next = *bucket;
+                *bucket = i;
+            }
+            free(cache->buckets);
+            cache->buckets = buckets;
+            cache->bucket_count = bucket_count;
+        }
+    }
+
+    int index = cache->free_head;
+    cache->free_head = cache->entries[index].hash_next;
+    return index;
+}
+
+JobCacheEntry *job_cache_lookup(JobCache *cache, const DrawJob *job, Recti area, int *added)
+{
+    JobCacheKey key;
+    memset(&key, 0, sizeof(key));
+    key.callback = job->callback;
+    key.span_callback = job->span_callback;
+    key.userdata = job->userdata;
+    key.kind = job->kind;
+    key.blend = job->blend;
+    key.area = job->area;
+    key.version = job->version;
+    memcpy(key.params, &job->params, sizeof(key.params));
+    if (job->transform.active)
+        key.transform = job->transform;
+
+    uint64_t hash = hash_key(&key);
+    *added = 0;
+
+    for (int i = cache->buckets[hash & (cache->bucket_count - 1)]; i >= 0; i = cache->entries[i].hash_next)
+    {
+        JobCacheEntry *entry = &cache->entries[i];
+        if (entry->hash == hash && !memcmp(&entry->key, &key, sizeof(key)) && !memcmp(&entry->area, &area, sizeof(area)))
+        {
+            entry->last_used = cache->batch;
+            lru_unlink(cache, i);
+            lru_push_front(cache, i);
+            cache->stats.hits++;
+            return entry;
+        }
+    }
+
+    size_t bytes = sizeof(uint32_t) * (size_t)(area.bottom_right.x - area.top_left.x) * (area.bottom_right.y - area.top_left.y);
+    if (make_room(cache, bytes))
+        return NULL;
+
+    // Blended jobs are drawn onto transparent pixels
+    uint32_t *pixels = job->blend != BLEND_OPAQUE ? calloc(bytes, 1) : malloc(bytes);
+    int index = pixels ? take_slot(cache) : -1;
+    if (index < 0)
+    {
+        free(pixels);
+        return NULL;
+    }
+
+    JobCacheEntry *entry = &cache->entries[index];
+    int *bucket = &cache->buckets[hash & (cache->bucket_count - 1)];
+    *entry = (JobCacheEntry){key, hash, area, pixels, bytes, cache->batch, *bucket, -1, -1};
+    *bucket = index;
+    lru_push_front(cache, index);
+    cache->bytes += bytes;
+    cache->count++;
+    cache->stats.misses++;
+    *added = 1;
+    return entry;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include "drawjob.h"
+
+/// @brief Memory a framebuffer's job cache may use for pixels unless changed with job_cache_set_budget
+#define JOB_CACHE_DEFAULT_BUDGET (16 * 1024 * 1024)
+
+/// @brief Everything that tells cacheable jobs apart. Built zeroed, so keys compare with memcmp
+typedef struct JobCacheKey
+{
+    uint32_t (*callback)(int x, int y, void *userdata);
+    void (*span_callback)(int y, int x0, int x1, uint32_t *dst, void *userdata);
+    void *userdata;
+    DrawJobKind kind;
+    BlendMode blend;
+    Recti area;
+    uint32_t version;
+    unsigned char params[sizeof(((DrawJob *)0)->params)];
+    JobTransform transform;
+} JobCacheKey;
+
+/// @brief Drawn pixels of one job. Slots not in use are chained through `hash_next` in the free list
+typedef struct JobCacheEntry
+{
+    JobCacheKey key;
+    uint64_t hash;
+    Recti area;
+    uint32_t *pixels;
+    size_t bytes;
+    uint64_t last_used;
+    int hash_next;
+    int lru_prev;
+    int lru_next;
+} JobCacheEntry;
+
+/// @brief Counters of a job cache since it was created
+/// @param hits Jobs copied from the cache
+/// @param misses Jobs drawn into the cache
+/// @param evictions Entries dropped to stay within the budget
+/// @param uncacheable Cacheable jobs drawn without the cache, because they may leave pixels unwritten or don't fit in the budget
+typedef struct JobCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t uncacheable;
+} JobCacheStats;
+
+/// @brief Least recently used cache of the pixels drawn by cacheable jobs, bounded by a memory budget.
+/// Entries used by the batch being drawn are never evicted
+/// @param entries Entry slots
+/// @param buckets First entry of every hash chain, -1 if empty
+/// @param lru_head Most recently used entry
+/// @param lru_tail Least recently used entry, evicted first
+/// @param budget Maximum bytes of cached pixels
+/// @param bytes Bytes of cached pixels
+/// @param batch Current batch, entries used in it have `last_used == batch`
+typedef struct JobCache
+{
+    JobCacheEntry *entries;
+    int capacity;
+    int count;
+    int free_head;
+    int *buckets;
+    int bucket_count;
+    int lru_head;
+    int lru_tail;
+    size_t budget;
+    size_t bytes;
+    uint64_t batch;
+    JobCacheStats stats;
+} JobCache;
+
+/// @brief Creates an empty cache
+/// @param cache Cache to initialize
+/// @param budget Maximum bytes of cached pixels
+/// @return 0 on success, 1 if allocation failed
+int job_cache_init(JobCache *cache, size_t budget);
+
+/// @brief Frees the cache and all cached pixels
+/// @param cache Cache to free
+void job_cache_free(JobCache *cache);
+
+/// @brief Changes the memory budget, evicting least recently used entries until the cache fits
+/// @param cache Cache to change
+/// @param budget Maximum bytes of cached pixels. 0 disables caching
+void job_cache_set_budget(JobCache *cache, size_t budget);
+
+/// @brief Drops every entry drawn by a job with the same callbacks and userdata as `job`, whatever its area or version.
+/// Must not be called while drawing
+/// @param cache Cache to invalidate
+/// @param job Job whose entries to drop
+void job_cache_invalidate(JobCache *cache, const DrawJob *job);
+
+/// @brief Drops every entry. Must not be called while drawing
+/// @param cache Cache to clear
+void job_cache_clear(JobCache *cache);
+
+/// @brief Whether a job's pixels can be cached: it must write every pixel of its area, or blend,
+/// since blended jobs start from transparent pixels
+/// @param job Job to check
+/// @return 1 if the job can be cached
+int job_cache_supports(const DrawJob *job);
+
+/// @brief Starts a batch of lookups. Entries found or added until the next batch are kept from eviction
+/// @param cache Cache to use
+void job_cache_begin_batch(JobCache *cache);
+
+/// @brief Finds the entry of a job, or adds an empty one for it to be drawn into
+/// @param cache Cache to search
+/// @param job Cacheable job
+/// @param area The job's area clamped to the framebuffer. Must not be empty
+/// @param added Set to 1 if a new entry was added, whose pixels the caller must draw, and 0 if it was found
+/// @return The entry, or NULL if the job doesn't fit in the budget
+JobCacheEntry *job_cache_lookup(JobCache *cache, const DrawJob *job, Recti area, int *added);
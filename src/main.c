@@ -1,16 +1,39 @@
 #include "../include/renderer.h"
+#include "profile.c"
+#include "span_kernels.c"
+#include "plot.c"
 #include "text.c"
 #include "drawjob.c"
 #include "drawjob_modifier.c"
-
-static uint32_t buffer[WIDTH * HEIGHT];
-static SDL_mutex *pixel_mutex = NULL;
-static DrawJob *draw_queue = NULL;
-static int draw_queue_length = 0;
-static int draw_queue_capacity = 0;
+#include "primitives.c"
+#include "tile_bins.c"
+#include "spatial_index.c"
+#include "occlusion.c"
+#include "dirty_rects.c"
+#include "frame_ring.c"
+#include "worker_pool.c"
+#include "draw_queue.c"
+#include "job_cache.c"
+#include "traversal.c"
+#include "pixel_format.c"
+#include "png.c"
+#include "capture.c"
+#include "asset_pack.c"
+#include "scene.c"
+
+// Rows drawn by one task. Small enough for stealing to balance expensive callbacks, large enough to amortize scheduling
+#define ROWS_PER_TASK 8
+#include "framebuffer.c"
 
 int init_sdl(SDLContext *ctx)
 {
+    return init_sdl_format(ctx, PIXEL_FORMAT_ARGB8888);
+}
+
+int init_sdl_format(SDLContext *ctx, PixelFormat format)
+{
+    PROFILE_SCOPE("init_sdl");
+
     if (SDL_Init(SDL_INIT_VIDEO) != 0)
         return 1;
 
@@ -23,190 +46,600 @@ int init_sdl(SDLContext *ctx)
     if (!ctx->window)
         return 1;
 
+    // The texture format follows the framebuffer's
+    if (framebuffer_init_format(&ctx->framebuffer, WIDTH, HEIGHT, format) != 0)
+        return 1;
+
+    ctx->renderer = NULL;
+    ctx->texture = NULL;
+    if (create_sdl_renderer(ctx) != 0)
+        return 1;
+
+    ctx->skip_unchanged_frames = 0;
+    ctx->upload_stats = (UploadStats){0};
+    return 0;
+}
+
+void shutdown_sdl(SDLContext *ctx)
+{
+    PROFILE_SCOPE("shutdown_sdl");
+
+    framebuffer_destroy(&ctx->framebuffer);
+    destroy_sdl_renderer(ctx);
+    SDL_DestroyWindow(ctx->window);
+    SDL_Quit();
+}
+
+int create_sdl_renderer(SDLContext *ctx)
+{
+    PROFILE_SCOPE("create_sdl_renderer");
+
     ctx->renderer = SDL_CreateRenderer(ctx->window, -1, SDL_RENDERER_ACCELERATED);
     if (!ctx->renderer)
         return 1;
 
+    // RGB565 is uploaded as it is. RGB332 is expanded to ARGB while uploading, few renderers take it directly
     ctx->texture = SDL_CreateTexture(
         ctx->renderer,
-        SDL_PIXELFORMAT_ARGB8888,
+        ctx->framebuffer.format == PIXEL_FORMAT_RGB565 ? SDL_PIXELFORMAT_RGB565 : SDL_PIXELFORMAT_ARGB8888,
         SDL_TEXTUREACCESS_STREAMING,
         WIDTH, HEIGHT);
 
     if (!ctx->texture)
+    {
+        destroy_sdl_renderer(ctx);
         return 1;
-
-    pixel_mutex = SDL_CreateMutex();
-    if (!pixel_mutex)
-        return 1;
+    }
 
     return 0;
 }
 
-void shutdown_sdl(SDLContext *ctx)
+void destroy_sdl_renderer(SDLContext *ctx)
 {
-    SDL_DestroyMutex(pixel_mutex);
-    SDL_DestroyTexture(ctx->texture);
-    SDL_DestroyRenderer(ctx->renderer);
-    SDL_DestroyWindow(ctx->window);
-    SDL_Quit();
+    PROFILE_SCOPE("destroy_sdl_renderer");
+
+    if (ctx->texture)
+        SDL_DestroyTexture(ctx->texture);
+    if (ctx->renderer)
+        SDL_DestroyRenderer(ctx->renderer);
+    ctx->texture = NULL;
+    ctx->renderer = NULL;
 }
 
-void draw_pixel(int x, int y, uint32_t color)
+void draw_pixel(Framebuffer *fb, int x, int y, uint32_t color)
 {
-    if ((unsigned)x >= WIDTH || (unsigned)y >= HEIGHT)
+    if ((unsigned)x >= (unsigned)fb->width || (unsigned)y >= (unsigned)fb->height)
         return;
 
-    buffer[y * WIDTH + x] = color;
+    if (fb->format == PIXEL_FORMAT_ARGB8888)
+        *framebuffer_pixel(fb, x, y) = color;
+    else
+        pixel_format_store(fb->format, framebuffer_address(fb, x, y), color);
+    framebuffer_mark_pixel_dirty(fb, x, y);
+    PROFILE_COUNT(1, 0);
 }
 
-void safe_draw_pixel(int x, int y, uint32_t color)
+void safe_draw_pixel(Framebuffer *fb, int x, int y, uint32_t color)
 {
-    if ((unsigned)x >= WIDTH || (unsigned)y >= HEIGHT)
+    if ((unsigned)x >= (unsigned)fb->width || (unsigned)y >= (unsigned)fb->height)
         return;
 
-    SDL_LockMutex(pixel_mutex);
-    buffer[y * WIDTH + x] = color;
-    SDL_UnlockMutex(pixel_mutex);
+    pixel_format_store(fb->format, framebuffer_address(fb, x, y), color);
+    framebuffer_mark_pixel_dirty(fb, x, y);
+    PROFILE_COUNT(1, 0);
 }
 
-void update(SDLContext *ctx)
+void safe_plot_pixel(Framebuffer *fb, int x, int y, uint32_t color, PlotOp op)
+{
+    if ((unsigned)x >= (unsigned)fb->width || (unsigned)y >= (unsigned)fb->height)
+        return;
+
+    pixel_format_plot_atomic(fb->format, framebuffer_address(fb, x, y), color, op);
+    framebuffer_mark_pixel_dirty(fb, x, y);
+    PROFILE_COUNT(1, 0);
+}
+
+void present_framebuffer(SDLContext *ctx, Framebuffer *fb, const DirtyRects *dirty)
 {
-    SDL_UpdateTexture(ctx->texture, NULL, buffer, WIDTH * sizeof(uint32_t));
+    PROFILE_SCOPE("present_framebuffer");
+    UploadStats *stats = &ctx->upload_stats;
+
+    stats->frames++;
+    stats->bytes_last_frame = 0;
+
+    if (dirty->count == 0 && ctx->skip_unchanged_frames)
+    {
+        stats->frames_skipped++;
+        return;
+    }
+
+    for (int i = 0; i < dirty->count; i++)
+    {
+        PROFILE_SCOPE("SDL_UpdateTexture");
+        Recti area = dirty->rects[i];
+        SDL_Rect rect = {
+            area.top_left.x, area.top_left.y,
+            area.bottom_right.x - area.top_left.x, area.bottom_right.y - area.top_left.y};
+
+        int bytes = pixel_format_bytes(fb->format);
+        if (fb->format == PIXEL_FORMAT_RGB332)
+        {
+            // The only conversion of the frame, straight into the texture's memory
+            void *texture_pixels;
+            int pitch;
+            if (SDL_LockTexture(ctx->texture, &rect, &texture_pixels, &pitch) != 0)
+                continue;
+            for (int y = 0; y < rect.h; y++)
+                pixel_format_kernels(fb->format)->unpack((uint32_t *)((uint8_t *)texture_pixels + (size_t)y * pitch),
+                                                         framebuffer_address(fb, rect.x, rect.y + y), rect.w);
+            SDL_UnlockTexture(ctx->texture);
+        }
+        else
+            SDL_UpdateTexture(ctx->texture, &rect, framebuffer_address(fb, rect.x, rect.y), fb->stride * bytes);
+        stats->bytes_last_frame += (uint64_t)rect.w * rect.h * bytes;
+    }
+
+    stats->bytes_total += stats->bytes_last_frame;
+
+    PROFILE_SCOPE("SDL_RenderPresent");
     SDL_RenderClear(ctx->renderer);
     SDL_RenderCopy(ctx->renderer, ctx->texture, NULL, NULL);
     SDL_RenderPresent(ctx->renderer);
 }
 
-void draw(DrawJob job)
+void update(SDLContext *ctx)
+{
+    Framebuffer *fb = &ctx->framebuffer;
+
+    {
+        PROFILE_SCOPE("update");
+        present_framebuffer(ctx, fb, framebuffer_dirty(fb));
+        framebuffer_clear_dirty(fb);
+    }
+    profile_end_frame();
+}
+
+// Runs task(context, i) for i from 0 up to count on the framebuffer's worker pool, or with OpenMP without one
+static void run_tasks(Framebuffer *fb, int count, void (*task)(void *, int), void *context)
+{
+    // Time not spent in tasks is fork, join and waiting, see ProfileThreadCounters
+    PROFILE_SCOPE("run_tasks");
+
+    if (fb->pool)
+    {
+        worker_pool_run(fb->pool, count, task, context);
+        return;
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < count; i++)
+        task(context, i);
+}
+
+typedef struct PlotTask
+{
+    Framebuffer *fb;
+    PlotOp op;
+} PlotTask;
+
+// Every tile is plotted by one thread, so its pixels need no atomics
+static void plot_tile_task(void *context, int tile)
+{
+    PlotTask *plot = context;
+    Framebuffer *fb = plot->fb;
+    int start = fb->plot_tile_start[tile];
+    int end = fb->plot_tile_start[tile + 1];
+    if (start == end)
+        return;
+
+    PROFILE_TASK();
+    for (int i = start; i < end; i++)
+    {
+        const PlotPoint *point = &fb->plot_points[i];
+        if (fb->format == PIXEL_FORMAT_ARGB8888)
+        {
+            uint32_t *pixel = framebuffer_pixel(fb, point->x, point->y);
+            *pixel = plot_combine(*pixel, point->color, plot->op);
+        }
+        else
+        {
+            void *pixel = framebuffer_address(fb, point->x, point->y);
+            pixel_format_store(fb->format, pixel, plot_combine(pixel_format_load(fb->format, pixel), point->color, plot->op));
+        }
+    }
+    __atomic_store_n(&fb->dirty_tiles[tile], 1, __ATOMIC_RELAXED);
+    PROFILE_COUNT(end - start, 0);
+}
+
+void plot_pixels(Framebuffer *fb, const PlotPoint *points, int count, PlotOp op)
+{
+    PROFILE_SCOPE("plot_pixels");
+    int tiles = fb->dirty_tiles_x * fb->dirty_tiles_y;
+    int *start = fb->plot_tile_start;
+
+    if (count > fb->plot_capacity)
+    {
+        fb->plot_capacity = count * 2;
+        fb->plot_points = realloc(fb->plot_points, fb->plot_capacity * sizeof(PlotPoint));
+    }
+
+    // Counting sort by tile. It is stable, which keeps the plots to every pixel in order
+    memset(start, 0, (tiles + 1) * sizeof(int));
+    for (int i = 0; i < count; i++)
+    {
+        if ((unsigned)points[i].x < (unsigned)fb->width && (unsigned)points[i].y < (unsigned)fb->height)
+            start[(points[i].y / TILE_SIZE) * fb->dirty_tiles_x + points[i].x / TILE_SIZE + 1]++;
+    }
+    for (int t = 0; t < tiles; t++)
+        start[t + 1] += start[t];
+
+    // Scattering moves every start to the next tile's, shifting them back restores them
+    for (int i = 0; i < count; i++)
+    {
+        if ((unsigned)points[i].x < (unsigned)fb->width && (unsigned)points[i].y < (unsigned)fb->height)
+            fb->plot_points[start[(points[i].y / TILE_SIZE) * fb->dirty_tiles_x + points[i].x / TILE_SIZE]++] = points[i];
+    }
+    for (int t = tiles; t > 0; t--)
+        start[t] = start[t - 1];
+    start[0] = 0;
+
+    PlotTask task = {fb, op};
+    run_tasks(fb, tiles, plot_tile_task, &task);
+}
+
+// Draws part of a job into the framebuffer in its pixel format
+static void draw_area(Framebuffer *fb, const DrawJob *job, Recti area)
+{
+    if (fb->format == PIXEL_FORMAT_ARGB8888)
+        drawjob_draw_area(job, area, framebuffer_pixel(fb, area.top_left.x, area.top_left.y), fb->stride);
+    else
+        pixel_format_draw_area(fb->format, job, area, framebuffer_address(fb, area.top_left.x, area.top_left.y), fb->stride);
+}
+
+typedef struct BlocksTask
+{
+    Framebuffer *fb;
+    const DrawJob *job;
+} BlocksTask;
+
+// The area is clamped to the framebuffer when planned, so blocks are drawn without checking pixels against its bounds
+static void draw_blocks_task(void *context, int index)
+{
+    PROFILE_TASK();
+    BlocksTask *blocks = context;
+    const TraversalPlan *plan = &blocks->fb->traversal_plan;
+    int64_t pixels = 0;
+
+    for (int b = plan->task_start[index]; b < plan->task_start[index + 1]; b++)
+    {
+        Recti block = traversal_block_area(plan, b);
+        draw_area(blocks->fb, blocks->job, block);
+        pixels += (int64_t)(block.bottom_right.x - block.top_left.x) * (block.bottom_right.y - block.top_left.y);
+    }
+    PROFILE_COUNT(pixels, 1);
+}
+
+// Draws an area in the blocks and order of fb->traversal
+static void draw_blocks(Framebuffer *fb, const DrawJob *job, Recti area)
 {
-    uint32_t (*callback)(int, int, void *) = job.callback;
-    void *userdata = job.userdata;
+    if (recti_is_empty(area))
+        return;
 
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < HEIGHT; y++)
-        for (int x = 0; x < WIDTH; x++)
-            draw_pixel(x, y, callback(x, y, userdata));
+    traversal_plan_build(&fb->traversal_plan, fb->traversal, area, fb->pool ? fb->pool->thread_count : omp_get_max_threads());
+    BlocksTask blocks = {fb, job};
+    run_tasks(fb, fb->traversal_plan.task_count, draw_blocks_task, &blocks);
 }
 
-void draw_bounded(DrawJob job)
+void draw(Framebuffer *fb, DrawJob job)
 {
-    uint32_t (*callback)(int x, int y, void *) = job.callback;
-    Recti area = job.area;
-    void *userdata = job.userdata;
+    PROFILE_SCOPE("draw");
+    Recti area = {{0, 0}, {fb->width, fb->height}};
+
+    framebuffer_mark_dirty(fb, area);
+    draw_blocks(fb, &job, area);
+}
+
+void draw_bounded(Framebuffer *fb, DrawJob job)
+{
+    PROFILE_SCOPE("draw_bounded");
+    Recti area = recti_clamp(job.area, fb->width, fb->height);
+
+    framebuffer_mark_dirty(fb, area);
+    draw_blocks(fb, &job, area);
+}
+
+typedef struct JobsTask
+{
+    Framebuffer *fb;
+    const DrawJob *jobs;
+    int job_count;
+} JobsTask;
+
+// Tasks are row chunks of every job. fb->task_offsets[j] is the first task of job j
+static void draw_jobs_task(void *context, int index)
+{
+    PROFILE_TASK();
+    JobsTask *jobs = context;
+    const int *offsets = jobs->fb->task_offsets;
+
+    int low = 0;
+    int high = jobs->job_count - 1;
+    while (low < high)
+    {
+        int mid = (low + high + 1) / 2;
+        if (offsets[mid] <= index)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+
+    const DrawJob *job = &jobs->jobs[low];
+    Recti area = recti_clamp(job->area, jobs->fb->width, jobs->fb->height);
     int x0 = area.top_left.x;
-    int y0 = area.top_left.y;
     int x1 = area.bottom_right.x;
-    int y1 = area.bottom_right.y;
-
-    // Clamp to framebuffer bounds
-    if (x0 < 0)
-        x0 = 0;
-    if (y0 < 0)
-        y0 = 0;
-    if (x1 > WIDTH)
-        x1 = WIDTH;
-    if (y1 > HEIGHT)
-        y1 = HEIGHT;
-
-#pragma omp parallel for collapse(2)
-    for (int y = y0; y < y1; y++)
-    {
-        for (int x = x0; x < x1; x++)
+    int y0 = area.top_left.y + (index - offsets[low]) * ROWS_PER_TASK;
+    int y1 = y0 + ROWS_PER_TASK < area.bottom_right.y ? y0 + ROWS_PER_TASK : area.bottom_right.y;
+
+    // safe unless overlapping
+    draw_area(jobs->fb, job, (Recti){{x0, y0}, {x1, y1}});
+    PROFILE_COUNT((int64_t)(y1 - y0) * (x1 - x0), 1);
+}
+
+typedef struct FillTask
+{
+    const DrawJob *job;
+    JobCacheEntry *entry;
+} FillTask;
+
+static void fill_cache_task(void *context, int index)
+{
+    PROFILE_TASK();
+    FillTask *fill = context;
+    Recti area = fill->entry->area;
+    int width = area.bottom_right.x - area.top_left.x;
+    int y0 = area.top_left.y + index * ROWS_PER_TASK;
+    int y1 = y0 + ROWS_PER_TASK < area.bottom_right.y ? y0 + ROWS_PER_TASK : area.bottom_right.y;
+
+    drawjob_draw_area(fill->job, (Recti){{area.top_left.x, y0}, {area.bottom_right.x, y1}},
+                      fill->entry->pixels + (size_t)(y0 - area.top_left.y) * width, width);
+    PROFILE_COUNT((int64_t)(y1 - y0) * width, 1);
+}
+
+// Swaps cacheable jobs for bitmap jobs copying their cached pixels, drawing them into the cache first on a miss.
+// Works on a copy, so the caller's jobs are left alone
+static DrawJob *replay_cached_jobs(Framebuffer *fb, DrawJob *jobs, int job_count)
+{
+    JobCache *cache = &fb->job_cache;
+    int cacheable = 0;
+    for (int j = 0; j < job_count && !cacheable; j++)
+        cacheable = jobs[j].cacheable;
+    if (!cacheable || !cache->budget)
+        return jobs;
+
+    PROFILE_SCOPE("replay_cached_jobs");
+    if (job_count > fb->replay_capacity)
+    {
+        fb->replay_capacity = job_count * 2;
+        fb->replay_jobs = realloc(fb->replay_jobs, fb->replay_capacity * sizeof(DrawJob));
+    }
+    memcpy(fb->replay_jobs, jobs, job_count * sizeof(DrawJob));
+    job_cache_begin_batch(cache);
+
+    for (int j = 0; j < job_count; j++)
+    {
+        DrawJob *job = &fb->replay_jobs[j];
+        Recti area = recti_clamp(job->area, fb->width, fb->height);
+        if (!job->cacheable || recti_is_empty(area))
+            continue;
+
+        int added = 0;
+        JobCacheEntry *entry = job_cache_supports(job) ? job_cache_lookup(cache, job, area, &added) : NULL;
+        if (!entry)
         {
-            uint32_t color = callback(x, y, userdata);
-            draw_pixel(x, y, color);
+            cache->stats.uncacheable++;
+            continue;
         }
+
+        if (added)
+        {
+            FillTask fill = {job, entry};
+            run_tasks(fb, (area.bottom_right.y - area.top_left.y + ROWS_PER_TASK - 1) / ROWS_PER_TASK, fill_cache_task, &fill);
+        }
+
+        Bitmap pixels = {area.bottom_right.x - area.top_left.x, area.bottom_right.y - area.top_left.y, entry->pixels};
+        BlendMode blend = job->blend;
+        *job = create_bitmap_draw_job(pixels, area.top_left.x, area.top_left.y);
+        job->blend = blend;
     }
+    return fb->replay_jobs;
 }
 
-void draw_multiple_bounded(DrawJob *jobs, int job_count)
+typedef struct TilesTask
 {
-#pragma omp parallel for
-    for (int j = 0; j < job_count; j++)
+    Framebuffer *fb;
+    const DrawJob *jobs;
+} TilesTask;
+
+// Draws part of a binned job. Primitives reuse the setup done while binning
+static void draw_binned_area(Framebuffer *fb, const DrawJob *job, const PrimitiveSetup *setup, Recti area)
+{
+    if (setup && fb->format == PIXEL_FORMAT_ARGB8888)
+        primitive_setup_draw_area(setup, area, framebuffer_pixel(fb, area.top_left.x, area.top_left.y), fb->stride, job->blend);
+    else
+        draw_area(fb, job, area);
+}
+
+// Draws the part of `area` inside the visible cells, trimmed per row of cells to the first and last visible cell
+static int64_t draw_visible_cells(Framebuffer *fb, const DrawJob *job, const PrimitiveSetup *setup, Recti tile, Recti area,
+                                  uint64_t visible)
+{
+    int64_t drawn = 0;
+
+    for (int cy = 0; cy < 8; cy++)
     {
-        Recti area = jobs[j].area;
-        uint32_t (*callback)(int, int, void *) = jobs[j].callback;
-
-        int x0 = area.top_left.x;
-        int y0 = area.top_left.y;
-        int x1 = area.bottom_right.x;
-        int y1 = area.bottom_right.y;
-
-        // Clamp
-        if (x0 < 0)
-            x0 = 0;
-        if (y0 < 0)
-            y0 = 0;
-        if (x1 > WIDTH)
-            x1 = WIDTH;
-        if (y1 > HEIGHT)
-            y1 = HEIGHT;
-
-        for (int y = y0; y < y1; y++)
+        unsigned row = (unsigned)(visible >> (8 * cy)) & 0xFF;
+        if (!row)
+            continue;
+
+        int cell_y = tile.top_left.y + cy * OCCLUSION_CELL_SIZE;
+        int y0 = area.top_left.y > cell_y ? area.top_left.y : cell_y;
+        int y1 = area.bottom_right.y < cell_y + OCCLUSION_CELL_SIZE ? area.bottom_right.y : cell_y + OCCLUSION_CELL_SIZE;
+        int first_x = tile.top_left.x + __builtin_ctz(row) * OCCLUSION_CELL_SIZE;
+        int end_x = tile.top_left.x + (32 - __builtin_clz(row)) * OCCLUSION_CELL_SIZE;
+        int x0 = area.top_left.x > first_x ? area.top_left.x : first_x;
+        int x1 = area.bottom_right.x < end_x ? area.bottom_right.x : end_x;
+
+        if (y0 < y1 && x0 < x1)
         {
-            for (int x = x0; x < x1; x++)
-            {
-                uint32_t color = callback(x, y, jobs[j].userdata);
-                buffer[y * WIDTH + x] = color; // safe unless overlapping
-            }
+            draw_binned_area(fb, job, setup, (Recti){{x0, y0}, {x1, y1}});
+            drawn += (int64_t)(y1 - y0) * (x1 - x0);
         }
     }
+    return drawn;
 }
 
-void draw_multiple_bounded_safe(DrawJob *jobs, int job_count)
+// Tiles never share pixels, and every tile draws its jobs in submission order
+static void draw_tile_task(void *context, int t)
 {
-    for (int j = 0; j < job_count; j++)
+    PROFILE_TASK();
+    TilesTask *tiles = context;
+    Framebuffer *fb = tiles->fb;
+    TileBins *bins = &fb->bins;
+    Recti tile = tile_bins_tile_area(bins, t);
+    OcclusionStats stats = {0};
+
+    if (fb->occlusion_culling)
+        occlusion_cull_tile(bins, tiles->jobs, t);
+
+    for (int i = bins->tile_start[t]; i < bins->tile_start[t + 1]; i++)
     {
-        Recti area = jobs[j].area;
-        uint32_t (*callback)(int, int, void *) = jobs[j].callback;
-        void *userdata = jobs[j].userdata;
-
-        int x0 = area.top_left.x;
-        int y0 = area.top_left.y;
-        int x1 = area.bottom_right.x;
-        int y1 = area.bottom_right.y;
-
-        if (x0 < 0)
-            x0 = 0;
-        if (y0 < 0)
-            y0 = 0;
-        if (x1 > WIDTH)
-            x1 = WIDTH;
-        if (y1 > HEIGHT)
-            y1 = HEIGHT;
-
-        // Parallelize the pixel loop, not the job loop
-#pragma omp parallel for collapse(2)
-        for (int y = y0; y < y1; y++)
+        const DrawJob *job = &tiles->jobs[bins->job_indices[i]];
+        const PrimitiveSetup *setup = tile_bins_setup(bins, tiles->jobs, bins->job_indices[i]);
+
+        int x0 = job->area.top_left.x > tile.top_left.x ? job->area.top_left.x : tile.top_left.x;
+        int y0 = job->area.top_left.y > tile.top_left.y ? job->area.top_left.y : tile.top_left.y;
+        int x1 = job->area.bottom_right.x < tile.bottom_right.x ? job->area.bottom_right.x : tile.bottom_right.x;
+        int y1 = job->area.bottom_right.y < tile.bottom_right.y ? job->area.bottom_right.y : tile.bottom_right.y;
+
+        if (!fb->occlusion_culling)
         {
-            for (int x = x0; x < x1; x++)
-            {
-                buffer[y * WIDTH + x] = callback(x, y, userdata);
-            }
+            draw_binned_area(fb, job, setup, (Recti){{x0, y0}, {x1, y1}});
+            PROFILE_COUNT((int64_t)(x1 - x0) * (y1 - y0), 1);
+            continue;
         }
+
+        int64_t pixels = (int64_t)(x1 - x0) * (y1 - y0);
+        int64_t drawn = bins->cell_masks[i] ? draw_visible_cells(fb, job, setup, tile, (Recti){{x0, y0}, {x1, y1}}, bins->cell_masks[i]) : 0;
+        stats.job_tiles++;
+        stats.job_tiles_culled += drawn == 0;
+        stats.pixels_drawn += drawn;
+        stats.pixels_culled += pixels - drawn;
+        PROFILE_COUNT(drawn, drawn > 0);
+    }
+
+    if (fb->occlusion_culling)
+    {
+        __atomic_fetch_add(&fb->occlusion_stats.job_tiles, stats.job_tiles, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&fb->occlusion_stats.job_tiles_culled, stats.job_tiles_culled, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&fb->occlusion_stats.pixels_culled, stats.pixels_culled, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&fb->occlusion_stats.pixels_drawn, stats.pixels_drawn, __ATOMIC_RELAXED);
     }
 }
 
-void enqueue_draw_job(DrawJob job)
+// The in order tile scheduler behind draw_multiple_bounded_safe, for jobs whose cached jobs are already replayed
+static void draw_tiles(Framebuffer *fb, DrawJob *jobs, int job_count)
+{
+    for (int j = 0; j < job_count; j++)
+        framebuffer_mark_dirty(fb, jobs[j].area);
+
+    TileBins *bins = &fb->bins;
+    tile_bins_build(bins, jobs, job_count, fb->width, fb->height);
+
+    TilesTask task = {fb, jobs};
+    run_tasks(fb, bins->tiles_x * bins->tiles_y, draw_tile_task, &task);
+}
+
+void draw_multiple_bounded_safe(Framebuffer *fb, DrawJob *jobs, int job_count)
+{
+    PROFILE_SCOPE("draw_multiple_bounded_safe");
+    draw_tiles(fb, replay_cached_jobs(fb, jobs, job_count), job_count);
+}
+
+void draw_multiple_bounded(Framebuffer *fb, DrawJob *jobs, int job_count)
 {
-    if (draw_queue_length == draw_queue_capacity)
+    PROFILE_SCOPE("draw_multiple_bounded");
+    if (job_count <= 0)
+        return;
+
+    jobs = replay_cached_jobs(fb, jobs, job_count);
+
+    // Blended jobs read the pixels under them, so they need the in order tile scheduler
+    for (int j = 0; j < job_count; j++)
+    {
+        if (jobs[j].blend != BLEND_OPAQUE)
+        {
+            draw_tiles(fb, jobs, job_count);
+            return;
+        }
+    }
+
+    if (job_count + 1 > fb->task_offsets_capacity)
+    {
+        fb->task_offsets_capacity = (job_count + 1) * 2;
+        fb->task_offsets = realloc(fb->task_offsets, fb->task_offsets_capacity * sizeof(int));
+    }
+
+    int task_count = 0;
+    for (int j = 0; j < job_count; j++)
     {
-        draw_queue_capacity = draw_queue_capacity == 0 ? 16 : draw_queue_capacity * 2;
-        draw_queue = realloc(draw_queue, draw_queue_capacity * sizeof(DrawJob));
+        Recti area = recti_clamp(jobs[j].area, fb->width, fb->height);
+        framebuffer_mark_dirty(fb, area);
+
+        fb->task_offsets[j] = task_count;
+        if (!recti_is_empty(area))
+            task_count += (area.bottom_right.y - area.top_left.y + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
     }
+    fb->task_offsets[job_count] = task_count;
 
-    draw_queue[draw_queue_length++] = job;
+    JobsTask task = {fb, jobs, job_count};
+    run_tasks(fb, task_count, draw_jobs_task, &task);
+}
+
+void enqueue_draw_job(Framebuffer *fb, DrawJob job)
+{
+    draw_queue_push(&fb->queue, job);
 }
 
-void process_queue()
+void *enqueue_draw_job_with_data(Framebuffer *fb, DrawJob job, const void *userdata, size_t size)
 {
-    draw_multiple_bounded(draw_queue, draw_queue_length);
-    draw_queue_length = 0;
+    void *copy = draw_queue_alloc(&fb->queue, size);
+    if (!copy)
+        return NULL;
+
+    memcpy(copy, userdata, size);
+    job.userdata = copy;
+    draw_queue_push(&fb->queue, job);
+    return copy;
 }
 
-void process_queue_safe()
+void process_queue(Framebuffer *fb)
 {
-    draw_multiple_bounded_safe(draw_queue, draw_queue_length);
-    draw_queue_length = 0;
+    PROFILE_SCOPE("process_queue");
+    int job_count;
+    DrawJob *jobs = draw_queue_jobs(&fb->queue, &job_count);
+    PROFILE_QUEUE_LENGTH(job_count);
+
+    draw_multiple_bounded(fb, jobs, job_count);
+    draw_queue_reset(&fb->queue);
+}
+
+void process_queue_safe(Framebuffer *fb)
+{
+    PROFILE_SCOPE("process_queue_safe");
+    int job_count;
+    DrawJob *jobs = draw_queue_jobs(&fb->queue, &job_count);
+    PROFILE_QUEUE_LENGTH(job_count);
+
+    draw_multiple_bounded_safe(fb, jobs, job_count);
+    draw_queue_reset(&fb->queue);
 }
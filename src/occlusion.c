@@ -0,0 +1,63 @@
+#include "../include/renderer.h"
+
+_Static_assert(TILE_SIZE == 8 * OCCLUSION_CELL_SIZE, "the cells of a tile must fit in 64 bits");
+
+// Cells [*first, *last] of a tile spanning [tile_start, tile_end) that [start, end) touches or covers
+static void cell_range(int tile_start, int tile_end, int start, int end, int covered_only, int *first, int *last)
+{
+    if (!covered_only)
+    {
+        *first = (start - tile_start) / OCCLUSION_CELL_SIZE;
+        *last = (end - 1 - tile_start) / OCCLUSION_CELL_SIZE;
+        return;
+    }
+
+    // Cells cut off by the edge of the framebuffer only need to be covered up to that edge
+    *first = (start - tile_start + OCCLUSION_CELL_SIZE - 1) / OCCLUSION_CELL_SIZE;
+    if (end >= tile_end)
+        *last = (tile_end - 1 - tile_start) / OCCLUSION_CELL_SIZE;
+    else
+        *last = (end - tile_start) / OCCLUSION_CELL_SIZE - 1;
+}
+
+uint64_t occlusion_cells(Recti tile, Recti area, int covered_only)
+{
+    int x0 = area.top_left.x > tile.top_left.x ? area.top_left.x : tile.top_left.x;
+    int y0 = area.top_left.y > tile.top_left.y ? area.top_left.y : tile.top_left.y;
+    int x1 = area.bottom_right.x < tile.bottom_right.x ? area.bottom_right.x : tile.bottom_right.x;
+    int y1 = area.bottom_right.y < tile.bottom_right.y ? area.bottom_right.y : tile.bottom_right.y;
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+
+    int first_x, last_x, first_y, last_y;
+    cell_range(tile.top_left.x, tile.bottom_right.x, x0, x1, covered_only, &first_x, &last_x);
+    cell_range(tile.top_left.y, tile.bottom_right.y, y0, y1, covered_only, &first_y, &last_y);
+    if (first_x > last_x || first_y > last_y)
+        return 0;
+
+    uint64_t row = ((UINT64_C(1) << (last_x - first_x + 1)) - 1) << first_x;
+    uint64_t cells = 0;
+    for (int cy = first_y; cy <= last_y; cy++)
+        cells |= row << (8 * cy);
+    return cells;
+}
+
+void occlusion_cull_tile(TileBins *bins, const DrawJob *jobs, int tile)
+{
+    Recti tile_area = tile_bins_tile_area(bins, tile);
+    uint64_t covered = 0;
+
+    // Back to front: a job is visible where no later opaque job has covered the cell
+    for (int i = bins->tile_start[tile + 1] - 1; i >= bins->tile_start[tile]; i--)
+    {
+        const DrawJob *job = &jobs[bins->job_indices[i]];
+        Recti area = recti_clamp(job->area, bins->width, bins->height);
+        uint64_t visible = occlusion_cells(tile_area, area, 0) & ~covered;
+
+        bins->cell_masks[i] = visible;
+        if (visible && drawjob_is_opaque(job))
+            covered |= occlusion_cells(tile_area, area, 1);
+        else if (visible)
+            covered |= primitive_covered_cells(job, tile_bins_setup(bins, jobs, bins->job_indices[i]), tile_area);
+    }
+}
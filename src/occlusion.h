@@ -0,0 +1,34 @@
+#pragma once
+#include "drawjob.h"
+#include "tile_bins.h"
+
+/// @brief Side of the square cells coverage is tracked in. A tile has 8 by 8 cells, so its coverage fits one uint64_t
+#define OCCLUSION_CELL_SIZE (TILE_SIZE / 8)
+
+/// @brief Counters of the occlusion culling pass, summed over every processed queue since they were last reset
+/// @param job_tiles Job and tile pairs tested
+/// @param job_tiles_culled Job and tile pairs skipped entirely, because later opaque jobs cover all of the job in the tile
+/// @param pixels_culled Pixels of jobs not drawn because later opaque jobs cover them
+/// @param pixels_drawn Pixels of jobs drawn
+typedef struct OcclusionStats
+{
+    uint64_t job_tiles;
+    uint64_t job_tiles_culled;
+    uint64_t pixels_culled;
+    uint64_t pixels_drawn;
+} OcclusionStats;
+
+/// @brief Gives the cells of a tile an area touches, or with `covered_only` the cells it covers completely.
+/// Bit `cy * 8 + cx` stands for cell (cx,cy) of the tile
+/// @param tile Area of the tile, clamped to the framebuffer
+/// @param area Area to test, clamped to the framebuffer
+/// @param covered_only Only give cells the area covers completely
+/// @return Cell mask
+uint64_t occlusion_cells(Recti tile, Recti area, int covered_only);
+
+/// @brief Walks the jobs of one tile back to front, tracking which cells opaque jobs cover,
+/// and stores in `bins->cell_masks` the cells of every job still visible under the jobs after it
+/// @param bins Built bins
+/// @param jobs The binned jobs
+/// @param tile Tile to cull
+void occlusion_cull_tile(TileBins *bins, const DrawJob *jobs, int tile);
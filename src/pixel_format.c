@@ -0,0 +1,156 @@
+#include "../include/renderer.h"
+
+// ARGB pixels staged per pass of pixel_format_draw_area. Small enough to stay in the L1 cache
+#define PIXEL_FORMAT_STAGING 2048
+
+#define ARGB8888_PACK(c) (c)
+#define ARGB8888_UNPACK(p) (p)
+
+#define RGB565_PACK(c) (uint16_t)((((c) >> 8) & 0xF800) | (((c) >> 5) & 0x07E0) | (((c) >> 3) & 0x001F))
+// Channels are widened by repeating their top bits, so packing an unpacked pixel gives it back unchanged
+#define RGB565_UNPACK(p)                                                                                  \
+    (0xFF000000 | ((((uint32_t)(p) >> 11) * 0x21 >> 2) << 16) | (((((uint32_t)(p) >> 5) & 0x3F) * 0x41 >> 4) << 8) | \
+     (((uint32_t)(p) & 0x1F) * 0x21 >> 2))
+
+#define RGB332_PACK(c) (uint8_t)((((c) >> 16) & 0xE0) | (((c) >> 11) & 0x1C) | (((c) >> 6) & 0x03))
+#define RGB332_UNPACK(p)                                                                                   \
+    (0xFF000000 | ((((uint32_t)(p) >> 5) * 0x49 >> 1) << 16) | (((((uint32_t)(p) >> 2) & 0x07) * 0x49 >> 1) << 8) | \
+     (((uint32_t)(p) & 0x03) * 0x55))
+
+// Row kernels of one format. Plain loops over fixed width pixels, which the compiler vectorizes per format
+#define DEFINE_PIXEL_FORMAT(name, type)                                    \
+    static void pack_##name(void *dst, const uint32_t *src, int count)     \
+    {                                                                      \
+        type *out = dst;                                                   \
+        for (int i = 0; i < count; i++)                                    \
+            out[i] = name##_PACK(src[i]);                                  \
+    }                                                                      \
+    static void unpack_##name(uint32_t *dst, const void *src, int count)   \
+    {                                                                      \
+        const type *in = src;                                              \
+        for (int i = 0; i < count; i++)                                    \
+            dst[i] = name##_UNPACK(in[i]);                                 \
+    }                                                                      \
+    static void fill_##name(void *dst, int count, uint32_t color)          \
+    {                                                                      \
+        type *out = dst;                                                   \
+        type value = name##_PACK(color);                                   \
+        for (int i = 0; i < count; i++)                                    \
+            out[i] = value;                                                \
+    }                                                                      \
+    static const PixelFormatKernels name##_kernels = {sizeof(type), pack_##name, unpack_##name, fill_##name};
+
+DEFINE_PIXEL_FORMAT(ARGB8888, uint32_t)
+DEFINE_PIXEL_FORMAT(RGB565, uint16_t)
+DEFINE_PIXEL_FORMAT(RGB332, uint8_t)
+
+const PixelFormatKernels *pixel_format_kernels(PixelFormat format)
+{
+    switch (format)
+    {
+    case PIXEL_FORMAT_RGB565:
+        return &RGB565_kernels;
+    case PIXEL_FORMAT_RGB332:
+        return &RGB332_kernels;
+    default:
+        return &ARGB8888_kernels;
+    }
+}
+
+uint32_t pixel_format_load(PixelFormat format, const void *pixel)
+{
+    switch (format)
+    {
+    case PIXEL_FORMAT_RGB565:
+        return RGB565_UNPACK(__atomic_load_n((const uint16_t *)pixel, __ATOMIC_RELAXED));
+    case PIXEL_FORMAT_RGB332:
+        return RGB332_UNPACK(__atomic_load_n((const uint8_t *)pixel, __ATOMIC_RELAXED));
+    default:
+        return __atomic_load_n((const uint32_t *)pixel, __ATOMIC_RELAXED);
+    }
+}
+
+void pixel_format_store(PixelFormat format, void *pixel, uint32_t color)
+{
+    switch (format)
+    {
+    case PIXEL_FORMAT_RGB565:
+        __atomic_store_n((uint16_t *)pixel, RGB565_PACK(color), __ATOMIC_RELAXED);
+        break;
+    case PIXEL_FORMAT_RGB332:
+        __atomic_store_n((uint8_t *)pixel, RGB332_PACK(color), __ATOMIC_RELAXED);
+        break;
+    default:
+        __atomic_store_n((uint32_t *)pixel, color, __ATOMIC_RELAXED);
+        break;
+    }
+}
+
+// Compare and swap loop of plot_atomic on pixels of a packed type
+#define PLOT_PACKED(name, type, pixel, color, op)                                                           \
+    do                                                                                                      \
+    {                                                                                                       \
+        type old = __atomic_load_n((type *)(pixel), __ATOMIC_RELAXED);                                      \
+        type combined = name##_PACK(plot_combine(name##_UNPACK(old), color, op));                           \
+        while (combined != old &&                                                                           \
+               !__atomic_compare_exchange_n((type *)(pixel), &old, combined, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) \
+            combined = name##_PACK(plot_combine(name##_UNPACK(old), color, op));                            \
+    } while (0)
+
+void pixel_format_plot_atomic(PixelFormat format, void *pixel, uint32_t color, PlotOp op)
+{
+    if (op == PLOT_REPLACE || format == PIXEL_FORMAT_ARGB8888)
+    {
+        if (format == PIXEL_FORMAT_ARGB8888)
+            plot_atomic(pixel, color, op);
+        else
+            pixel_format_store(format, pixel, color);
+        return;
+    }
+
+    if (format == PIXEL_FORMAT_RGB565)
+        PLOT_PACKED(RGB565, uint16_t, pixel, color, op);
+    else
+        PLOT_PACKED(RGB332, uint8_t, pixel, color, op);
+}
+
+void pixel_format_draw_area(PixelFormat format, const DrawJob *job, Recti area, void *dst, int stride)
+{
+    const PixelFormatKernels *kernels = pixel_format_kernels(format);
+    int width = area.bottom_right.x - area.top_left.x;
+    size_t row_bytes = (size_t)stride * kernels->bytes;
+
+    // Solid fills need no ARGB pixels at all, which makes clears write only the packed pixels
+    if (job->kind == DRAWJOB_SOLID && job->blend == BLEND_OPAQUE && !job->transform.active)
+    {
+        uint8_t *row = dst;
+        for (int y = area.top_left.y; y < area.bottom_right.y; y++, row += row_bytes)
+            kernels->fill(row, width, job->params.color);
+        return;
+    }
+
+    uint32_t staging[PIXEL_FORMAT_STAGING];
+    int reads = !drawjob_is_opaque(job);
+    int columns = width < PIXEL_FORMAT_STAGING ? width : PIXEL_FORMAT_STAGING;
+    int rows = PIXEL_FORMAT_STAGING / columns;
+
+    for (int x0 = area.top_left.x; x0 < area.bottom_right.x; x0 += columns)
+    {
+        int x1 = x0 + columns < area.bottom_right.x ? x0 + columns : area.bottom_right.x;
+        for (int y0 = area.top_left.y; y0 < area.bottom_right.y; y0 += rows)
+        {
+            int y1 = y0 + rows < area.bottom_right.y ? y0 + rows : area.bottom_right.y;
+            uint8_t *first = (uint8_t *)dst + (size_t)(y0 - area.top_left.y) * row_bytes +
+                             (size_t)(x0 - area.top_left.x) * kernels->bytes;
+
+            if (reads)
+            {
+                for (int y = y0; y < y1; y++)
+                    kernels->unpack(staging + (size_t)(y - y0) * (x1 - x0), first + (size_t)(y - y0) * row_bytes, x1 - x0);
+            }
+            drawjob_draw_area(job, (Recti){{x0, y0}, {x1, y1}}, staging, x1 - x0);
+            for (int y = y0; y < y1; y++)
+                kernels->pack(first + (size_t)(y - y0) * row_bytes, staging + (size_t)(y - y0) * (x1 - x0), x1 - x0);
+        }
+    }
+}
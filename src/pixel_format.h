@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include "drawjob.h"
+#include "plot.h"
+
+/// @brief Formats a framebuffer can store its pixels in. Jobs always produce ARGB, packed formats convert it when storing.
+/// PIXEL_FORMAT_ARGB8888 is 32 bit ARGB, the default. PIXEL_FORMAT_RGB565 is 16 bit opaque color with 5 bits of red,
+/// 6 of green and 5 of blue. PIXEL_FORMAT_RGB332 is 8 bit opaque color indexing a fixed palette of 8 reds, 8 greens and 4 blues
+typedef enum PixelFormat
+{
+    PIXEL_FORMAT_ARGB8888 = 0,
+    PIXEL_FORMAT_RGB565,
+    PIXEL_FORMAT_RGB332
+} PixelFormat;
+
+/// @brief Row kernels of a packed pixel format, generated per format so none of them branches per pixel
+/// @param bytes Bytes per pixel
+/// @param pack Converts `count` ARGB pixels to the format. Alpha is dropped
+/// @param unpack Converts `count` pixels of the format to opaque ARGB
+/// @param fill Fills `count` pixels with an ARGB color
+typedef struct PixelFormatKernels
+{
+    int bytes;
+    void (*pack)(void *dst, const uint32_t *src, int count);
+    void (*unpack)(uint32_t *dst, const void *src, int count);
+    void (*fill)(void *dst, int count, uint32_t color);
+} PixelFormatKernels;
+
+/// @brief Kernels of a pixel format
+/// @param format Format to look up
+/// @return The format's kernels. ARGB8888 has kernels too, copying pixels unchanged
+const PixelFormatKernels *pixel_format_kernels(PixelFormat format);
+
+/// @brief Bytes per pixel of a format
+/// @param format Pixel format
+/// @return 4, 2 or 1
+static inline int pixel_format_bytes(PixelFormat format)
+{
+    return format == PIXEL_FORMAT_RGB565 ? 2 : format == PIXEL_FORMAT_RGB332 ? 1 : 4;
+}
+
+/// @brief Reads one pixel as ARGB
+/// @param format Format of the pixel
+/// @param pixel Address of the pixel
+/// @return The pixel as ARGB
+uint32_t pixel_format_load(PixelFormat format, const void *pixel);
+
+/// @brief Stores an ARGB color into one pixel with a single atomic store
+/// @param format Format of the pixel
+/// @param pixel Address of the pixel
+/// @param color ARGB color
+void pixel_format_store(PixelFormat format, void *pixel, uint32_t color);
+
+/// @brief Plots onto one pixel like plot_atomic, combining in ARGB and storing in the pixel's format
+/// @param format Format of the pixel
+/// @param pixel Address of the pixel
+/// @param color Plotted color
+/// @param op How they combine
+void pixel_format_plot_atomic(PixelFormat format, void *pixel, uint32_t color, PlotOp op);
+
+/// @brief Draws part of a job into pixels of a packed format. Solid opaque jobs are filled directly,
+/// every other job is drawn into an ARGB row buffer small enough to stay in cache and packed from there.
+/// The pixels are only unpacked into that buffer for jobs that read them, see drawjob_is_opaque
+/// @param format Format of the pixels
+/// @param job Job to draw
+/// @param area Area to draw, inside the job's area
+/// @param dst Pixel at the top left of `area`
+/// @param stride Distance between the start of two rows, in pixels
+void pixel_format_draw_area(PixelFormat format, const DrawJob *job, Recti area, void *dst, int stride);
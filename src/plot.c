@@ -0,0 +1,52 @@
+#include "../include/renderer.h"
+
+uint32_t plot_combine(uint32_t dst, uint32_t color, PlotOp op)
+{
+    switch (op)
+    {
+    case PLOT_SRC_OVER:
+        return blend_color(color, dst, BLEND_SRC_OVER);
+    case PLOT_ADD:
+    {
+        // Two channels per 16 bit lane. A carry into bit 8 of a lane saturates that channel
+        uint32_t even = (dst & 0x00FF00FF) + (color & 0x00FF00FF);
+        uint32_t odd = ((dst >> 8) & 0x00FF00FF) + ((color >> 8) & 0x00FF00FF);
+        even |= (even & 0x01000100) - ((even & 0x01000100) >> 8);
+        odd |= (odd & 0x01000100) - ((odd & 0x01000100) >> 8);
+        return (even & 0x00FF00FF) | (odd & 0x00FF00FF) << 8;
+    }
+    case PLOT_MULTIPLY:
+        return blend_color(color, dst, BLEND_MULTIPLY);
+    case PLOT_MAX:
+    case PLOT_MIN:
+    {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            uint32_t a = (dst >> shift) & 0xFF;
+            uint32_t b = (color >> shift) & 0xFF;
+            result |= ((op == PLOT_MAX) == (a > b) ? a : b) << shift;
+        }
+        return result;
+    }
+    default:
+        return color;
+    }
+}
+
+void plot_atomic(uint32_t *pixel, uint32_t color, PlotOp op)
+{
+    if (op == PLOT_REPLACE)
+    {
+        __atomic_store_n(pixel, color, __ATOMIC_RELAXED);
+        return;
+    }
+
+    uint32_t old = __atomic_load_n(pixel, __ATOMIC_RELAXED);
+    uint32_t combined = plot_combine(old, color, op);
+
+    // Plots that change nothing need no store, which keeps max and min cheap once they settle
+    while (combined != old &&
+           !__atomic_compare_exchange_n(pixel, &old, combined, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        combined = plot_combine(old, color, op);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include "span_kernels.h"
+
+/// @brief How a plotted color combines with the pixel under it. Colors of the blending ops are premultiplied, see BlendMode
+/// @param PLOT_REPLACE Overwrites the pixel. Of plots to the same pixel at the same time, one wins whole
+/// @param PLOT_SRC_OVER Draws over the pixel like BLEND_SRC_OVER
+/// @param PLOT_ADD Adds to the pixel like BLEND_ADD. Useful for accumulating particles
+/// @param PLOT_MULTIPLY Darkens the pixel like BLEND_MULTIPLY
+/// @param PLOT_MAX Keeps the larger value of every channel
+/// @param PLOT_MIN Keeps the smaller value of every channel
+typedef enum PlotOp
+{
+    PLOT_REPLACE = 0,
+    PLOT_SRC_OVER,
+    PLOT_ADD,
+    PLOT_MULTIPLY,
+    PLOT_MAX,
+    PLOT_MIN
+} PlotOp;
+
+/// @brief A pixel to plot
+typedef struct PlotPoint
+{
+    int x;
+    int y;
+    uint32_t color;
+} PlotPoint;
+
+/// @brief The color a pixel gets when `color` is plotted onto it. The reference every plot function matches
+/// @param dst Pixel under the plot
+/// @param color Plotted color
+/// @param op How they combine
+/// @return Resulting pixel
+uint32_t plot_combine(uint32_t dst, uint32_t color, PlotOp op);
+
+/// @brief Plots onto a pixel with a single atomic store, or a compare and swap loop for the ops reading the pixel,
+/// so concurrent plots to the same pixel are never lost or torn
+/// @param pixel Pixel to plot onto
+/// @param color Plotted color
+/// @param op How they combine
+void plot_atomic(uint32_t *pixel, uint32_t color, PlotOp op);
@@ -0,0 +1,302 @@
+#include "../include/renderer.h"
+
+#define PNG_HASH_BITS 15
+#define PNG_WINDOW 32768
+#define PNG_MAX_MATCH 258
+
+// Tables filled once by whichever thread gets there first. Every thread stores the same values, so racing is harmless
+static uint32_t crc_table[256];
+static uint16_t literal_codes[288];
+static uint8_t literal_lengths[288];
+static uint8_t distance_codes[30];
+static int tables_ready;
+
+// Huffman codes are sent most significant bit first, while deflate packs bits from the least significant end
+static uint32_t reverse_bits(uint32_t code, int length)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    return reversed;
+}
+
+static void png_tables_init(void)
+{
+    if (__atomic_load_n(&tables_ready, __ATOMIC_ACQUIRE))
+        return;
+
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        __atomic_store_n(&crc_table[n], c, __ATOMIC_RELAXED);
+    }
+
+    // The fixed Huffman code of RFC 1951 section 3.2.6
+    for (uint32_t symbol = 0; symbol < 288; symbol++)
+    {
+        uint32_t code, length;
+        if (symbol < 144)
+            code = 0x30 + symbol, length = 8;
+        else if (symbol < 256)
+            code = 0x190 + symbol - 144, length = 9;
+        else if (symbol < 280)
+            code = symbol - 256, length = 7;
+        else
+            code = 0xC0 + symbol - 280, length = 8;
+        __atomic_store_n(&literal_codes[symbol], (uint16_t)reverse_bits(code, length), __ATOMIC_RELAXED);
+        __atomic_store_n(&literal_lengths[symbol], (uint8_t)length, __ATOMIC_RELAXED);
+    }
+    for (uint32_t symbol = 0; symbol < 30; symbol++)
+        __atomic_store_n(&distance_codes[symbol], (uint8_t)reverse_bits(symbol, 5), __ATOMIC_RELAXED);
+
+    __atomic_store_n(&tables_ready, 1, __ATOMIC_RELEASE);
+}
+
+uint32_t png_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+    png_tables_init();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t adler32(const uint8_t *data, size_t size)
+{
+    uint32_t a = 1, b = 0;
+    while (size > 0)
+    {
+        // Largest run that cannot overflow b before the modulo
+        size_t run = size < 5552 ? size : 5552;
+        size -= run;
+        while (run--)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+typedef struct BitWriter
+{
+    uint8_t *out;
+    size_t pos;
+    uint64_t bits;
+    int count;
+} BitWriter;
+
+static inline void put_bits(BitWriter *writer, uint32_t value, int count)
+{
+    writer->bits |= (uint64_t)value << writer->count;
+    writer->count += count;
+    if (writer->count >= 32)
+    {
+        for (int i = 0; i < 4; i++)
+            writer->out[writer->pos++] = (uint8_t)(writer->bits >> (8 * i));
+        writer->bits >>= 32;
+        writer->count -= 32;
+    }
+}
+
+static inline void put_literal(BitWriter *writer, int symbol)
+{
+    put_bits(writer, literal_codes[symbol], literal_lengths[symbol]);
+}
+
+// Length and distance codes, each a base symbol plus extra bits, see RFC 1951 section 3.2.5
+static inline void put_match(BitWriter *writer, int length, int distance)
+{
+    if (length == PNG_MAX_MATCH)
+        put_literal(writer, 285);
+    else if (length < 11)
+        put_literal(writer, 254 + length);
+    else
+    {
+        uint32_t x = (uint32_t)length - 3;
+        int bits = 31 - __builtin_clz(x);
+        put_literal(writer, 257 + 4 * (bits - 1) + (int)((x >> (bits - 2)) & 3));
+        put_bits(writer, x & ((1u << (bits - 2)) - 1), bits - 2);
+    }
+
+    uint32_t x = (uint32_t)distance - 1;
+    if (x < 4)
+        put_bits(writer, distance_codes[x], 5);
+    else
+    {
+        int bits = 31 - __builtin_clz(x);
+        put_bits(writer, distance_codes[2 * bits + ((x >> (bits - 1)) & 1)], 5);
+        put_bits(writer, x & ((1u << (bits - 1)) - 1), bits - 1);
+    }
+}
+
+static inline uint32_t load32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// One fixed Huffman block. Every position looks up the last position with the same next four bytes and takes the
+// match if it is real, so runs of equal filtered bytes, the common case in rendered frames, become long matches
+static void deflate_fixed(BitWriter *writer, const uint8_t *in, size_t size, int32_t *head)
+{
+    memset(head, 0xFF, sizeof(int32_t) << PNG_HASH_BITS);
+    put_bits(writer, 1, 1);
+    put_bits(writer, 1, 2);
+
+    size_t i = 0;
+    while (i + 4 <= size)
+    {
+        uint32_t hash = (load32(in + i) * 2654435761u) >> (32 - PNG_HASH_BITS);
+        int32_t candidate = head[hash];
+        head[hash] = (int32_t)i;
+
+        if (candidate >= 0 && i - (size_t)candidate <= PNG_WINDOW && load32(in + candidate) == load32(in + i))
+        {
+            size_t limit = size - i < PNG_MAX_MATCH ? size - i : PNG_MAX_MATCH;
+            size_t length = 4;
+            while (length < limit && in[candidate + length] == in[i + length])
+                length++;
+            put_match(writer, (int)length, (int)(i - (size_t)candidate));
+            i += length;
+        }
+        else
+            put_literal(writer, in[i++]);
+    }
+    while (i < size)
+        put_literal(writer, in[i++]);
+
+    put_literal(writer, 256);
+    put_bits(writer, 0, (8 - writer->count % 8) % 8);
+    while (writer->count > 0)
+    {
+        writer->out[writer->pos++] = (uint8_t)writer->bits;
+        writer->bits >>= 8;
+        writer->count -= 8;
+    }
+}
+
+static void put_u32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+// Finishes a chunk whose length, type and data are at `chunk`
+static size_t end_chunk(uint8_t *chunk, size_t data_size)
+{
+    put_u32(chunk, (uint32_t)data_size);
+    put_u32(chunk + 8 + data_size, png_crc32(0, chunk + 4, data_size + 4));
+    return data_size + 12;
+}
+
+int png_encoder_init(PngEncoder *encoder, int width, int height)
+{
+    *encoder = (PngEncoder){0};
+    if (width <= 0 || height <= 0)
+        return 1;
+
+    size_t filtered_size = (size_t)height * (1 + 3 * (size_t)width);
+    encoder->width = width;
+    encoder->height = height;
+    // Fixed Huffman codes take at most 9 bits per byte, and matches less
+    encoder->out_capacity = filtered_size + filtered_size / 8 + 128;
+    encoder->filtered = malloc(filtered_size);
+    encoder->out = malloc(encoder->out_capacity);
+    encoder->head = malloc(sizeof(int32_t) << PNG_HASH_BITS);
+    if (!encoder->filtered || !encoder->out || !encoder->head)
+    {
+        png_encoder_free(encoder);
+        return 1;
+    }
+
+    png_tables_init();
+    return 0;
+}
+
+const uint8_t *png_encode(PngEncoder *encoder, const uint32_t *pixels, int stride, size_t *size)
+{
+    int width = encoder->width;
+    size_t row_size = 1 + 3 * (size_t)width;
+    size_t filtered_size = (size_t)encoder->height * row_size;
+
+    // Up filter: every byte minus the one above, per byte with no carries between channels
+    for (int y = 0; y < encoder->height; y++)
+    {
+        const uint32_t *row = pixels + (size_t)y * stride;
+        const uint32_t *above = y > 0 ? row - stride : NULL;
+        uint8_t *out = encoder->filtered + y * row_size;
+        *out++ = 2;
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t pixel = row[x];
+            if (above)
+                pixel = ((pixel | 0x80808080u) - (above[x] & 0x7F7F7F7Fu)) ^ ((pixel ^ ~above[x]) & 0x80808080u);
+            *out++ = (uint8_t)(pixel >> 16);
+            *out++ = (uint8_t)(pixel >> 8);
+            *out++ = (uint8_t)pixel;
+        }
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t *out = encoder->out;
+    size_t pos = 0;
+    memcpy(out, signature, sizeof(signature));
+    pos += sizeof(signature);
+
+    uint8_t *ihdr = out + pos;
+    memcpy(ihdr + 4, "IHDR", 4);
+    put_u32(ihdr + 8, (uint32_t)width);
+    put_u32(ihdr + 12, (uint32_t)encoder->height);
+    // 8 bits per channel, RGB, deflate, adaptive filtering, not interlaced
+    memcpy(ihdr + 16, (const uint8_t[]){8, 2, 0, 0, 0}, 5);
+    pos += end_chunk(ihdr, 13);
+
+    uint8_t *idat = out + pos;
+    memcpy(idat + 4, "IDAT", 4);
+    BitWriter writer = {idat + 8, 0, 0, 0};
+    writer.out[writer.pos++] = 0x78;
+    writer.out[writer.pos++] = 0x01;
+    deflate_fixed(&writer, encoder->filtered, filtered_size, encoder->head);
+    put_u32(writer.out + writer.pos, adler32(encoder->filtered, filtered_size));
+    pos += end_chunk(idat, writer.pos + 4);
+
+    uint8_t *iend = out + pos;
+    memcpy(iend + 4, "IEND", 4);
+    pos += end_chunk(iend, 0);
+
+    *size = pos;
+    return out;
+}
+
+void png_encoder_free(PngEncoder *encoder)
+{
+    free(encoder->filtered);
+    free(encoder->out);
+    free(encoder->head);
+    *encoder = (PngEncoder){0};
+}
+
+int png_write(const char *path, const uint32_t *pixels, int width, int height, int stride)
+{
+    PngEncoder encoder;
+    if (png_encoder_init(&encoder, width, height) != 0)
+        return 1;
+
+    size_t size;
+    const uint8_t *data = png_encode(&encoder, pixels, stride, &size);
+    FILE *file = fopen(path, "wb");
+    int failed = !file || fwrite(data, 1, size, file) != size;
+    if (file && fclose(file) != 0)
+        failed = 1;
+
+    png_encoder_free(&encoder);
+    return failed;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/// @brief Scratch memory of a PNG encoder, sized for one image size so encoding allocates nothing.
+/// Images are written as 8 bit RGB, dropping alpha like the window does. Rows use the Up filter and are compressed
+/// with a single fixed Huffman deflate block and a one entry per hash match finder, trading size for speed
+/// @param filtered Filtered rows, each starting with its filter type
+/// @param out Encoded file
+/// @param head Last position of every hash of four bytes, -1 if none
+typedef struct PngEncoder
+{
+    int width;
+    int height;
+    uint8_t *filtered;
+    uint8_t *out;
+    size_t out_capacity;
+    int32_t *head;
+} PngEncoder;
+
+/// @brief Allocates an encoder for images of one size
+/// @param encoder Encoder to initialize
+/// @param width Width of the images
+/// @param height Height of the images
+/// @return 0 for success and 1 for failure
+int png_encoder_init(PngEncoder *encoder, int width, int height);
+
+/// @brief Encodes ARGB pixels as a PNG file
+/// @param encoder Encoder initialized for the image's size
+/// @param pixels Pixel (x,y) is `pixels[y * stride + x]`
+/// @param stride Distance between the start of two rows, in pixels
+/// @param size Set to the size of the file in bytes
+/// @return The file, valid until the next call
+const uint8_t *png_encode(PngEncoder *encoder, const uint32_t *pixels, int stride, size_t *size);
+
+/// @brief Frees the encoder's scratch memory
+/// @param encoder Encoder to free
+void png_encoder_free(PngEncoder *encoder);
+
+/// @brief Writes ARGB pixels to a PNG file. Allocates an encoder, so keep a PngEncoder around for repeated captures
+/// @param path File to write
+/// @param pixels Pixel (x,y) is `pixels[y * stride + x]`
+/// @param width Width in pixels
+/// @param height Height in pixels
+/// @param stride Distance between the start of two rows, in pixels
+/// @return 0 for success and 1 for failure
+int png_write(const char *path, const uint32_t *pixels, int width, int height, int stride);
+
+/// @brief CRC-32 as used by PNG chunks and zip
+/// @param crc CRC of the data before, 0 to start
+/// @param data Bytes to add
+/// @param size Number of bytes
+/// @return CRC of all bytes so far
+uint32_t png_crc32(uint32_t crc, const uint8_t *data, size_t size);
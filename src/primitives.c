@@ -0,0 +1,663 @@
+#include "../include/renderer.h"
+
+// Coordinates are clamped well inside int, so bounding boxes and spans never overflow
+#define PRIMITIVE_COORD_LIMIT (double)(1 << 28)
+
+// Relative distance from a pixel center within which a crossing computed with an inverse is recomputed exactly
+#define PRIMITIVE_TIE_MARGIN 1e-12
+
+// Rows are drawn in chunks of at most this many pixels, so blending and shading can use buffers on the stack
+#define PRIMITIVE_CHUNK 256
+
+static int clamp_coord(double value)
+{
+    if (!(value > -PRIMITIVE_COORD_LIMIT))
+        return (int)-PRIMITIVE_COORD_LIMIT;
+    if (value > PRIMITIVE_COORD_LIMIT)
+        return (int)PRIMITIVE_COORD_LIMIT;
+    return (int)value;
+}
+
+// Smallest pixel area containing the rectangle
+static Recti outer_pixels(Rectf rect)
+{
+    return (Recti){
+        .top_left = {clamp_coord(floor(rect.top_left.x)), clamp_coord(floor(rect.top_left.y))},
+        .bottom_right = {clamp_coord(ceil(rect.bottom_right.x)), clamp_coord(ceil(rect.bottom_right.y))}};
+}
+
+// fmin and fmax are library calls unless NaNs can be ignored, which is too slow per pixel
+static inline double min_double(double a, double b)
+{
+    return a < b ? a : b;
+}
+
+static inline double max_double(double a, double b)
+{
+    return a > b ? a : b;
+}
+
+// Pixels whose centers lie in [low, high], narrowed to [*start, *end)
+static void clip_centers(double low, double high, int *start, int *end)
+{
+    int first = clamp_coord(ceil(low - 0.5));
+    int last = clamp_coord(floor(high - 0.5)) + 1;
+    if (first > *start)
+        *start = first;
+    if (last < *end)
+        *end = last;
+}
+
+// Scales every channel of a premultiplied color by coverage / 256
+static inline uint32_t scale_coverage(uint32_t color, uint32_t coverage)
+{
+    uint32_t red_blue = ((color & 0x00FF00FF) * coverage >> 8) & 0x00FF00FF;
+    uint32_t alpha_green = ((color >> 8) & 0x00FF00FF) * coverage & 0xFF00FF00;
+    return red_blue | alpha_green;
+}
+
+static inline uint32_t coverage_fixed(double coverage)
+{
+    return (uint32_t)(coverage * 256 + 0.5);
+}
+
+DrawJob drawjob_triangle(Pointf a, Pointf b, Pointf c, uint32_t color)
+{
+    return drawjob_shaded_triangle(a, color, b, color, c, color);
+}
+
+DrawJob drawjob_shaded_triangle(Pointf a, uint32_t a_color, Pointf b, uint32_t b_color, Pointf c, uint32_t c_color)
+{
+    TriangleParams triangle = {
+        .x = {(float)a.x, (float)b.x, (float)c.x},
+        .y = {(float)a.y, (float)b.y, (float)c.y},
+        .colors = {a_color, b_color, c_color}};
+
+    Rectf bounds = {{triangle.x[0], triangle.y[0]}, {triangle.x[0], triangle.y[0]}};
+    for (int i = 1; i < 3; i++)
+    {
+        bounds.top_left.x = min_double(bounds.top_left.x, triangle.x[i]);
+        bounds.top_left.y = min_double(bounds.top_left.y, triangle.y[i]);
+        bounds.bottom_right.x = max_double(bounds.bottom_right.x, triangle.x[i]);
+        bounds.bottom_right.y = max_double(bounds.bottom_right.y, triangle.y[i]);
+    }
+
+    return (DrawJob){.area = outer_pixels(bounds), .kind = DRAWJOB_TRIANGLE, .params.triangle = triangle};
+}
+
+DrawJob drawjob_line(Pointf start, uint32_t start_color, Pointf end, uint32_t end_color, double width)
+{
+    LineParams line = {
+        .x0 = (float)start.x,
+        .y0 = (float)start.y,
+        .x1 = (float)end.x,
+        .y1 = (float)end.y,
+        .half_width = (float)(width > 0 ? width / 2 : 0),
+        .colors = {start_color, end_color}};
+
+    // Coverage fades out half a pixel past the edge of the line
+    double reach = line.half_width + 0.5;
+    Rectf bounds = {
+        {min_double(line.x0, line.x1) - reach, min_double(line.y0, line.y1) - reach},
+        {max_double(line.x0, line.x1) + reach, max_double(line.y0, line.y1) + reach}};
+
+    return (DrawJob){.area = outer_pixels(bounds), .kind = DRAWJOB_LINE, .params.line = line, .blend = BLEND_SRC_OVER};
+}
+
+DrawJob drawjob_ring(Pointf center, double radius, double thickness, uint32_t color)
+{
+    if (radius < 0)
+        radius = 0;
+    double inner_radius = thickness < radius ? radius - thickness : 0;
+
+    CircleParams circle = {
+        .center_x = (float)center.x,
+        .center_y = (float)center.y,
+        .radius = (float)radius,
+        .inner_radius = (float)inner_radius,
+        .color = color};
+
+    double reach = circle.radius + 0.5;
+    Rectf bounds = {
+        {circle.center_x - reach, circle.center_y - reach},
+        {circle.center_x + reach, circle.center_y + reach}};
+
+    return (DrawJob){.area = outer_pixels(bounds), .kind = DRAWJOB_CIRCLE, .params.circle = circle, .blend = BLEND_SRC_OVER};
+}
+
+DrawJob drawjob_circle(Pointf center, double radius, uint32_t color)
+{
+    return drawjob_ring(center, radius, radius, color);
+}
+
+int drawjob_is_primitive(const DrawJob *job)
+{
+    return job->kind == DRAWJOB_TRIANGLE || job->kind == DRAWJOB_LINE || job->kind == DRAWJOB_CIRCLE;
+}
+
+static int triangle_edges(const TriangleParams *triangle, TriangleEdges *edges)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        int j = i == 2 ? 0 : i + 1;
+        int k = j == 2 ? 0 : j + 1;
+        edges->a[i] = (double)triangle->y[j] - triangle->y[k];
+        edges->b[i] = (double)triangle->x[k] - triangle->x[j];
+        edges->c[i] = (double)triangle->x[j] * triangle->y[k] - (double)triangle->x[k] * triangle->y[j];
+    }
+
+    // Twice the signed area. Clockwise triangles are flipped so the inside is positive either way
+    edges->area = edges->a[0] * triangle->x[0] + edges->b[0] * triangle->y[0] + edges->c[0];
+    if (edges->area < 0)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            edges->a[i] = -edges->a[i];
+            edges->b[i] = -edges->b[i];
+            edges->c[i] = -edges->c[i];
+        }
+        edges->area = -edges->area;
+    }
+
+    // Horizontal edges get infinite inverses, which give infinite or NaN bounds like dividing does
+    for (int i = 0; i < 3; i++)
+        edges->inverse_a[i] = 1 / edges->a[i];
+    return edges->area > 0;
+}
+
+// Rows of a triangle with pixel centers between its top and bottom vertex, narrowed by its horizontal edges.
+// Horizontal edges follow the same rule as the others: a center exactly on one is inside if it is a top edge
+static void triangle_rows(const TriangleParams *triangle, const TriangleEdges *edges, int *row_start, int *row_end)
+{
+    double top = min_double(triangle->y[0], min_double(triangle->y[1], triangle->y[2]));
+    double bottom = max_double(triangle->y[0], max_double(triangle->y[1], triangle->y[2]));
+    clip_centers(top, bottom, row_start, row_end);
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (edges->a[i] != 0)
+            continue;
+
+        double bound = ceil(-edges->c[i] / edges->b[i] - 0.5);
+        if (edges->b[i] > 0 && bound > *row_start)
+            *row_start = bound < *row_end ? (int)bound : *row_end;
+        else if (edges->b[i] < 0 && bound < *row_end)
+            *row_end = bound > *row_start ? (int)bound : *row_start;
+    }
+}
+
+int primitive_setup(const DrawJob *job, PrimitiveSetup *setup)
+{
+    // Rows come from the shape, not the job's area, which is in other coordinates once the job is transformed
+    setup->kind = job->kind;
+    setup->row_start = 0;
+    setup->row_end = 0;
+
+    switch (job->kind)
+    {
+    case DRAWJOB_TRIANGLE:
+    {
+        const TriangleParams *params = &job->params.triangle;
+        const TriangleEdges *edges = &setup->triangle.edges;
+        if (!triangle_edges(params, &setup->triangle.edges))
+            return 0;
+        setup->row_start = INT_MIN;
+        setup->row_end = INT_MAX;
+        triangle_rows(params, edges, &setup->row_start, &setup->row_end);
+        if (setup->row_start >= setup->row_end)
+            return 0;
+
+        setup->triangle.color = params->colors[0];
+        setup->triangle.shaded = params->colors[0] != params->colors[1] || params->colors[1] != params->colors[2];
+        double inverse_area = 1 / edges->area;
+        for (int channel = 0; setup->triangle.shaded && channel < 4; channel++)
+        {
+            double *plane = setup->triangle.plane[channel];
+            plane[0] = plane[1] = plane[2] = 0;
+            for (int i = 0; i < 3; i++)
+            {
+                double weight = (params->colors[i] >> (24 - 8 * channel) & 0xFF) * inverse_area;
+                plane[0] += edges->a[i] * weight;
+                plane[1] += edges->b[i] * weight;
+                plane[2] += edges->c[i] * weight;
+            }
+        }
+        return 1;
+    }
+    case DRAWJOB_LINE:
+    {
+        const LineParams *params = &job->params.line;
+        double dx = (double)params->x1 - params->x0;
+        double dy = (double)params->y1 - params->y0;
+        double length = sqrt(dx * dx + dy * dy);
+
+        setup->line.params = params;
+        setup->line.dx = dx;
+        setup->line.dy = dy;
+        setup->line.inverse_dx = dx != 0 ? 1 / dx : 0;
+        setup->line.inverse_dy = dy != 0 ? 1 / dy : 0;
+        setup->line.length_squared = dx * dx + dy * dy;
+        setup->line.inverse_length_squared = length > 0 ? 1 / setup->line.length_squared : 0;
+        setup->line.inverse_length = length > 0 ? 1 / length : 0;
+        setup->line.reach = params->half_width + 0.5;
+        setup->line.band = setup->line.reach * length;
+        setup->line.peak = params->half_width < 0.5 ? 2 * params->half_width : 1;
+        setup->line.shaded = params->colors[0] != params->colors[1];
+        setup->row_start = INT_MIN;
+        setup->row_end = INT_MAX;
+        return 1;
+    }
+    case DRAWJOB_CIRCLE:
+    {
+        const CircleParams *params = &job->params.circle;
+        setup->circle.params = params;
+        setup->circle.outer = params->radius + 0.5;
+        // Pixels of a disc within radius - 0.5 of the center are covered completely
+        setup->circle.solid = params->inner_radius <= 0 ? params->radius - 0.5 : 0;
+        setup->row_start = INT_MIN;
+        setup->row_end = INT_MAX;
+        return 1;
+    }
+    default:
+        return 0;
+    }
+}
+
+// Narrows [*start, *end) to the pixels of row y whose centers are inside the triangle. A center exactly on an edge is inside
+// if it is a left edge. The shared edge is a right edge of the neighbouring triangle, and both compute the same bound,
+// so exactly one of them draws the pixel. Horizontal edges only limit the rows, their bounds are infinite or NaN here and ignored
+static void triangle_row(const TriangleEdges *edges, int y, int *start, int *end)
+{
+    double center_y = y + 0.5;
+    double low = *start;
+    double high = *end;
+
+    // Selects instead of branches, since which edges bound a row differs from triangle to triangle
+    for (int i = 0; i < 3; i++)
+    {
+        // The edge function at the center of pixel x is a * (x + 0.5) + b * center_y + c, which changes sign at x = bound.
+        // Dividing three times per row costs as much as the rest of the row, so the crossing is multiplied by the inverse,
+        // which is off by at most a few ulps. Only crossings that close to a pixel center, exact ties included, are divided
+        double numerator = -(edges->b[i] * center_y + edges->c[i]);
+        double crossing = numerator * edges->inverse_a[i] - 0.5;
+        if (fabs(crossing - nearbyint(crossing)) < PRIMITIVE_TIE_MARGIN * (fabs(crossing) + 1))
+            crossing = numerator / edges->a[i] - 0.5;
+        double bound = ceil(crossing);
+        low = edges->a[i] > 0 && bound > low ? bound : low;
+        high = edges->a[i] < 0 && bound < high ? bound : high;
+    }
+
+    *start = (int)low;
+    *end = high > low ? (int)high : *start;
+}
+
+static void triangle_pixels(const PrimitiveSetup *setup, int y, int start, int end, uint32_t *dst)
+{
+    if (!setup->triangle.shaded)
+    {
+        span_kernels.fill_solid(dst, end - start, setup->triangle.color);
+        return;
+    }
+
+    // Channels step in 16.16 fixed point from their value at x = 0 of the row, so a pixel gets the same value however
+    // the row is split into spans. Pixels at the very edge can land just outside the channel range and are clamped
+    double center_y = y + 0.5;
+    int64_t value[4];
+    int64_t step[4];
+    for (int channel = 0; channel < 4; channel++)
+    {
+        const double *plane = setup->triangle.plane[channel];
+        step[channel] = (int64_t)(plane[0] * 65536);
+        value[channel] = (int64_t)((plane[0] * 0.5 + plane[1] * center_y + plane[2]) * 65536) + 32768 + step[channel] * start;
+    }
+
+    for (int x = start; x < end; x++)
+    {
+        uint32_t color = 0;
+        for (int channel = 0; channel < 4; channel++)
+        {
+            int64_t v = value[channel];
+            color = color << 8 | (v < 0 ? 0 : v >= 256 << 16 ? 255 : (uint32_t)(v >> 16));
+            value[channel] += step[channel];
+        }
+        *dst++ = color;
+    }
+}
+
+// Narrows [*low, *high] to the x where `slope * x + offset` is within [min, max]
+static void clip_linear(double slope, double inverse_slope, double offset, double min, double max, double *low, double *high)
+{
+    if (slope == 0)
+    {
+        if (offset < min || offset > max)
+            *high = *low - 1;
+        return;
+    }
+
+    double a = (min - offset) * inverse_slope;
+    double b = (max - offset) * inverse_slope;
+    *low = max_double(*low, min_double(a, b));
+    *high = min_double(*high, max_double(a, b));
+}
+
+// Lines are capsules. The capsule lies within the band around the line and the slab along it,
+// so only that part of the row is visited
+static void line_row(const PrimitiveSetup *setup, int y, int *start, int *end)
+{
+    const LineParams *line = setup->line.params;
+    double dx = setup->line.dx;
+    double dy = setup->line.dy;
+    double py = y + 0.5 - line->y0;
+    double low = *start + 0.5;
+    double high = *end - 0.5;
+
+    clip_linear(-dy, -setup->line.inverse_dy, dx * py + dy * line->x0, -setup->line.band, setup->line.band, &low, &high);
+    clip_linear(dx, setup->line.inverse_dx, dy * py - dx * line->x0, -setup->line.band,
+                setup->line.length_squared + setup->line.band, &low, &high);
+    if (low > high)
+        *end = *start;
+    else
+        clip_centers(low, high, start, end);
+}
+
+// Blends two colors by weight / 256, matching gradient_color
+static inline uint32_t lerp_color(uint32_t start_color, uint32_t end_color, uint32_t weight)
+{
+    uint32_t red_blue = ((start_color & 0x00FF00FF) * (256 - weight) + (end_color & 0x00FF00FF) * weight) >> 8;
+    uint32_t alpha_green = ((start_color >> 8) & 0x00FF00FF) * (256 - weight) + ((end_color >> 8) & 0x00FF00FF) * weight;
+    return (red_blue & 0x00FF00FF) | (alpha_green & 0xFF00FF00);
+}
+
+// Coverage falls from 1 to 0 over the pixel around distance half_width from the segment. Along the row the position on
+// the segment and the distance from the line are linear in x, so only pixels past the ends need a square root. They are
+// computed from x rather than stepped, so a row gives the same pixels however it is split into spans
+static void line_pixels(const PrimitiveSetup *setup, int y, int start, int end, uint32_t *dst)
+{
+    const LineParams *line = setup->line.params;
+    double dx = setup->line.dx;
+    double dy = setup->line.dy;
+    double py = y + 0.5 - line->y0;
+    double t_step = dx * setup->line.inverse_length_squared;
+    double t_row = (0.5 - line->x0) * t_step + py * dy * setup->line.inverse_length_squared;
+    double side_step = dy * setup->line.inverse_length;
+    double side_row = (0.5 - line->x0) * side_step - py * dx * setup->line.inverse_length;
+
+    for (int x = start; x < end; x++, dst++)
+    {
+        double t = t_row + x * t_step;
+        double px = x + 0.5 - line->x0;
+        double distance;
+        if (t <= 0)
+            distance = sqrt(px * px + py * py);
+        else if (t >= 1)
+            distance = sqrt((px - dx) * (px - dx) + (py - dy) * (py - dy));
+        else
+            distance = fabs(side_row + x * side_step);
+
+        double coverage = min_double(setup->line.reach - distance, setup->line.peak);
+        if (coverage <= 0)
+            continue;
+
+        uint32_t color = line->colors[0];
+        if (setup->line.shaded)
+            color = lerp_color(line->colors[0], line->colors[1], (uint32_t)(min_double(max_double(t, 0), 1) * 256 + 0.5));
+        *dst = coverage >= 1 ? color : scale_coverage(color, coverage_fixed(coverage));
+    }
+}
+
+static void circle_row(const PrimitiveSetup *setup, int y, int *start, int *end)
+{
+    const CircleParams *circle = setup->circle.params;
+    double dy = y + 0.5 - circle->center_y;
+    double outer = setup->circle.outer;
+    if (fabs(dy) >= outer)
+    {
+        *end = *start;
+        return;
+    }
+
+    double reach = sqrt(outer * outer - dy * dy);
+    clip_centers(circle->center_x - reach, circle->center_x + reach, start, end);
+}
+
+static void circle_edge_pixels(const CircleParams *circle, double dy, int start, int end, uint32_t *dst)
+{
+    double outer = circle->radius + 0.5;
+    double inner = circle->inner_radius - 0.5;
+
+    for (int x = start; x < end; x++, dst++)
+    {
+        double dx = x + 0.5 - circle->center_x;
+        double distance = sqrt(dx * dx + dy * dy);
+        double coverage = outer - distance;
+        if (circle->inner_radius > 0)
+            coverage = min_double(coverage, distance - inner);
+        if (coverage <= 0)
+            continue;
+        *dst = coverage >= 1 ? circle->color : scale_coverage(circle->color, coverage_fixed(coverage));
+    }
+}
+
+static void circle_pixels(const PrimitiveSetup *setup, int y, int start, int end, uint32_t *dst)
+{
+    const CircleParams *circle = setup->circle.params;
+    double dy = y + 0.5 - circle->center_y;
+    double solid = setup->circle.solid;
+
+    // The solid inside of the row is filled as one run
+    int solid_start = end;
+    int solid_end = end;
+    if (solid > fabs(dy))
+    {
+        double half = sqrt(solid * solid - dy * dy);
+        solid_start = start;
+        clip_centers(circle->center_x - half, circle->center_x + half, &solid_start, &solid_end);
+        if (solid_start > solid_end)
+            solid_start = solid_end = end;
+    }
+
+    circle_edge_pixels(circle, dy, start, solid_start, dst);
+    if (solid_start < solid_end)
+        span_kernels.fill_solid(dst + (solid_start - start), solid_end - solid_start, circle->color);
+    circle_edge_pixels(circle, dy, solid_end, end, dst + (solid_end - start));
+}
+
+static void primitive_row(const PrimitiveSetup *setup, int y, int *start, int *end)
+{
+    if (setup->kind == DRAWJOB_TRIANGLE)
+        triangle_row(&setup->triangle.edges, y, start, end);
+    else if (setup->kind == DRAWJOB_LINE)
+        line_row(setup, y, start, end);
+    else
+        circle_row(setup, y, start, end);
+}
+
+// Writes the covered pixels from start up to end, at most PRIMITIVE_CHUNK of them, where dst points to the pixel at (start,y)
+static void primitive_pixels(const PrimitiveSetup *setup, int y, int start, int end, uint32_t *dst)
+{
+    if (setup->kind == DRAWJOB_TRIANGLE)
+        triangle_pixels(setup, y, start, end, dst);
+    else if (setup->kind == DRAWJOB_LINE)
+        line_pixels(setup, y, start, end, dst);
+    else
+        circle_pixels(setup, y, start, end, dst);
+}
+
+void primitive_draw_area(const DrawJob *job, Recti area, uint32_t *dst, int stride, BlendMode blend)
+{
+    PrimitiveSetup setup;
+    if (primitive_setup(job, &setup))
+        primitive_setup_draw_area(&setup, area, dst, stride, blend);
+}
+
+void primitive_setup_draw_area(const PrimitiveSetup *setup, Recti area, uint32_t *dst, int stride, BlendMode blend)
+{
+    uint32_t src[PRIMITIVE_CHUNK];
+    int x0 = area.top_left.x;
+    int y0 = area.top_left.y > setup->row_start ? area.top_left.y : setup->row_start;
+    int y1 = area.bottom_right.y < setup->row_end ? area.bottom_right.y : setup->row_end;
+    dst += (ptrdiff_t)(y0 - area.top_left.y) * stride;
+
+    for (int y = y0; y < y1; y++, dst += stride)
+    {
+        int start = x0;
+        int end = area.bottom_right.x;
+        primitive_row(setup, y, &start, &end);
+        if (start >= end)
+            continue;
+
+        // Only the part of the row the primitive covers is visited
+        for (int x = start; x < end; x += PRIMITIVE_CHUNK)
+        {
+            int chunk_end = x + PRIMITIVE_CHUNK < end ? x + PRIMITIVE_CHUNK : end;
+            if (blend == BLEND_OPAQUE)
+            {
+                primitive_pixels(setup, y, x, chunk_end, dst + (x - x0));
+                continue;
+            }
+
+            memset(src, 0, (size_t)(chunk_end - x) * sizeof(uint32_t));
+            primitive_pixels(setup, y, x, chunk_end, src);
+            span_kernels.blend(dst + (x - x0), src, chunk_end - x, blend);
+        }
+    }
+}
+
+void primitive_draw_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    primitive_draw_area(job, (Recti){{x0, y}, {x1, y + 1}}, dst, 0, BLEND_OPAQUE);
+}
+
+// Smallest and largest value of `a * x + b * y + c` over the pixel centers of an area
+static void linear_range(double a, double b, double c, Recti area, double *min, double *max)
+{
+    double left = area.top_left.x + 0.5;
+    double right = area.bottom_right.x - 0.5;
+    double top = area.top_left.y + 0.5;
+    double bottom = area.bottom_right.y - 0.5;
+
+    *min = (a > 0 ? a * left : a * right) + (b > 0 ? b * top : b * bottom) + c;
+    *max = (a > 0 ? a * right : a * left) + (b > 0 ? b * bottom : b * top) + c;
+}
+
+// Distance from the center of a circle to the nearest and farthest pixel centers of an area
+static void distance_range(const CircleParams *circle, Recti area, double *nearest, double *farthest)
+{
+    double left = area.top_left.x + 0.5 - circle->center_x;
+    double right = area.bottom_right.x - 0.5 - circle->center_x;
+    double top = area.top_left.y + 0.5 - circle->center_y;
+    double bottom = area.bottom_right.y - 0.5 - circle->center_y;
+
+    double near_x = left > 0 ? left : right < 0 ? right : 0;
+    double near_y = top > 0 ? top : bottom < 0 ? bottom : 0;
+    double far_x = max_double(fabs(left), fabs(right));
+    double far_y = max_double(fabs(top), fabs(bottom));
+    *nearest = sqrt(near_x * near_x + near_y * near_y);
+    *farthest = sqrt(far_x * far_x + far_y * far_y);
+}
+
+int primitive_touches_tile(const DrawJob *job, Recti tile)
+{
+    if (job->transform.active || !drawjob_is_primitive(job))
+        return 1;
+
+    PrimitiveSetup setup;
+    return primitive_setup(job, &setup) && primitive_setup_touches_tile(&setup, tile);
+}
+
+int primitive_setup_touches_tile(const PrimitiveSetup *setup, Recti tile)
+{
+    if (tile.top_left.y >= setup->row_end || tile.bottom_right.y <= setup->row_start)
+        return 0;
+
+    double min, max;
+    switch (setup->kind)
+    {
+    case DRAWJOB_TRIANGLE:
+    {
+        const TriangleEdges *edges = &setup->triangle.edges;
+        for (int i = 0; i < 3; i++)
+        {
+            linear_range(edges->a[i], edges->b[i], edges->c[i], tile, &min, &max);
+            if (max < 0)
+                return 0;
+        }
+        return 1;
+    }
+    case DRAWJOB_LINE:
+    {
+        const LineParams *line = setup->line.params;
+        double dx = setup->line.dx;
+        double dy = setup->line.dy;
+
+        linear_range(-dy, dx, dy * line->x0 - dx * line->y0, tile, &min, &max);
+        return min < setup->line.band && max > -setup->line.band;
+    }
+    case DRAWJOB_CIRCLE:
+    {
+        const CircleParams *circle = setup->circle.params;
+        distance_range(circle, tile, &min, &max);
+        return min < setup->circle.outer && (circle->inner_radius <= 0 || max > circle->inner_radius - 0.5);
+    }
+    default:
+        return 1;
+    }
+}
+
+uint64_t primitive_covered_cells(const DrawJob *job, const PrimitiveSetup *setup, Recti tile)
+{
+    if (job->transform.active)
+        return 0;
+
+    const TriangleEdges *edges = NULL;
+    const CircleParams *circle = &job->params.circle;
+    if (job->kind == DRAWJOB_TRIANGLE)
+    {
+        if (job->blend != BLEND_OPAQUE || setup->row_start >= setup->row_end)
+            return 0;
+        edges = &setup->triangle.edges;
+    }
+    else if (job->kind == DRAWJOB_CIRCLE)
+    {
+        // Source over with full alpha overwrites the pixels, so the solid inside of a disc covers them
+        int overwrites = job->blend == BLEND_OPAQUE || (job->blend == BLEND_SRC_OVER && circle->color >> 24 == 0xFF);
+        if (!overwrites || circle->inner_radius > 0)
+            return 0;
+    }
+    else
+        return 0;
+
+    // Only cells inside the bounding box can be covered
+    uint64_t candidates = occlusion_cells(tile, job->area, 1);
+    uint64_t cells = 0;
+    for (int bit = 0; bit < 64; bit++)
+    {
+        if (!(candidates >> bit & 1))
+            continue;
+
+        Recti cell = {
+            .top_left = {tile.top_left.x + bit % 8 * OCCLUSION_CELL_SIZE, tile.top_left.y + bit / 8 * OCCLUSION_CELL_SIZE}};
+        cell.bottom_right.x = cell.top_left.x + OCCLUSION_CELL_SIZE < tile.bottom_right.x ? cell.top_left.x + OCCLUSION_CELL_SIZE : tile.bottom_right.x;
+        cell.bottom_right.y = cell.top_left.y + OCCLUSION_CELL_SIZE < tile.bottom_right.y ? cell.top_left.y + OCCLUSION_CELL_SIZE : tile.bottom_right.y;
+
+        double min, max;
+        int covered = 1;
+        if (job->kind == DRAWJOB_TRIANGLE)
+        {
+            for (int i = 0; i < 3 && covered; i++)
+            {
+                linear_range(edges->a[i], edges->b[i], edges->c[i], cell, &min, &max);
+                covered = min > 0;
+            }
+        }
+        else
+        {
+            distance_range(circle, cell, &min, &max);
+            covered = max <= circle->radius - 0.5;
+        }
+
+        if (covered)
+            cells |= UINT64_C(1) << bit;
+    }
+    return cells;
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <stdint.h>
+#include "drawjob.h"
+
+// Triangles, lines and circles are drawn as built in job kinds. Their area is their bounding box, and rows are clipped
+// to the shape analytically, so pixels of the box outside the shape are never visited and are left unwritten
+
+/// @brief Creates a job filling a triangle with one color. Vertices can be in either winding order.
+/// A pixel is drawn if its center is inside the triangle. Centers exactly on an edge go to only one of the triangles
+/// sharing the edge, so meshes have neither gaps nor pixels drawn twice
+/// @param a First vertex
+/// @param b Second vertex
+/// @param c Third vertex
+/// @param color Fill color
+/// @return A DRAWJOB_TRIANGLE job, opaque unless its blend mode is changed
+DrawJob drawjob_triangle(Pointf a, Pointf b, Pointf c, uint32_t color);
+
+/// @brief Same as drawjob_triangle, but every vertex has its own color, interpolated across the triangle
+/// @param a First vertex
+/// @param a_color Color at `a`
+/// @param b Second vertex
+/// @param b_color Color at `b`
+/// @param c Third vertex
+/// @param c_color Color at `c`
+/// @return A DRAWJOB_TRIANGLE job
+DrawJob drawjob_shaded_triangle(Pointf a, uint32_t a_color, Pointf b, uint32_t b_color, Pointf c, uint32_t c_color);
+
+/// @brief Creates an anti-aliased line with round caps. The color fades from `start_color` to `end_color` along the line
+/// @param start Start of the line
+/// @param start_color Premultiplied ARGB color at `start`
+/// @param end End of the line
+/// @param end_color Premultiplied ARGB color at `end`
+/// @param width Width of the line in pixels
+/// @return A DRAWJOB_LINE job blended with BLEND_SRC_OVER
+DrawJob drawjob_line(Pointf start, uint32_t start_color, Pointf end, uint32_t end_color, double width);
+
+/// @brief Creates an anti-aliased filled circle
+/// @param center Center of the circle
+/// @param radius Radius in pixels
+/// @param color Premultiplied ARGB color
+/// @return A DRAWJOB_CIRCLE job blended with BLEND_SRC_OVER
+DrawJob drawjob_circle(Pointf center, double radius, uint32_t color);
+
+/// @brief Creates an anti-aliased ring, the outline of a circle
+/// @param center Center of the ring
+/// @param radius Outer radius in pixels
+/// @param thickness Distance from the outer to the inner edge in pixels
+/// @param color Premultiplied ARGB color
+/// @return A DRAWJOB_CIRCLE job blended with BLEND_SRC_OVER
+DrawJob drawjob_ring(Pointf center, double radius, double thickness, uint32_t color);
+
+/// @brief Whether the job is a triangle, line or circle
+/// @param job Job to check
+/// @return 1 for primitives and 0 otherwise
+int drawjob_is_primitive(const DrawJob *job);
+
+/// @brief Edge functions of a triangle. Edge i runs from vertex i + 1 to vertex i + 2 and is `a * x + b * y + c`,
+/// which is 0 on the edge and positive inside. Vertices are floats, so the coefficients are exact in double,
+/// and the edge a neighbouring triangle shares gets exactly the negated coefficients
+/// @param inverse_a `1 / a` for every edge, which the neighbouring triangle also gets exactly negated
+/// @param area Twice the area of the triangle
+typedef struct TriangleEdges
+{
+    double a[3];
+    double b[3];
+    double c[3];
+    double inverse_a[3];
+    double area;
+} TriangleEdges;
+
+/// @brief Everything about a primitive that is the same for every row. Set up once per job of a batch,
+/// it is shared by binning, occlusion culling and every tile the job is drawn in.
+/// Points into the job it was set up from, so it is only valid as long as the job is
+/// @param row_start First row with pixels of the primitive
+/// @param row_end One past the last row with pixels of the primitive. Equal to `row_start` if it has none
+typedef struct PrimitiveSetup
+{
+    DrawJobKind kind;
+    int row_start;
+    int row_end;
+    union
+    {
+        struct
+        {
+            TriangleEdges edges;
+            uint32_t color;
+            int shaded;
+            // Channel value at (x,y) is `plane[channel][0] * x + plane[channel][1] * y + plane[channel][2]`, alpha first
+            double plane[4][3];
+        } triangle;
+        struct
+        {
+            const LineParams *params;
+            double dx;
+            double dy;
+            double inverse_dx;
+            double inverse_dy;
+            double length_squared;
+            double inverse_length_squared;
+            double inverse_length;
+            double band;
+            double reach;
+            double peak;
+            int shaded;
+        } line;
+        struct
+        {
+            const CircleParams *params;
+            double outer;
+            double solid;
+        } circle;
+    };
+} PrimitiveSetup;
+
+/// @brief Sets up a primitive for drawing. The job's transform is ignored
+/// @param job Primitive job
+/// @param setup Filled with the setup of `job`
+/// @return 1 if the primitive may draw pixels, 0 if it draws none, like degenerate triangles or jobs that are not primitives
+int primitive_setup(const DrawJob *job, PrimitiveSetup *setup);
+
+/// @brief Same as primitive_draw_area, with the setup already done
+/// @param setup Setup of the primitive, from primitive_setup
+/// @param area Area to draw
+/// @param dst Pointer to the pixel at the top left of `area`
+/// @param stride Pixels from one row of `dst` to the next
+/// @param blend How the pixels combine with `dst`
+void primitive_setup_draw_area(const PrimitiveSetup *setup, Recti area, uint32_t *dst, int stride, BlendMode blend);
+
+/// @brief Draws the pixels of an area covered by an untransformed primitive, leaving the others unwritten.
+/// Everything that is the same for every row is set up once, and only the covered part of each row is visited
+/// @param job Primitive job to draw. Its transform is ignored
+/// @param area Area to draw
+/// @param dst Pointer to the pixel at the top left of `area`
+/// @param stride Pixels from one row of `dst` to the next
+/// @param blend How the pixels combine with `dst`
+void primitive_draw_area(const DrawJob *job, Recti area, uint32_t *dst, int stride, BlendMode blend);
+
+/// @brief Draws the pixels of row y from x0 up to x1 covered by a primitive, leaving the others unwritten
+/// @param job Primitive job to draw
+/// @param y Row to draw
+/// @param x0 First pixel to draw
+/// @param x1 One past the last pixel to draw
+/// @param dst Pointer to the pixel at (x0,y)
+void primitive_draw_span(const DrawJob *job, int y, int x0, int x1, uint32_t *dst);
+
+/// @brief Trivial reject of a tile. Tile binning uses it to skip the tiles of a primitive's bounding box it misses
+/// @param job Job to test. Jobs that are not primitives, and transformed primitives, touch every tile of their area
+/// @param tile Area of the tile
+/// @return 0 if the job draws no pixel of the tile, 1 if it may
+int primitive_touches_tile(const DrawJob *job, Recti tile);
+
+/// @brief Same as primitive_touches_tile for an untransformed primitive, with the setup already done
+/// @param setup Setup of the primitive, from primitive_setup
+/// @param tile Area of the tile
+/// @return 0 if the primitive draws no pixel of the tile, 1 if it may
+int primitive_setup_touches_tile(const PrimitiveSetup *setup, Recti tile);
+
+/// @brief Trivial accept of occlusion cells. Gives the cells of a tile an opaque primitive covers completely,
+/// the cells whose corner pixels are all inside it
+/// @param job Job to test. Gives 0 for jobs that are not untransformed opaque triangles or filled circles of opaque color
+/// @param setup Setup of `job` from primitive_setup. Only read for the jobs above
+/// @param tile Area of the tile, clamped to the framebuffer
+/// @return Cell mask, see occlusion_cells
+uint64_t primitive_covered_cells(const DrawJob *job, const PrimitiveSetup *setup, Recti tile);
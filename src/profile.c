@@ -0,0 +1,204 @@
+#include "../include/renderer.h"
+
+#ifdef RENDERER_PROFILE
+
+// Frames are recorded into a ring. Writers find the current frame with one atomic load and claim event slots
+// with one atomic add, so recording never takes a lock
+typedef struct Profiler
+{
+    ProfileFrame frames[PROFILE_FRAMES];
+    uint64_t current;
+    int thread_count;
+    uint64_t origin;
+    double ns_per_tick;
+} Profiler;
+
+static Profiler profiler;
+static _Thread_local int profile_thread = -1;
+
+static uint64_t profile_now_ns(void)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+
+    // Threads racing to start the clock store nearly the same values
+    if (!__atomic_load_n(&profiler.origin, __ATOMIC_ACQUIRE))
+    {
+        profiler.ns_per_tick = 1e9 / (double)SDL_GetPerformanceFrequency();
+        __atomic_store_n(&profiler.origin, now - 1, __ATOMIC_RELEASE);
+    }
+    return (uint64_t)((double)(now - profiler.origin) * profiler.ns_per_tick);
+}
+
+static ProfileFrame *profile_current(void)
+{
+    return &profiler.frames[__atomic_load_n(&profiler.current, __ATOMIC_ACQUIRE) % PROFILE_FRAMES];
+}
+
+static ProfileThreadCounters *profile_counters(void)
+{
+    if (profile_thread < 0)
+    {
+        int thread = __atomic_fetch_add(&profiler.thread_count, 1, __ATOMIC_RELAXED);
+        // Threads beyond the limit share the last counters, which is why counters are added atomically
+        profile_thread = thread < PROFILE_MAX_THREADS ? thread : PROFILE_MAX_THREADS - 1;
+    }
+    return &profile_current()->threads[profile_thread];
+}
+
+ProfileScope profile_scope_begin(const char *name)
+{
+    return (ProfileScope){name, profile_now_ns()};
+}
+
+void profile_scope_end(ProfileScope *scope)
+{
+    uint64_t end = profile_now_ns();
+    ProfileFrame *frame = profile_current();
+    if (profile_thread < 0)
+        profile_counters();
+
+    int index = __atomic_fetch_add(&frame->event_count, 1, __ATOMIC_RELAXED);
+    if (index >= PROFILE_MAX_EVENTS)
+    {
+        __atomic_fetch_add(&frame->events_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    frame->events[index] = (ProfileEvent){scope->name, profile_thread, scope->start, end - scope->start};
+}
+
+ProfileScope profile_task_begin(void)
+{
+    return (ProfileScope){NULL, profile_now_ns()};
+}
+
+void profile_task_end(ProfileScope *scope)
+{
+    uint64_t duration = profile_now_ns() - scope->start;
+    ProfileThreadCounters *counters = profile_counters();
+
+    __atomic_fetch_add(&counters->tasks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->task_ns, duration, __ATOMIC_RELAXED);
+}
+
+void profile_count(uint64_t pixels, uint64_t jobs)
+{
+    ProfileThreadCounters *counters = profile_counters();
+
+    __atomic_fetch_add(&counters->pixels, pixels, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&counters->jobs, jobs, __ATOMIC_RELAXED);
+}
+
+void profile_queue_length(int length)
+{
+    ProfileFrame *frame = profile_current();
+    int high_water = __atomic_load_n(&frame->queue_high_water, __ATOMIC_RELAXED);
+
+    while (length > high_water &&
+           !__atomic_compare_exchange_n(&frame->queue_high_water, &high_water, length, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void profile_end_frame(void)
+{
+    uint64_t now = profile_now_ns();
+    uint64_t current = __atomic_load_n(&profiler.current, __ATOMIC_ACQUIRE);
+    ProfileFrame *frame = &profiler.frames[current % PROFILE_FRAMES];
+    ProfileFrame *next = &profiler.frames[(current + 1) % PROFILE_FRAMES];
+
+    frame->index = current;
+    frame->end_ns = now;
+    frame->thread_count = profiler.thread_count < PROFILE_MAX_THREADS ? profiler.thread_count : PROFILE_MAX_THREADS;
+    if (frame->event_count > PROFILE_MAX_EVENTS)
+        frame->event_count = PROFILE_MAX_EVENTS;
+
+    // The oldest frame is reused. Scopes still open from it are recorded into it once they end
+    next->index = current + 1;
+    next->start_ns = now;
+    next->end_ns = 0;
+    next->event_count = 0;
+    next->events_dropped = 0;
+    next->queue_high_water = 0;
+    memset(next->threads, 0, sizeof(next->threads));
+    __atomic_store_n(&profiler.current, current + 1, __ATOMIC_RELEASE);
+}
+
+const ProfileFrame *profile_frame(int frames_ago)
+{
+    uint64_t current = __atomic_load_n(&profiler.current, __ATOMIC_ACQUIRE);
+    if (frames_ago < 1 || frames_ago >= PROFILE_FRAMES || (uint64_t)frames_ago > current)
+        return NULL;
+    return &profiler.frames[(current - frames_ago) % PROFILE_FRAMES];
+}
+
+static void write_counter(FILE *file, const ProfileFrame *frame, const char *name, size_t offset, double scale)
+{
+    fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 0, \"ts\": %.3f, \"args\": {", name, frame->end_ns / 1e3);
+    for (int t = 0; t < frame->thread_count; t++)
+    {
+        uint64_t value = *(const uint64_t *)((const char *)&frame->threads[t] + offset);
+        fprintf(file, "%s\"thread %d\": %.3f", t ? ", " : "", t, value * scale);
+    }
+    fprintf(file, "}}");
+}
+
+int profile_write_chrome_trace(const char *file_name, int frame_count)
+{
+    FILE *file = fopen(file_name, "w");
+    if (!file)
+        return 1;
+
+    // Frames get a track of their own after the threads
+    fprintf(file, "{\"traceEvents\": [\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"frames\"}}",
+            PROFILE_MAX_THREADS);
+    for (int t = 0; t < profiler.thread_count && t < PROFILE_MAX_THREADS; t++)
+        fprintf(file, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}", t, t);
+
+    for (int ago = frame_count; ago >= 1; ago--)
+    {
+        const ProfileFrame *frame = profile_frame(ago);
+        if (!frame)
+            continue;
+
+        fprintf(file, ",\n{\"name\": \"frame %llu\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+                      "\"args\": {\"events_dropped\": %d}}",
+                (unsigned long long)frame->index, PROFILE_MAX_THREADS, frame->start_ns / 1e3,
+                (frame->end_ns - frame->start_ns) / 1e3, frame->events_dropped);
+
+        for (int i = 0; i < frame->event_count; i++)
+        {
+            const ProfileEvent *event = &frame->events[i];
+            fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, event->thread, event->start_ns / 1e3, event->duration_ns / 1e3);
+        }
+
+        write_counter(file, frame, "pixels", offsetof(ProfileThreadCounters, pixels), 1.0);
+        write_counter(file, frame, "jobs", offsetof(ProfileThreadCounters, jobs), 1.0);
+        write_counter(file, frame, "task ms", offsetof(ProfileThreadCounters, task_ns), 1e-6);
+        fprintf(file, ",\n{\"name\": \"queue high water\", \"ph\": \"C\", \"pid\": 0, \"ts\": %.3f, \"args\": {\"jobs\": %d}}",
+                frame->end_ns / 1e3, frame->queue_high_water);
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) != 0;
+}
+
+#else
+
+void profile_end_frame(void)
+{
+}
+
+const ProfileFrame *profile_frame(int frames_ago)
+{
+    (void)frames_ago;
+    return NULL;
+}
+
+int profile_write_chrome_trace(const char *file_name, int frame_count)
+{
+    (void)file_name;
+    (void)frame_count;
+    return 1;
+}
+
+#endif
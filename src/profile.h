@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+
+// Instrumentation is compiled in with -DRENDERER_PROFILE (make PROFILE=1). Without it the PROFILE_ macros expand to nothing,
+// profile_end_frame does nothing and no frames are recorded
+#define PROFILE_FRAMES 16
+#define PROFILE_MAX_EVENTS 4096
+#define PROFILE_MAX_THREADS 64
+
+/// @brief A timed scope
+/// @param name Static name, usually the function timed
+/// @param thread Index of the thread, in the order threads first recorded something
+/// @param start_ns Start, in nanoseconds since profiling started
+/// @param duration_ns Duration in nanoseconds
+typedef struct ProfileEvent
+{
+    const char *name;
+    int thread;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+} ProfileEvent;
+
+/// @brief Work done by one thread in a frame
+/// @param pixels Pixels written, including pixels written into the job cache
+/// @param jobs Parts of jobs drawn. A job split over several tasks or tiles counts once per part
+/// @param tasks Tasks run
+/// @param task_ns Time spent running tasks. The rest of a parallel draw is fork, join and waiting
+typedef struct ProfileThreadCounters
+{
+    uint64_t pixels;
+    uint64_t jobs;
+    uint64_t tasks;
+    uint64_t task_ns;
+} ProfileThreadCounters;
+
+/// @brief Everything recorded in one frame. Frames end with update, frame_ring_submit or profile_end_frame
+/// @param index Number of the frame since profiling started
+/// @param event_count Number of events recorded, at most PROFILE_MAX_EVENTS
+/// @param events_dropped Events not recorded because the frame was full
+/// @param queue_high_water Most jobs held by a draw queue when processed
+/// @param thread_count Number of threads that recorded anything so far, the size of `threads`
+typedef struct ProfileFrame
+{
+    uint64_t index;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    int event_count;
+    int events_dropped;
+    int queue_high_water;
+    int thread_count;
+    ProfileEvent events[PROFILE_MAX_EVENTS];
+    ProfileThreadCounters threads[PROFILE_MAX_THREADS];
+} ProfileFrame;
+
+/// @brief Ends the current frame and starts recording the next one. Called by update and frame_ring_submit
+void profile_end_frame(void);
+
+/// @brief Gives a finished frame. The frame stays valid until PROFILE_FRAMES - 1 more frames end
+/// @param frames_ago 1 for the frame ended last, up to PROFILE_FRAMES - 1
+/// @return The frame, or NULL if it was not recorded or profiling is compiled out
+const ProfileFrame *profile_frame(int frames_ago);
+
+/// @brief Writes finished frames as Chrome trace event JSON, viewable in chrome://tracing or Perfetto.
+/// Counters are written as counter events at the end of each frame
+/// @param file_name File to write
+/// @param frame_count Number of most recent frames to write, at most PROFILE_FRAMES - 1
+/// @return 0 for success and 1 for failure or if profiling is compiled out
+int profile_write_chrome_trace(const char *file_name, int frame_count);
+
+#ifdef RENDERER_PROFILE
+
+typedef struct ProfileScope
+{
+    const char *name;
+    uint64_t start;
+} ProfileScope;
+
+ProfileScope profile_scope_begin(const char *name);
+void profile_scope_end(ProfileScope *scope);
+ProfileScope profile_task_begin(void);
+void profile_task_end(ProfileScope *scope);
+void profile_count(uint64_t pixels, uint64_t jobs);
+void profile_queue_length(int length);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/// @brief Times the rest of the enclosing block as an event
+#define PROFILE_SCOPE(name) \
+    ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__) __attribute__((cleanup(profile_scope_end))) = profile_scope_begin(name)
+/// @brief Counts the rest of the enclosing block as a task of the calling thread, without recording an event
+#define PROFILE_TASK() \
+    ProfileScope PROFILE_CONCAT(profile_task_, __LINE__) __attribute__((cleanup(profile_task_end))) = profile_task_begin()
+#define PROFILE_COUNT(pixels, jobs) profile_count((uint64_t)(pixels), (uint64_t)(jobs))
+#define PROFILE_QUEUE_LENGTH(length) profile_queue_length(length)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_TASK() ((void)0)
+#define PROFILE_COUNT(pixels, jobs) ((void)0)
+#define PROFILE_QUEUE_LENGTH(length) ((void)0)
+
+#endif
@@ -0,0 +1,317 @@
+#include "../include/renderer.h"
+
+static Recti recti_intersect(Recti a, Recti b)
+{
+    return (Recti){
+        .top_left = {a.top_left.x > b.top_left.x ? a.top_left.x : b.top_left.x,
+                     a.top_left.y > b.top_left.y ? a.top_left.y : b.top_left.y},
+        .bottom_right = {a.bottom_right.x < b.bottom_right.x ? a.bottom_right.x : b.bottom_right.x,
+                         a.bottom_right.y < b.bottom_right.y ? a.bottom_right.y : b.bottom_right.y}};
+}
+
+int scene_init(Scene *scene, int width, int height, uint32_t background)
+{
+    *scene = (Scene){0};
+    if (width <= 0 || height <= 0)
+        return 1;
+
+    scene->width = width;
+    scene->height = height;
+    scene->background = background;
+    scene->cells_x = (width + SCENE_CELL_SIZE - 1) / SCENE_CELL_SIZE;
+    scene->cells_y = (height + SCENE_CELL_SIZE - 1) / SCENE_CELL_SIZE;
+    scene->cells = calloc((size_t)scene->cells_x * scene->cells_y, sizeof(SceneCell));
+    if (!scene->cells)
+        return 1;
+
+    // Nothing has been drawn yet, so the first render draws everything
+    dirty_rects_add(&scene->damage, (Recti){{0, 0}, {width, height}});
+    return 0;
+}
+
+void scene_free(Scene *scene)
+{
+    for (int c = 0; scene->cells && c < scene->cells_x * scene->cells_y; c++)
+        free(scene->cells[c].nodes);
+    free(scene->cells);
+    free(scene->nodes);
+    free(scene->free_slots);
+    free(scene->changed);
+    free(scene->items);
+    *scene = (Scene){0};
+}
+
+static int scene_valid(const Scene *scene, SceneHandle node)
+{
+    return node.index >= 0 && node.index < scene->node_count && scene->nodes[node.index].in_use &&
+           !scene->nodes[node.index].removed && scene->nodes[node.index].generation == node.generation;
+}
+
+// Queues a node for the next render, once however often it changes
+static int scene_mark_changed(Scene *scene, int index)
+{
+    if (scene->nodes[index].changed)
+        return 0;
+
+    if (scene->changed_count == scene->changed_capacity)
+    {
+        int capacity = scene->changed_capacity ? scene->changed_capacity * 2 : 64;
+        int *changed = realloc(scene->changed, capacity * sizeof(int));
+        if (!changed)
+            return 1;
+        scene->changed = changed;
+        scene->changed_capacity = capacity;
+    }
+    scene->changed[scene->changed_count++] = index;
+    scene->nodes[index].changed = 1;
+    return 0;
+}
+
+SceneHandle scene_add(Scene *scene, DrawJob job, int z)
+{
+    int index;
+    if (scene->free_count > 0)
+        index = scene->free_slots[--scene->free_count];
+    else
+    {
+        if (scene->node_count == scene->node_capacity)
+        {
+            int capacity = scene->node_capacity ? scene->node_capacity * 2 : 64;
+            SceneNode *nodes = realloc(scene->nodes, capacity * sizeof(SceneNode));
+            if (!nodes)
+                return (SceneHandle){-1, 0};
+            scene->nodes = nodes;
+            scene->node_capacity = capacity;
+        }
+        index = scene->node_count++;
+        scene->nodes[index] = (SceneNode){0};
+    }
+
+    SceneNode *node = &scene->nodes[index];
+    *node = (SceneNode){.job = job, .z = z, .sequence = scene->next_sequence++, .generation = node->generation, .in_use = 1};
+    if (scene_mark_changed(scene, index) != 0)
+    {
+        // Give the slot back where it came from
+        node->in_use = 0;
+        if (index == scene->node_count - 1)
+            scene->node_count--;
+        else
+            scene->free_count++;
+        return (SceneHandle){-1, 0};
+    }
+    return (SceneHandle){index, node->generation};
+}
+
+int scene_remove(Scene *scene, SceneHandle node)
+{
+    if (!scene_valid(scene, node) || scene_mark_changed(scene, node.index) != 0)
+        return 1;
+
+    // The slot is freed by the next render, once its area has been redrawn
+    scene->nodes[node.index].removed = 1;
+    scene->nodes[node.index].generation++;
+    return 0;
+}
+
+int scene_set_job(Scene *scene, SceneHandle node, DrawJob job)
+{
+    if (!scene_valid(scene, node) || scene_mark_changed(scene, node.index) != 0)
+        return 1;
+    scene->nodes[node.index].job = job;
+    return 0;
+}
+
+int scene_set_z(Scene *scene, SceneHandle node, int z)
+{
+    if (!scene_valid(scene, node) || scene_mark_changed(scene, node.index) != 0)
+        return 1;
+    scene->nodes[node.index].z = z;
+    return 0;
+}
+
+int scene_move(Scene *scene, SceneHandle node, Pointi offset)
+{
+    if (!scene_valid(scene, node) || scene_mark_changed(scene, node.index) != 0)
+        return 1;
+    scene->nodes[node.index].offset = offset;
+    return 0;
+}
+
+int scene_set_transform(Scene *scene, SceneHandle node, const TransformationMatrix *matrix)
+{
+    if (!scene_valid(scene, node) || scene_mark_changed(scene, node.index) != 0)
+        return 1;
+    scene->nodes[node.index].has_matrix = matrix != NULL;
+    if (matrix)
+        scene->nodes[node.index].matrix = *matrix;
+    return 0;
+}
+
+void scene_invalidate(Scene *scene, Recti area)
+{
+    dirty_rects_add(&scene->damage, recti_clamp(area, scene->width, scene->height));
+}
+
+// Adds a node to or removes it from every cell its bounds touch
+static int scene_update_cells(Scene *scene, int index, int add)
+{
+    Recti bounds = scene->nodes[index].bounds;
+    if (recti_is_empty(bounds))
+        return 0;
+
+    for (int cy = bounds.top_left.y / SCENE_CELL_SIZE; cy <= (bounds.bottom_right.y - 1) / SCENE_CELL_SIZE; cy++)
+    {
+        for (int cx = bounds.top_left.x / SCENE_CELL_SIZE; cx <= (bounds.bottom_right.x - 1) / SCENE_CELL_SIZE; cx++)
+        {
+            SceneCell *cell = &scene->cells[cy * scene->cells_x + cx];
+            if (!add)
+            {
+                for (int i = 0; i < cell->count; i++)
+                {
+                    if (cell->nodes[i] == index)
+                    {
+                        cell->nodes[i] = cell->nodes[--cell->count];
+                        break;
+                    }
+                }
+                continue;
+            }
+
+            if (cell->count == cell->capacity)
+            {
+                int capacity = cell->capacity ? cell->capacity * 2 : 16;
+                int *nodes = realloc(cell->nodes, capacity * sizeof(int));
+                if (!nodes)
+                    return 1;
+                cell->nodes = nodes;
+                cell->capacity = capacity;
+            }
+            cell->nodes[cell->count++] = index;
+        }
+    }
+    return 0;
+}
+
+static int compare_draw_items(const void *a, const void *b)
+{
+    const SceneDrawItem *x = a, *y = b;
+    if (x->z != y->z)
+        return (x->z > y->z) - (x->z < y->z);
+    return (x->sequence > y->sequence) - (x->sequence < y->sequence);
+}
+
+// Finds the nodes touching an area and sorts them into drawing order
+static int scene_collect(Scene *scene, Recti area)
+{
+    int count = 0;
+    scene->visit++;
+
+    for (int cy = area.top_left.y / SCENE_CELL_SIZE; cy <= (area.bottom_right.y - 1) / SCENE_CELL_SIZE; cy++)
+    {
+        for (int cx = area.top_left.x / SCENE_CELL_SIZE; cx <= (area.bottom_right.x - 1) / SCENE_CELL_SIZE; cx++)
+        {
+            const SceneCell *cell = &scene->cells[cy * scene->cells_x + cx];
+            for (int i = 0; i < cell->count; i++)
+            {
+                SceneNode *node = &scene->nodes[cell->nodes[i]];
+                if (node->visit == scene->visit || recti_is_empty(recti_intersect(node->bounds, area)))
+                    continue;
+                node->visit = scene->visit;
+
+                if (count == scene->item_capacity)
+                {
+                    int capacity = scene->item_capacity ? scene->item_capacity * 2 : 64;
+                    SceneDrawItem *items = realloc(scene->items, capacity * sizeof(SceneDrawItem));
+                    if (!items)
+                        return -1;
+                    scene->items = items;
+                    scene->item_capacity = capacity;
+                }
+                scene->items[count++] = (SceneDrawItem){node->z, node->sequence, cell->nodes[i]};
+            }
+        }
+    }
+
+    qsort(scene->items, count, sizeof(SceneDrawItem), compare_draw_items);
+    return count;
+}
+
+int scene_render(Scene *scene, Framebuffer *fb)
+{
+    PROFILE_SCOPE("scene_render");
+    if (fb->width != scene->width || fb->height != scene->height)
+        return 1;
+
+    scene->stats = (SceneStats){.changed = scene->changed_count};
+
+    // Diff the changed nodes: their old and new areas both need redrawing
+    for (int c = 0; c < scene->changed_count; c++)
+    {
+        int index = scene->changed[c];
+        SceneNode *node = &scene->nodes[index];
+        Recti old_bounds = node->bounds;
+        node->changed = 0;
+        dirty_rects_add(&scene->damage, old_bounds);
+
+        if (node->removed)
+        {
+            scene_update_cells(scene, index, 0);
+            node->in_use = 0;
+            node->removed = 0;
+            if (scene->free_count == scene->free_capacity)
+            {
+                int capacity = scene->free_capacity ? scene->free_capacity * 2 : 64;
+                int *slots = realloc(scene->free_slots, capacity * sizeof(int));
+                if (!slots)
+                    continue;
+                scene->free_slots = slots;
+                scene->free_capacity = capacity;
+            }
+            scene->free_slots[scene->free_count++] = index;
+            continue;
+        }
+
+        node->drawn = node->job;
+        if (node->has_matrix)
+            node->drawn = drawjob_transform(node->drawn, node->matrix);
+        if (node->offset.x || node->offset.y)
+            node->drawn = drawjob_shift(node->drawn, node->offset);
+
+        Recti bounds = recti_clamp(node->drawn.area, scene->width, scene->height);
+        if (recti_is_empty(bounds))
+            bounds = (Recti){0};
+        if (memcmp(&bounds, &old_bounds, sizeof(Recti)) != 0)
+        {
+            scene_update_cells(scene, index, 0);
+            node->bounds = bounds;
+            if (scene_update_cells(scene, index, 1) != 0)
+                return 1;
+        }
+        dirty_rects_add(&scene->damage, bounds);
+    }
+    scene->changed_count = 0;
+
+    // Repaint every damaged area from the background up. Areas may overlap, and an area queued later repaints the overlap whole
+    for (int r = 0; r < scene->damage.count; r++)
+    {
+        Recti area = scene->damage.rects[r];
+        int count = scene_collect(scene, area);
+        if (count < 0)
+            return 1;
+
+        enqueue_draw_job(fb, drawjob_solid(area, scene->background));
+        for (int i = 0; i < count; i++)
+        {
+            DrawJob job = scene->nodes[scene->items[i].node].drawn;
+            job.area = recti_intersect(job.area, area);
+            enqueue_draw_job(fb, job);
+        }
+        scene->stats.jobs_drawn += count;
+    }
+
+    scene->stats.damage_rects = scene->damage.count;
+    scene->stats.damage_pixels = dirty_rects_pixels(&scene->damage);
+    dirty_rects_clear(&scene->damage);
+    process_queue_safe(fb);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <stdint.h>
+#include "drawjob.h"
+#include "drawjob_modifier.h"
+#include "dirty_rects.h"
+
+// Side of the square cells the scene sorts its nodes into, in pixels
+#define SCENE_CELL_SIZE 128
+
+/// @brief Refers to a node of a scene. Handles of removed nodes stop working, even once their slot is reused
+typedef struct SceneHandle
+{
+    int index;
+    uint32_t generation;
+} SceneHandle;
+
+/// @brief A retained job. Nodes are drawn in increasing `z`, nodes of equal `z` in the order they were added
+/// @param job Job as given, before the node's transform
+/// @param drawn Job as drawn: `job` transformed by `matrix`, then shifted by `offset`
+/// @param bounds Area of `drawn` clamped to the scene, as of the last scene_render
+/// @param sequence Order the node was added in
+/// @param changed Set when the node changed since the last scene_render, and its index is in `changed`
+/// @param removed Set when the node was removed since the last scene_render, its slot is freed there
+typedef struct SceneNode
+{
+    DrawJob job;
+    DrawJob drawn;
+    Recti bounds;
+    int z;
+    uint64_t sequence;
+    int has_matrix;
+    TransformationMatrix matrix;
+    Pointi offset;
+    uint32_t generation;
+    int in_use;
+    int changed;
+    int removed;
+    uint32_t visit;
+} SceneNode;
+
+/// @brief Nodes whose bounds touch a cell of the scene
+typedef struct SceneCell
+{
+    int *nodes;
+    int count;
+    int capacity;
+} SceneCell;
+
+/// @brief A node found in a damaged area, sorted by `z` and `sequence` before drawing
+typedef struct SceneDrawItem
+{
+    int z;
+    uint64_t sequence;
+    int node;
+} SceneDrawItem;
+
+/// @brief Counters of the last scene_render
+/// @param changed Nodes added, changed or removed since the render before
+/// @param damage_rects Areas redrawn
+/// @param damage_pixels Pixels redrawn
+/// @param jobs_drawn Node jobs drawn, counting a node once per area it was drawn in
+typedef struct SceneStats
+{
+    int changed;
+    int damage_rects;
+    long long damage_pixels;
+    int jobs_drawn;
+} SceneStats;
+
+/// @brief A retained list of jobs. Nodes are added, changed and removed through handles, and scene_render redraws
+/// only the areas the changes touched, so the time per frame follows what changed rather than the size of the scene.
+/// Nodes are kept in a grid of SCENE_CELL_SIZE cells to find the nodes of a damaged area without visiting the others
+/// @param background Color of pixels no node covers
+/// @param nodes Node slots, indices of free slots are kept in `free_slots`
+/// @param changed Indices of nodes changed since the last scene_render
+/// @param damage Areas to redraw on top of those of the changed nodes
+typedef struct Scene
+{
+    int width;
+    int height;
+    uint32_t background;
+    SceneNode *nodes;
+    int node_count;
+    int node_capacity;
+    int *free_slots;
+    int free_count;
+    int free_capacity;
+    int *changed;
+    int changed_count;
+    int changed_capacity;
+    SceneCell *cells;
+    int cells_x;
+    int cells_y;
+    SceneDrawItem *items;
+    int item_capacity;
+    uint64_t next_sequence;
+    uint32_t visit;
+    DirtyRects damage;
+    SceneStats stats;
+} Scene;
+
+/// @brief Creates an empty scene. The first scene_render draws all of it
+/// @param scene Scene to initialize
+/// @param width Width of the framebuffers the scene is drawn to
+/// @param height Height of the framebuffers the scene is drawn to
+/// @param background Color of pixels no node covers
+/// @return 0 for success and 1 for failure
+int scene_init(Scene *scene, int width, int height, uint32_t background);
+
+/// @brief Frees the scene. Handles of its nodes stop working
+/// @param scene Scene to free
+void scene_free(Scene *scene);
+
+/// @brief Adds a node
+/// @param scene Scene to add to
+/// @param job Job the node draws. Userdata and bitmap pixels must stay valid while the node exists
+/// @param z Drawing order, higher z is drawn on top
+/// @return Handle of the node, with index -1 if allocation failed
+SceneHandle scene_add(Scene *scene, DrawJob job, int z);
+
+/// @brief Removes a node
+/// @param scene Scene of the node
+/// @param node Node to remove
+/// @return 0 for success and 1 if the handle doesn't refer to a node
+int scene_remove(Scene *scene, SceneHandle node);
+
+/// @brief Replaces the job of a node. Also needed when a job's output changes without the job changing,
+/// like a callback drawing something else
+/// @param scene Scene of the node
+/// @param node Node to change
+/// @param job New job
+/// @return 0 for success and 1 if the handle doesn't refer to a node
+int scene_set_job(Scene *scene, SceneHandle node, DrawJob job);
+
+/// @brief Changes the drawing order of a node
+/// @param scene Scene of the node
+/// @param node Node to change
+/// @param z New drawing order
+/// @return 0 for success and 1 if the handle doesn't refer to a node
+int scene_set_z(Scene *scene, SceneHandle node, int z);
+
+/// @brief Moves a node. The job is drawn shifted by `offset`, after its matrix
+/// @param scene Scene of the node
+/// @param node Node to move
+/// @param offset Shift of the job
+/// @return 0 for success and 1 if the handle doesn't refer to a node
+int scene_move(Scene *scene, SceneHandle node, Pointi offset);
+
+/// @brief Transforms a node's job with a matrix around the origin, before its offset
+/// @param scene Scene of the node
+/// @param node Node to change
+/// @param matrix Matrix to transform with, NULL to draw the job untransformed
+/// @return 0 for success and 1 if the handle doesn't refer to a node
+int scene_set_transform(Scene *scene, SceneHandle node, const TransformationMatrix *matrix);
+
+/// @brief Marks an area to be redrawn by the next scene_render, for example after something else drew over it
+/// @param scene Scene to change
+/// @param area Area to redraw. Clamped to the scene
+void scene_invalidate(Scene *scene, Recti area);
+
+/// @brief Redraws the areas changed since the last call: the old and new areas of every changed node and the invalidated areas.
+/// Every area is cleared to the background and the nodes touching it are drawn clipped to it in z-order, through the framebuffer's
+/// queue and process_queue_safe. The framebuffer must hold what the last call drew, and its queue must be empty
+/// @param scene Scene to draw
+/// @param fb Framebuffer the scene's size
+/// @return 0 for success and 1 for failure
+int scene_render(Scene *scene, Framebuffer *fb);
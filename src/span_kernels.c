@@ -0,0 +1,391 @@
+#include "../include/renderer.h"
+
+uint32_t gradient_color(int64_t t, uint32_t start_color, uint32_t end_color)
+{
+    int64_t w = t >> 8;
+    if (w < 0)
+        w = 0;
+    if (w > 256)
+        w = 256;
+
+    uint32_t weight = (uint32_t)w;
+    uint32_t color = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t c0 = (start_color >> shift) & 0xFF;
+        uint32_t c1 = (end_color >> shift) & 0xFF;
+        color |= ((c0 * (256 - weight) + c1 * weight) >> 8) << shift;
+    }
+    return color;
+}
+
+static void fill_solid_scalar(uint32_t *dst, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = color;
+}
+
+// Gradient position `n` pixels further along. Wraps instead of overflowing for lanes past the end of a span
+static inline int32_t step_t(int32_t t, int32_t dt, int n)
+{
+    return (int32_t)((uint32_t)t + (uint32_t)dt * (uint32_t)n);
+}
+
+static void fill_gradient_scalar(uint32_t *dst, int count, int32_t t, int32_t dt, uint32_t start_color, uint32_t end_color)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = gradient_color(step_t(t, dt, i), start_color, end_color);
+}
+
+// a * b / 255, rounded. Exact for all 8 bit inputs
+static inline uint32_t mul_255(uint32_t a, uint32_t b)
+{
+    uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+uint32_t blend_color(uint32_t src, uint32_t dst, BlendMode mode)
+{
+    uint32_t inv_src_alpha = 255 - (src >> 24);
+    uint32_t inv_dst_alpha = 255 - (dst >> 24);
+    uint32_t color = 0;
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t s = (src >> shift) & 0xFF;
+        uint32_t d = (dst >> shift) & 0xFF;
+        uint32_t c;
+
+        switch (mode)
+        {
+        case BLEND_SRC_OVER:
+            c = s + mul_255(d, inv_src_alpha);
+            break;
+        case BLEND_ADD:
+            c = s + d;
+            break;
+        case BLEND_MULTIPLY:
+            c = mul_255(s, d) + mul_255(s, inv_dst_alpha) + mul_255(d, inv_src_alpha);
+            break;
+        default:
+            c = s;
+            break;
+        }
+        color |= (c > 255 ? 255 : c) << shift;
+    }
+    return color;
+}
+
+uint32_t color_premultiply(uint32_t color)
+{
+    uint32_t alpha = color >> 24;
+    return (color & 0xFF000000) |
+           mul_255((color >> 16) & 0xFF, alpha) << 16 |
+           mul_255((color >> 8) & 0xFF, alpha) << 8 |
+           mul_255(color & 0xFF, alpha);
+}
+
+static void blend_scalar(uint32_t *dst, const uint32_t *src, int count, BlendMode mode)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = blend_color(src[i], dst[i], mode);
+}
+
+static void fill_masked_scalar(uint32_t *dst, const uint8_t *mask, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = mask[i] ? color : dst[i];
+}
+
+#ifdef RENDERER_X86
+
+__attribute__((target("sse2"))) static void fill_solid_sse2(uint32_t *dst, int count, uint32_t color)
+{
+    __m128i c = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(dst + i), c);
+        _mm_storeu_si128((__m128i *)(dst + i + 4), c);
+    }
+    for (; i < count; i++)
+        dst[i] = color;
+}
+
+// Interpolates one 8 bit channel of 8 pixels held in 16 bit lanes
+__attribute__((target("sse2"))) static inline __m128i lerp_channel_sse2(__m128i w, __m128i inv_w, uint32_t c0, uint32_t c1, int shift)
+{
+    __m128i a = _mm_set1_epi16((short)((c0 >> shift) & 0xFF));
+    __m128i b = _mm_set1_epi16((short)((c1 >> shift) & 0xFF));
+    return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(a, inv_w), _mm_mullo_epi16(b, w)), 8);
+}
+
+__attribute__((target("sse2"))) static void fill_gradient_sse2(uint32_t *dst, int count, int32_t t, int32_t dt, uint32_t start_color, uint32_t end_color)
+{
+    __m128i t_lo = _mm_setr_epi32(t, step_t(t, dt, 1), step_t(t, dt, 2), step_t(t, dt, 3));
+    __m128i t_hi = _mm_add_epi32(t_lo, _mm_set1_epi32(step_t(0, dt, 4)));
+    __m128i step = _mm_set1_epi32(step_t(0, dt, 8));
+    __m128i zero = _mm_setzero_si128();
+    __m128i full = _mm_set1_epi16(256);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i w = _mm_packs_epi32(_mm_srai_epi32(t_lo, 8), _mm_srai_epi32(t_hi, 8));
+        w = _mm_min_epi16(_mm_max_epi16(w, zero), full);
+        __m128i inv_w = _mm_sub_epi16(full, w);
+
+        __m128i b = lerp_channel_sse2(w, inv_w, start_color, end_color, 0);
+        __m128i g = lerp_channel_sse2(w, inv_w, start_color, end_color, 8);
+        __m128i r = lerp_channel_sse2(w, inv_w, start_color, end_color, 16);
+        __m128i a = lerp_channel_sse2(w, inv_w, start_color, end_color, 24);
+
+        __m128i gb = _mm_or_si128(_mm_slli_epi16(g, 8), b);
+        __m128i ar = _mm_or_si128(_mm_slli_epi16(a, 8), r);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(gb, ar));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(gb, ar));
+
+        t_lo = _mm_add_epi32(t_lo, step);
+        t_hi = _mm_add_epi32(t_hi, step);
+    }
+
+    fill_gradient_scalar(dst + i, count - i, step_t(t, dt, i), dt, start_color, end_color);
+}
+
+__attribute__((target("sse2"))) static inline __m128i mul_255_sse2(__m128i a, __m128i b)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Blends two pixels held in 16 bit lanes. Results above 255 saturate when packed
+__attribute__((target("sse2"))) static inline __m128i blend_pixels_sse2(__m128i s, __m128i d, BlendMode mode)
+{
+    __m128i max = _mm_set1_epi16(255);
+    __m128i inv_src_alpha = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF));
+    if (mode == BLEND_SRC_OVER)
+        return _mm_add_epi16(s, mul_255_sse2(d, inv_src_alpha));
+
+    __m128i inv_dst_alpha = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xFF), 0xFF));
+    return _mm_add_epi16(_mm_add_epi16(mul_255_sse2(s, d), mul_255_sse2(s, inv_dst_alpha)), mul_255_sse2(d, inv_src_alpha));
+}
+
+__attribute__((target("sse2"))) static void blend_sse2(uint32_t *dst, const uint32_t *src, int count, BlendMode mode)
+{
+    __m128i zero = _mm_setzero_si128();
+    int i = 0;
+
+    if (mode == BLEND_OPAQUE)
+    {
+        memcpy(dst, src, (size_t)count * sizeof(uint32_t));
+        return;
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i result;
+
+        if (mode == BLEND_ADD)
+            result = _mm_adds_epu8(s, d);
+        else
+        {
+            __m128i lo = blend_pixels_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), mode);
+            __m128i hi = blend_pixels_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), mode);
+            result = _mm_packus_epi16(lo, hi);
+        }
+        _mm_storeu_si128((__m128i *)(dst + i), result);
+    }
+
+    blend_scalar(dst + i, src + i, count - i, mode);
+}
+
+// SSE2 has no masked store, so the uncovered pixels are read and written back unchanged
+__attribute__((target("sse2"))) static void fill_masked_sse2(uint32_t *dst, const uint8_t *mask, int count, uint32_t color)
+{
+    __m128i c = _mm_set1_epi32((int)color);
+    __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        int32_t bytes;
+        memcpy(&bytes, mask + i, sizeof(bytes));
+        __m128i uncovered = _mm_cmpeq_epi8(_mm_cvtsi32_si128(bytes), zero);
+        uncovered = _mm_unpacklo_epi8(uncovered, uncovered);
+        uncovered = _mm_unpacklo_epi16(uncovered, uncovered);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(_mm_and_si128(uncovered, d), _mm_andnot_si128(uncovered, c)));
+    }
+    fill_masked_scalar(dst + i, mask + i, count - i, color);
+}
+
+__attribute__((target("avx2"))) static void fill_solid_avx2(uint32_t *dst, int count, uint32_t color)
+{
+    __m256i c = _mm256_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm256_storeu_si256((__m256i *)(dst + i), c);
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), c);
+    }
+    for (; i < count; i++)
+        dst[i] = color;
+}
+
+__attribute__((target("avx2"))) static inline __m256i lerp_channel_avx2(__m256i w, __m256i inv_w, uint32_t c0, uint32_t c1, int shift)
+{
+    __m256i a = _mm256_set1_epi16((short)((c0 >> shift) & 0xFF));
+    __m256i b = _mm256_set1_epi16((short)((c1 >> shift) & 0xFF));
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, inv_w), _mm256_mullo_epi16(b, w)), 8);
+}
+
+// Packing and unpacking both work within 128 bit lanes, so the unpacks undo the lane interleaving of the pack
+__attribute__((target("avx2"))) static void fill_gradient_avx2(uint32_t *dst, int count, int32_t t, int32_t dt, uint32_t start_color, uint32_t end_color)
+{
+    __m256i t_lo = _mm256_add_epi32(_mm256_set1_epi32(t), _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(dt)));
+    __m256i t_hi = _mm256_add_epi32(t_lo, _mm256_set1_epi32(step_t(0, dt, 8)));
+    __m256i step = _mm256_set1_epi32(step_t(0, dt, 16));
+    __m256i zero = _mm256_setzero_si256();
+    __m256i full = _mm256_set1_epi16(256);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i w = _mm256_packs_epi32(_mm256_srai_epi32(t_lo, 8), _mm256_srai_epi32(t_hi, 8));
+        w = _mm256_min_epi16(_mm256_max_epi16(w, zero), full);
+        __m256i inv_w = _mm256_sub_epi16(full, w);
+
+        __m256i b = lerp_channel_avx2(w, inv_w, start_color, end_color, 0);
+        __m256i g = lerp_channel_avx2(w, inv_w, start_color, end_color, 8);
+        __m256i r = lerp_channel_avx2(w, inv_w, start_color, end_color, 16);
+        __m256i a = lerp_channel_avx2(w, inv_w, start_color, end_color, 24);
+
+        __m256i gb = _mm256_or_si256(_mm256_slli_epi16(g, 8), b);
+        __m256i ar = _mm256_or_si256(_mm256_slli_epi16(a, 8), r);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_unpacklo_epi16(gb, ar));
+        _mm256_storeu_si256((__m256i *)(dst + i + 8), _mm256_unpackhi_epi16(gb, ar));
+
+        t_lo = _mm256_add_epi32(t_lo, step);
+        t_hi = _mm256_add_epi32(t_hi, step);
+    }
+
+    fill_gradient_sse2(dst + i, count - i, step_t(t, dt, i), dt, start_color, end_color);
+}
+
+__attribute__((target("avx2"))) static inline __m256i mul_255_avx2(__m256i a, __m256i b)
+{
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2"))) static inline __m256i blend_pixels_avx2(__m256i s, __m256i d, BlendMode mode)
+{
+    __m256i max = _mm256_set1_epi16(255);
+    __m256i inv_src_alpha = _mm256_sub_epi16(max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF));
+    if (mode == BLEND_SRC_OVER)
+        return _mm256_add_epi16(s, mul_255_avx2(d, inv_src_alpha));
+
+    __m256i inv_dst_alpha = _mm256_sub_epi16(max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(d, 0xFF), 0xFF));
+    return _mm256_add_epi16(_mm256_add_epi16(mul_255_avx2(s, d), mul_255_avx2(s, inv_dst_alpha)), mul_255_avx2(d, inv_src_alpha));
+}
+
+// Unpacking and packing both work within 128 bit lanes, so pixels come back in their original order
+__attribute__((target("avx2"))) static void blend_avx2(uint32_t *dst, const uint32_t *src, int count, BlendMode mode)
+{
+    __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+
+    if (mode == BLEND_OPAQUE)
+    {
+        memcpy(dst, src, (size_t)count * sizeof(uint32_t));
+        return;
+    }
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i result;
+
+        if (mode == BLEND_ADD)
+            result = _mm256_adds_epu8(s, d);
+        else
+        {
+            __m256i lo = blend_pixels_avx2(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), mode);
+            __m256i hi = blend_pixels_avx2(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), mode);
+            result = _mm256_packus_epi16(lo, hi);
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), result);
+    }
+
+    blend_sse2(dst + i, src + i, count - i, mode);
+}
+
+__attribute__((target("avx2"))) static void fill_masked_avx2(uint32_t *dst, const uint8_t *mask, int count, uint32_t color)
+{
+    __m256i c = _mm256_set1_epi32((int)color);
+    __m128i zero = _mm_setzero_si128();
+    __m256i ones = _mm256_set1_epi32(-1);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i uncovered = _mm_cmpeq_epi8(_mm_loadl_epi64((const __m128i *)(mask + i)), zero);
+        __m256i covered = _mm256_xor_si256(_mm256_cvtepi8_epi32(uncovered), ones);
+        _mm256_maskstore_epi32((int *)(dst + i), covered, c);
+    }
+    fill_masked_sse2(dst + i, mask + i, count - i, color);
+}
+
+#endif
+
+static SpanKernels span_kernels = {fill_solid_scalar, fill_gradient_scalar, blend_scalar, fill_masked_scalar};
+static SimdLevel span_kernels_level = SIMD_SCALAR;
+
+SimdLevel simd_detect(void)
+{
+#ifdef RENDERER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SIMD_SSE2;
+#endif
+    return SIMD_SCALAR;
+}
+
+SimdLevel simd_select(SimdLevel level)
+{
+    SimdLevel supported = simd_detect();
+    if (level > supported)
+        level = supported;
+
+    switch (level)
+    {
+#ifdef RENDERER_X86
+    case SIMD_AVX2:
+        span_kernels = (SpanKernels){fill_solid_avx2, fill_gradient_avx2, blend_avx2, fill_masked_avx2};
+        break;
+    case SIMD_SSE2:
+        span_kernels = (SpanKernels){fill_solid_sse2, fill_gradient_sse2, blend_sse2, fill_masked_sse2};
+        break;
+#endif
+    default:
+        level = SIMD_SCALAR;
+        span_kernels = (SpanKernels){fill_solid_scalar, fill_gradient_scalar, blend_scalar, fill_masked_scalar};
+        break;
+    }
+
+    span_kernels_level = level;
+    return level;
+}
+
+SimdLevel simd_level(void)
+{
+    return span_kernels_level;
+}
+
+__attribute__((constructor)) static void span_kernels_init(void)
+{
+    simd_select(simd_detect());
+}
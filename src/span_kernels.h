@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RENDERER_X86 1
+#endif
+
+/// @brief Instruction sets the span kernels can use
+typedef enum SimdLevel
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2
+} SimdLevel;
+
+/// @brief How a job's pixels combine with the pixels under them. Colors are ARGB with premultiplied alpha
+/// @param BLEND_OPAQUE Overwrites the pixels. The default, and the only mode that doesn't read the framebuffer
+/// @param BLEND_SRC_OVER Draws over the pixels: src + dst * (1 - src alpha)
+/// @param BLEND_ADD Adds to the pixels, saturating at full intensity
+/// @param BLEND_MULTIPLY Darkens the pixels: src * dst + src * (1 - dst alpha) + dst * (1 - src alpha)
+typedef enum BlendMode
+{
+    BLEND_OPAQUE = 0,
+    BLEND_SRC_OVER,
+    BLEND_ADD,
+    BLEND_MULTIPLY
+} BlendMode;
+
+/// @brief Row kernels used by the built in job kinds. Chosen at startup from the instruction sets the CPU supports.
+/// All kernels produce exactly the same pixels regardless of the level in use
+/// @param fill_solid Fills `count` pixels with `color`
+/// @param fill_gradient Fills `count` pixels of a gradient. `t` is the 16.16 fixed point gradient position of the first pixel, increasing by `dt` per pixel
+/// @param blend Blends `count` pixels of `src` into `dst` with `mode`
+/// @param fill_masked Sets the pixels of `count` whose byte in `mask` is nonzero to `color`, leaving the others unwritten
+typedef struct SpanKernels
+{
+    void (*fill_solid)(uint32_t *dst, int count, uint32_t color);
+    void (*fill_gradient)(uint32_t *dst, int count, int32_t t, int32_t dt, uint32_t start_color, uint32_t end_color);
+    void (*blend)(uint32_t *dst, const uint32_t *src, int count, BlendMode mode);
+    void (*fill_masked)(uint32_t *dst, const uint8_t *mask, int count, uint32_t color);
+} SpanKernels;
+
+/// @brief Best instruction set supported by the CPU
+/// @return The best supported SimdLevel
+SimdLevel simd_detect(void);
+
+/// @brief Selects which kernels to use. Intended for testing and benchmarking, the best level is selected at startup.
+/// Must not be called while drawing
+/// @param level Wanted level. Lowered to the best supported level if the CPU lacks it
+/// @return The level actually selected
+SimdLevel simd_select(SimdLevel level);
+
+/// @brief Currently selected instruction set
+/// @return The selected SimdLevel
+SimdLevel simd_level(void);
+
+/// @brief Color of a gradient at a 16.16 fixed point position, clamped to the start and end colors.
+/// This is the reference every gradient kernel matches
+/// @param t Gradient position where 0 is the start color and 65536 the end color
+/// @param start_color Color at t = 0
+/// @param end_color Color at t = 65536
+/// @return Interpolated ARGB color
+uint32_t gradient_color(int64_t t, uint32_t start_color, uint32_t end_color);
+
+/// @brief Blends one premultiplied ARGB pixel into another. This is the reference every blend kernel matches
+/// @param src Pixel being drawn
+/// @param dst Pixel under it
+/// @param mode How to combine them
+/// @return The blended pixel
+uint32_t blend_color(uint32_t src, uint32_t dst, BlendMode mode);
+
+/// @brief Converts a straight alpha ARGB color to premultiplied alpha, as used by the blend modes
+/// @param color Color with straight alpha
+/// @return The color with every channel scaled by its alpha
+uint32_t color_premultiply(uint32_t color);
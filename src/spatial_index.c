@@ -0,0 +1,161 @@
+#include "../include/renderer.h"
+
+// Grows an int array to hold at least `needed` entries, doubling from 64
+static int spatial_index_reserve(int **array, int *capacity, int needed)
+{
+    if (needed <= *capacity)
+        return 0;
+
+    int grown = *capacity ? *capacity : 64;
+    while (grown < needed)
+        grown *= 2;
+    int *resized = realloc(*array, grown * sizeof(int));
+    if (!resized)
+        return 1;
+    *array = resized;
+    *capacity = grown;
+    return 0;
+}
+
+int spatial_index_build(SpatialIndex *index, const DrawJob *jobs, int job_count, int width, int height)
+{
+    PROFILE_SCOPE("spatial_index_build");
+    index->width = width > 0 ? width : 0;
+    index->height = height > 0 ? height : 0;
+    index->cells_x = (index->width + SPATIAL_INDEX_CELL_SIZE - 1) / SPATIAL_INDEX_CELL_SIZE;
+    index->cells_y = (index->height + SPATIAL_INDEX_CELL_SIZE - 1) / SPATIAL_INDEX_CELL_SIZE;
+    index->jobs = jobs;
+    index->job_count = 0;
+    int cell_count = index->cells_x * index->cells_y;
+
+    int capacity = index->cell_capacity;
+    if (spatial_index_reserve(&index->cell_start, &capacity, cell_count + 1) != 0 ||
+        spatial_index_reserve(&index->cell_fill, &index->cell_capacity, cell_count + 1) != 0)
+        return 1;
+    if (job_count > index->area_capacity)
+    {
+        int grown = index->area_capacity ? index->area_capacity : 64;
+        while (grown < job_count)
+            grown *= 2;
+        Recti *areas = realloc(index->areas, grown * sizeof(Recti));
+        if (!areas)
+            return 1;
+        index->areas = areas;
+        index->area_capacity = grown;
+    }
+
+    for (int c = 0; c <= cell_count; c++)
+        index->cell_start[c] = 0;
+
+    // Count how many jobs touch every cell
+    for (int j = 0; j < job_count; j++)
+    {
+        Recti area = recti_clamp(jobs[j].area, index->width, index->height);
+        if (recti_is_empty(area))
+            area = (Recti){0};
+        index->areas[j] = area;
+        if (recti_is_empty(area))
+            continue;
+
+        for (int cy = area.top_left.y / SPATIAL_INDEX_CELL_SIZE; cy <= (area.bottom_right.y - 1) / SPATIAL_INDEX_CELL_SIZE; cy++)
+            for (int cx = area.top_left.x / SPATIAL_INDEX_CELL_SIZE; cx <= (area.bottom_right.x - 1) / SPATIAL_INDEX_CELL_SIZE; cx++)
+                index->cell_start[cy * index->cells_x + cx + 1]++;
+    }
+
+    for (int c = 0; c < cell_count; c++)
+    {
+        index->cell_start[c + 1] += index->cell_start[c];
+        index->cell_fill[c] = index->cell_start[c];
+    }
+
+    if (spatial_index_reserve(&index->job_indices, &index->index_capacity, index->cell_start[cell_count]) != 0)
+        return 1;
+
+    // Jobs are visited in submission order, which keeps every cell's list in submission order
+    for (int j = 0; j < job_count; j++)
+    {
+        Recti area = index->areas[j];
+        if (recti_is_empty(area))
+            continue;
+
+        for (int cy = area.top_left.y / SPATIAL_INDEX_CELL_SIZE; cy <= (area.bottom_right.y - 1) / SPATIAL_INDEX_CELL_SIZE; cy++)
+            for (int cx = area.top_left.x / SPATIAL_INDEX_CELL_SIZE; cx <= (area.bottom_right.x - 1) / SPATIAL_INDEX_CELL_SIZE; cx++)
+                index->job_indices[index->cell_fill[cy * index->cells_x + cx]++] = j;
+    }
+
+    index->job_count = job_count;
+    return 0;
+}
+
+int spatial_index_hit(const SpatialIndex *index, Pointi point)
+{
+    if (point.x < 0 || point.y < 0 || point.x >= index->width || point.y >= index->height || !index->job_count)
+        return -1;
+
+    int cell = (point.y / SPATIAL_INDEX_CELL_SIZE) * index->cells_x + point.x / SPATIAL_INDEX_CELL_SIZE;
+    Recti pixel = {point, {point.x + 1, point.y + 1}};
+
+    // Later jobs are drawn over earlier ones, so the first match from the back is on top
+    for (int i = index->cell_start[cell + 1] - 1; i >= index->cell_start[cell]; i--)
+    {
+        int j = index->job_indices[i];
+        Recti area = index->areas[j];
+        if (point.x < area.top_left.x || point.x >= area.bottom_right.x || point.y < area.top_left.y || point.y >= area.bottom_right.y)
+            continue;
+        if (drawjob_is_primitive(&index->jobs[j]) && !primitive_touches_tile(&index->jobs[j], pixel))
+            continue;
+        return j;
+    }
+    return -1;
+}
+
+static int compare_ints(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int spatial_index_query(const SpatialIndex *index, Recti area, int *out, int capacity)
+{
+    area = recti_clamp(area, index->width, index->height);
+    if (recti_is_empty(area) || !index->job_count)
+        return 0;
+
+    int count = 0;
+    for (int cy = area.top_left.y / SPATIAL_INDEX_CELL_SIZE; cy <= (area.bottom_right.y - 1) / SPATIAL_INDEX_CELL_SIZE; cy++)
+    {
+        for (int cx = area.top_left.x / SPATIAL_INDEX_CELL_SIZE; cx <= (area.bottom_right.x - 1) / SPATIAL_INDEX_CELL_SIZE; cx++)
+        {
+            int cell = cy * index->cells_x + cx;
+            for (int i = index->cell_start[cell]; i < index->cell_start[cell + 1]; i++)
+            {
+                int j = index->job_indices[i];
+                Recti job = index->areas[j];
+                int x0 = job.top_left.x > area.top_left.x ? job.top_left.x : area.top_left.x;
+                int y0 = job.top_left.y > area.top_left.y ? job.top_left.y : area.top_left.y;
+                int x1 = job.bottom_right.x < area.bottom_right.x ? job.bottom_right.x : area.bottom_right.x;
+                int y1 = job.bottom_right.y < area.bottom_right.y ? job.bottom_right.y : area.bottom_right.y;
+
+                // A job spanning several cells is reported only by the cell holding the top left of its overlap
+                if (x0 >= x1 || y0 >= y1 || x0 / SPATIAL_INDEX_CELL_SIZE != cx || y0 / SPATIAL_INDEX_CELL_SIZE != cy)
+                    continue;
+                if (count < capacity)
+                    out[count] = j;
+                count++;
+            }
+        }
+    }
+
+    if (count <= capacity && count > 1)
+        qsort(out, count, sizeof(int), compare_ints);
+    return count;
+}
+
+void spatial_index_free(SpatialIndex *index)
+{
+    free(index->cell_start);
+    free(index->cell_fill);
+    free(index->job_indices);
+    free(index->areas);
+    *index = (SpatialIndex){0};
+}
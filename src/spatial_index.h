@@ -0,0 +1,60 @@
+#pragma once
+#include "drawjob.h"
+
+/// @brief Side of the square cells of a spatial index, in pixels
+#define SPATIAL_INDEX_CELL_SIZE 32
+
+/// @brief Uniform grid over the areas of a list of jobs, answering which job is on top at a pixel and which jobs touch an area
+/// without visiting the others. Built in bulk in one counting pass and one filling pass, so rebuilding it every frame costs O(n).
+/// Every job is referenced by every cell its clamped area touches, in submission order like TileBins, so the last job of a cell
+/// covering a pixel is the one drawn on top
+/// @param cells_x Number of cell columns
+/// @param cells_y Number of cell rows
+/// @param cell_start Offsets into `job_indices`. The jobs of cell `c` are `job_indices[cell_start[c]]` up to `job_indices[cell_start[c + 1]]`
+/// @param job_indices Indices into `jobs`, grouped by cell
+/// @param areas Area of every job clamped to the index, empty for jobs outside it
+/// @param jobs The indexed jobs, which must stay valid while the index is queried
+typedef struct SpatialIndex
+{
+    int cells_x;
+    int cells_y;
+    int width;
+    int height;
+    int *cell_start;
+    int *cell_fill;
+    int cell_capacity;
+    int *job_indices;
+    int index_capacity;
+    Recti *areas;
+    int area_capacity;
+    const DrawJob *jobs;
+    int job_count;
+} SpatialIndex;
+
+/// @brief Indexes jobs. Storage is reused between calls, so keeping one SpatialIndex around avoids reallocating every frame
+/// @param index SpatialIndex to fill. Must be zero initialized before first use
+/// @param jobs Jobs to index, for example those of draw_queue_jobs
+/// @param job_count Length of `jobs`
+/// @param width Width of the area to index, usually the framebuffer's
+/// @param height Height of the area to index, usually the framebuffer's
+/// @return 0 for success and 1 for failure, after which the index holds no jobs
+int spatial_index_build(SpatialIndex *index, const DrawJob *jobs, int job_count, int width, int height);
+
+/// @brief Finds the job drawn on top at a pixel: the last job whose area holds it. Primitives only hold the pixels
+/// near their shape, as tested by primitive_touches_tile. Safe to call from multiple threads at once
+/// @param index Built index
+/// @param point Pixel to test
+/// @return Index of the job, or -1 if no job holds the pixel
+int spatial_index_hit(const SpatialIndex *index, Pointi point);
+
+/// @brief Finds the jobs whose clamped areas overlap an area. Safe to call from multiple threads at once
+/// @param index Built index
+/// @param area Area to test
+/// @param out Receives the indices of the jobs in submission order, if there are at most `capacity`
+/// @param capacity Length of `out`
+/// @return Number of jobs found. When larger than `capacity`, `out` holds some of them in no particular order
+int spatial_index_query(const SpatialIndex *index, Recti area, int *out, int capacity);
+
+/// @brief Frees storage held by the index
+/// @param index Index to free
+void spatial_index_free(SpatialIndex *index);
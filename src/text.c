@@ -1,2 +1,707 @@
 #include "../include/renderer.h"
 
+DrawJob create_bitmap_draw_job(Bitmap bitmap, int x_pos, int y_pos)
+{
+    return (DrawJob){
+        .area = {{x_pos, y_pos}, {x_pos + bitmap.width, y_pos + bitmap.height}},
+        .kind = DRAWJOB_BITMAP,
+        .params.bitmap = {bitmap.bitmap_argb, bitmap.width, bitmap.height, {x_pos, y_pos}}};
+}
+
+// Filter weights are 14 bit fixed point and sum to 1 for each destination pixel
+#define SCALE_WEIGHT_BITS 14
+#define SCALE_WEIGHT_ONE (1 << SCALE_WEIGHT_BITS)
+
+// Source pixels contributing to each destination pixel along one axis
+typedef struct ScaleTaps
+{
+    int *start;
+    int *count;
+    uint16_t *weights;
+    int max_taps;
+} ScaleTaps;
+
+static int scale_taps_build(ScaleTaps *taps, int source_size, int destination_size, ScaleMode mode)
+{
+    double ratio = (double)source_size / destination_size;
+    taps->max_taps = mode == SCALE_BOX ? (int)ceil(ratio) + 1 : 2;
+    taps->start = malloc(sizeof(int) * destination_size);
+    taps->count = malloc(sizeof(int) * destination_size);
+    taps->weights = malloc(sizeof(uint16_t) * destination_size * taps->max_taps);
+    if (!taps->start || !taps->count || !taps->weights)
+        return 1;
+
+    for (int i = 0; i < destination_size; i++)
+    {
+        uint16_t *weights = taps->weights + i * taps->max_taps;
+
+        if (mode == SCALE_BILINEAR)
+        {
+            // Pixel centers line up, and the edges repeat the outermost pixels
+            double position = (i + 0.5) * ratio - 0.5;
+            if (position < 0)
+                position = 0;
+            int first = (int)position;
+            double fraction = position - first;
+            if (first >= source_size - 1)
+            {
+                first = source_size - 1;
+                fraction = 0;
+            }
+
+            int second_weight = (int)lround(fraction * SCALE_WEIGHT_ONE);
+            taps->start[i] = first;
+            taps->count[i] = second_weight ? 2 : 1;
+            weights[0] = (uint16_t)(SCALE_WEIGHT_ONE - second_weight);
+            weights[1] = (uint16_t)second_weight;
+            continue;
+        }
+
+        // Box: every source pixel weighs by how much of it the destination pixel covers
+        double low = i * ratio;
+        double high = (i + 1) * ratio;
+        int first = (int)low;
+        int last = (int)ceil(high) - 1;
+        if (last >= source_size)
+            last = source_size - 1;
+        if (last < first)
+            last = first;
+
+        int count = 0, sum = 0, largest = 0;
+        for (int j = first; j <= last && count < taps->max_taps; j++)
+        {
+            double covered = fmin(high, j + 1) - fmax(low, j);
+            int weight = covered > 0 ? (int)lround(covered / ratio * SCALE_WEIGHT_ONE) : 0;
+            weights[count] = (uint16_t)weight;
+            if (weight > weights[largest])
+                largest = count;
+            sum += weight;
+            count++;
+        }
+
+        // Rounding leftovers go to the largest weight, so flat areas keep their exact color
+        weights[largest] = (uint16_t)(weights[largest] + SCALE_WEIGHT_ONE - sum);
+        taps->start[i] = first;
+        taps->count[i] = count;
+    }
+    return 0;
+}
+
+static void scale_taps_free(ScaleTaps *taps)
+{
+    free(taps->start);
+    free(taps->count);
+    free(taps->weights);
+}
+
+// Horizontal pass: filters one source row into 8.8 fixed point channels, four per destination pixel
+static void scale_filter_row(const uint32_t *row, const ScaleTaps *taps, int width, uint32_t *out)
+{
+    for (int x = 0; x < width; x++)
+    {
+        const uint32_t *src = row + taps->start[x];
+        const uint16_t *weights = taps->weights + x * taps->max_taps;
+        uint32_t a = 0, r = 0, g = 0, b = 0;
+
+        for (int k = 0; k < taps->count[x]; k++)
+        {
+            uint32_t pixel = src[k];
+            uint32_t weight = weights[k];
+            a += (pixel >> 24) * weight;
+            r += ((pixel >> 16) & 0xFF) * weight;
+            g += ((pixel >> 8) & 0xFF) * weight;
+            b += (pixel & 0xFF) * weight;
+        }
+
+        out[4 * x + 0] = (a + 32) >> 6;
+        out[4 * x + 1] = (r + 32) >> 6;
+        out[4 * x + 2] = (g + 32) >> 6;
+        out[4 * x + 3] = (b + 32) >> 6;
+    }
+}
+
+static void scale_nearest(Bitmap source, Bitmap destination)
+{
+    // 16.16 steps through the source, starting half a step in so pixel centers line up
+    uint32_t step = (uint32_t)(((uint64_t)source.width << 16) / destination.width);
+
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < destination.height; y++)
+    {
+        int source_y = (int)(((int64_t)y * 2 + 1) * source.height / (2 * (int64_t)destination.height));
+        const uint32_t *row = source.bitmap_argb + (size_t)source_y * source.width;
+        uint32_t *dst = destination.bitmap_argb + (size_t)y * destination.width;
+        uint32_t u = step / 2;
+
+        for (int x = 0; x < destination.width; x++)
+        {
+            dst[x] = row[u >> 16];
+            u += step;
+        }
+    }
+}
+
+static int scale_separable(Bitmap source, Bitmap destination, ScaleMode mode)
+{
+    ScaleTaps columns = {0}, rows = {0};
+    int threads = omp_get_max_threads();
+    size_t row_values = (size_t)destination.width * 4;
+
+    // Per thread: two filtered source rows and the vertical accumulator
+    uint32_t *scratch = malloc(sizeof(uint32_t) * row_values * 3 * threads);
+    int failed = !scratch ||
+                 scale_taps_build(&columns, source.width, destination.width, mode) ||
+                 scale_taps_build(&rows, source.height, destination.height, mode);
+
+    if (!failed)
+    {
+        #pragma omp parallel
+        {
+            uint32_t *filtered[2];
+            filtered[0] = scratch + row_values * 3 * omp_get_thread_num();
+            filtered[1] = filtered[0] + row_values;
+            uint32_t *sums = filtered[1] + row_values;
+            int filtered_row[2] = {-1, -1};
+
+            // Static scheduling hands each thread neighbouring rows, which mostly share filtered source rows
+            #pragma omp for schedule(static)
+            for (int y = 0; y < destination.height; y++)
+            {
+                const uint16_t *weights = rows.weights + y * rows.max_taps;
+                memset(sums, 0, sizeof(uint32_t) * row_values);
+
+                for (int k = 0; k < rows.count[y]; k++)
+                {
+                    int source_y = rows.start[y] + k;
+                    int slot = source_y & 1;
+                    if (filtered_row[slot] != source_y)
+                    {
+                        scale_filter_row(source.bitmap_argb + (size_t)source_y * source.width, &columns, destination.width, filtered[slot]);
+                        filtered_row[slot] = source_y;
+                    }
+
+                    uint32_t weight = weights[k];
+                    const uint32_t *values = filtered[slot];
+                    for (size_t i = 0; i < row_values; i++)
+                        sums[i] += weight * values[i];
+                }
+
+                uint32_t *dst = destination.bitmap_argb + (size_t)y * destination.width;
+                const uint32_t round = 1u << (SCALE_WEIGHT_BITS + 7);
+                for (int x = 0; x < destination.width; x++)
+                {
+                    dst[x] = ((sums[4 * x + 0] + round) >> (SCALE_WEIGHT_BITS + 8)) << 24 |
+                             ((sums[4 * x + 1] + round) >> (SCALE_WEIGHT_BITS + 8)) << 16 |
+                             ((sums[4 * x + 2] + round) >> (SCALE_WEIGHT_BITS + 8)) << 8 |
+                             ((sums[4 * x + 3] + round) >> (SCALE_WEIGHT_BITS + 8));
+                }
+            }
+        }
+    }
+
+    scale_taps_free(&columns);
+    scale_taps_free(&rows);
+    free(scratch);
+    return failed;
+}
+
+int scale_bitmap_into(Bitmap source, Bitmap destination, ScaleMode mode)
+{
+    if (source.width <= 0 || source.height <= 0 || !source.bitmap_argb ||
+        destination.width <= 0 || destination.height <= 0 || !destination.bitmap_argb)
+        return 1;
+
+    if (mode == SCALE_NEAREST)
+    {
+        scale_nearest(source, destination);
+        return 0;
+    }
+    return scale_separable(source, destination, mode);
+}
+
+Bitmap scale_bitmap(Bitmap bitmap, double scale)
+{
+    Bitmap scaled = {(int)(bitmap.width * scale), (int)(bitmap.height * scale), NULL};
+    if (scaled.width <= 0 || scaled.height <= 0)
+        return (Bitmap){0, 0, NULL};
+
+    scaled.bitmap_argb = malloc(sizeof(uint32_t) * scaled.width * scaled.height);
+    if (scale_bitmap_into(bitmap, scaled, scale < 1 ? SCALE_BOX : SCALE_BILINEAR))
+    {
+        free(scaled.bitmap_argb);
+        return (Bitmap){0, 0, NULL};
+    }
+    return scaled;
+}
+
+// Built in font: columns of the 5x7 glyphs for ' ' to '~', least significant bit at the top
+static const uint8_t builtin_font[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7F, 0x14, 0x7F, 0x14},
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62}, {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00},
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00}, {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31},
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00}, {0x00, 0x56, 0x36, 0x00, 0x00},
+    {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14}, {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06},
+    {0x32, 0x49, 0x79, 0x41, 0x3E}, {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01}, {0x3E, 0x41, 0x49, 0x49, 0x7A},
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00}, {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41},
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46}, {0x46, 0x49, 0x49, 0x49, 0x31},
+    {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F}, {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F},
+    {0x63, 0x14, 0x08, 0x14, 0x63}, {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},
+    {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78}, {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20},
+    {0x38, 0x44, 0x44, 0x48, 0x7F}, {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00}, {0x7F, 0x10, 0x28, 0x44, 0x00},
+    {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78}, {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},
+    {0x7C, 0x14, 0x14, 0x14, 0x08}, {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C}, {0x3C, 0x40, 0x30, 0x40, 0x3C},
+    {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C}, {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},
+    {0x00, 0x00, 0x7F, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08}};
+
+#define FONT_ATLAS_WIDTH 256
+
+// Packs the glyph masks into rows of the atlas. Takes ownership of the masks, which have the glyphs' width and height
+static int font_pack(Font *font, uint8_t **masks)
+{
+    int x = 0, y = 0, row_height = 0;
+    for (int c = 0; c < FONT_GLYPHS; c++)
+    {
+        Glyph *glyph = &font->glyphs[c];
+        if (!masks[c])
+            continue;
+        if (x + glyph->width > FONT_ATLAS_WIDTH)
+        {
+            x = 0;
+            y += row_height;
+            row_height = 0;
+        }
+        glyph->atlas_x = x;
+        glyph->atlas_y = y;
+        x += glyph->width;
+        row_height = glyph->height > row_height ? glyph->height : row_height;
+    }
+
+    font->atlas_width = FONT_ATLAS_WIDTH;
+    font->atlas_height = y + row_height;
+    font->atlas = calloc((size_t)font->atlas_width * (font->atlas_height ? font->atlas_height : 1), 1);
+
+    for (int c = 0; c < FONT_GLYPHS; c++)
+    {
+        const Glyph *glyph = &font->glyphs[c];
+        if (masks[c] && font->atlas)
+        {
+            for (int row = 0; row < glyph->height; row++)
+                memcpy(font->atlas + (size_t)(glyph->atlas_y + row) * font->atlas_width + glyph->atlas_x,
+                       masks[c] + row * glyph->width, glyph->width);
+        }
+        free(masks[c]);
+    }
+    return font->atlas == NULL;
+}
+
+int font_init_builtin(Font *font)
+{
+    uint8_t *masks[FONT_GLYPHS] = {0};
+    memset(font, 0, sizeof(Font));
+    font->line_height = 8;
+
+    for (int c = ' '; c <= '~'; c++)
+    {
+        font->glyphs[c] = (Glyph){.width = 5, .height = 7, .advance = 6};
+        masks[c] = malloc(5 * 7);
+        if (!masks[c])
+            continue;
+
+        for (int row = 0; row < 7; row++)
+            for (int column = 0; column < 5; column++)
+                masks[c][row * 5 + column] = (builtin_font[c - ' '][column] >> row) & 1 ? 255 : 0;
+    }
+
+    for (int c = ' '; c <= '~'; c++)
+    {
+        if (!masks[c])
+        {
+            for (int i = 0; i < FONT_GLYPHS; i++)
+                free(masks[i]);
+            return 1;
+        }
+    }
+    return font_pack(font, masks);
+}
+
+int font_load_bdf(Font *font, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return 1;
+
+    uint8_t *masks[FONT_GLYPHS] = {0};
+    char line[512];
+    int ascent = -1, descent = -1;
+    int box_height = 0, box_offset_y = 0;
+    int encoding = -1, advance = 0;
+    int width = 0, height = 0, offset_x = 0, offset_y = 0;
+    int bitmap_row = -1, failed = 0, ended = 0;
+    memset(font, 0, sizeof(Font));
+
+    while (!failed && fgets(line, sizeof(line), file))
+    {
+        int a, b, c, d;
+
+        if (bitmap_row >= 0)
+        {
+            if (!strncmp(line, "ENDCHAR", 7))
+            {
+                bitmap_row = -1;
+                encoding = -1;
+                continue;
+            }
+            if (bitmap_row >= height)
+                continue;
+
+            // Rows are hex with the leftmost pixel in the most significant bit
+            uint8_t *row = masks[encoding] + bitmap_row * width;
+            for (int x = 0; x < width; x++)
+            {
+                char digit = line[x / 4];
+                int value = digit >= '0' && digit <= '9' ? digit - '0' : digit >= 'A' && digit <= 'F' ? digit - 'A' + 10 : digit >= 'a' && digit <= 'f' ? digit - 'a' + 10 : -1;
+                if (value < 0)
+                {
+                    failed = 1;
+                    break;
+                }
+                row[x] = (value >> (3 - x % 4)) & 1 ? 255 : 0;
+            }
+            bitmap_row++;
+        }
+        else if (sscanf(line, "FONTBOUNDINGBOX %d %d %d %d", &a, &b, &c, &d) == 4)
+        {
+            box_height = b;
+            box_offset_y = d;
+        }
+        else if (sscanf(line, "FONT_ASCENT %d", &a) == 1)
+            ascent = a;
+        else if (sscanf(line, "FONT_DESCENT %d", &a) == 1)
+            descent = a;
+        else if (sscanf(line, "ENCODING %d", &a) == 1)
+        {
+            encoding = a;
+            advance = 0;
+        }
+        else if (sscanf(line, "DWIDTH %d", &a) == 1)
+            advance = a;
+        else if (sscanf(line, "BBX %d %d %d %d", &width, &height, &offset_x, &offset_y) == 4)
+        {
+            if (width < 0 || height < 0 || width > 1024 || height > 1024)
+                failed = 1;
+        }
+        else if (!strncmp(line, "BITMAP", 6))
+        {
+            // Glyphs outside the byte range are skipped row by row until their ENDCHAR
+            if (encoding < 0 || encoding >= FONT_GLYPHS || masks[encoding])
+            {
+                encoding = 0;
+                height = 0;
+                bitmap_row = 0;
+                continue;
+            }
+
+            font->glyphs[encoding] = (Glyph){.width = width, .height = height, .offset_x = offset_x, .offset_y = offset_y, .advance = advance};
+            masks[encoding] = calloc((size_t)width * height + 1, 1);
+            failed = masks[encoding] == NULL;
+            bitmap_row = 0;
+        }
+        else if (!strncmp(line, "ENDFONT", 7))
+            ended = 1;
+    }
+    fclose(file);
+
+    if (failed || !ended)
+    {
+        for (int i = 0; i < FONT_GLYPHS; i++)
+            free(masks[i]);
+        memset(font, 0, sizeof(Font));
+        return 1;
+    }
+
+    if (ascent < 0 || descent < 0)
+    {
+        ascent = box_height + box_offset_y;
+        descent = -box_offset_y;
+    }
+    font->line_height = ascent + descent;
+
+    // BDF offsets are from the baseline, up. Glyphs are placed from the top of the line, down
+    for (int i = 0; i < FONT_GLYPHS; i++)
+        if (masks[i])
+            font->glyphs[i].offset_y = ascent - (font->glyphs[i].offset_y + font->glyphs[i].height);
+
+    return font_pack(font, masks);
+}
+
+void font_free(Font *font)
+{
+    free(font->atlas);
+    font->atlas = NULL;
+}
+
+static const Glyph *font_glyph(const Font *font, unsigned char c)
+{
+    const Glyph *glyph = &font->glyphs[c];
+    if (!glyph->advance && !glyph->width)
+        glyph = &font->glyphs['?'];
+    return glyph;
+}
+
+// Lays out the text and blits each glyph from the atlas into the coverage of the line
+static ShapedLine *shape_line(const Font *font, const char *text, uint32_t color)
+{
+    int width = 0, lines = 1, pen = 0;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+    {
+        if (*c == '\n')
+        {
+            lines++;
+            pen = 0;
+            continue;
+        }
+        const Glyph *glyph = font_glyph(font, *c);
+        int right = pen + (glyph->offset_x + glyph->width > glyph->advance ? glyph->offset_x + glyph->width : glyph->advance);
+        width = right > width ? right : width;
+        pen += glyph->advance;
+    }
+
+    ShapedLine *line = malloc(sizeof(ShapedLine));
+    if (!line)
+        return NULL;
+    line->width = width;
+    line->height = lines * font->line_height;
+    line->color = color;
+    line->coverage = calloc((size_t)width * line->height + 1, 1);
+    if (!line->coverage)
+    {
+        free(line);
+        return NULL;
+    }
+
+    int top = 0;
+    pen = 0;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+    {
+        if (*c == '\n')
+        {
+            top += font->line_height;
+            pen = 0;
+            continue;
+        }
+
+        const Glyph *glyph = font_glyph(font, *c);
+        int left = pen + glyph->offset_x;
+        int first_column = left < 0 ? -left : 0;
+        pen += glyph->advance;
+
+        for (int row = 0; row < glyph->height; row++)
+        {
+            int y = top + glyph->offset_y + row;
+            if (y < 0 || y >= line->height || first_column >= glyph->width)
+                continue;
+
+            const uint8_t *src = font->atlas + (size_t)(glyph->atlas_y + row) * font->atlas_width + glyph->atlas_x;
+            uint8_t *dst = line->coverage + (size_t)y * width + left;
+            for (int x = first_column; x < glyph->width; x++)
+                dst[x] |= src[x];
+        }
+    }
+    return line;
+}
+
+static void shaped_line_free(ShapedLine *line)
+{
+    if (line)
+        free(line->coverage);
+    free(line);
+}
+
+void text_draw_span(const TextParams *text, int y, int x0, int x1, uint32_t *dst)
+{
+    const ShapedLine *line = text->line;
+    const uint8_t *coverage = line->coverage + (size_t)(y - text->position.y) * line->width + (x0 - text->position.x);
+    span_kernels.fill_masked(dst, coverage, x1 - x0, line->color);
+}
+
+static uint64_t text_hash(const Font *font, const char *text, uint32_t color)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char *c = (const unsigned char *)text; *c; c++)
+        hash = (hash ^ *c) * 1099511628211ull;
+    hash = (hash ^ (uintptr_t)font) * 1099511628211ull;
+    return (hash ^ color) * 1099511628211ull;
+}
+
+#define TEXT_CACHE_FIRST_CAPACITY 1024
+
+int text_cache_init(TextCache *cache)
+{
+    cache->capacity = TEXT_CACHE_FIRST_CAPACITY;
+    cache->count = 0;
+    cache->frame = 0;
+    cache->stats = (TextCacheStats){0};
+    cache->entries = calloc(cache->capacity, sizeof(TextCacheEntry));
+    cache->lock = SDL_CreateMutex();
+    if (!cache->entries || !cache->lock)
+    {
+        text_cache_free(cache);
+        return 1;
+    }
+    return 0;
+}
+
+static TextCacheEntry *text_cache_slot(TextCacheEntry *entries, int capacity, uint64_t hash, const Font *font, const char *text, uint32_t color)
+{
+    int mask = capacity - 1;
+    for (int i = (int)(hash & mask);; i = (i + 1) & mask)
+    {
+        TextCacheEntry *entry = &entries[i];
+        if (!entry->text)
+            return entry;
+        if (entry->hash == hash && entry->font == font && entry->line->color == color && !strcmp(entry->text, text))
+            return entry;
+    }
+}
+
+// Moves the entries into a new table with room for `capacity` entries
+static void text_cache_rehash(TextCache *cache, int capacity)
+{
+    TextCacheEntry *entries = calloc(capacity, sizeof(TextCacheEntry));
+    if (!entries)
+        return;
+
+    for (int i = 0; i < cache->capacity; i++)
+    {
+        TextCacheEntry *entry = &cache->entries[i];
+        if (entry->text)
+            *text_cache_slot(entries, capacity, entry->hash, entry->font, entry->text, entry->line->color) = *entry;
+    }
+
+    free(cache->entries);
+    cache->entries = entries;
+    cache->capacity = capacity;
+}
+
+// Empties a slot by moving later entries of its probe sequence back into the gap, so lookups never need tombstones
+static void text_cache_remove(TextCache *cache, int slot)
+{
+    int mask = cache->capacity - 1;
+    int gap = slot;
+    for (int i = (slot + 1) & mask; cache->entries[i].text; i = (i + 1) & mask)
+    {
+        // Entries whose home slot lies after the gap, up to their own slot, stay reachable where they are
+        int home = (int)(cache->entries[i].hash & mask);
+        if (((i - home) & mask) < ((i - gap) & mask))
+            continue;
+        cache->entries[gap] = cache->entries[i];
+        gap = i;
+    }
+    cache->entries[gap] = (TextCacheEntry){0};
+    cache->count--;
+}
+
+DrawJob text_draw_job(TextCache *cache, const Font *font, const char *text, int x, int y, uint32_t color)
+{
+    uint64_t hash = text_hash(font, text, color);
+    ShapedLine *line = NULL;
+
+    SDL_LockMutex(cache->lock);
+    TextCacheEntry *entry = text_cache_slot(cache->entries, cache->capacity, hash, font, text, color);
+    if (entry->text)
+    {
+        cache->stats.hits++;
+        entry->last_used = cache->frame;
+        line = entry->line;
+    }
+    else
+    {
+        cache->stats.misses++;
+        size_t length = strlen(text);
+        char *key = malloc(length + 1);
+        line = shape_line(font, text, color);
+        if (key && line)
+        {
+            memcpy(key, text, length + 1);
+            *entry = (TextCacheEntry){hash, key, font, line, cache->frame};
+            cache->count++;
+
+            // Half full keeps probe sequences short
+            if (cache->count * 2 > cache->capacity)
+                text_cache_rehash(cache, cache->capacity * 2);
+        }
+        else
+        {
+            free(key);
+            shaped_line_free(line);
+            line = NULL;
+        }
+    }
+    SDL_UnlockMutex(cache->lock);
+
+    if (!line || !line->width || !line->height)
+        return (DrawJob){0};
+
+    return (DrawJob){
+        .area = {{x, y}, {x + line->width, y + line->height}},
+        .kind = DRAWJOB_TEXT,
+        .params.text = {line, {x, y}}};
+}
+
+void text_cache_end_frame(TextCache *cache)
+{
+    SDL_LockMutex(cache->lock);
+    int mask = cache->capacity - 1;
+
+    // Start after an empty slot, so no probe sequence wraps around into the slots already visited
+    int start = 0;
+    while (cache->entries[start].text)
+        start++;
+
+    for (int visited = 0; visited < cache->capacity; visited++)
+    {
+        int slot = (start + visited) & mask;
+        TextCacheEntry *entry = &cache->entries[slot];
+        while (entry->text && entry->last_used != cache->frame)
+        {
+            free(entry->text);
+            shaped_line_free(entry->line);
+            cache->stats.evictions++;
+            // Refills the slot with a later entry, which is checked next
+            text_cache_remove(cache, slot);
+        }
+    }
+
+    int capacity = cache->capacity;
+    while (capacity > TEXT_CACHE_FIRST_CAPACITY && cache->count * 8 < capacity)
+        capacity /= 2;
+    if (capacity != cache->capacity)
+        text_cache_rehash(cache, capacity);
+    cache->frame++;
+    SDL_UnlockMutex(cache->lock);
+}
+
+void text_cache_free(TextCache *cache)
+{
+    if (cache->entries)
+    {
+        for (int i = 0; i < cache->capacity; i++)
+        {
+            free(cache->entries[i].text);
+            shaped_line_free(cache->entries[i].line);
+        }
+    }
+    free(cache->entries);
+    if (cache->lock)
+        SDL_DestroyMutex(cache->lock);
+    cache->entries = NULL;
+    cache->lock = NULL;
+}
@@ -3,8 +3,8 @@
 /// @brief A rectangular bitmap of RGB values
 /// @param width Width of the bitmap in pixels
 /// @param height Height of the bitmap in pixels
-/// @param bitmap_argb List of all items in the bitmap. Each pixel is represented by a uint32_t RGB color 
-/// (Technically ARGB but alpha is not supported)
+/// @param bitmap_argb List of all items in the bitmap. Each pixel is represented by a uint32_t ARGB color.
+/// Alpha is only used by jobs with a blend mode, and is expected premultiplied
 typedef struct Bitmap
 {
     int width;
@@ -20,9 +20,161 @@ typedef struct Bitmap
 /// @return A draw job that can be enqueued to draw the bitmap at the given coordinates
 DrawJob create_bitmap_draw_job(Bitmap bitmap, int x_pos, int y_pos);
 
+/// @brief Filters used when scaling bitmaps
+/// @param SCALE_NEAREST Copies the source pixel closest to each destination pixel. Fastest, blocky when enlarging
+/// @param SCALE_BILINEAR Interpolates between the four closest source pixels. Smooth when enlarging, aliases when shrinking a lot
+/// @param SCALE_BOX Averages all source pixels covered by each destination pixel. Best for shrinking
+typedef enum ScaleMode
+{
+    SCALE_NEAREST,
+    SCALE_BILINEAR,
+    SCALE_BOX
+} ScaleMode;
+
 /// @brief Scales a bitmap by the scale.
 /// Will round width and height down in case of floating point values arising from scaling. This will result in non-smooth scaling.
-/// @param bitmap
-/// @param scale
-/// @return
-Bitmap scale_bitmap(Bitmap bitmap, double scale);
\ No newline at end of file
+/// Shrinking uses SCALE_BOX and enlarging SCALE_BILINEAR
+/// @param bitmap Bitmap to scale
+/// @param scale Factor to scale width and height by
+/// @return The scaled bitmap. Free `bitmap_argb` with free(). Empty with a NULL bitmap_argb if the result has no pixels or allocation failed
+Bitmap scale_bitmap(Bitmap bitmap, double scale);
+
+/// @brief Scales a bitmap into storage supplied by the caller. Rows run in parallel.
+/// Reusing the destination between frames avoids allocating for bitmaps scaled every frame
+/// @param source Bitmap to scale
+/// @param destination Bitmap to write to. Its width and height give the size to scale to
+/// @param mode Filter to scale with
+/// @return 0 on success, 1 if either bitmap is empty or allocating scratch memory failed
+int scale_bitmap_into(Bitmap source, Bitmap destination, ScaleMode mode);
+
+/// @brief Number of glyphs in a font, one per byte value. Strings are laid out byte by byte (ASCII or Latin-1)
+#define FONT_GLYPHS 256
+
+/// @brief Placement of one glyph
+/// @param atlas_x Left edge of the glyph in the atlas
+/// @param atlas_y Top edge of the glyph in the atlas
+/// @param width Width of the glyph in pixels. 0 for glyphs the font doesn't have
+/// @param height Height of the glyph in pixels
+/// @param offset_x Distance from the pen position to the left edge of the glyph
+/// @param offset_y Distance from the top of the line to the top edge of the glyph
+/// @param advance Distance to move the pen after the glyph
+typedef struct Glyph
+{
+    int atlas_x;
+    int atlas_y;
+    int width;
+    int height;
+    int offset_x;
+    int offset_y;
+    int advance;
+} Glyph;
+
+/// @brief A bitmap font with all glyphs packed into one atlas
+/// @param glyphs Glyph for each byte value
+/// @param atlas Coverage of the packed glyphs, one byte per pixel, 0 or 255
+/// @param atlas_width Width of the atlas in pixels
+/// @param atlas_height Height of the atlas in pixels
+/// @param line_height Distance between the tops of two lines
+typedef struct Font
+{
+    Glyph glyphs[FONT_GLYPHS];
+    uint8_t *atlas;
+    int atlas_width;
+    int atlas_height;
+    int line_height;
+} Font;
+
+/// @brief Loads the built in 5x7 pixel ASCII font. Lines are 8 pixels high and every character advances 6 pixels
+/// @param font Font to load into
+/// @return 0 on success, 1 if allocating the atlas failed
+int font_init_builtin(Font *font);
+
+/// @brief Loads a font in the BDF format. Characters with encodings above 255 are skipped
+/// @param font Font to load into
+/// @param path Path of the .bdf file
+/// @return 0 on success, 1 if the file couldn't be read or isn't a valid BDF font
+int font_load_bdf(Font *font, const char *path);
+
+/// @brief Frees the atlas of a font
+/// @param font Font to free
+void font_free(Font *font);
+
+/// @brief A laid out block of text, drawn by text jobs
+/// @param width Width of the block in pixels
+/// @param height Height of the block in pixels
+/// @param color Color of the text
+/// @param coverage Coverage of the laid out glyphs, width * height bytes, 0 or 255
+typedef struct ShapedLine
+{
+    int width;
+    int height;
+    uint32_t color;
+    uint8_t *coverage;
+} ShapedLine;
+
+/// @brief Slot of a text cache. Empty while `text` is NULL
+typedef struct TextCacheEntry
+{
+    uint64_t hash;
+    char *text;
+    const Font *font;
+    ShapedLine *line;
+    uint32_t last_used;
+} TextCacheEntry;
+
+/// @brief Hit and miss counts of a text cache since it was created
+typedef struct TextCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+} TextCacheStats;
+
+/// @brief Cache of shaped lines keyed by string, font and color. Unchanged labels are laid out once and then only looked up.
+/// Safe to use from several threads. Lines stay valid until the end of the frame after their last use
+/// @param entries Open addressed hash table
+/// @param capacity Number of slots in the table, a power of two
+/// @param count Number of used slots
+/// @param frame Current frame, advanced by text_cache_end_frame
+typedef struct TextCache
+{
+    TextCacheEntry *entries;
+    int capacity;
+    int count;
+    uint32_t frame;
+    SDL_mutex *lock;
+    TextCacheStats stats;
+} TextCache;
+
+/// @brief Creates an empty text cache
+/// @param cache Cache to initialize
+/// @return 0 on success, 1 if allocation failed
+int text_cache_init(TextCache *cache);
+
+/// @brief Ends a frame. Frees lines that weren't used during it, so only call this once their jobs are drawn
+/// @param cache Cache to update
+void text_cache_end_frame(TextCache *cache);
+
+/// @brief Frees a text cache and all lines in it
+/// @param cache Cache to free
+void text_cache_free(TextCache *cache);
+
+/// @brief Lays out the text, or finds it in the cache, and returns a job drawing it with its top left corner at (x,y).
+/// Only pixels covered by glyphs are drawn. '\n' starts a new line
+/// @param cache Cache of shaped lines
+/// @param font Font to draw with
+/// @param text Text to draw
+/// @param x x-coordinate of the left edge of the text
+/// @param y y-coordinate of the top of the first line
+/// @param color Color of the text
+/// @return A DRAWJOB_TEXT job drawing the text. Has an empty area if the text is empty or allocation failed
+DrawJob text_draw_job(TextCache *cache, const Font *font, const char *text, int x, int y, uint32_t color);
+
+/// @brief Draws the pixels of row y from x0 up to x1 covered by the text of a DRAWJOB_TEXT job, leaving the others unwritten.
+/// The span must lie inside the area of the job
+/// @param text Parameters of the job
+/// @param y Row to draw
+/// @param x0 First pixel to draw
+/// @param x1 One past the last pixel to draw
+/// @param dst Pointer to the pixel at (x0,y)
+void text_draw_span(const TextParams *text, int y, int x0, int x1, uint32_t *dst);
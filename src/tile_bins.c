@@ -0,0 +1,139 @@
+#include "../include/renderer.h"
+
+static int grow_capacity(int capacity, int needed)
+{
+    if (capacity == 0)
+        capacity = 64;
+    while (capacity < needed)
+        capacity *= 2;
+    return capacity;
+}
+
+// Counts the job in every tile it touches, or with `fill` adds it to their lists. Tiles only count for a primitive if its rows
+// reach them, and if it spans more than one tile, if its shape touches them
+static void bin_job(TileBins *bins, int job, Recti area, const PrimitiveSetup *setup, int fill)
+{
+    if (setup)
+    {
+        area.top_left.y = area.top_left.y > setup->row_start ? area.top_left.y : setup->row_start;
+        area.bottom_right.y = area.bottom_right.y < setup->row_end ? area.bottom_right.y : setup->row_end;
+        if (area.top_left.y >= area.bottom_right.y)
+            return;
+    }
+
+    int tx0 = area.top_left.x / TILE_SIZE;
+    int ty0 = area.top_left.y / TILE_SIZE;
+    int tx1 = (area.bottom_right.x - 1) / TILE_SIZE;
+    int ty1 = (area.bottom_right.y - 1) / TILE_SIZE;
+    int test = setup && (tx0 != tx1 || ty0 != ty1);
+
+    for (int ty = ty0; ty <= ty1; ty++)
+    {
+        for (int tx = tx0; tx <= tx1; tx++)
+        {
+            int tile = ty * bins->tiles_x + tx;
+            if (test && !primitive_setup_touches_tile(setup, tile_bins_tile_area(bins, tile)))
+                continue;
+            if (fill)
+                bins->job_indices[bins->tile_fill[tile]++] = job;
+            else
+                bins->tile_start[tile + 1]++;
+        }
+    }
+}
+
+void tile_bins_build(TileBins *bins, const DrawJob *jobs, int job_count, int width, int height)
+{
+    bins->width = width;
+    bins->height = height;
+    bins->tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    bins->tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    int tile_count = bins->tiles_x * bins->tiles_y;
+
+    if (tile_count + 1 > bins->tile_capacity)
+    {
+        bins->tile_capacity = grow_capacity(bins->tile_capacity, tile_count + 1);
+        bins->tile_start = realloc(bins->tile_start, bins->tile_capacity * sizeof(int));
+        bins->tile_fill = realloc(bins->tile_fill, bins->tile_capacity * sizeof(int));
+    }
+
+    if (job_count > bins->setup_capacity)
+    {
+        bins->setup_capacity = grow_capacity(bins->setup_capacity, job_count);
+        bins->setups = realloc(bins->setups, bins->setup_capacity * sizeof(PrimitiveSetup));
+    }
+
+    for (int t = 0; t <= tile_count; t++)
+        bins->tile_start[t] = 0;
+
+    // Count how many jobs touch every tile. Primitives are set up here, once for binning and drawing,
+    // and skip the tiles of their bounding box they miss
+    for (int j = 0; j < job_count; j++)
+    {
+        Recti area = recti_clamp(jobs[j].area, width, height);
+        if (recti_is_empty(area))
+            continue;
+
+        const PrimitiveSetup *setup = NULL;
+        if (drawjob_is_primitive(&jobs[j]) && !jobs[j].transform.active)
+        {
+            if (!primitive_setup(&jobs[j], &bins->setups[j]))
+                continue;
+            setup = &bins->setups[j];
+        }
+        bin_job(bins, j, area, setup, 0);
+    }
+
+    for (int t = 0; t < tile_count; t++)
+    {
+        bins->tile_start[t + 1] += bins->tile_start[t];
+        bins->tile_fill[t] = bins->tile_start[t];
+    }
+
+    if (bins->tile_start[tile_count] > bins->index_capacity)
+    {
+        bins->index_capacity = grow_capacity(bins->index_capacity, bins->tile_start[tile_count]);
+        bins->job_indices = realloc(bins->job_indices, bins->index_capacity * sizeof(int));
+        bins->cell_masks = realloc(bins->cell_masks, bins->index_capacity * sizeof(uint64_t));
+    }
+
+    // Jobs are visited in submission order, which keeps every tile's list in submission order
+    for (int j = 0; j < job_count; j++)
+    {
+        Recti area = recti_clamp(jobs[j].area, width, height);
+        if (recti_is_empty(area))
+            continue;
+
+        const PrimitiveSetup *setup = tile_bins_setup(bins, jobs, j);
+        if (setup && setup->row_start >= setup->row_end)
+            continue;
+        bin_job(bins, j, area, setup, 1);
+    }
+}
+
+const PrimitiveSetup *tile_bins_setup(const TileBins *bins, const DrawJob *jobs, int job)
+{
+    return drawjob_is_primitive(&jobs[job]) && !jobs[job].transform.active ? &bins->setups[job] : NULL;
+}
+
+Recti tile_bins_tile_area(const TileBins *bins, int tile)
+{
+    int tx = tile % bins->tiles_x;
+    int ty = tile / bins->tiles_x;
+
+    Recti area = {
+        .top_left = {tx * TILE_SIZE, ty * TILE_SIZE},
+        .bottom_right = {(tx + 1) * TILE_SIZE, (ty + 1) * TILE_SIZE}};
+
+    return recti_clamp(area, bins->width, bins->height);
+}
+
+void tile_bins_free(TileBins *bins)
+{
+    free(bins->tile_start);
+    free(bins->tile_fill);
+    free(bins->job_indices);
+    free(bins->cell_masks);
+    free(bins->setups);
+    *bins = (TileBins){0};
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "drawjob.h"
+#include "primitives.h"
+
+#define TILE_SIZE 64
+
+/// @brief Draw jobs sorted into fixed size tiles of the buffer.
+/// Every job is referenced by every tile its clamped area touches, and jobs keep their submission order within a tile,
+/// so tiles can be processed independently of each other while later jobs still override earlier ones.
+/// @param tiles_x Number of tile columns
+/// @param tiles_y Number of tile rows
+/// @param tile_start Offsets into `job_indices`. The jobs of tile `t` are `job_indices[tile_start[t]]` up to `job_indices[tile_start[t + 1]]`
+/// @param job_indices Indices into the binned job list, grouped by tile
+/// @param cell_masks Visible cells of every entry of `job_indices`, filled by occlusion_cull_tile
+/// @param setups Setup of every untransformed primitive of the binned jobs, indexed like the jobs.
+/// Done once per job, so tiles drawing a part of one don't set it up again
+typedef struct TileBins
+{
+    int tiles_x;
+    int tiles_y;
+    int width;
+    int height;
+    int *tile_start;
+    int *tile_fill;
+    int tile_capacity;
+    int *job_indices;
+    uint64_t *cell_masks;
+    int index_capacity;
+    PrimitiveSetup *setups;
+    int setup_capacity;
+} TileBins;
+
+/// @brief Sorts jobs into tiles. Storage is reused between calls, so keeping one TileBins around avoids reallocating every frame
+/// @param bins TileBins to fill. Must be zero initialized before first use
+/// @param jobs Jobs to bin
+/// @param job_count Length of `jobs`
+/// @param width Width of the area to bin into
+/// @param height Height of the area to bin into
+void tile_bins_build(TileBins *bins, const DrawJob *jobs, int job_count, int width, int height);
+
+/// @brief Gives the setup of a binned job
+/// @param bins Built bins
+/// @param jobs The jobs the bins were built from
+/// @param job Index of the job
+/// @return Setup of the job, or NULL if it is not an untransformed primitive
+const PrimitiveSetup *tile_bins_setup(const TileBins *bins, const DrawJob *jobs, int job);
+
+/// @brief Gives the area covered by a tile, clamped to the binned area
+/// @param bins Built bins
+/// @param tile Tile index, `ty * tiles_x + tx`
+/// @return Area of the tile
+Recti tile_bins_tile_area(const TileBins *bins, int tile);
+
+/// @brief Frees storage held by the bins
+/// @param bins Bins to free
+void tile_bins_free(TileBins *bins);
@@ -0,0 +1,90 @@
+#include "../include/renderer.h"
+
+// Appends the blocks of the square of `size` blocks at (bx,by) that lie inside the grid, in Z-order.
+// Squares entirely outside the grid are skipped whole, so grids of any shape cost about one visit per block
+static int append_morton(int *morton, int count, int bx, int by, int size, int blocks_x, int blocks_y)
+{
+    if (bx >= blocks_x || by >= blocks_y)
+        return count;
+    if (size == 1)
+    {
+        morton[count] = by * blocks_x + bx;
+        return count + 1;
+    }
+
+    int half = size / 2;
+    count = append_morton(morton, count, bx, by, half, blocks_x, blocks_y);
+    count = append_morton(morton, count, bx + half, by, half, blocks_x, blocks_y);
+    count = append_morton(morton, count, bx, by + half, half, blocks_x, blocks_y);
+    return append_morton(morton, count, bx + half, by + half, half, blocks_x, blocks_y);
+}
+
+void traversal_plan_build(TraversalPlan *plan, Traversal traversal, Recti area, int thread_count)
+{
+    int width = area.bottom_right.x - area.top_left.x;
+    int height = area.bottom_right.y - area.top_left.y;
+    int size = traversal.block_size;
+    if (size <= 0)
+        size = traversal.order == TRAVERSAL_ROWS ? TRAVERSAL_DEFAULT_ROWS : TRAVERSAL_DEFAULT_TILE;
+    if (thread_count < 1)
+        thread_count = 1;
+
+    plan->area = area;
+    plan->order = traversal.order;
+    plan->block_width = traversal.order == TRAVERSAL_ROWS ? width : size;
+    plan->block_height = size;
+    plan->blocks_x = (width + plan->block_width - 1) / plan->block_width;
+    int blocks_y = (height + plan->block_height - 1) / plan->block_height;
+    plan->block_count = plan->blocks_x * blocks_y;
+
+    if (traversal.order == TRAVERSAL_MORTON)
+    {
+        if (plan->block_count > plan->morton_capacity)
+        {
+            plan->morton_capacity = plan->block_count * 2;
+            plan->morton = realloc(plan->morton, plan->morton_capacity * sizeof(int));
+        }
+
+        int side = 1;
+        while (side < plan->blocks_x || side < blocks_y)
+            side *= 2;
+        append_morton(plan->morton, 0, 0, 0, side, plan->blocks_x, blocks_y);
+    }
+
+    if (plan->block_count + 1 > plan->task_capacity)
+    {
+        plan->task_capacity = (plan->block_count + 1) * 2;
+        plan->task_start = realloc(plan->task_start, plan->task_capacity * sizeof(int));
+    }
+
+    // Guided tasks take a share of what is left, like OpenMP's guided schedule but with twice as many tasks
+    plan->task_count = 0;
+    for (int start = 0; start < plan->block_count; plan->task_count++)
+    {
+        plan->task_start[plan->task_count] = start;
+        int blocks = 1;
+        if (traversal.schedule == TRAVERSAL_GUIDED)
+            blocks = (plan->block_count - start) / (2 * thread_count);
+        else if (traversal.schedule == TRAVERSAL_STATIC)
+            blocks = (plan->block_count + thread_count - 1) / thread_count;
+        start += blocks > 1 ? blocks : 1;
+    }
+    plan->task_start[plan->task_count] = plan->block_count;
+}
+
+Recti traversal_block_area(const TraversalPlan *plan, int position)
+{
+    int block = plan->order == TRAVERSAL_MORTON ? plan->morton[position] : position;
+    int x = plan->area.top_left.x + block % plan->blocks_x * plan->block_width;
+    int y = plan->area.top_left.y + block / plan->blocks_x * plan->block_height;
+    int x1 = x + plan->block_width < plan->area.bottom_right.x ? x + plan->block_width : plan->area.bottom_right.x;
+    int y1 = y + plan->block_height < plan->area.bottom_right.y ? y + plan->block_height : plan->area.bottom_right.y;
+    return (Recti){{x, y}, {x1, y1}};
+}
+
+void traversal_plan_free(TraversalPlan *plan)
+{
+    free(plan->morton);
+    free(plan->task_start);
+    *plan = (TraversalPlan){0};
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "drawjob.h"
+
+// Rows per band and side of the square blocks used when Traversal.block_size is 0
+#define TRAVERSAL_DEFAULT_ROWS 8
+#define TRAVERSAL_DEFAULT_TILE 32
+
+/// @brief Shape and order of the blocks draw and draw_bounded split their area into. TRAVERSAL_ROWS are full width bands
+/// of rows, top to bottom. TRAVERSAL_TILES are square blocks, row by row. TRAVERSAL_MORTON are square blocks in Z-order,
+/// so blocks drawn one after another are also close vertically
+typedef enum TraversalOrder
+{
+    TRAVERSAL_ROWS = 0,
+    TRAVERSAL_TILES,
+    TRAVERSAL_MORTON
+} TraversalOrder;
+
+/// @brief How blocks are handed to threads. The blocks of one task are drawn by one thread in traversal order.
+/// TRAVERSAL_DYNAMIC makes every block a task, taken by whichever thread is free. TRAVERSAL_GUIDED makes tasks of
+/// several blocks that shrink towards the end to even out the last ones. TRAVERSAL_STATIC gives every thread one equal
+/// run of blocks, the least overhead for callbacks of even cost
+typedef enum TraversalSchedule
+{
+    TRAVERSAL_DYNAMIC = 0,
+    TRAVERSAL_GUIDED,
+    TRAVERSAL_STATIC
+} TraversalSchedule;
+
+/// @brief How draw and draw_bounded walk their area. The zero value draws bands of TRAVERSAL_DEFAULT_ROWS rows,
+/// one per task. Square blocks keep callbacks reading textures or noise fields around a pixel within the cache
+/// @param order Shape and order of the blocks
+/// @param schedule How blocks are handed to threads
+/// @param block_size Rows per band, or pixels per side of a square block. 0 picks the default
+typedef struct Traversal
+{
+    TraversalOrder order;
+    TraversalSchedule schedule;
+    int block_size;
+} Traversal;
+
+/// @brief An area split into blocks in traversal order, and the blocks split into tasks.
+/// Storage is reused between builds
+/// @param area Area that was split
+/// @param block_width Width of every block but the last column
+/// @param block_height Height of every block but the last row
+/// @param blocks_x Number of block columns
+/// @param block_count Number of blocks
+/// @param morton Block indices, `by * blocks_x + bx`, in Z-order. Only used for TRAVERSAL_MORTON
+/// @param task_start The blocks of task `t` are the blocks from `task_start[t]` up to `task_start[t + 1]` in traversal order
+/// @param task_count Number of tasks
+typedef struct TraversalPlan
+{
+    Recti area;
+    TraversalOrder order;
+    int block_width;
+    int block_height;
+    int blocks_x;
+    int block_count;
+    int *morton;
+    int morton_capacity;
+    int *task_start;
+    int task_capacity;
+    int task_count;
+} TraversalPlan;
+
+/// @brief Splits an area into blocks and tasks
+/// @param plan Plan to fill. Must be zero initialized before first use
+/// @param traversal How to walk the area
+/// @param area Area to split. Must not be empty
+/// @param thread_count Number of threads drawing, used by TRAVERSAL_GUIDED and TRAVERSAL_STATIC
+void traversal_plan_build(TraversalPlan *plan, Traversal traversal, Recti area, int thread_count);
+
+/// @brief Gives the area of a block, clamped to the plan's area
+/// @param plan Built plan
+/// @param position Position of the block in traversal order
+/// @return Area of the block
+Recti traversal_block_area(const TraversalPlan *plan, int position);
+
+/// @brief Frees storage held by the plan
+/// @param plan Plan to free
+void traversal_plan_free(TraversalPlan *plan);
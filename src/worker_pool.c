@@ -0,0 +1,269 @@
+#include "../include/renderer.h"
+
+static uint64_t worker_pool_now_ns(const WorkerPool *pool)
+{
+    return (uint64_t)((double)SDL_GetPerformanceCounter() * pool->ns_per_tick);
+}
+
+static void worker_pool_pin(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#else
+    (void)cpu;
+#endif
+}
+
+// Like SDL_AtomicLock, yielding between attempts. Its atomics sit in SDL's own library, where ThreadSanitizer
+// can't see them and reports the deques as racing
+static void deque_lock(WorkerDeque *deque)
+{
+    while (__atomic_exchange_n(&deque->lock, 1, __ATOMIC_ACQUIRE))
+        SDL_Delay(0);
+}
+
+static void deque_unlock(WorkerDeque *deque)
+{
+    __atomic_store_n(&deque->lock, 0, __ATOMIC_RELEASE);
+}
+
+static int deque_pop(WorkerDeque *deque, int *index)
+{
+    int found = 0;
+    deque_lock(deque);
+    if (deque->top < deque->bottom)
+    {
+        *index = --deque->bottom;
+        found = 1;
+    }
+    deque_unlock(deque);
+    return found;
+}
+
+static int deque_steal(WorkerDeque *deque, int *index)
+{
+    int found = 0;
+    deque_lock(deque);
+    if (deque->top < deque->bottom)
+    {
+        *index = deque->top++;
+        found = 1;
+    }
+    deque_unlock(deque);
+    return found;
+}
+
+static void worker_pool_work(WorkerPool *pool, int worker, void (*task)(void *, int), void *context)
+{
+    WorkerStats *stats = &pool->stats[worker];
+
+    for (;;)
+    {
+        int index;
+        if (!deque_pop(&pool->deques[worker], &index))
+        {
+            int found = 0;
+            for (int k = 1; k < pool->thread_count && !found; k++)
+                found = deque_steal(&pool->deques[(worker + k) % pool->thread_count], &index);
+
+            if (!found)
+                return;
+            stats->steals++;
+        }
+
+        uint64_t start = worker_pool_now_ns(pool);
+        task(context, index);
+        stats->busy_ns += worker_pool_now_ns(pool) - start;
+        stats->tasks++;
+
+        // The last task to finish wakes the thread waiting at the barrier
+        if (__atomic_fetch_sub(&pool->remaining, 1, __ATOMIC_ACQ_REL) == 1)
+        {
+            SDL_LockMutex(pool->lock);
+            SDL_CondBroadcast(pool->done);
+            SDL_UnlockMutex(pool->lock);
+        }
+    }
+}
+
+static int worker_pool_thread(void *data)
+{
+    WorkerThread *self = data;
+    WorkerPool *pool = self->pool;
+    int worker = self->index;
+    uint64_t seen_generation = 0;
+
+    if (pool->config.pin_threads)
+        worker_pool_pin((pool->config.first_cpu + worker) % SDL_GetCPUCount());
+
+    SDL_LockMutex(pool->lock);
+    for (;;)
+    {
+        while (pool->running && (!pool->batch_open || seen_generation == pool->generation))
+            SDL_CondWait(pool->wake, pool->lock);
+
+        if (!pool->running)
+            break;
+
+        seen_generation = pool->generation;
+        pool->busy_workers++;
+        void (*task)(void *, int) = pool->task;
+        void *context = pool->context;
+        SDL_UnlockMutex(pool->lock);
+
+        worker_pool_work(pool, worker, task, context);
+
+        SDL_LockMutex(pool->lock);
+        if (--pool->busy_workers == 0)
+            SDL_CondBroadcast(pool->done);
+    }
+    SDL_UnlockMutex(pool->lock);
+
+    return 0;
+}
+
+int worker_pool_init(WorkerPool *pool, const WorkerPoolConfig *config)
+{
+    memset(pool, 0, sizeof(*pool));
+    if (config)
+        pool->config = *config;
+
+    int thread_count = pool->config.thread_count > 0 ? pool->config.thread_count : SDL_GetCPUCount();
+    if (thread_count < 1)
+        thread_count = 1;
+    if (thread_count > WORKER_POOL_MAX_THREADS)
+        thread_count = WORKER_POOL_MAX_THREADS;
+
+    pool->thread_count = 1;
+    pool->running = 1;
+    pool->ns_per_tick = 1e9 / (double)SDL_GetPerformanceFrequency();
+    pool->run_lock = SDL_CreateMutex();
+    pool->lock = SDL_CreateMutex();
+    pool->wake = SDL_CreateCond();
+    pool->done = SDL_CreateCond();
+    if (!pool->run_lock || !pool->lock || !pool->wake || !pool->done)
+    {
+        worker_pool_shutdown(pool);
+        return 1;
+    }
+
+    // Worker 0 is the thread calling worker_pool_run
+    for (int i = 1; i < thread_count; i++)
+    {
+        WorkerThread *thread = &pool->threads[i];
+        thread->pool = pool;
+        thread->index = i;
+        thread->thread = SDL_CreateThread(worker_pool_thread, "worker_pool", thread);
+        if (!thread->thread)
+        {
+            worker_pool_shutdown(pool);
+            return 1;
+        }
+        pool->thread_count = i + 1;
+    }
+
+    return 0;
+}
+
+void worker_pool_run(WorkerPool *pool, int count, void (*task)(void *context, int index), void *context)
+{
+    if (count <= 0)
+        return;
+
+    SDL_LockMutex(pool->run_lock);
+
+    // No worker is inside a batch here, so the deques can be refilled without their locks
+    SDL_LockMutex(pool->lock);
+    for (int w = 0; w < pool->thread_count; w++)
+    {
+        pool->deques[w].top = (int)((long long)count * w / pool->thread_count);
+        pool->deques[w].bottom = (int)((long long)count * (w + 1) / pool->thread_count);
+    }
+    pool->task = task;
+    pool->context = context;
+    __atomic_store_n(&pool->remaining, count, __ATOMIC_RELEASE);
+    pool->generation++;
+    pool->batch_open = 1;
+    SDL_CondBroadcast(pool->wake);
+    SDL_UnlockMutex(pool->lock);
+
+    worker_pool_work(pool, 0, task, context);
+
+    // Wait for the last task, then for every worker to leave the batch before its context goes away
+    uint64_t start = worker_pool_now_ns(pool);
+    SDL_LockMutex(pool->lock);
+    while (__atomic_load_n(&pool->remaining, __ATOMIC_ACQUIRE) > 0)
+        SDL_CondWait(pool->done, pool->lock);
+    pool->batch_open = 0;
+    while (pool->busy_workers > 0)
+        SDL_CondWait(pool->done, pool->lock);
+    SDL_UnlockMutex(pool->lock);
+
+    pool->barrier_ns += worker_pool_now_ns(pool) - start;
+    pool->batches++;
+
+    SDL_UnlockMutex(pool->run_lock);
+}
+
+void worker_pool_stats(WorkerPool *pool, WorkerPoolStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    SDL_LockMutex(pool->run_lock);
+    stats->thread_count = pool->thread_count;
+    stats->batches = pool->batches;
+    stats->barrier_ns = pool->barrier_ns;
+
+    uint64_t total = 0;
+    uint64_t busiest = 0;
+    for (int w = 0; w < pool->thread_count; w++)
+    {
+        stats->workers[w] = pool->stats[w];
+        total += pool->stats[w].busy_ns;
+        if (pool->stats[w].busy_ns > busiest)
+            busiest = pool->stats[w].busy_ns;
+    }
+    SDL_UnlockMutex(pool->run_lock);
+
+    stats->imbalance = total ? (double)busiest * pool->thread_count / (double)total : 1.0;
+}
+
+void worker_pool_reset_stats(WorkerPool *pool)
+{
+    SDL_LockMutex(pool->run_lock);
+    memset(pool->stats, 0, sizeof(pool->stats));
+    pool->batches = 0;
+    pool->barrier_ns = 0;
+    SDL_UnlockMutex(pool->run_lock);
+}
+
+void worker_pool_shutdown(WorkerPool *pool)
+{
+    if (pool->lock)
+    {
+        SDL_LockMutex(pool->lock);
+        pool->running = 0;
+        if (pool->wake)
+            SDL_CondBroadcast(pool->wake);
+        SDL_UnlockMutex(pool->lock);
+    }
+
+    for (int i = 1; i < pool->thread_count; i++)
+        SDL_WaitThread(pool->threads[i].thread, NULL);
+
+    if (pool->done)
+        SDL_DestroyCond(pool->done);
+    if (pool->wake)
+        SDL_DestroyCond(pool->wake);
+    if (pool->lock)
+        SDL_DestroyMutex(pool->lock);
+    if (pool->run_lock)
+        SDL_DestroyMutex(pool->run_lock);
+
+    memset(pool, 0, sizeof(*pool));
+}
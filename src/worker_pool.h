@@ -0,0 +1,114 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <stdint.h>
+
+#define WORKER_POOL_MAX_THREADS 64
+
+/// @brief Settings of a worker pool
+/// @param thread_count Number of workers including the thread calling worker_pool_run. 0 uses one per CPU
+/// @param pin_threads When nonzero, worker `i` is pinned to CPU `(first_cpu + i) % cpu_count`.
+/// The calling thread (worker 0) is never pinned
+/// @param first_cpu CPU of worker 0 when pinning
+typedef struct WorkerPoolConfig
+{
+    int thread_count;
+    int pin_threads;
+    int first_cpu;
+} WorkerPoolConfig;
+
+/// @brief Counters of a single worker
+/// @param busy_ns Time spent running tasks
+/// @param tasks Number of tasks run
+/// @param steals Number of tasks taken from other workers
+typedef struct WorkerStats
+{
+    uint64_t busy_ns;
+    uint64_t tasks;
+    uint64_t steals;
+} WorkerStats;
+
+/// @brief Counters of a worker pool since creation or the last worker_pool_reset_stats
+/// @param batches Number of calls to worker_pool_run
+/// @param barrier_ns Time the calling thread spent waiting for other workers to finish after running out of tasks
+/// @param imbalance Busy time of the busiest worker divided by the average busy time. 1 is perfect balance
+typedef struct WorkerPoolStats
+{
+    int thread_count;
+    uint64_t batches;
+    uint64_t barrier_ns;
+    double imbalance;
+    WorkerStats workers[WORKER_POOL_MAX_THREADS];
+} WorkerPoolStats;
+
+/// @brief Range of task indices owned by a worker. The owner takes from the bottom, thieves from the top
+typedef struct WorkerDeque
+{
+    int lock;
+    int top;
+    int bottom;
+    char padding[64 - 3 * sizeof(int)];
+} WorkerDeque;
+
+struct WorkerPool;
+
+/// @brief A thread of a worker pool
+typedef struct WorkerThread
+{
+    struct WorkerPool *pool;
+    SDL_Thread *thread;
+    int index;
+} WorkerThread;
+
+/// @brief Persistent threads running batches of indexed tasks with work stealing.
+/// Attach a pool to a framebuffer by setting `fb->pool` to make its draw functions use it instead of OpenMP.
+/// A pool can be shared by several framebuffers, batches from different threads run one after another
+typedef struct WorkerPool
+{
+    WorkerPoolConfig config;
+    int thread_count;
+    WorkerThread threads[WORKER_POOL_MAX_THREADS];
+    WorkerDeque deques[WORKER_POOL_MAX_THREADS];
+    WorkerStats stats[WORKER_POOL_MAX_THREADS];
+    SDL_mutex *run_lock;
+    SDL_mutex *lock;
+    SDL_cond *wake;
+    SDL_cond *done;
+    int remaining;
+    uint64_t generation;
+    int batch_open;
+    int busy_workers;
+    int running;
+    void (*task)(void *context, int index);
+    void *context;
+    uint64_t batches;
+    uint64_t barrier_ns;
+    double ns_per_tick;
+} WorkerPool;
+
+/// @brief Starts the worker threads
+/// @param pool WorkerPool to initialize
+/// @param config Settings. NULL for one worker per CPU without pinning
+/// @return 0 for success and 1 for failure
+int worker_pool_init(WorkerPool *pool, const WorkerPoolConfig *config);
+
+/// @brief Runs `task(context, i)` for every i from 0 up to `count` and waits for all of them to finish.
+/// Tasks are split evenly between the workers, and workers running out of tasks steal from the others.
+/// The calling thread works as worker 0
+/// @param pool Pool to run on
+/// @param count Number of tasks
+/// @param task Task function. Tasks may run in any order and in parallel
+/// @param context Passed to every task
+void worker_pool_run(WorkerPool *pool, int count, void (*task)(void *context, int index), void *context);
+
+/// @brief Copies the pool's counters
+/// @param pool Pool to read
+/// @param stats Filled with the counters
+void worker_pool_stats(WorkerPool *pool, WorkerPoolStats *stats);
+
+/// @brief Sets all counters of the pool to 0
+/// @param pool Pool to reset
+void worker_pool_reset_stats(WorkerPool *pool);
+
+/// @brief Stops and joins the worker threads
+/// @param pool Pool to shut down
+void worker_pool_shutdown(WorkerPool *pool);
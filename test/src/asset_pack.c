@@ -0,0 +1,127 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of asset packs: written bitmaps map back unchanged and aligned, lookups find every name,
+ * writing to a mapped bitmap leaves the file alone, and damaged files fail to open.
+ */
+
+#define PACK_PATH "test/build/assets.pak"
+#define DAMAGED_PATH "test/build/assets_damaged.pak"
+#define ASSETS 6
+
+static int copy_damaged(long keep, long corrupt_at)
+{
+    static uint8_t data[1 << 20];
+    FILE *in = fopen(PACK_PATH, "rb");
+    size_t size = in ? fread(data, 1, sizeof(data), in) : 0;
+    if (in)
+        fclose(in);
+    if (keep >= 0 && (size_t)keep < size)
+        size = (size_t)keep;
+    if (corrupt_at >= 0)
+        data[corrupt_at] ^= 0x21;
+
+    FILE *out = fopen(DAMAGED_PATH, "wb");
+    if (!out)
+        return 1;
+    fwrite(data, 1, size, out);
+    fclose(out);
+    return 0;
+}
+
+int main(void)
+{
+    const char *names[ASSETS] = {"zeta", "alpha", "player_walk_3", "b", "tiles", "a_very_long_name_of_47_characters_is_the_limit_"};
+    const int sizes[ASSETS][2] = {{1, 1}, {3, 5}, {64, 64}, {100, 37}, {7, 300}, {16, 16}};
+    Bitmap bitmaps[ASSETS];
+    AssetPack pack;
+    int failures = 0;
+
+    srand(13);
+    for (int i = 0; i < ASSETS; i++)
+    {
+        bitmaps[i] = (Bitmap){sizes[i][0], sizes[i][1], malloc((size_t)sizes[i][0] * sizes[i][1] * sizeof(uint32_t))};
+        for (int p = 0; p < sizes[i][0] * sizes[i][1]; p++)
+            bitmaps[i].bitmap_argb[p] = (uint32_t)rand() * 2654435761u;
+    }
+
+    if (asset_pack_write(PACK_PATH, names, bitmaps, ASSETS) != 0 || asset_pack_open(&pack, PACK_PATH) != 0)
+    {
+        printf("FAILED: writing and opening the pack\n");
+        return 1;
+    }
+
+    /* Every asset is found by name, aligned, and holds the written pixels */
+    for (int i = 0; i < ASSETS; i++)
+    {
+        int index = asset_pack_find(&pack, names[i]);
+        Bitmap bitmap = index >= 0 ? asset_pack_bitmap(&pack, index) : (Bitmap){0};
+        size_t bytes = (size_t)sizes[i][0] * sizes[i][1] * sizeof(uint32_t);
+        if (index < 0 || bitmap.width != sizes[i][0] || bitmap.height != sizes[i][1] ||
+            (uintptr_t)bitmap.bitmap_argb % ASSET_PACK_ALIGNMENT != 0 || memcmp(bitmap.bitmap_argb, bitmaps[i].bitmap_argb, bytes) != 0)
+        {
+            printf("FAIL %s: not found or different after mapping\n", names[i]);
+            failures++;
+        }
+    }
+    if (pack.count != ASSETS || asset_pack_find(&pack, "missing") != -1 || asset_pack_find(&pack, "") != -1)
+    {
+        printf("FAIL lookup: %d assets, missing names found\n", pack.count);
+        failures++;
+    }
+
+    /* Mapped bitmaps draw like heap bitmaps */
+    Framebuffer mapped_fb, heap_fb;
+    framebuffer_init(&mapped_fb, 120, 80);
+    framebuffer_init(&heap_fb, 120, 80);
+    Bitmap tiles = asset_pack_bitmap(&pack, asset_pack_find(&pack, "b"));
+    draw_bounded(&mapped_fb, create_bitmap_draw_job(tiles, 10, 20));
+    draw_bounded(&heap_fb, create_bitmap_draw_job(bitmaps[3], 10, 20));
+    if (memcmp(mapped_fb.pixels, heap_fb.pixels, 120 * 80 * sizeof(uint32_t)) != 0)
+    {
+        printf("FAIL draw: mapped bitmap draws differently\n");
+        failures++;
+    }
+    framebuffer_destroy(&mapped_fb);
+    framebuffer_destroy(&heap_fb);
+
+    /* Writing to a mapped bitmap copies the page, other mappings of the file still see the original */
+    AssetPack other;
+    tiles.bitmap_argb[0] = ~bitmaps[3].bitmap_argb[0];
+    if (asset_pack_open(&other, PACK_PATH) != 0 ||
+        asset_pack_bitmap(&other, asset_pack_find(&other, "b")).bitmap_argb[0] != bitmaps[3].bitmap_argb[0])
+    {
+        printf("FAIL copy on write: the file changed\n");
+        failures++;
+    }
+    asset_pack_close(&other);
+    asset_pack_close(&pack);
+
+    /* Duplicate and too long names are refused */
+    const char *duplicate[2] = {"same", "same"};
+    const char *too_long[1] = {"a_name_of_48_characters_is_one_more_than_allowed"};
+    if (asset_pack_write(DAMAGED_PATH, duplicate, bitmaps, 2) == 0 || asset_pack_write(DAMAGED_PATH, too_long, bitmaps, 1) == 0)
+    {
+        printf("FAIL write: bad names accepted\n");
+        failures++;
+    }
+
+    /* Truncated files and files with a damaged header or index don't open */
+    const long damage[][2] = {{100, -1}, {-1, 0}, {-1, 12}, {-1, 32 + 50}, {-1, 32 + 56}};
+    for (int d = 0; d < (int)(sizeof(damage) / sizeof(damage[0])); d++)
+    {
+        if (copy_damaged(damage[d][0], damage[d][1]) != 0 || asset_pack_open(&other, DAMAGED_PATH) == 0)
+        {
+            printf("FAIL damaged file %d: opened\n", d);
+            asset_pack_close(&other);
+            failures++;
+        }
+    }
+
+    remove(PACK_PATH);
+    remove(DAMAGED_PATH);
+    for (int i = 0; i < ASSETS; i++)
+        free(bitmaps[i].bitmap_argb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,355 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of frame capture: PNG files decode back to the framebuffer's colors with valid checksums,
+ * raw and delta streams read back every captured frame under its number, and a full ring drops frames
+ * instead of waiting.
+ */
+
+#define FB_WIDTH 157
+#define FB_HEIGHT 91
+#define FRAMES 40
+#define STREAM_PATH "test/build/capture_stream.bin"
+#define PNG_PREFIX "test/build/capture_frame_"
+
+static uint32_t expected[FRAMES][FB_WIDTH * FB_HEIGHT];
+
+typedef struct BitReader
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    int error;
+} BitReader;
+
+static uint32_t read_bit(BitReader *reader)
+{
+    if (reader->pos >= reader->size * 8)
+    {
+        reader->error = 1;
+        return 0;
+    }
+    uint32_t bit = reader->data[reader->pos / 8] >> (reader->pos % 8) & 1;
+    reader->pos++;
+    return bit;
+}
+
+static uint32_t read_bits(BitReader *reader, int count)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++)
+        value |= read_bit(reader) << i;
+    return value;
+}
+
+/* Fixed Huffman codes are read most significant bit first */
+static int read_fixed_symbol(BitReader *reader)
+{
+    uint32_t code = 0;
+    for (int i = 0; i < 7; i++)
+        code = code << 1 | read_bit(reader);
+    if (code <= 23)
+        return 256 + (int)code;
+    code = code << 1 | read_bit(reader);
+    if (code >= 0x30 && code <= 0xBF)
+        return (int)code - 0x30;
+    if (code >= 0xC0 && code <= 0xC7)
+        return 280 + (int)code - 0xC0;
+    code = code << 1 | read_bit(reader);
+    return 144 + (int)code - 0x190;
+}
+
+/* Inflates a zlib stream of fixed Huffman blocks, the only kind the encoder writes */
+static size_t inflate_fixed(const uint8_t *data, size_t size, uint8_t *out, size_t capacity)
+{
+    static const int length_base[] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int length_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int distance_base[] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const int distance_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    if (size < 6 || (data[0] << 8 | data[1]) % 31 != 0 || (data[0] & 0x0F) != 8)
+        return 0;
+
+    BitReader reader = {data + 2, size - 6, 0, 0};
+    size_t length = 0;
+    int last = 0;
+    while (!last && !reader.error)
+    {
+        last = (int)read_bits(&reader, 1);
+        if (read_bits(&reader, 2) != 1)
+            return 0;
+
+        for (;;)
+        {
+            int symbol = read_fixed_symbol(&reader);
+            if (reader.error || symbol > 285)
+                return 0;
+            if (symbol < 256)
+            {
+                if (length >= capacity)
+                    return 0;
+                out[length++] = (uint8_t)symbol;
+                continue;
+            }
+            if (symbol == 256)
+                break;
+
+            int run = length_base[symbol - 257] + (int)read_bits(&reader, length_extra[symbol - 257]);
+            uint32_t code = 0;
+            for (int i = 0; i < 5; i++)
+                code = code << 1 | read_bit(&reader);
+            if (code > 29)
+                return 0;
+            size_t distance = (size_t)distance_base[code] + read_bits(&reader, distance_extra[code]);
+            if (distance > length || length + run > capacity)
+                return 0;
+            for (int i = 0; i < run; i++, length++)
+                out[length] = out[length - distance];
+        }
+    }
+
+    /* Adler-32 of the inflated data, big endian after the deflate stream */
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        a = (a + out[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    const uint8_t *adler = data + size - 4;
+    if (reader.error || (b << 16 | a) != ((uint32_t)adler[0] << 24 | adler[1] << 16 | adler[2] << 8 | adler[3]))
+        return 0;
+    return length;
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+/* Decodes a PNG written by png_encode back to 0xFF-alpha ARGB. Returns 0 on success */
+static int decode_png(const uint8_t *file, size_t size, uint32_t *pixels, int width, int height)
+{
+    static uint8_t filtered[FB_HEIGHT * (1 + 3 * FB_WIDTH)];
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    size_t row_size = 1 + 3 * (size_t)width;
+
+    if (size < 8 || memcmp(file, signature, 8) != 0)
+        return 1;
+
+    size_t inflated = 0;
+    for (size_t pos = 8; pos + 12 <= size;)
+    {
+        uint32_t length = read_u32(file + pos);
+        if (pos + 12 + length > size || png_crc32(0, file + pos + 4, length + 4) != read_u32(file + pos + 8 + length))
+            return 1;
+
+        const uint8_t *data = file + pos + 8;
+        if (memcmp(file + pos + 4, "IHDR", 4) == 0 &&
+            (read_u32(data) != (uint32_t)width || read_u32(data + 4) != (uint32_t)height || data[8] != 8 || data[9] != 2))
+            return 1;
+        if (memcmp(file + pos + 4, "IDAT", 4) == 0)
+            inflated = inflate_fixed(data, length, filtered, sizeof(filtered));
+        pos += 12 + length;
+    }
+    if (inflated != (size_t)height * row_size)
+        return 1;
+
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t *row = filtered + y * row_size;
+        if (row[0] != 2)
+            return 1;
+        for (size_t i = 1; y > 0 && i < row_size; i++)
+            row[i] = (uint8_t)(row[i] + row[i - row_size]);
+        for (int x = 0; x < width; x++)
+            pixels[y * width + x] = 0xFF000000 | row[1 + 3 * x] << 16 | row[2 + 3 * x] << 8 | row[3 + 3 * x];
+    }
+    return 0;
+}
+
+/* Moving shapes over a still background, so most of every frame is unchanged */
+static void draw_frame(Framebuffer *fb, int frame)
+{
+    draw(fb, drawjob_linear_gradient((Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, (Pointf){0, 0}, 0xFF102030,
+                                     (Pointf){FB_WIDTH, FB_HEIGHT}, 0xFFF0C080));
+    draw_bounded(fb, drawjob_solid((Recti){{frame * 3, 10}, {frame * 3 + 20, 40}}, 0xFF00FF00 | (uint32_t)frame));
+    draw_bounded(fb, drawjob_circle((Pointf){80, 60 + frame % 7}, 12, 0xC0804020));
+}
+
+static int check_stream(Framebuffer *fb, CaptureFormat format, int buffer_count, const char *name)
+{
+    Capture capture;
+    CaptureStats stats;
+    int queued[FRAMES];
+
+    if (capture_init(&capture, &(CaptureConfig){STREAM_PATH, format, buffer_count, 0}, FB_WIDTH, FB_HEIGHT) != 0)
+    {
+        printf("FAIL %s: capture_init\n", name);
+        return 1;
+    }
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        draw_frame(fb, frame);
+        memcpy(expected[frame], fb->pixels, sizeof(expected[frame]));
+        queued[frame] = capture_frame(&capture, fb) == 0;
+    }
+    capture_shutdown(&capture, &stats);
+
+    int captured = 0;
+    for (int frame = 0; frame < FRAMES; frame++)
+        captured += queued[frame];
+    if ((int)stats.captured != captured || stats.written != stats.captured || stats.captured + stats.dropped != FRAMES ||
+        stats.failed)
+    {
+        printf("FAIL %s: %llu captured, %llu written, %llu dropped, %llu failed\n", name,
+               (unsigned long long)stats.captured, (unsigned long long)stats.written,
+               (unsigned long long)stats.dropped, (unsigned long long)stats.failed);
+        return 1;
+    }
+
+    CaptureReader reader;
+    if (capture_reader_open(&reader, STREAM_PATH) != 0 || reader.width != FB_WIDTH || reader.height != FB_HEIGHT)
+    {
+        printf("FAIL %s: capture_reader_open\n", name);
+        return 1;
+    }
+
+    int read = 0;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        if (!queued[frame])
+            continue;
+        if (capture_reader_next(&reader) != 0 || reader.frame != (uint64_t)frame ||
+            memcmp(reader.pixels, expected[frame], sizeof(expected[frame])) != 0)
+        {
+            printf("FAIL %s: frame %d reads back as frame %llu with other pixels\n", name, frame,
+                   (unsigned long long)reader.frame);
+            capture_reader_close(&reader);
+            return 1;
+        }
+        read++;
+    }
+    int extra = capture_reader_next(&reader) == 0;
+    capture_reader_close(&reader);
+
+    if (extra || read != captured)
+    {
+        printf("FAIL %s: stream holds other frames than the %d captured\n", name, captured);
+        return 1;
+    }
+
+    /* After the first frame, deltas of mostly still frames are much smaller than raw frames */
+    uint64_t raw = (uint64_t)FB_WIDTH * FB_HEIGHT * 4 + 16;
+    if (format == CAPTURE_DELTA && stats.bytes > raw + (uint64_t)(captured - 1) * raw / 2)
+    {
+        printf("FAIL %s: %llu bytes for %d frames\n", name, (unsigned long long)stats.bytes, captured);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static uint32_t decoded[FB_WIDTH * FB_HEIGHT];
+    static uint8_t file[1 << 20];
+    Framebuffer fb;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    /* Random noise, which barely compresses, and a rendered frame, which does. Alpha is dropped */
+    PngEncoder encoder;
+    png_encoder_init(&encoder, FB_WIDTH, FB_HEIGHT);
+    srand(9);
+    for (int image = 0; image < 2; image++)
+    {
+        if (image == 0)
+            for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+                fb.pixels[i] = (uint32_t)rand() * 2654435761u;
+        else
+            draw_frame(&fb, 5);
+
+        size_t size;
+        const uint8_t *png = png_encode(&encoder, fb.pixels, fb.stride, &size);
+        if (decode_png(png, size, decoded, FB_WIDTH, FB_HEIGHT) != 0)
+        {
+            printf("FAIL png %d: does not decode\n", image);
+            failures++;
+            continue;
+        }
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+            if (decoded[i] != (fb.pixels[i] | 0xFF000000))
+            {
+                printf("FAIL png %d: pixel %d is %08x, expected %08x\n", image, i, decoded[i], fb.pixels[i] | 0xFF000000);
+                failures++;
+                break;
+            }
+        if (image == 1 && size > (size_t)FB_WIDTH * FB_HEIGHT * 3 / 2)
+        {
+            printf("FAIL png: rendered frame takes %zu bytes\n", size);
+            failures++;
+        }
+    }
+    png_encoder_free(&encoder);
+
+    failures += check_stream(&fb, CAPTURE_RAW, FRAMES, "raw");
+    failures += check_stream(&fb, CAPTURE_DELTA, FRAMES, "delta");
+    failures += check_stream(&fb, CAPTURE_DELTA, 1, "delta with one buffer");
+
+    /* PNG sequences: every written frame is a file named by its number. One slow buffer has to drop frames */
+    Capture capture;
+    CaptureStats stats;
+    capture_init(&capture, &(CaptureConfig){PNG_PREFIX, CAPTURE_PNG, 1, 1}, FB_WIDTH, FB_HEIGHT);
+    int queued[FRAMES];
+    /* The frames drawn for the streams are still in `expected`, so frames come much faster than they are encoded */
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        memcpy(fb.pixels, expected[frame], sizeof(expected[frame]));
+        queued[frame] = capture_frame(&capture, &fb) == 0;
+    }
+    capture_shutdown(&capture, &stats);
+
+    if (stats.dropped == 0 || stats.written != stats.captured || stats.captured + stats.dropped != FRAMES)
+    {
+        printf("FAIL png sequence: %llu captured, %llu written, %llu dropped\n", (unsigned long long)stats.captured,
+               (unsigned long long)stats.written, (unsigned long long)stats.dropped);
+        failures++;
+    }
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), PNG_PREFIX "%06d.png", frame);
+        FILE *png = fopen(name, "rb");
+        if (!png)
+        {
+            if (queued[frame])
+            {
+                printf("FAIL png sequence: frame %d was not written\n", frame);
+                failures++;
+            }
+            continue;
+        }
+        size_t size = fread(file, 1, sizeof(file), png);
+        fclose(png);
+        remove(name);
+
+        if (!queued[frame] || decode_png(file, size, decoded, FB_WIDTH, FB_HEIGHT) != 0 ||
+            memcmp(decoded, expected[frame], sizeof(decoded)) != 0)
+        {
+            printf("FAIL png sequence: file of frame %d is wrong\n", frame);
+            failures++;
+        }
+    }
+
+    remove(STREAM_PATH);
+    framebuffer_destroy(&fb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
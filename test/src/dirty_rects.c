@@ -0,0 +1,84 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the dirty area list: every damaged pixel is covered, and by exactly one area,
+ * so no pixel is uploaded or counted twice.
+ */
+
+#define GRID 120
+
+/* Counts how many areas of the list cover each pixel, and checks the damaged pixels are all covered once */
+static int check_cover(const char *name, const DirtyRects *dirty, const uint8_t *damaged)
+{
+    static uint8_t cover[GRID * GRID];
+    memset(cover, 0, sizeof(cover));
+
+    for (int i = 0; i < dirty->count; i++)
+    {
+        Recti rect = dirty->rects[i];
+        for (int y = rect.top_left.y; y < rect.bottom_right.y; y++)
+            for (int x = rect.top_left.x; x < rect.bottom_right.x; x++)
+                cover[y * GRID + x]++;
+    }
+
+    for (int i = 0; i < GRID * GRID; i++)
+    {
+        if (cover[i] > 1 || (damaged[i] && !cover[i]))
+        {
+            printf("FAIL %s: pixel (%d,%d) covered %d times\n", name, i % GRID, i / GRID, cover[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void add_damage(DirtyRects *dirty, uint8_t *damaged, Recti rect)
+{
+    dirty_rects_add(dirty, rect);
+    for (int y = rect.top_left.y; y < rect.bottom_right.y; y++)
+        for (int x = rect.top_left.x; x < rect.bottom_right.x; x++)
+            damaged[y * GRID + x] = 1;
+}
+
+int main(void)
+{
+    static uint8_t damaged[GRID * GRID];
+    DirtyRects dirty = {0};
+    int failures = 0;
+
+    /* A plus shape: merging the arms grows the area, but keeping both would count the middle twice */
+    add_damage(&dirty, damaged, (Recti){{0, 10}, {30, 20}});
+    add_damage(&dirty, damaged, (Recti){{10, 0}, {20, 30}});
+    failures += check_cover("plus", &dirty, damaged);
+
+    /* Touching areas of the same height become one */
+    dirty_rects_clear(&dirty);
+    memset(damaged, 0, sizeof(damaged));
+    add_damage(&dirty, damaged, (Recti){{0, 0}, {10, 10}});
+    add_damage(&dirty, damaged, (Recti){{10, 0}, {20, 10}});
+    if (dirty.count != 1 || dirty_rects_pixels(&dirty) != 200)
+    {
+        printf("FAIL touching: %d areas, %lld pixels\n", dirty.count, dirty_rects_pixels(&dirty));
+        failures++;
+    }
+
+    /* Random damage, including enough areas to fill the list */
+    srand(5);
+    for (int round = 0; round < 200 && !failures; round++)
+    {
+        dirty_rects_clear(&dirty);
+        memset(damaged, 0, sizeof(damaged));
+        int count = 1 + rand() % 40;
+        for (int i = 0; i < count; i++)
+        {
+            int x = rand() % GRID, y = rand() % GRID;
+            int w = 1 + rand() % (GRID - x < 30 ? GRID - x : 30);
+            int h = 1 + rand() % (GRID - y < 30 ? GRID - y : 30);
+            add_damage(&dirty, damaged, (Recti){{x, y}, {x + w, y + h}});
+        }
+        failures += check_cover("random", &dirty, damaged);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
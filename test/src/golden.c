@@ -0,0 +1,587 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless golden image runner. Every scenario is a list of jobs drawn with one of the draw, queue or plot functions.
+ * A reference image is drawn one job after another with drawjob_draw_area or plot_combine on a single thread, and its
+ * hash must match the one stored in test/golden/hashes.txt. The scenario is then drawn through the real function under
+ * every configuration: OpenMP and worker pools of 1 to N threads, each traversal order, occlusion culling and the job
+ * cache. Every configuration must give the reference image pixel for pixel. On a mismatch the actual and expected images
+ * and a diff marking the wrong pixels in red are written to test/build as PNG files, and on a wrong hash the reference image.
+ *
+ * Usage: golden [--update] [hash file]. --update rewrites the hash file from the reference images, after a deliberate
+ * change of output.
+ */
+
+#define FB_WIDTH 203
+#define FB_HEIGHT 151
+#define MAX_JOBS 512
+#define MAX_POINTS 20000
+#define MAX_CONFIGS 48
+#define MAX_SCENARIOS 32
+#define HASH_FILE "test/golden/hashes.txt"
+
+// Libgomp isn't instrumented, so under TSan its barriers look like races. Thread sanitized builds use worker pools only
+#if defined(__SANITIZE_THREAD__)
+#define GOLDEN_OPENMP 0
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define GOLDEN_OPENMP 0
+#endif
+#endif
+#ifndef GOLDEN_OPENMP
+#define GOLDEN_OPENMP 1
+#endif
+
+typedef enum GoldenCall
+{
+    CALL_DRAW,
+    CALL_DRAW_BOUNDED,
+    CALL_MULTIPLE,
+    CALL_MULTIPLE_SAFE,
+    CALL_QUEUE,
+    CALL_QUEUE_SAFE,
+    CALL_PLOT
+} GoldenCall;
+
+/* A scenario fills `jobs` or `points` and is drawn `frames` times through `call` */
+typedef struct Scenario
+{
+    const char *name;
+    GoldenCall call;
+    int (*build)(void);
+    PlotOp op;
+    int frames;
+} Scenario;
+
+typedef struct Config
+{
+    char name[32];
+    int threads;
+    int use_pool;
+    Traversal traversal;
+    int culling;
+    int cache;
+} Config;
+
+typedef struct CallbackData
+{
+    uint32_t seed;
+    int scale;
+} CallbackData;
+
+static DrawJob jobs[MAX_JOBS];
+static CallbackData job_data[MAX_JOBS];
+static PlotPoint points[MAX_POINTS];
+static uint32_t sprite[37 * 23];
+static uint32_t reference[FB_WIDTH * FB_HEIGHT];
+static uint32_t diff[FB_WIDTH * FB_HEIGHT];
+static uint32_t random_state;
+
+/* The runner's own generator, so images don't depend on the C library's rand */
+static uint32_t next_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static int random_int(int low, int high)
+{
+    return low + (int)(next_random() % (uint32_t)(high - low + 1));
+}
+
+static uint32_t seeded_callback(int x, int y, void *userdata)
+{
+    const CallbackData *data = userdata;
+    uint32_t v = ((uint32_t)(x / data->scale) * 73856093u) ^ ((uint32_t)(y / data->scale) * 19349663u) ^ data->seed;
+    return 0xFF000000 | (v & 0xFFFFFF);
+}
+
+/* Writes only every other pixel, so blended it leaves the rest transparent */
+static void checker_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    const CallbackData *data = userdata;
+    for (int x = x0; x < x1; x++)
+        if (((x / data->scale) + (y / data->scale)) & 1)
+            dst[x - x0] = data->seed | 0xFF000000;
+}
+
+static Recti random_area(int spread)
+{
+    int x = random_int(-spread, FB_WIDTH + spread / 2), y = random_int(-spread, FB_HEIGHT + spread / 2);
+    return (Recti){{x, y}, {x + random_int(1, 80), y + random_int(1, 60)}};
+}
+
+static DrawJob callback_job(int j, Recti area)
+{
+    job_data[j] = (CallbackData){next_random(), random_int(1, 9)};
+    return (DrawJob){.area = area, .callback = seeded_callback, .userdata = &job_data[j]};
+}
+
+/* Any kind of job, transformed and blended at random */
+static DrawJob random_job(int j, int spread)
+{
+    Recti area = random_area(spread);
+    Pointf a = {area.top_left.x, area.top_left.y}, b = {area.bottom_right.x, area.bottom_right.y};
+    uint32_t color = 0xFF000000 | next_random();
+    DrawJob job;
+
+    switch (j % 9)
+    {
+    case 0:
+        job = drawjob_solid(area, color);
+        break;
+    case 1:
+        job = drawjob_linear_gradient(area, a, color, b, ~color | 0xFF000000);
+        break;
+    case 2:
+        job = callback_job(j, area);
+        break;
+    case 3:
+        job_data[j] = (CallbackData){next_random() & 0xFFFFFF, random_int(1, 4)};
+        job = (DrawJob){.area = area, .span_callback = checker_span, .userdata = &job_data[j]};
+        break;
+    case 4:
+        job = create_bitmap_draw_job((Bitmap){37, 23, sprite}, area.top_left.x, area.top_left.y);
+        break;
+    case 5:
+        job = drawjob_shaded_triangle(a, color, (Pointf){b.x, a.y + 7}, 0xFF00FF00, (Pointf){a.x + 3, b.y}, 0xFF0000FF);
+        break;
+    case 6:
+        job = drawjob_line(a, color, b, 0x80402010, random_int(1, 8) / 2.0);
+        break;
+    case 7:
+        job = drawjob_ring((Pointf){(a.x + b.x) / 2, (a.y + b.y) / 2}, (b.y - a.y) / 2 + 2, 3, color_premultiply(color & 0xA0FFFFFF));
+        break;
+    default:
+        job = drawjob_rotate_around_point(drawjob_solid(area, color), random_int(0, 628) / 100.0, (Pointf){(a.x + b.x) / 2, (a.y + b.y) / 2});
+        break;
+    }
+
+    if (j % 5 == 0 && !drawjob_is_primitive(&job))
+    {
+        // Blended jobs produce premultiplied colors, see DrawJob
+        job.blend = (BlendMode)random_int(BLEND_SRC_OVER, BLEND_MULTIPLY);
+        if (job.kind == DRAWJOB_SOLID)
+            job.params.color = color_premultiply(job.params.color & 0x80FFFFFF);
+    }
+    if (j % 7 == 3)
+        job = drawjob_shear(job, random_int(-30, 30) / 100.0, 0);
+    return job;
+}
+
+static int build_draw_callback(void)
+{
+    jobs[0] = callback_job(0, (Recti){{0, 0}, {1, 1}});
+    return 1;
+}
+
+static int build_draw_span(void)
+{
+    job_data[0] = (CallbackData){0x3060C0, 3};
+    jobs[0] = (DrawJob){.area = {{0, 0}, {1, 1}}, .span_callback = checker_span, .userdata = &job_data[0]};
+    jobs[1] = callback_job(1, (Recti){{0, 0}, {1, 1}});
+    jobs[1].blend = BLEND_ADD;
+    return 2;
+}
+
+/* Areas entirely outside, partly outside, far larger than the framebuffer, empty and inverted */
+static int build_clamping(void)
+{
+    const Recti areas[] = {
+        {{-50, -50}, {-10, -10}}, {{-30, -20}, {40, 30}}, {{FB_WIDTH - 20, FB_HEIGHT - 15}, {FB_WIDTH + 40, FB_HEIGHT + 40}},
+        {{-1000000, 40}, {1000000, 60}}, {{90, -1000000}, {110, 1000000}}, {{INT_MIN / 2, INT_MIN / 2}, {10, 10}},
+        {{50, 50}, {50, 90}}, {{120, 80}, {100, 60}}, {{FB_WIDTH, 0}, {FB_WIDTH + 10, FB_HEIGHT}}, {{0, FB_HEIGHT - 1}, {FB_WIDTH, FB_HEIGHT + 5}}};
+    int count = 0;
+
+    for (int i = 0; i < (int)(sizeof(areas) / sizeof(areas[0])); i++)
+    {
+        Pointf a = {areas[i].top_left.x, areas[i].top_left.y};
+        jobs[count++] = drawjob_solid(areas[i], 0xFF000000 | next_random());
+        jobs[count] = drawjob_linear_gradient(areas[i], a, 0xFFFF0000, (Pointf){a.x + 50, a.y + 30}, 0xFF0000FF);
+        jobs[count].area.top_left.x += 3;
+        count++;
+    }
+    jobs[count++] = create_bitmap_draw_job((Bitmap){37, 23, sprite}, -20, -10);
+    jobs[count++] = create_bitmap_draw_job((Bitmap){37, 23, sprite}, FB_WIDTH - 15, FB_HEIGHT - 9);
+    jobs[count++] = drawjob_circle((Pointf){-5, FB_HEIGHT / 2.0}, 30, 0xC0406080);
+    jobs[count++] = drawjob_triangle((Pointf){-100, -100}, (Pointf){FB_WIDTH + 100, 20}, (Pointf){30, FB_HEIGHT + 200}, 0x80808000);
+    return count;
+}
+
+/* A grid of jobs that never overlap, the contract of draw_multiple_bounded and process_queue */
+static int build_disjoint(void)
+{
+    int count = 0;
+    for (int y = -10; y < FB_HEIGHT; y += 23)
+    {
+        for (int x = -7; x < FB_WIDTH; x += 29)
+        {
+            Recti area = {{x, y}, {x + 29, y + 23}};
+            Pointf a = {x, y};
+            switch (count % 4)
+            {
+            case 0:
+                jobs[count] = drawjob_solid(area, 0xFF000000 | next_random());
+                break;
+            case 1:
+                jobs[count] = drawjob_linear_gradient(area, a, 0xFF000000 | next_random(), (Pointf){a.x + 29, a.y + 23}, 0xFFFFFFFF);
+                break;
+            case 2:
+                jobs[count] = callback_job(count, area);
+                break;
+            default:
+                jobs[count] = create_bitmap_draw_job((Bitmap){37, 23, sprite}, x - 4, y);
+                jobs[count].area = area;
+                break;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+static int build_overlapping(void)
+{
+    for (int j = 0; j < 300; j++)
+        jobs[j] = random_job(j, 40);
+    return 300;
+}
+
+/* Disjoint opaque jobs with a few blended ones over them, which sends draw_multiple_bounded to the tile scheduler */
+static int build_disjoint_blended(void)
+{
+    int count = build_disjoint();
+    for (int j = 0; j < 12; j++, count++)
+    {
+        jobs[count] = drawjob_solid(random_area(20), color_premultiply(0x60000000 | (next_random() & 0xFFFFFF)));
+        jobs[count].blend = BLEND_SRC_OVER;
+    }
+    return count;
+}
+
+/* Stacks of opaque panels, so occlusion culling skips most of what is under them */
+static int build_occluded(void)
+{
+    jobs[0] = callback_job(0, (Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}});
+    for (int j = 1; j < 200; j++)
+    {
+        Recti area = random_area(10);
+        area.bottom_right.x += 30;
+        jobs[j] = j % 3 ? drawjob_solid(area, 0xFF000000 | next_random()) : callback_job(j, area);
+        if (j % 17 == 0)
+        {
+            jobs[j] = drawjob_solid(area, color_premultiply(0x70FFFFFF & next_random()));
+            jobs[j].blend = BLEND_SRC_OVER;
+        }
+    }
+    return 200;
+}
+
+/* Cacheable jobs, drawn over two frames so the second copies them from the cache */
+static int build_cached(void)
+{
+    for (int j = 0; j < 60; j++)
+    {
+        jobs[j] = random_job(j, 20);
+        jobs[j].cacheable = j % 2 == 0;
+    }
+    return 60;
+}
+
+static int build_points(void)
+{
+    for (int p = 0; p < MAX_POINTS; p++)
+    {
+        // Clustered so many points land on the same pixels, some outside the framebuffer
+        int x = random_int(-5, FB_WIDTH + 4) / 2 * 2, y = random_int(-5, FB_HEIGHT + 4) / 3 * 3;
+        points[p] = (PlotPoint){x, y, color_premultiply(next_random())};
+    }
+    return MAX_POINTS;
+}
+
+/* One point per pixel at most, since which of several replacing plots wins is unspecified */
+static int build_unique_points(void)
+{
+    int count = 0;
+    for (int y = -2; y < FB_HEIGHT + 2; y += 2)
+        for (int x = -3 + y % 3; x < FB_WIDTH + 3; x += 3)
+            points[count++] = (PlotPoint){x, y, 0xFF000000 | next_random()};
+    return count;
+}
+
+static const Scenario scenarios[] = {
+    {"draw_callback", CALL_DRAW, build_draw_callback, 0, 1},
+    {"draw_span_blend", CALL_DRAW, build_draw_span, 0, 1},
+    {"draw_bounded_clamping", CALL_DRAW_BOUNDED, build_clamping, 0, 1},
+    {"draw_bounded_overlapping", CALL_DRAW_BOUNDED, build_overlapping, 0, 1},
+    {"multiple_disjoint", CALL_MULTIPLE, build_disjoint, 0, 1},
+    {"multiple_blended", CALL_MULTIPLE, build_disjoint_blended, 0, 1},
+    {"multiple_safe_overlapping", CALL_MULTIPLE_SAFE, build_overlapping, 0, 1},
+    {"multiple_safe_clamping", CALL_MULTIPLE_SAFE, build_clamping, 0, 1},
+    {"multiple_safe_occluded", CALL_MULTIPLE_SAFE, build_occluded, 0, 1},
+    {"multiple_safe_cached", CALL_MULTIPLE_SAFE, build_cached, 0, 2},
+    {"queue_disjoint", CALL_QUEUE, build_disjoint, 0, 1},
+    {"queue_safe_overlapping", CALL_QUEUE_SAFE, build_overlapping, 0, 1},
+    {"queue_safe_occluded", CALL_QUEUE_SAFE, build_occluded, 0, 2},
+    {"plot_replace", CALL_PLOT, build_unique_points, PLOT_REPLACE, 1},
+    {"plot_add", CALL_PLOT, build_points, PLOT_ADD, 1},
+    {"plot_max", CALL_PLOT, build_points, PLOT_MAX, 1},
+    {"plot_min", CALL_PLOT, build_points, PLOT_MIN, 1},
+};
+
+#define SCENARIO_COUNT ((int)(sizeof(scenarios) / sizeof(scenarios[0])))
+
+/* The image every configuration must give: one job or point after another, on one thread, without any scheduling */
+static void draw_reference(const Scenario *scenario, int count)
+{
+    for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+        reference[p] = 0;
+
+    for (int frame = 0; frame < scenario->frames; frame++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (scenario->call == CALL_PLOT)
+            {
+                if (points[i].x >= 0 && points[i].y >= 0 && points[i].x < FB_WIDTH && points[i].y < FB_HEIGHT)
+                {
+                    uint32_t *pixel = &reference[points[i].y * FB_WIDTH + points[i].x];
+                    *pixel = plot_combine(*pixel, points[i].color, scenario->op);
+                }
+                continue;
+            }
+
+            Recti area = scenario->call == CALL_DRAW ? (Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}} : recti_clamp(jobs[i].area, FB_WIDTH, FB_HEIGHT);
+            if (!recti_is_empty(area))
+                drawjob_draw_area(&jobs[i], area, &reference[area.top_left.y * FB_WIDTH + area.top_left.x], FB_WIDTH);
+        }
+    }
+}
+
+static void draw_scenario(Framebuffer *fb, const Scenario *scenario, int count)
+{
+    for (int frame = 0; frame < scenario->frames; frame++)
+    {
+        switch (scenario->call)
+        {
+        case CALL_DRAW:
+            for (int j = 0; j < count; j++)
+                draw(fb, jobs[j]);
+            break;
+        case CALL_DRAW_BOUNDED:
+            for (int j = 0; j < count; j++)
+                draw_bounded(fb, jobs[j]);
+            break;
+        case CALL_MULTIPLE:
+            draw_multiple_bounded(fb, jobs, count);
+            break;
+        case CALL_MULTIPLE_SAFE:
+            draw_multiple_bounded_safe(fb, jobs, count);
+            break;
+        case CALL_QUEUE:
+        case CALL_QUEUE_SAFE:
+            // Callback jobs get a copy of their userdata in the queue's arena
+            for (int j = 0; j < count; j++)
+            {
+                if (jobs[j].userdata)
+                    enqueue_draw_job_with_data(fb, jobs[j], jobs[j].userdata, sizeof(CallbackData));
+                else
+                    enqueue_draw_job(fb, jobs[j]);
+            }
+            if (scenario->call == CALL_QUEUE)
+                process_queue(fb);
+            else
+                process_queue_safe(fb);
+            break;
+        case CALL_PLOT:
+            plot_pixels(fb, points, count, scenario->op);
+            break;
+        }
+    }
+}
+
+static uint64_t hash_pixels(const uint32_t *pixels)
+{
+    // FNV-1a over the bytes of every pixel, lowest byte first whatever the host's byte order
+    uint64_t hash = 14695981039346656037ull;
+    for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+        for (int shift = 0; shift < 32; shift += 8)
+            hash = (hash ^ ((pixels[p] >> shift) & 0xFF)) * 1099511628211ull;
+    return hash;
+}
+
+/* Writes the actual and expected images and a diff of them: matching pixels dimmed, mismatches red */
+static void dump_images(const char *scenario, const char *config, const uint32_t *actual)
+{
+    char path[256];
+    for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+        diff[p] = actual[p] == reference[p] ? 0xFF000000 | (reference[p] >> 2 & 0x3F3F3F) : 0xFFFF0000;
+
+    snprintf(path, sizeof(path), "test/build/golden-%s-%s-actual.png", scenario, config);
+    png_write(path, actual, FB_WIDTH, FB_HEIGHT, FB_WIDTH);
+    snprintf(path, sizeof(path), "test/build/golden-%s-expected.png", scenario);
+    png_write(path, reference, FB_WIDTH, FB_HEIGHT, FB_WIDTH);
+    snprintf(path, sizeof(path), "test/build/golden-%s-%s-diff.png", scenario, config);
+    png_write(path, diff, FB_WIDTH, FB_HEIGHT, FB_WIDTH);
+}
+
+static int build_configs(Config *configs, int max_threads)
+{
+    int count = 0;
+    for (int threads = 1; threads <= max_threads; threads++)
+    {
+        if (GOLDEN_OPENMP)
+        {
+            configs[count] = (Config){.threads = threads, .cache = 1};
+            snprintf(configs[count++].name, sizeof(configs[0].name), "omp%d", threads);
+        }
+        configs[count] = (Config){.threads = threads, .use_pool = 1, .cache = 1};
+        snprintf(configs[count++].name, sizeof(configs[0].name), "pool%d", threads);
+    }
+
+    // Scheduling variants at the most threads, where they can race
+    const Config variants[] = {
+        {"tiles_static", max_threads, !GOLDEN_OPENMP, {TRAVERSAL_TILES, TRAVERSAL_STATIC, 0}, 0, 1},
+        {"morton_guided", max_threads, !GOLDEN_OPENMP, {TRAVERSAL_MORTON, TRAVERSAL_GUIDED, 16}, 0, 1},
+        {"rows_static", max_threads, 1, {TRAVERSAL_ROWS, TRAVERSAL_STATIC, 3}, 0, 1},
+        {"culling", max_threads, !GOLDEN_OPENMP, {0}, 1, 1},
+        {"culling_pool", max_threads, 1, {0}, 1, 1},
+        {"no_cache", max_threads, !GOLDEN_OPENMP, {0}, 0, 0},
+    };
+    for (int v = 0; v < (int)(sizeof(variants) / sizeof(variants[0])); v++)
+        configs[count++] = variants[v];
+    return count;
+}
+
+static int read_hashes(const char *path, char names[][64], uint64_t *hashes)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    int count = 0;
+    if (!file)
+        return 0;
+
+    while (count < MAX_SCENARIOS && fgets(line, sizeof(line), file))
+    {
+        unsigned long long hash;
+        if (line[0] != '#' && sscanf(line, "%63s %llx", names[count], &hash) == 2)
+            hashes[count++] = hash;
+    }
+    fclose(file);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    const char *hash_path = HASH_FILE;
+    int update = 0;
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "--update") == 0)
+            update = 1;
+        else
+            hash_path = argv[a];
+    }
+
+    static char golden_names[MAX_SCENARIOS][64];
+    static uint64_t golden_hashes[MAX_SCENARIOS];
+    uint64_t hashes[SCENARIO_COUNT];
+    int golden_count = read_hashes(hash_path, golden_names, golden_hashes);
+
+    int procs = omp_get_num_procs();
+    int max_threads = procs < 4 ? 4 : procs > 16 ? 16 : procs;
+    Config configs[MAX_CONFIGS];
+    int config_count = build_configs(configs, max_threads);
+    WorkerPool pools[17];
+    for (int t = 1; t <= max_threads; t++)
+    {
+        if (worker_pool_init(&pools[t], &(WorkerPoolConfig){.thread_count = t}) != 0)
+        {
+            printf("FAILED: worker pool of %d threads\n", t);
+            return 1;
+        }
+    }
+
+    random_state = 0x9E3779B9;
+    for (int i = 0; i < 37 * 23; i++)
+        sprite[i] = 0xFF000000 | next_random();
+
+    int failures = 0;
+    for (int s = 0; s < SCENARIO_COUNT; s++)
+    {
+        const Scenario *scenario = &scenarios[s];
+        random_state = 0x12345u + (uint32_t)s * 7919u;
+        int count = scenario->build();
+        draw_reference(scenario, count);
+        hashes[s] = hash_pixels(reference);
+
+        int golden = -1;
+        for (int g = 0; g < golden_count; g++)
+            if (strcmp(golden_names[g], scenario->name) == 0)
+                golden = g;
+        if (!update && (golden < 0 || golden_hashes[golden] != hashes[s]))
+        {
+            printf("FAIL %s: reference hash %016llx, golden %s\n", scenario->name, (unsigned long long)hashes[s],
+                   golden < 0 ? "missing" : "differs");
+            // No image of the golden is kept, only its hash, so there is nothing to diff against
+            char path[256];
+            snprintf(path, sizeof(path), "test/build/golden-%s-reference.png", scenario->name);
+            png_write(path, reference, FB_WIDTH, FB_HEIGHT, FB_WIDTH);
+            failures++;
+        }
+
+        int mismatched = 0;
+        for (int c = 0; c < config_count; c++)
+        {
+            const Config *config = &configs[c];
+            Framebuffer fb;
+            if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) != 0)
+                return 1;
+            fb.pool = config->use_pool ? &pools[config->threads] : NULL;
+            fb.traversal = config->traversal;
+            fb.occlusion_culling = config->culling;
+            if (!config->cache)
+                job_cache_set_budget(&fb.job_cache, 0);
+            omp_set_num_threads(config->threads);
+
+            draw_scenario(&fb, scenario, count);
+
+            int wrong = 0;
+            for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+                wrong += fb.pixels[p] != reference[p];
+            if (wrong)
+            {
+                printf("FAIL %s with %s: %d pixels differ from the reference\n", scenario->name, config->name, wrong);
+                dump_images(scenario->name, config->name, fb.pixels);
+                mismatched++;
+            }
+            framebuffer_destroy(&fb);
+        }
+        failures += mismatched;
+        if (!mismatched)
+            printf("  %-28s %016llx  %d configurations\n", scenario->name, (unsigned long long)hashes[s], config_count);
+    }
+
+    for (int t = 1; t <= max_threads; t++)
+        worker_pool_shutdown(&pools[t]);
+
+    if (update)
+    {
+        FILE *file = fopen(hash_path, "w");
+        if (!file)
+        {
+            printf("FAILED: can't write %s\n", hash_path);
+            return 1;
+        }
+        fprintf(file, "# Hashes of the reference images of test/src/golden.c. Regenerate with: make check-update\n");
+        for (int s = 0; s < SCENARIO_COUNT; s++)
+            fprintf(file, "%s %016llx\n", scenarios[s].name, (unsigned long long)hashes[s]);
+        fclose(file);
+        printf("wrote %s\n", hash_path);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,163 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the job cache: cached jobs draw the same pixels without calling their callbacks again,
+ * and versions, invalidation and the memory budget work as documented.
+ */
+
+#define FB_WIDTH 200
+#define FB_HEIGHT 150
+
+static int calls;
+
+static uint32_t counting_callback(int x, int y, void *userdata)
+{
+    __atomic_fetch_add(&calls, 1, __ATOMIC_RELAXED);
+    return 0xFF000000 | (uint32_t)(x * 31 + y * 17) * (uint32_t)(uintptr_t)userdata;
+}
+
+static void counting_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+        *dst++ = counting_callback(x, y, userdata);
+}
+
+/*
+ * Draws the jobs through the queue into `fb` and into `reference` without caching, and compares the pixels.
+ */
+static int draw_and_compare(const char *name, Framebuffer *fb, Framebuffer *reference, DrawJob *jobs, int job_count)
+{
+    for (int j = 0; j < job_count; j++)
+    {
+        enqueue_draw_job(fb, jobs[j]);
+        DrawJob uncached = jobs[j];
+        uncached.cacheable = 0;
+        enqueue_draw_job(reference, uncached);
+    }
+
+    process_queue_safe(reference);
+    calls = 0;
+    process_queue_safe(fb);
+
+    if (memcmp(fb->pixels, reference->pixels, sizeof(uint32_t) * FB_WIDTH * FB_HEIGHT))
+    {
+        printf("FAIL %s: cached pixels differ\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+static int expect_calls(const char *name, int expected)
+{
+    if (calls != expected)
+    {
+        printf("FAIL %s: %d callback calls, expected %d\n", name, calls, expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    Framebuffer fb, reference;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) || framebuffer_init(&reference, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    DrawJob panel = {.area = {{10, 10}, {110, 60}}, .callback = counting_callback, .userdata = (void *)3, .cacheable = 1};
+    DrawJob glass = drawjob_solid((Recti){{50, 40}, {150, 140}}, color_premultiply(0x80FF8000));
+    glass.blend = BLEND_SRC_OVER;
+    glass.cacheable = 1;
+    DrawJob jobs[] = {panel, glass};
+
+    /* First frame draws into the cache, the second only copies */
+    failures += draw_and_compare("first frame", &fb, &reference, jobs, 2);
+    failures += expect_calls("first frame", 100 * 50);
+    failures += draw_and_compare("second frame", &fb, &reference, jobs, 2);
+    failures += expect_calls("second frame", 0);
+
+    /* A new version or position is a different job */
+    jobs[0].version++;
+    failures += draw_and_compare("new version", &fb, &reference, jobs, 2);
+    failures += expect_calls("new version", 100 * 50);
+    jobs[0].area = (Recti){{-20, 120}, {80, 170}};
+    failures += draw_and_compare("moved", &fb, &reference, jobs, 2);
+    failures += expect_calls("moved", 100 * 50 - 20 * 50 - 100 * 20 + 20 * 20);
+
+    job_cache_invalidate(&fb.job_cache, &panel);
+    failures += draw_and_compare("invalidated", &fb, &reference, jobs, 2);
+    failures += expect_calls("invalidated", 80 * 30);
+
+    /* Span callbacks may leave pixels unwritten, so they are never cached */
+    DrawJob span = {.area = {{0, 0}, {10, 10}}, .span_callback = counting_span, .userdata = (void *)5, .cacheable = 1};
+    uint64_t uncacheable = fb.job_cache.stats.uncacheable;
+    failures += draw_and_compare("span callback", &fb, &reference, &span, 1);
+    failures += draw_and_compare("span callback again", &fb, &reference, &span, 1);
+    failures += expect_calls("span callback", 100);
+    if (fb.job_cache.stats.uncacheable != uncacheable + 2)
+    {
+        printf("FAIL span callback: counted as cacheable\n");
+        failures++;
+    }
+
+    /* A blended job sends process_queue to the tile scheduler, which must not replay the cached jobs a second time */
+    DrawJob mixed[] = {span, glass};
+    JobCacheStats before = fb.job_cache.stats;
+    for (int j = 0; j < 2; j++)
+    {
+        enqueue_draw_job(&fb, mixed[j]);
+        DrawJob uncached = mixed[j];
+        uncached.cacheable = 0;
+        enqueue_draw_job(&reference, uncached);
+    }
+    process_queue(&reference);
+    process_queue(&fb);
+    if (memcmp(fb.pixels, reference.pixels, sizeof(uint32_t) * FB_WIDTH * FB_HEIGHT))
+    {
+        printf("FAIL blended fallback: cached pixels differ\n");
+        failures++;
+    }
+    if (fb.job_cache.stats.uncacheable != before.uncacheable + 1 || fb.job_cache.stats.hits != before.hits + 1 ||
+        fb.job_cache.stats.misses != before.misses)
+    {
+        printf("FAIL blended fallback: %llu uncacheable, %llu hits, %llu misses, expected 1, 1 and 0\n",
+               (unsigned long long)(fb.job_cache.stats.uncacheable - before.uncacheable),
+               (unsigned long long)(fb.job_cache.stats.hits - before.hits),
+               (unsigned long long)(fb.job_cache.stats.misses - before.misses));
+        failures++;
+    }
+
+    /* With room for two panels, the least recently used one is evicted */
+    job_cache_clear(&fb.job_cache);
+    job_cache_set_budget(&fb.job_cache, 2 * 100 * 50 * sizeof(uint32_t));
+    DrawJob panels[3];
+    for (int i = 0; i < 3; i++)
+    {
+        panels[i] = panel;
+        panels[i].userdata = (void *)(uintptr_t)(7 + i);
+    }
+    failures += draw_and_compare("panel 0", &fb, &reference, &panels[0], 1);
+    failures += draw_and_compare("panel 1", &fb, &reference, &panels[1], 1);
+    failures += draw_and_compare("panel 0 again", &fb, &reference, &panels[0], 1);
+    failures += expect_calls("panel 0 again", 0);
+    failures += draw_and_compare("panel 2", &fb, &reference, &panels[2], 1);
+    failures += draw_and_compare("panel 1 again", &fb, &reference, &panels[1], 1);
+    failures += expect_calls("evicted panel 1", 100 * 50);
+    if (fb.job_cache.bytes > fb.job_cache.budget || fb.job_cache.stats.evictions < 2)
+    {
+        printf("FAIL budget: %zu bytes cached, %llu evictions\n", fb.job_cache.bytes, (unsigned long long)fb.job_cache.stats.evictions);
+        failures++;
+    }
+
+    /* Jobs of one batch are never evicted for each other, the ones that don't fit are drawn directly */
+    failures += draw_and_compare("over budget", &fb, &reference, panels, 3);
+
+    framebuffer_destroy(&fb);
+    framebuffer_destroy(&reference);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -9,28 +9,30 @@ static uint32_t rgb(uint8_t r, uint8_t g, uint8_t b)
 }
 
 /*
- * Callback used by draw() to fill entire screen with a gradient.
+ * Span callback used by draw() to fill entire screen with a gradient, one row at a time.
  */
-static uint32_t gradient_callback(int x, int y, void *_)
+static void gradient_span(int y, int x0, int x1, uint32_t *dst, void *_)
 {
-    float fx = (float)x / (float)WIDTH;
-    float fy = (float)y / (float)HEIGHT;
-
-    uint8_t r = (uint8_t)(fx * 255.0f);
-    uint8_t g = (uint8_t)(fy * 255.0f);
+    uint8_t g = (uint8_t)((float)y / (float)HEIGHT * 255.0f);
     uint8_t b = 128;
 
-    return rgb(r, g, b);
+    for (int x = x0; x < x1; x++)
+    {
+        uint8_t r = (uint8_t)((float)x / (float)WIDTH * 255.0f);
+        *dst++ = rgb(r, g, b);
+    }
 }
 
 /*
- * Callback for a solid color, used in bounded draws and jobs.
+ * Span callback for a solid color, used in bounded draws and jobs.
  */
-static uint32_t solid_blue(int x, int y, void *_)
+static void solid_blue_span(int y, int x0, int x1, uint32_t *dst, void *_)
 {
-    (void)x;
     (void)y;
-    return rgb(0, 0, 255);
+    uint32_t color = rgb(0, 0, 255);
+
+    for (int x = x0; x < x1; x++)
+        *dst++ = color;
 }
 
 int main(int argc, char *argv[])
@@ -43,7 +45,16 @@ int main(int argc, char *argv[])
     Rectf square = {.top_left = {.x = 10, .y = 10}, .bottom_right = {.x = 100, .y = 100}};
     double velocity[] = {120, 200};
 
-    DrawJob square_job = {.area = Rectf_to_i(square), .callback = solid_blue};
+    // Both span callbacks write every pixel, so they may hide what is under them
+    DrawJob square_job = {.area = Rectf_to_i(square), .span_callback = solid_blue_span, .opaque = 1};
+    DrawJob background_job = {.span_callback = gradient_span, .opaque = 1};
+
+    // Draw background once. Afterwards only the area the square left is redrawn,
+    // so update() only uploads the areas around the square
+    draw(&ctx.framebuffer, background_job);
+
+    // The restored background is only culled where the square covers it when both are in the same batch
+    ctx.framebuffer.occlusion_culling = 1;
 
     // Basic event loop
     SDL_Event e;
@@ -72,6 +83,8 @@ int main(int argc, char *argv[])
             frame_count = 0;
             last_fps_time = now;
             printf("DT: %.10f\n", dt);
+            printf("Uploaded: %llu bytes last frame\n", (unsigned long long)ctx.upload_stats.bytes_last_frame);
+            printf("Culled: %llu pixels\n", (unsigned long long)ctx.framebuffer.occlusion_stats.pixels_culled);
         }
 
         dt = (now - last_frame_time) / 1000.0f;
@@ -95,14 +108,13 @@ int main(int argc, char *argv[])
         else if (square.top_left.y <= 0 && velocity[1] < 0)
             velocity[1] = -velocity[1];
 
-        square_job.area = Rectf_to_i(square);
-
-        // Draw background
-        draw((DrawJob){.callback = gradient_callback});
+        // Restore background where the square was, then draw the square over it
+        background_job.area = square_job.area;
+        enqueue_draw_job(&ctx.framebuffer, background_job);
 
-        // Draw square
-        enqueue_draw_job(square_job);
-        process_queue();
+        square_job.area = Rectf_to_i(square);
+        enqueue_draw_job(&ctx.framebuffer, square_job);
+        process_queue_safe(&ctx.framebuffer);
 
         update(&ctx);
     }
@@ -0,0 +1,156 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check that occlusion culling never changes the image, and that it skips what it should.
+ */
+
+#define FB_WIDTH 333
+#define FB_HEIGHT 211
+#define JOB_COUNT 300
+
+static uint32_t sprite_pixels[50 * 40];
+
+static uint32_t xor_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (uint32_t)(x ^ y) * 2654435761u;
+}
+
+/* Leaves every other pixel unwritten, so it must never hide the jobs under it */
+static void stripes_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+        if ((x + y) & 1)
+            dst[x - x0] = (uint32_t)(uintptr_t)userdata;
+}
+
+/* Writes every pixel, so with `opaque` set it hides the jobs under it */
+static void xor_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+        dst[x - x0] = xor_callback(x, y, userdata);
+}
+
+static Recti random_area(void)
+{
+    int x = rand() % (FB_WIDTH + 40) - 20;
+    int y = rand() % (FB_HEIGHT + 40) - 20;
+    int w = 1 + rand() % (rand() % 4 ? 60 : FB_WIDTH);
+    int h = 1 + rand() % (rand() % 4 ? 60 : FB_HEIGHT);
+    return (Recti){{x, y}, {x + w, y + h}};
+}
+
+static DrawJob random_job(void)
+{
+    Recti area = random_area();
+    DrawJob job;
+
+    switch (rand() % 7)
+    {
+    case 0:
+        job = drawjob_solid(area, 0xFF000000 | (uint32_t)rand());
+        break;
+    case 1:
+        job = drawjob_linear_gradient(area, (Pointf){0, 0}, 0xFFFF0000, (Pointf){FB_WIDTH, FB_HEIGHT}, 0xFF0000FF);
+        break;
+    case 2:
+    {
+        Bitmap sprite = {50, 40, sprite_pixels};
+        job = create_bitmap_draw_job(sprite, area.top_left.x, area.top_left.y);
+        /* Sometimes larger than the bitmap, which leaves pixels unwritten */
+        job.area.bottom_right.x += rand() % 2 * 10;
+        break;
+    }
+    case 3:
+        job = (DrawJob){.area = area, .callback = xor_callback};
+        break;
+    case 4:
+        job = (DrawJob){.area = area, .span_callback = stripes_span, .userdata = (void *)(uintptr_t)(0xFF000000 | (uint32_t)rand())};
+        break;
+    case 5:
+        job = (DrawJob){.area = area, .span_callback = xor_span, .opaque = 1};
+        break;
+    default:
+        job = drawjob_solid(area, color_premultiply(0x80000000 | (uint32_t)rand()));
+        job.blend = BLEND_SRC_OVER;
+        break;
+    }
+
+    if (rand() % 8 == 0)
+        job = drawjob_rotate_around_point(job, 0.3, (Pointf){area.top_left.x, area.top_left.y});
+    return job;
+}
+
+int main(void)
+{
+    Framebuffer plain, culled;
+    static DrawJob jobs[JOB_COUNT];
+    int failures = 0;
+
+    for (int i = 0; i < 50 * 40; i++)
+        sprite_pixels[i] = 0xFF000000 | (uint32_t)i * 40503u;
+
+    if (framebuffer_init(&plain, FB_WIDTH, FB_HEIGHT) || framebuffer_init(&culled, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+    culled.occlusion_culling = 1;
+
+    for (int round = 0; round < 40 && !failures; round++)
+    {
+        for (int j = 0; j < JOB_COUNT; j++)
+            jobs[j] = random_job();
+
+        draw_multiple_bounded_safe(&plain, jobs, JOB_COUNT);
+        draw_multiple_bounded_safe(&culled, jobs, JOB_COUNT);
+
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+        {
+            if (plain.pixels[i] != culled.pixels[i])
+            {
+                printf("FAIL round %d: pixel (%d,%d) is %08x, expected %08x\n",
+                       round, i % FB_WIDTH, i / FB_WIDTH, culled.pixels[i], plain.pixels[i]);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    OcclusionStats *stats = &culled.occlusion_stats;
+    if (!failures && (stats->pixels_culled == 0 || stats->job_tiles_culled == 0))
+    {
+        printf("FAIL random jobs: nothing was culled\n");
+        failures++;
+    }
+
+    /* A full screen background under a full screen job is culled completely */
+    culled.occlusion_stats = (OcclusionStats){0};
+    jobs[0] = drawjob_solid((Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, 0xFF101010);
+    jobs[1] = drawjob_solid((Recti){{-5, -5}, {FB_WIDTH + 5, FB_HEIGHT + 5}}, 0xFF202020);
+    draw_multiple_bounded_safe(&culled, jobs, 2);
+    if (stats->pixels_culled != FB_WIDTH * FB_HEIGHT || stats->pixels_drawn != FB_WIDTH * FB_HEIGHT)
+    {
+        printf("FAIL background: culled %llu pixels, drew %llu\n",
+               (unsigned long long)stats->pixels_culled, (unsigned long long)stats->pixels_drawn);
+        failures++;
+    }
+
+    /* Span callbacks only hide what is under them when they are marked opaque */
+    for (int opaque = 0; opaque <= 1; opaque++)
+    {
+        culled.occlusion_stats = (OcclusionStats){0};
+        jobs[1] = (DrawJob){.area = jobs[0].area, .span_callback = xor_span, .opaque = opaque};
+        draw_multiple_bounded_safe(&culled, jobs, 2);
+        if (stats->pixels_culled != (uint64_t)opaque * FB_WIDTH * FB_HEIGHT)
+        {
+            printf("FAIL span background (opaque %d): culled %llu pixels\n", opaque, (unsigned long long)stats->pixels_culled);
+            failures++;
+        }
+    }
+
+    framebuffer_destroy(&plain);
+    framebuffer_destroy(&culled);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,189 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of packed pixel formats: packing an unpacked pixel gives it back, and every draw path and plot function
+ * leaves a packed framebuffer holding exactly the pixels of an ARGB framebuffer converted after every job.
+ * The framebuffer is wider than the staging buffer of pixel_format_draw_area, so rows are drawn in several passes.
+ */
+
+#define FB_WIDTH 2300
+#define FB_HEIGHT 61
+#define JOBS 8
+#define PLOTS 5000
+
+static uint32_t argb[FB_WIDTH * FB_HEIGHT];
+static uint32_t packed_argb[FB_WIDTH * FB_HEIGHT];
+static uint32_t sprite[40 * 30];
+
+static uint32_t pixel_hash(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u));
+}
+
+// What storing a pixel in the format and reading it back gives
+static void convert(PixelFormat format, uint32_t *pixels, int count)
+{
+    const PixelFormatKernels *kernels = pixel_format_kernels(format);
+    uint8_t packed[4 * 64];
+    for (int i = 0; i < count; i += 64)
+    {
+        int n = count - i < 64 ? count - i : 64;
+        kernels->pack(packed, pixels + i, n);
+        kernels->unpack(pixels + i, packed, n);
+    }
+}
+
+static void make_jobs(DrawJob *jobs)
+{
+    jobs[0] = drawjob_linear_gradient((Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, (Pointf){0, 0}, 0xFF2040A0, (Pointf){FB_WIDTH, 40}, 0xFFE0C010);
+    jobs[1] = drawjob_solid((Recti){{2100, 5}, {2290, 50}}, 0xFF7F3F1F);
+    jobs[2] = create_bitmap_draw_job((Bitmap){40, 30, sprite}, 2030, 20);
+    jobs[3] = drawjob_shaded_triangle((Pointf){1990, 2}, 0xFFFF0000, (Pointf){2120, 58}, 0xFF00FF00, (Pointf){1900, 50}, 0xFF0000FF);
+    jobs[4] = drawjob_circle((Pointf){2060, 30}, 25, 0x80404000);
+    jobs[4].blend = BLEND_SRC_OVER;
+    jobs[5] = drawjob_rotate(create_bitmap_draw_job((Bitmap){40, 30, sprite}, 200, 10), 0.3);
+    jobs[6] = drawjob_solid((Recti){{1000, 10}, {2200, 40}}, 0x40202020);
+    jobs[6].blend = BLEND_ADD;
+    jobs[7] = (DrawJob){.area = {{500, 30}, {700, 61}}, .callback = pixel_hash};
+}
+
+static int compare(const Framebuffer *fb, const char *name)
+{
+    framebuffer_read_argb(fb, (Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, packed_argb, FB_WIDTH);
+    for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+    {
+        if (packed_argb[i] != argb[i])
+        {
+            printf("FAIL %s: pixel (%d,%d) is %08x instead of %08x\n", name, i % FB_WIDTH, i / FB_WIDTH, packed_argb[i], argb[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    const PixelFormat formats[] = {PIXEL_FORMAT_RGB565, PIXEL_FORMAT_RGB332};
+    const char *format_names[] = {"rgb565", "rgb332"};
+    DrawJob jobs[JOBS];
+    Framebuffer reference, fb;
+    int failures = 0;
+
+    srand(21);
+    for (int i = 0; i < 40 * 30; i++)
+        sprite[i] = 0xFF000000 | (uint32_t)rand();
+    make_jobs(jobs);
+
+    /* Packing an unpacked pixel gives it back, and white and black survive */
+    const PixelFormatKernels *rgb565 = pixel_format_kernels(PIXEL_FORMAT_RGB565);
+    const PixelFormatKernels *rgb332 = pixel_format_kernels(PIXEL_FORMAT_RGB332);
+    for (uint32_t p = 0; p < 65536; p++)
+    {
+        uint16_t in = (uint16_t)p, out;
+        uint8_t in8 = (uint8_t)p, out8;
+        uint32_t color;
+        rgb565->unpack(&color, &in, 1);
+        rgb565->pack(&out, &color, 1);
+        if (out != in)
+        {
+            printf("FAIL rgb565 %04x comes back as %04x\n", in, out);
+            failures++;
+            break;
+        }
+        rgb332->unpack(&color, &in8, 1);
+        rgb332->pack(&out8, &color, 1);
+        if (out8 != in8)
+        {
+            printf("FAIL rgb332 %02x comes back as %02x\n", in8, out8);
+            failures++;
+            break;
+        }
+    }
+    uint32_t extremes[2] = {0xFFFFFFFF, 0x00000000};
+    convert(PIXEL_FORMAT_RGB332, extremes, 2);
+    if (extremes[0] != 0xFFFFFFFF || extremes[1] != 0xFF000000)
+    {
+        printf("FAIL rgb332 white and black are %08x and %08x\n", extremes[0], extremes[1]);
+        failures++;
+    }
+
+    for (int f = 0; f < 2; f++)
+    {
+        PixelFormat format = formats[f];
+        char name[64];
+
+        /* The reference converts the whole framebuffer after every job, like storing every job's pixels */
+        framebuffer_init(&reference, FB_WIDTH, FB_HEIGHT);
+        convert(format, reference.pixels, FB_WIDTH * FB_HEIGHT);
+        for (int j = 0; j < JOBS; j++)
+        {
+            draw_bounded(&reference, jobs[j]);
+            convert(format, reference.pixels, FB_WIDTH * FB_HEIGHT);
+        }
+        memcpy(argb, reference.pixels, sizeof(argb));
+        framebuffer_destroy(&reference);
+
+        for (int path = 0; path < 4; path++)
+        {
+            const char *path_names[] = {"draw_bounded", "process_queue", "process_queue_safe", "occlusion culling"};
+            if (framebuffer_init_format(&fb, FB_WIDTH, FB_HEIGHT, format) != 0 || fb.pixels || !fb.packed_pixels)
+            {
+                printf("FAILED: framebuffer_init_format\n");
+                return 1;
+            }
+            fb.occlusion_culling = path == 3;
+            for (int j = 0; j < JOBS; j++)
+            {
+                if (path == 0)
+                    draw_bounded(&fb, jobs[j]);
+                else
+                    enqueue_draw_job(&fb, jobs[j]);
+            }
+            if (path == 1)
+                process_queue(&fb);
+            else if (path >= 2)
+                process_queue_safe(&fb);
+
+            snprintf(name, sizeof(name), "%s %s", format_names[f], path_names[path]);
+            failures += compare(&fb, name);
+            framebuffer_destroy(&fb);
+        }
+
+        /* Plots combine with the converted pixel and are converted again */
+        framebuffer_init(&reference, FB_WIDTH, FB_HEIGHT);
+        framebuffer_init_format(&fb, FB_WIDTH, FB_HEIGHT, format);
+        convert(format, reference.pixels, FB_WIDTH * FB_HEIGHT);
+        PlotPoint *points = malloc(PLOTS * sizeof(PlotPoint));
+        for (int i = 0; i < PLOTS; i++)
+            points[i] = (PlotPoint){rand() % 100, rand() % FB_HEIGHT, (uint32_t)rand() & 0x3F3F3F3F};
+        for (int i = 0; i < PLOTS; i++)
+        {
+            uint32_t *pixel = framebuffer_pixel(&reference, points[i].x, points[i].y);
+            *pixel = plot_combine(*pixel, points[i].color, PLOT_ADD);
+            convert(format, pixel, 1);
+        }
+        memcpy(argb, reference.pixels, sizeof(argb));
+        plot_pixels(&fb, points, PLOTS / 2, PLOT_ADD);
+        for (int i = PLOTS / 2; i < PLOTS; i++)
+            safe_plot_pixel(&fb, points[i].x, points[i].y, points[i].color, PLOT_ADD);
+        snprintf(name, sizeof(name), "%s plots", format_names[f]);
+        failures += compare(&fb, name);
+
+        /* Plain pixel stores */
+        draw_pixel(&fb, 3, 4, 0xFFFFFFFF);
+        safe_draw_pixel(&fb, 5, 6, 0xFFFFFFFF);
+        if (pixel_format_load(format, framebuffer_address(&fb, 3, 4)) != 0xFFFFFFFF ||
+            pixel_format_load(format, framebuffer_address(&fb, 5, 6)) != 0xFFFFFFFF)
+        {
+            printf("FAIL %s: draw_pixel and safe_draw_pixel\n", format_names[f]);
+            failures++;
+        }
+        free(points);
+        framebuffer_destroy(&fb);
+        framebuffer_destroy(&reference);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
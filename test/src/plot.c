@@ -0,0 +1,118 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of pixel plotting: batched plots match plotting one by one in order,
+ * and concurrent plots to the same pixels are never lost.
+ */
+
+#define FB_WIDTH 150
+#define FB_HEIGHT 130
+#define POINTS 20000
+#define THREADS 8
+
+static PlotPoint points[POINTS];
+
+int main(void)
+{
+    const char *op_names[] = {"replace", "src-over", "add", "multiply", "max", "min"};
+    static uint32_t expected[FB_WIDTH * FB_HEIGHT];
+    Framebuffer fb;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    /* The blending ops match the blend modes of jobs */
+    srand(3);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint32_t dst = (uint32_t)rand() * 2654435761u, color = (uint32_t)rand() * 40503u;
+        if (plot_combine(dst, color, PLOT_ADD) != blend_color(color, dst, BLEND_ADD) ||
+            plot_combine(dst, color, PLOT_SRC_OVER) != blend_color(color, dst, BLEND_SRC_OVER))
+        {
+            printf("FAIL plot_combine: %08x onto %08x differs from blend_color\n", color, dst);
+            failures++;
+            break;
+        }
+    }
+
+    /* Points fall on few pixels so most pixels are plotted several times, and some fall outside */
+    for (int i = 0; i < POINTS; i++)
+        points[i] = (PlotPoint){rand() % (FB_WIDTH + 20) - 10, rand() % (FB_HEIGHT + 20) - 10,
+                                color_premultiply((uint32_t)rand() * 2654435761u)};
+
+    for (int op = PLOT_REPLACE; op <= PLOT_MIN; op++)
+    {
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+            fb.pixels[i] = expected[i] = 0xFF000000 | (uint32_t)i * 40503u;
+
+        for (int i = 0; i < POINTS; i++)
+        {
+            if ((unsigned)points[i].x < FB_WIDTH && (unsigned)points[i].y < FB_HEIGHT)
+            {
+                uint32_t *pixel = &expected[points[i].y * FB_WIDTH + points[i].x];
+                *pixel = plot_combine(*pixel, points[i].color, (PlotOp)op);
+            }
+        }
+
+        framebuffer_clear_dirty(&fb);
+        plot_pixels(&fb, points, POINTS, (PlotOp)op);
+
+        if (memcmp(fb.pixels, expected, sizeof(expected)))
+        {
+            printf("FAIL plot_pixels %s: differs from plotting in order\n", op_names[op]);
+            failures++;
+        }
+        if (dirty_rects_pixels(framebuffer_dirty(&fb)) < FB_WIDTH * FB_HEIGHT)
+        {
+            printf("FAIL plot_pixels %s: plotted tiles not marked dirty\n", op_names[op]);
+            failures++;
+        }
+    }
+
+    /* Every thread adds 1 to the blue channel of the same pixels, none of the additions may be lost */
+    memset(fb.pixels, 0, sizeof(uint32_t) * FB_WIDTH * FB_HEIGHT);
+#pragma omp parallel num_threads(THREADS)
+    {
+        for (int round = 0; round < 30; round++)
+            for (int i = 0; i < 64; i++)
+                safe_plot_pixel(&fb, i % 8, i / 8, 0x00000001, PLOT_ADD);
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t pixel = fb.pixels[(i / 8) * FB_WIDTH + i % 8];
+        if (pixel != 30u * THREADS)
+        {
+            printf("FAIL safe_plot_pixel add: pixel %d is %08x, expected %08x\n", i, pixel, 30u * THREADS);
+            failures++;
+            break;
+        }
+    }
+
+    /* The largest and smallest channels win however the plots interleave */
+    for (int op = PLOT_MAX; op <= PLOT_MIN; op++)
+    {
+        for (int i = 0; i < 64; i++)
+            fb.pixels[i] = 0x80808080;
+#pragma omp parallel for num_threads(THREADS)
+        for (int i = 0; i < 64 * 256; i++)
+            safe_plot_pixel(&fb, i % 64, 0, (uint32_t)(i / 64) * 0x01010101u, (PlotOp)op);
+
+        for (int i = 0; i < 64; i++)
+        {
+            if (fb.pixels[i] != (op == PLOT_MAX ? 0xFFFFFFFFu : 0))
+            {
+                printf("FAIL safe_plot_pixel %s: pixel %d is %08x\n", op_names[op], i, fb.pixels[i]);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    framebuffer_destroy(&fb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
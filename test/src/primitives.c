@@ -0,0 +1,355 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the triangle, line and circle jobs: triangles match a brute force rasterizer, meshes have
+ * neither gaps nor overlaps, lines and circles cover what they should, and the tiled paths draw the same as direct drawing.
+ */
+
+#define FB_WIDTH 301
+#define FB_HEIGHT 203
+#define SENTINEL 0x12345678u
+#define JOB_COUNT 400
+
+/* Vertices on a 1/16 pixel grid keep the reference edge functions exact */
+static double random_coord(int limit)
+{
+    return (rand() % ((limit + 40) * 16)) / 16.0 - 20;
+}
+
+static Pointf random_point(void)
+{
+    return (Pointf){random_coord(FB_WIDTH), random_coord(FB_HEIGHT)};
+}
+
+static int channel_distance(uint32_t a, uint32_t b)
+{
+    int worst = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int d = abs((int)(a >> shift & 0xFF) - (int)(b >> shift & 0xFF));
+        worst = d > worst ? d : worst;
+    }
+    return worst;
+}
+
+/* Brute force rasterizer: the pixel is inside if every edge function at its center is positive, or 0 on a left or top edge */
+static int reference_triangle(const Pointf v[3], const uint32_t colors[3], int x, int y, uint32_t *color)
+{
+    double px = x + 0.5;
+    double py = y + 0.5;
+    double e[3];
+    double area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+    if (area == 0)
+        return 0;
+    double sign = area > 0 ? 1 : -1;
+
+    for (int i = 0; i < 3; i++)
+    {
+        Pointf p = v[(i + 1) % 3];
+        Pointf q = v[(i + 2) % 3];
+        double a = (p.y - q.y) * sign;
+        double b = (q.x - p.x) * sign;
+        e[i] = a * (px - p.x) + b * (py - p.y);
+        if (e[i] < 0 || (e[i] == 0 && !(a > 0 || (a == 0 && b > 0))))
+            return 0;
+    }
+
+    *color = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        double channel = 0;
+        for (int i = 0; i < 3; i++)
+            channel += e[i] * (colors[i] >> shift & 0xFF);
+        *color |= (uint32_t)lround(channel / (area * sign)) << shift;
+    }
+    return 1;
+}
+
+static int check_triangles(Framebuffer *fb)
+{
+    for (int round = 0; round < 300; round++)
+    {
+        Pointf v[3];
+        uint32_t colors[3];
+        for (int i = 0; i < 3; i++)
+        {
+            v[i] = random_point();
+            colors[i] = (uint32_t)rand() * 2654435761u;
+        }
+        /* Small triangles are the common case */
+        if (round % 2)
+            for (int i = 1; i < 3; i++)
+                v[i] = (Pointf){v[0].x + (rand() % 640) / 16.0 - 20, v[0].y + (rand() % 640) / 16.0 - 20};
+        if (round % 3 == 0)
+            colors[1] = colors[2] = colors[0];
+
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+            fb->pixels[i] = SENTINEL;
+        draw_bounded(fb, drawjob_shaded_triangle(v[0], colors[0], v[1], colors[1], v[2], colors[2]));
+
+        for (int y = 0; y < FB_HEIGHT; y++)
+            for (int x = 0; x < FB_WIDTH; x++)
+            {
+                uint32_t expected = SENTINEL;
+                int inside = reference_triangle(v, colors, x, y, &expected);
+                uint32_t actual = fb->pixels[y * FB_WIDTH + x];
+                if (inside ? channel_distance(actual, expected) > 1 : actual != SENTINEL)
+                {
+                    printf("FAIL triangle %d: pixel (%d,%d) is %08x, expected %08x\n", round, x, y, actual, expected);
+                    return 1;
+                }
+            }
+    }
+    return 0;
+}
+
+/* Jittered convex quads, split into triangles of both windings and added together, cover every pixel exactly once */
+static int check_mesh(Framebuffer *fb)
+{
+    enum
+    {
+        COLUMNS = 23,
+        ROWS = 15,
+        CELL = 11
+    };
+    static Pointf grid[ROWS + 1][COLUMNS + 1];
+
+    for (int y = 0; y <= ROWS; y++)
+        for (int x = 0; x <= COLUMNS; x++)
+        {
+            grid[y][x] = (Pointf){10 + x * CELL, 10 + y * CELL};
+            if (x > 0 && x < COLUMNS && y > 0 && y < ROWS)
+            {
+                grid[y][x].x += (rand() % 64) / 16.0 - 2;
+                grid[y][x].y += (rand() % 64) / 16.0 - 2;
+            }
+        }
+    /* Some vertices exactly on pixel centers, so edges run through them */
+    grid[3][3] = (Pointf){10.5 + 3 * CELL, 10.5 + 3 * CELL};
+    grid[3][4] = (Pointf){10.5 + 4 * CELL, 10.5 + 3 * CELL};
+    grid[4][3] = (Pointf){10.5 + 3 * CELL, 10.5 + 4 * CELL};
+
+    memset(fb->pixels, 0, (size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+    for (int y = 0; y < ROWS; y++)
+        for (int x = 0; x < COLUMNS; x++)
+        {
+            Pointf a = grid[y][x], b = grid[y][x + 1], c = grid[y + 1][x + 1], d = grid[y + 1][x];
+            DrawJob first, second;
+            if (rand() % 2)
+            {
+                first = drawjob_triangle(a, b, c, 1);
+                second = rand() % 2 ? drawjob_triangle(a, c, d, 1) : drawjob_triangle(a, d, c, 1);
+            }
+            else
+            {
+                first = drawjob_triangle(a, b, d, 1);
+                second = rand() % 2 ? drawjob_triangle(b, c, d, 1) : drawjob_triangle(b, d, c, 1);
+            }
+            first.blend = second.blend = BLEND_ADD;
+            enqueue_draw_job(fb, first);
+            enqueue_draw_job(fb, second);
+        }
+    process_queue_safe(fb);
+
+    for (int y = 0; y < FB_HEIGHT; y++)
+        for (int x = 0; x < FB_WIDTH; x++)
+        {
+            int inside = x >= 10 && x < 10 + COLUMNS * CELL && y >= 10 && y < 10 + ROWS * CELL;
+            if (fb->pixels[y * FB_WIDTH + x] != (uint32_t)inside)
+            {
+                printf("FAIL mesh: pixel (%d,%d) was drawn %u times\n", x, y, fb->pixels[y * FB_WIDTH + x]);
+                return 1;
+            }
+        }
+    return 0;
+}
+
+static int check_line_and_circles(Framebuffer *fb)
+{
+    int failures = 0;
+
+    /* A one pixel wide line along pixel centers covers exactly its row */
+    memset(fb->pixels, 0, (size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+    draw_bounded(fb, drawjob_line((Pointf){10.5, 20.5}, 0xFFFF0000, (Pointf){90.5, 20.5}, 0xFF0000FF, 1));
+    for (int x = 10; x <= 90; x++)
+        if ((fb->pixels[20 * FB_WIDTH + x] >> 24) != 0xFF || fb->pixels[19 * FB_WIDTH + x] || fb->pixels[21 * FB_WIDTH + x])
+        {
+            printf("FAIL line: column %d\n", x);
+            return 1;
+        }
+    if (fb->pixels[20 * FB_WIDTH + 10] != 0xFFFF0000 || fb->pixels[20 * FB_WIDTH + 90] != 0xFF0000FF ||
+        channel_distance(fb->pixels[20 * FB_WIDTH + 50], 0xFF800080) > 1)
+    {
+        printf("FAIL line colors: %08x %08x %08x\n", fb->pixels[20 * FB_WIDTH + 10], fb->pixels[20 * FB_WIDTH + 50],
+               fb->pixels[20 * FB_WIDTH + 90]);
+        failures++;
+    }
+
+    /* Anti-aliased edges: coverage summed over the pixels is the area of the shape */
+    struct
+    {
+        DrawJob job;
+        double area;
+    } shapes[] = {
+        {drawjob_circle((Pointf){100.3, 100.7}, 40, 0xFFFFFFFF), M_PI * 40 * 40},
+        {drawjob_ring((Pointf){150, 90.25}, 50, 6, 0xFFFFFFFF), M_PI * (50 * 50 - 44 * 44)},
+        {drawjob_line((Pointf){20.2, 30.9}, 0xFFFFFFFF, (Pointf){250.7, 180.1}, 0xFFFFFFFF, 5),
+         5 * hypot(230.5, 149.2) + M_PI * 2.5 * 2.5}};
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+    {
+        memset(fb->pixels, 0, (size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+        draw_bounded(fb, shapes[i].job);
+
+        double covered = 0;
+        for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+            covered += (fb->pixels[p] >> 24) / 255.0;
+        if (fabs(covered - shapes[i].area) > shapes[i].area * 0.01)
+        {
+            printf("FAIL shape %zu: covers %.1f pixels, expected %.1f\n", i, covered, shapes[i].area);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static DrawJob random_primitive(void)
+{
+    uint32_t color = 0xFF000000 | (uint32_t)rand();
+    Pointf at = random_point();
+    DrawJob job;
+
+    switch (rand() % 4)
+    {
+    case 0:
+        job = drawjob_triangle(at, random_point(), random_point(), color);
+        break;
+    case 1:
+        // Large enough to cross tile borders, where rows are split into spans
+        job = drawjob_shaded_triangle(at, color, (Pointf){at.x + rand() % 240 - 120, at.y + rand() % 240 - 120}, ~color,
+                                      (Pointf){at.x + rand() % 240 - 120, at.y + rand() % 240 - 120}, color ^ 0x00FF00);
+        break;
+    case 2:
+        job = drawjob_line(at, color, random_point(), color_premultiply(color & 0x80FFFFFF), 0.5 + rand() % 60 / 10.0);
+        break;
+    default:
+        job = rand() % 2 ? drawjob_circle(at, rand() % 500 / 10.0, color)
+                         : drawjob_ring(at, rand() % 500 / 10.0, rand() % 100 / 10.0, color_premultiply(color & 0xA0FFFFFF));
+        break;
+    }
+
+    if (rand() % 5 == 0)
+        job.blend = BLEND_SRC_OVER;
+    if (rand() % 10 == 0)
+        job = drawjob_rotate_around_point(job, 0.4, at);
+    return job;
+}
+
+/*
+ * Transformed primitives against an independent reference. A quarter turn around a pixel corner maps pixel centers onto
+ * pixel centers, so the rotated job draws exactly the triangle of the rotated vertices. Vertices offset by different
+ * irrational amounts in x and y keep edges off pixel centers, where the rotation changes which edges win ties. The pixels the triangle misses must keep the
+ * background, through both the direct and the tiled path.
+ */
+static int check_rotated(Framebuffer *direct, Framebuffer *tiled)
+{
+    for (int round = 0; round < 100; round++)
+    {
+        Pointf v[3], rotated[3];
+        Pointf center = {rand() % FB_WIDTH, rand() % FB_HEIGHT};
+        for (int i = 0; i < 3; i++)
+        {
+            v[i] = (Pointf){center.x + (rand() % 1600 - 800) / 13.0 + M_SQRT2 / 10, center.y + (rand() % 1600 - 800) / 13.0 + sqrt(3) / 10};
+            rotated[i] = (Pointf){center.x - (v[i].y - center.y), center.y + (v[i].x - center.x)};
+        }
+        uint32_t color = 0xFF000000 | (uint32_t)rand();
+        uint32_t colors[3] = {color, color, color};
+        DrawJob job = drawjob_rotate_around_point(drawjob_triangle(v[0], v[1], v[2], color), M_PI / 2, center);
+
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+            direct->pixels[i] = tiled->pixels[i] = SENTINEL;
+        draw_bounded(direct, job);
+        enqueue_draw_job(tiled, job);
+        process_queue_safe(tiled);
+
+        for (int y = 0; y < FB_HEIGHT; y++)
+        {
+            for (int x = 0; x < FB_WIDTH; x++)
+            {
+                uint32_t expected = SENTINEL;
+                reference_triangle(rotated, colors, x, y, &expected);
+                uint32_t drawn = direct->pixels[y * FB_WIDTH + x], queued = tiled->pixels[y * FB_WIDTH + x];
+                if (drawn != expected || queued != expected)
+                {
+                    printf("FAIL rotated triangle %d: pixel (%d,%d) is %08x and %08x, expected %08x\n",
+                           round, x, y, drawn, queued, expected);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/* Tiles skip the parts of bounding boxes primitives miss, and culling uses the cells they cover. Neither may change the image */
+static int check_tiled(Framebuffer *direct, Framebuffer *tiled, Framebuffer *culled)
+{
+    static DrawJob jobs[JOB_COUNT];
+    culled->occlusion_culling = 1;
+
+    for (int round = 0; round < 20; round++)
+    {
+        for (int j = 0; j < JOB_COUNT; j++)
+        {
+            jobs[j] = random_primitive();
+            draw_bounded(direct, jobs[j]);
+            enqueue_draw_job(tiled, jobs[j]);
+            enqueue_draw_job(culled, jobs[j]);
+        }
+        process_queue_safe(tiled);
+        process_queue_safe(culled);
+
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+            if (direct->pixels[i] != tiled->pixels[i] || direct->pixels[i] != culled->pixels[i])
+            {
+                printf("FAIL tiled round %d: pixel (%d,%d) is %08x and %08x, expected %08x\n", round, i % FB_WIDTH,
+                       i / FB_WIDTH, tiled->pixels[i], culled->pixels[i], direct->pixels[i]);
+                return 1;
+            }
+    }
+
+    if (culled->occlusion_stats.pixels_culled == 0)
+    {
+        printf("FAIL tiled: primitives never hid anything\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    Framebuffer fb, tiled, culled;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) || framebuffer_init(&tiled, FB_WIDTH, FB_HEIGHT) ||
+        framebuffer_init(&culled, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    failures += check_triangles(&fb);
+    failures += check_mesh(&fb);
+    failures += check_line_and_circles(&fb);
+    failures += check_rotated(&fb, &tiled);
+
+    memset(fb.pixels, 0, (size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+    memset(tiled.pixels, 0, (size_t)FB_WIDTH * FB_HEIGHT * sizeof(uint32_t));
+    failures += check_tiled(&fb, &tiled, &culled);
+
+    framebuffer_destroy(&fb);
+    framebuffer_destroy(&tiled);
+    framebuffer_destroy(&culled);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Headless check of the profiler. The library is built without instrumentation by default,
+ * so this test compiles its own instrumented copy of it.
+ */
+#ifndef RENDERER_PROFILE
+#define RENDERER_PROFILE
+#endif
+#include "../../src/main.c"
+
+#define FB_WIDTH 300
+#define FB_HEIGHT 200
+
+static uint32_t xor_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (uint32_t)(x ^ y);
+}
+
+static int has_event(const ProfileFrame *frame, const char *name)
+{
+    for (int i = 0; i < frame->event_count; i++)
+        if (!strcmp(frame->events[i].name, name))
+            return 1;
+    return 0;
+}
+
+static uint64_t total_pixels(const ProfileFrame *frame)
+{
+    uint64_t pixels = 0;
+    for (int t = 0; t < frame->thread_count; t++)
+        pixels += frame->threads[t].pixels;
+    return pixels;
+}
+
+int main(void)
+{
+    Framebuffer fb;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    if (profile_frame(1))
+    {
+        printf("FAIL: a frame exists before the first one ended\n");
+        failures++;
+    }
+
+    /* One frame of queued jobs, partly outside the framebuffer */
+    for (int i = 0; i < 50; i++)
+        enqueue_draw_job(&fb, (DrawJob){.area = {{i * 7 - 20, i * 3}, {i * 7 + 30, i * 3 + 40}}, .callback = xor_callback});
+    process_queue_safe(&fb);
+    for (int i = 0; i < 10; i++)
+        draw_pixel(&fb, i, i, 0xFFFFFFFF);
+    profile_end_frame();
+
+    int64_t expected = 10;
+    for (int i = 0; i < 50; i++)
+    {
+        Recti area = recti_clamp((Recti){{i * 7 - 20, i * 3}, {i * 7 + 30, i * 3 + 40}}, FB_WIDTH, FB_HEIGHT);
+        if (!recti_is_empty(area))
+            expected += (int64_t)(area.bottom_right.x - area.top_left.x) * (area.bottom_right.y - area.top_left.y);
+    }
+
+    const ProfileFrame *frame = profile_frame(1);
+    if (!frame || frame->index != 0)
+    {
+        printf("FAIL: first frame not recorded\n");
+        return 1;
+    }
+    if (!has_event(frame, "process_queue_safe") || !has_event(frame, "draw_multiple_bounded_safe") || !has_event(frame, "run_tasks"))
+    {
+        printf("FAIL: missing events\n");
+        failures++;
+    }
+    if (total_pixels(frame) != (uint64_t)expected)
+    {
+        printf("FAIL: %llu pixels counted, expected %lld\n", (unsigned long long)total_pixels(frame), (long long)expected);
+        failures++;
+    }
+    if (frame->queue_high_water != 50)
+    {
+        printf("FAIL: queue high water %d, expected 50\n", frame->queue_high_water);
+        failures++;
+    }
+
+    /* Frames overflowing the event buffer keep counting what they drop */
+    for (int i = 0; i < PROFILE_MAX_EVENTS; i++)
+        draw_bounded(&fb, drawjob_solid((Recti){{0, 0}, {2, 2}}, 0xFF00FF00));
+    profile_end_frame();
+    frame = profile_frame(1);
+    if (frame->index != 1 || frame->event_count != PROFILE_MAX_EVENTS || frame->events_dropped != PROFILE_MAX_EVENTS ||
+        total_pixels(frame) != 4 * PROFILE_MAX_EVENTS || profile_frame(2)->index != 0)
+    {
+        printf("FAIL overflow: %d events, %d dropped, %llu pixels\n", frame->event_count, frame->events_dropped,
+               (unsigned long long)total_pixels(frame));
+        failures++;
+    }
+
+    /* Only the last PROFILE_FRAMES - 1 frames can be read */
+    for (int i = 0; i < PROFILE_FRAMES; i++)
+        profile_end_frame();
+    if (profile_frame(PROFILE_FRAMES) || !profile_frame(PROFILE_FRAMES - 1) || profile_frame(1)->index != PROFILE_FRAMES + 1)
+    {
+        printf("FAIL: ring of frames\n");
+        failures++;
+    }
+
+    const char *trace = "test/build/profile_trace.json";
+    if (profile_write_chrome_trace(trace, PROFILE_FRAMES - 1))
+    {
+        printf("FAIL: trace not written\n");
+        failures++;
+    }
+    remove(trace);
+
+    framebuffer_destroy(&fb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,146 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless stress test of the lock free draw queue: several threads enqueue jobs with
+ * arena copied userdata at the same time, and every job must arrive exactly once with intact userdata.
+ */
+
+#define THREADS 8
+#define JOBS_PER_THREAD 20000
+#define FRAMES 5
+
+typedef struct JobData
+{
+    int thread;
+    int sequence;
+    char padding[40];
+} JobData;
+
+typedef struct Producer
+{
+    Framebuffer *fb;
+    int thread;
+} Producer;
+
+static uint32_t data_color(int x, int y, void *userdata)
+{
+    (void)x;
+    (void)y;
+    JobData *data = userdata;
+    return (uint32_t)(data->thread << 16 | (data->sequence & 0xFFFF));
+}
+
+static int produce(void *arg)
+{
+    Producer *producer = arg;
+
+    for (int i = 0; i < JOBS_PER_THREAD; i++)
+    {
+        JobData data = {.thread = producer->thread, .sequence = i};
+        memset(data.padding, (char)i, sizeof(data.padding));
+
+        // Tiny areas keep drawing cheap, the queue is what is being tested
+        int x = (producer->thread * JOBS_PER_THREAD + i) % 200;
+        DrawJob job = {.area = {{x, 0}, {x + 1, 1}}, .callback = data_color};
+
+        if (i % 2)
+            enqueue_draw_job_with_data(producer->fb, job, &data, sizeof(data));
+        else
+            enqueue_draw_job(producer->fb, drawjob_solid(job.area, (uint32_t)(producer->thread << 16 | i)));
+    }
+
+    return 0;
+}
+
+int main(void)
+{
+    Framebuffer fb;
+    if (framebuffer_init(&fb, 200, 1) != 0)
+        return 1;
+
+    static unsigned char seen[THREADS][JOBS_PER_THREAD];
+    DrawJob *first_chunk = NULL;
+    int failures = 0;
+
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        Producer producers[THREADS];
+        SDL_Thread *threads[THREADS];
+
+        for (int t = 0; t < THREADS; t++)
+        {
+            producers[t] = (Producer){&fb, t};
+            threads[t] = SDL_CreateThread(produce, "producer", &producers[t]);
+        }
+        for (int t = 0; t < THREADS; t++)
+            SDL_WaitThread(threads[t], NULL);
+
+        int count;
+        DrawJob *jobs = draw_queue_jobs(&fb.queue, &count);
+        if (count != THREADS * JOBS_PER_THREAD)
+        {
+            printf("FAIL frame %d: %d jobs queued, expected %d\n", frame, count, THREADS * JOBS_PER_THREAD);
+            failures++;
+        }
+
+        memset(seen, 0, sizeof(seen));
+        for (int j = 0; j < count; j++)
+        {
+            int thread;
+            int sequence;
+            if (jobs[j].kind == DRAWJOB_SOLID)
+            {
+                thread = (int)(jobs[j].params.color >> 16);
+                sequence = (int)(jobs[j].params.color & 0xFFFF);
+                // Solid jobs only carry the low bits of the sequence, even sequences above 65535 share them
+                while (sequence < JOBS_PER_THREAD && seen[thread][sequence])
+                    sequence += 0x10000;
+            }
+            else
+            {
+                JobData *data = jobs[j].userdata;
+                thread = data->thread;
+                sequence = data->sequence;
+                for (int b = 0; b < (int)sizeof(data->padding); b++)
+                {
+                    if (data->padding[b] != (char)sequence)
+                    {
+                        printf("FAIL frame %d: userdata of job %d was overwritten\n", frame, j);
+                        failures++;
+                        break;
+                    }
+                }
+            }
+
+            if (thread < 0 || thread >= THREADS || sequence < 0 || sequence >= JOBS_PER_THREAD || seen[thread][sequence]++)
+            {
+                printf("FAIL frame %d: job %d is unknown or duplicated\n", frame, j);
+                failures++;
+                break;
+            }
+        }
+
+        // Chunks are kept between frames, so the steady state does no allocations
+        if (frame == 1)
+            first_chunk = fb.queue.chunks[0];
+        else if (frame > 1 && fb.queue.chunks[0] != first_chunk)
+        {
+            printf("FAIL frame %d: queue storage was reallocated\n", frame);
+            failures++;
+        }
+
+        process_queue_safe(&fb);
+
+        int remaining;
+        draw_queue_jobs(&fb.queue, &remaining);
+        if (remaining != 0)
+        {
+            printf("FAIL frame %d: queue not empty after processing\n", frame);
+            failures++;
+        }
+    }
+
+    framebuffer_destroy(&fb);
+    printf("%s: %d threads, %d jobs per frame\n", failures ? "FAILED" : "passed", THREADS, THREADS * JOBS_PER_THREAD);
+    return failures != 0;
+}
@@ -0,0 +1,130 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of scale_bitmap_into against results that can be worked out by hand.
+ */
+
+#define SOURCE_WIDTH 97
+#define SOURCE_HEIGHT 61
+
+static uint32_t source_pixels[SOURCE_WIDTH * SOURCE_HEIGHT];
+static uint32_t destination_pixels[4 * SOURCE_WIDTH * SOURCE_HEIGHT];
+
+static int channel_distance(uint32_t a, uint32_t b)
+{
+    int largest = 0;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int difference = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+        largest = difference > largest ? difference : largest;
+    }
+    return largest;
+}
+
+static int check_flat(ScaleMode mode, int width, int height)
+{
+    for (int i = 0; i < SOURCE_WIDTH * SOURCE_HEIGHT; i++)
+        source_pixels[i] = 0xC0805A13;
+
+    Bitmap source = {SOURCE_WIDTH, SOURCE_HEIGHT, source_pixels};
+    Bitmap destination = {width, height, destination_pixels};
+    if (scale_bitmap_into(source, destination, mode))
+    {
+        printf("FAIL flat mode %d %dx%d: scaling failed\n", (int)mode, width, height);
+        return 1;
+    }
+
+    for (int i = 0; i < width * height; i++)
+    {
+        if (destination_pixels[i] != 0xC0805A13)
+        {
+            printf("FAIL flat mode %d %dx%d: pixel %d is %08x\n", (int)mode, width, height, i, destination_pixels[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    for (int mode = SCALE_NEAREST; mode <= SCALE_BOX; mode++)
+    {
+        failures += check_flat((ScaleMode)mode, 2 * SOURCE_WIDTH, 2 * SOURCE_HEIGHT);
+        failures += check_flat((ScaleMode)mode, 31, 17);
+        failures += check_flat((ScaleMode)mode, 130, 5);
+    }
+
+    for (int i = 0; i < SOURCE_WIDTH * SOURCE_HEIGHT; i++)
+        source_pixels[i] = (uint32_t)i * 2654435761u;
+    Bitmap source = {SOURCE_WIDTH, SOURCE_HEIGHT, source_pixels};
+
+    /* Doubling with nearest repeats every pixel twice in both directions */
+    Bitmap doubled = {2 * SOURCE_WIDTH, 2 * SOURCE_HEIGHT, destination_pixels};
+    scale_bitmap_into(source, doubled, SCALE_NEAREST);
+    for (int y = 0; y < doubled.height && !failures; y++)
+    {
+        for (int x = 0; x < doubled.width; x++)
+        {
+            if (doubled.bitmap_argb[y * doubled.width + x] != source_pixels[(y / 2) * SOURCE_WIDTH + x / 2])
+            {
+                printf("FAIL nearest: pixel (%d,%d)\n", x, y);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    /* At the original size bilinear and box reproduce the source */
+    for (int mode = SCALE_BILINEAR; mode <= SCALE_BOX; mode++)
+    {
+        Bitmap same = {SOURCE_WIDTH, SOURCE_HEIGHT, destination_pixels};
+        scale_bitmap_into(source, same, (ScaleMode)mode);
+        if (memcmp(same.bitmap_argb, source_pixels, sizeof(source_pixels)))
+        {
+            printf("FAIL mode %d: scaling to the same size changed pixels\n", mode);
+            failures++;
+        }
+    }
+
+    /* Halving with box averages each 2x2 block */
+    Bitmap halved = {SOURCE_WIDTH / 2, SOURCE_HEIGHT / 2, destination_pixels};
+    Bitmap even = {halved.width * 2, halved.height * 2, source_pixels};
+    for (int y = 0; y < even.height; y++)
+        memmove(&source_pixels[y * even.width], &source_pixels[y * SOURCE_WIDTH], sizeof(uint32_t) * even.width);
+    scale_bitmap_into(even, halved, SCALE_BOX);
+    for (int y = 0; y < halved.height; y++)
+    {
+        for (int x = 0; x < halved.width; x++)
+        {
+            const uint32_t *block = &even.bitmap_argb[2 * y * even.width + 2 * x];
+            uint32_t expected = 0;
+            for (int shift = 0; shift < 32; shift += 8)
+            {
+                uint32_t sum = ((block[0] >> shift) & 0xFF) + ((block[1] >> shift) & 0xFF) +
+                               ((block[even.width] >> shift) & 0xFF) + ((block[even.width + 1] >> shift) & 0xFF);
+                expected |= ((sum + 2) / 4) << shift;
+            }
+
+            if (channel_distance(halved.bitmap_argb[y * halved.width + x], expected) > 1)
+            {
+                printf("FAIL box: pixel (%d,%d) is %08x, expected %08x\n", x, y, halved.bitmap_argb[y * halved.width + x], expected);
+                failures++;
+                y = halved.height;
+                break;
+            }
+        }
+    }
+
+    Bitmap allocated = scale_bitmap(source, 0.5);
+    if (allocated.width != SOURCE_WIDTH / 2 || allocated.height != SOURCE_HEIGHT / 2 || !allocated.bitmap_argb)
+    {
+        printf("FAIL scale_bitmap: got %dx%d\n", allocated.width, allocated.height);
+        failures++;
+    }
+    free(allocated.bitmap_argb);
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
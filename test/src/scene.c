@@ -0,0 +1,196 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the retained scene: after random frames of adding, moving, reordering, transforming and removing
+ * nodes, the incrementally redrawn framebuffer matches drawing every node from scratch, a frame with one small change
+ * redraws only around it, and handles of removed nodes stop working.
+ */
+
+#define FB_WIDTH 300
+#define FB_HEIGHT 200
+#define BACKGROUND 0xFF102030
+#define MAX_NODES 64
+#define FRAMES 80
+
+typedef struct ModelNode
+{
+    SceneHandle handle;
+    DrawJob job;
+    int z;
+    int order;
+    int has_matrix;
+    TransformationMatrix matrix;
+    Pointi offset;
+    int alive;
+} ModelNode;
+
+static ModelNode model[MAX_NODES];
+static uint32_t sprite[24 * 16];
+
+static uint32_t pixel_hash(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return 0xFF000000 | (((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u));
+}
+
+static DrawJob random_job(void)
+{
+    int x = rand() % FB_WIDTH - 20, y = rand() % FB_HEIGHT - 20;
+    int w = 5 + rand() % 60, h = 5 + rand() % 50;
+    uint32_t color = 0xFF000000 | (uint32_t)rand();
+    DrawJob job;
+
+    switch (rand() % 6)
+    {
+    case 0:
+        return drawjob_solid((Recti){{x, y}, {x + w, y + h}}, color);
+    case 1:
+        return drawjob_linear_gradient((Recti){{x, y}, {x + w, y + h}}, (Pointf){x, y}, color, (Pointf){x + w, y + h}, ~color | 0xFF000000);
+    case 2:
+        job = drawjob_circle((Pointf){x + w / 2.0, y + h / 2.0}, h / 2.0, 0x80402010);
+        job.blend = BLEND_SRC_OVER;
+        return job;
+    case 3:
+        return create_bitmap_draw_job((Bitmap){24, 16, sprite}, x, y);
+    case 4:
+        return drawjob_shaded_triangle((Pointf){x, y}, color, (Pointf){x + w, y + h / 2.0}, 0xFF00FF00, (Pointf){x, y + h}, 0xFF0000FF);
+    default:
+        return (DrawJob){.area = {{x, y}, {x + w, y + h}}, .callback = pixel_hash};
+    }
+}
+
+static int compare_orders(const void *a, const void *b)
+{
+    const ModelNode *x = *(const ModelNode *const *)a, *y = *(const ModelNode *const *)b;
+    if (x->z != y->z)
+        return (x->z > y->z) - (x->z < y->z);
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+// Draws every live node from scratch, in z-order
+static void draw_reference(Framebuffer *fb)
+{
+    const ModelNode *sorted[MAX_NODES];
+    int count = 0;
+    for (int i = 0; i < MAX_NODES; i++)
+        if (model[i].alive)
+            sorted[count++] = &model[i];
+    qsort(sorted, count, sizeof(sorted[0]), compare_orders);
+
+    draw(fb, drawjob_solid((Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}}, BACKGROUND));
+    for (int i = 0; i < count; i++)
+    {
+        DrawJob job = sorted[i]->job;
+        if (sorted[i]->has_matrix)
+            job = drawjob_transform(job, sorted[i]->matrix);
+        if (sorted[i]->offset.x || sorted[i]->offset.y)
+            job = drawjob_shift(job, sorted[i]->offset);
+        draw_bounded(fb, job);
+    }
+}
+
+int main(void)
+{
+    Scene scene;
+    Framebuffer fb, reference;
+    int failures = 0, order = 0;
+
+    if (scene_init(&scene, FB_WIDTH, FB_HEIGHT, BACKGROUND) || framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) ||
+        framebuffer_init(&reference, FB_WIDTH, FB_HEIGHT))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+    srand(23);
+    for (int i = 0; i < 24 * 16; i++)
+        sprite[i] = 0xFF000000 | (uint32_t)rand();
+
+    /* Random frames of changes, every frame checked against a full redraw */
+    for (int frame = 0; frame < FRAMES && !failures; frame++)
+    {
+        int changes = frame == 0 ? 30 : 1 + rand() % 5;
+        for (int c = 0; c < changes; c++)
+        {
+            ModelNode *node = &model[rand() % MAX_NODES];
+            int op = node->alive ? rand() % 6 : 0;
+            if (op == 0 && !node->alive)
+            {
+                *node = (ModelNode){.job = random_job(), .z = rand() % 5, .order = order++, .alive = 1};
+                node->handle = scene_add(&scene, node->job, node->z);
+            }
+            else if (op == 1)
+            {
+                node->offset = (Pointi){rand() % 41 - 20, rand() % 41 - 20};
+                scene_move(&scene, node->handle, node->offset);
+            }
+            else if (op == 2)
+            {
+                node->z = rand() % 5;
+                scene_set_z(&scene, node->handle, node->z);
+            }
+            else if (op == 3)
+            {
+                double angle = (rand() % 100) / 100.0;
+                node->has_matrix = rand() % 2;
+                node->matrix = (TransformationMatrix){{{cos(angle), -sin(angle)}, {sin(angle), cos(angle)}}};
+                scene_set_transform(&scene, node->handle, node->has_matrix ? &node->matrix : NULL);
+            }
+            else if (op == 4)
+            {
+                node->job = random_job();
+                scene_set_job(&scene, node->handle, node->job);
+            }
+            else if (op == 5)
+            {
+                scene_remove(&scene, node->handle);
+                node->alive = 0;
+            }
+        }
+
+        if (scene_render(&scene, &fb) != 0)
+        {
+            printf("FAIL frame %d: scene_render failed\n", frame);
+            failures++;
+        }
+        draw_reference(&reference);
+        for (int p = 0; p < FB_WIDTH * FB_HEIGHT; p++)
+        {
+            if (fb.pixels[p] != reference.pixels[p])
+            {
+                printf("FAIL frame %d: pixel (%d,%d) is %08x instead of %08x\n", frame, p % FB_WIDTH, p / FB_WIDTH, fb.pixels[p],
+                       reference.pixels[p]);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    /* Moving one small node redraws only its old and new area, drawing only the nodes there */
+    SceneHandle small = scene_add(&scene, drawjob_solid((Recti){{10, 10}, {20, 20}}, 0xFFFFFFFF), 10);
+    scene_render(&scene, &fb);
+    scene_move(&scene, small, (Pointi){5, 0});
+    scene_render(&scene, &fb);
+    if (scene.stats.changed != 1 || scene.stats.damage_pixels > 15 * 10 || scene.stats.jobs_drawn >= 30)
+    {
+        printf("FAIL small move: %d changed, %lld pixels and %d jobs redrawn\n", scene.stats.changed, scene.stats.damage_pixels,
+               scene.stats.jobs_drawn);
+        failures++;
+    }
+
+    /* Removed handles stop working, also once their slot is reused */
+    scene_remove(&scene, small);
+    scene_render(&scene, &fb);
+    SceneHandle reused = scene_add(&scene, drawjob_solid((Recti){{0, 0}, {1, 1}}, 0xFFFFFFFF), 0);
+    if (scene_set_z(&scene, small, 3) == 0 || scene_remove(&scene, small) == 0 || reused.index != small.index ||
+        scene_set_z(&scene, reused, 3) != 0)
+    {
+        printf("FAIL handles: removed handle still works\n");
+        failures++;
+    }
+
+    scene_free(&scene);
+    framebuffer_destroy(&fb);
+    framebuffer_destroy(&reference);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
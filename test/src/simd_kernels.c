@@ -0,0 +1,175 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check that the vectorized built in jobs draw exactly the same pixels
+ * as the generic path, for every instruction set the CPU supports.
+ */
+
+#define ROW_LENGTH 1037
+
+static uint32_t bitmap_pixels[64 * 64];
+
+static uint32_t solid_callback(int x, int y, void *userdata)
+{
+    (void)x;
+    (void)y;
+    return *(uint32_t *)userdata;
+}
+
+static uint8_t text_coverage[ROW_LENGTH * 8];
+
+static uint32_t text_callback(int x, int y, void *userdata)
+{
+    const ShapedLine *line = userdata;
+    return text_coverage[y * ROW_LENGTH + x] ? line->color : 0;
+}
+
+static uint32_t bitmap_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return bitmap_pixels[(y - 3) * 64 + (x - 5)];
+}
+
+/*
+ * Generic path: draws the job one pixel at a time through the scalar kernels.
+ */
+static void draw_reference_row(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    for (int x = x0; x < x1; x++)
+        drawjob_draw_span(job, y, x, x + 1, &dst[x]);
+}
+
+/*
+ * Draws the row as a series of spans of random length, so kernels start at every alignment.
+ */
+static void draw_split_row(const DrawJob *job, int y, int x0, int x1, uint32_t *dst)
+{
+    int x = x0;
+    while (x < x1)
+    {
+        int end = x + 1 + rand() % 67;
+        if (end > x1)
+            end = x1;
+        drawjob_draw_span(job, y, x, end, &dst[x]);
+        x = end;
+    }
+}
+
+static int compare_job(const char *name, const DrawJob *job, const DrawJob *generic, int x0, int x1, int rows)
+{
+    static uint32_t expected[ROW_LENGTH];
+    static uint32_t actual[ROW_LENGTH];
+
+    for (int y = job->area.top_left.y; y < job->area.top_left.y + rows; y++)
+    {
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+
+        SimdLevel level = simd_level();
+        simd_select(SIMD_SCALAR);
+        draw_reference_row(generic, y, x0, x1, expected);
+        simd_select(level);
+        draw_split_row(job, y, x0, x1, actual);
+
+        for (int x = x0; x < x1; x++)
+        {
+            if (expected[x] != actual[x])
+            {
+                printf("FAIL %s (level %d): pixel (%d,%d) is %08x, expected %08x\n",
+                       name, (int)level, x, y, actual[x], expected[x]);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Blend kernels against blend_color, on random pixels including fully transparent and opaque ones.
+ * The pixels are drawn by a one row bitmap job, which reaches the kernels through the blended span path.
+ */
+static int compare_blend(BlendMode mode)
+{
+    static uint32_t src[ROW_LENGTH];
+    static uint32_t dst[ROW_LENGTH];
+    static uint32_t expected[ROW_LENGTH];
+
+    for (int i = 0; i < ROW_LENGTH; i++)
+    {
+        uint32_t alpha = i % 5 == 0 ? 0 : i % 5 == 1 ? 255 : (uint32_t)rand() & 0xFF;
+        src[i] = color_premultiply(alpha << 24 | ((uint32_t)rand() & 0xFFFFFF));
+        dst[i] = (uint32_t)rand() << 16 ^ (uint32_t)rand();
+        expected[i] = blend_color(src[i], dst[i], mode);
+    }
+
+    Bitmap row = {ROW_LENGTH, 1, src};
+    DrawJob job = create_bitmap_draw_job(row, 0, 0);
+    job.blend = mode;
+    draw_split_row(&job, 0, 0, ROW_LENGTH, dst);
+
+    for (int i = 0; i < ROW_LENGTH; i++)
+    {
+        if (dst[i] != expected[i])
+        {
+            printf("FAIL blend mode %d (level %d): pixel %d is %08x, expected %08x\n",
+                   (int)mode, (int)simd_level(), i, dst[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+
+    for (int i = 0; i < 64 * 64; i++)
+        bitmap_pixels[i] = (uint32_t)i * 2654435761u;
+
+    uint32_t color = 0xFF336699;
+    DrawJob solid = drawjob_solid((Recti){{0, 0}, {ROW_LENGTH, 8}}, color);
+    DrawJob solid_generic = {.area = solid.area, .callback = solid_callback, .userdata = &color};
+
+    Bitmap bitmap = {64, 64, bitmap_pixels};
+    DrawJob blit = create_bitmap_draw_job(bitmap, 5, 3);
+    DrawJob blit_generic = {.area = blit.area, .callback = bitmap_callback};
+
+    /* Random coverage including values other than 0 and 255, drawn through the masked fill kernels */
+    for (int i = 0; i < ROW_LENGTH * 8; i++)
+        text_coverage[i] = rand() % 3 == 0 ? 0 : (uint8_t)rand();
+    ShapedLine line = {ROW_LENGTH, 8, 0xFF123456, text_coverage};
+    DrawJob text = {.area = {{0, 0}, {ROW_LENGTH, 8}}, .kind = DRAWJOB_TEXT, .params.text = {&line, {0, 0}}};
+    DrawJob text_generic = {.area = text.area, .callback = text_callback, .userdata = &line};
+
+    Pointf starts[] = {{0, 0}, {100, 50}, {900, 10}, {-5000, 3}, {10, 10}};
+    Pointf ends[] = {{ROW_LENGTH, 0}, {400, 350}, {100, 20}, {5000, -3}, {10.5, 10}};
+
+    for (int level = SIMD_SCALAR; level <= (int)simd_detect(); level++)
+    {
+        simd_select((SimdLevel)level);
+
+        failures += compare_job("solid", &solid, &solid_generic, 0, ROW_LENGTH, 8);
+        failures += compare_job("bitmap", &blit, &blit_generic, 5, 69, 64);
+        failures += compare_job("text", &text, &text_generic, 0, ROW_LENGTH, 8);
+
+        for (int g = 0; g < (int)(sizeof(starts) / sizeof(starts[0])); g++)
+        {
+            DrawJob gradient = drawjob_linear_gradient((Recti){{0, 0}, {ROW_LENGTH, 200}}, starts[g], 0x80FF0000, ends[g], 0xFF00FF7F);
+            failures += compare_job("gradient", &gradient, &gradient, 0, ROW_LENGTH, 200);
+        }
+
+        for (int mode = BLEND_OPAQUE; mode <= BLEND_MULTIPLY; mode++)
+            failures += compare_blend((BlendMode)mode);
+
+        /* Blended jobs draw into a temporary row and blend it with the kernels */
+        DrawJob blended = blit;
+        blended.blend = BLEND_ADD;
+        DrawJob blended_generic = blit_generic;
+        blended_generic.blend = BLEND_ADD;
+        failures += compare_job("blended bitmap", &blended, &blended_generic, 5, 69, 64);
+    }
+
+    simd_select(simd_detect());
+    printf("%s: best level %d\n", failures ? "FAILED" : "passed", (int)simd_detect());
+    return failures != 0;
+}
@@ -0,0 +1,151 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the spatial index against linear scans over the same jobs: hit tests at random pixels and overlap
+ * queries over random areas, jobs partly or fully outside the framebuffer included. A frame of solid jobs drawn with
+ * draw_multiple_bounded_safe also shows the color of the job the index finds on top at every pixel.
+ */
+
+#define FB_WIDTH 333
+#define FB_HEIGHT 211
+#define JOB_COUNT 2000
+#define SAMPLES 20000
+
+static DrawJob jobs[JOB_COUNT];
+static int found[JOB_COUNT], expected[JOB_COUNT];
+
+static Recti random_area(void)
+{
+    int x = rand() % (FB_WIDTH + 80) - 40;
+    int y = rand() % (FB_HEIGHT + 80) - 40;
+    int w = 1 + rand() % (rand() % 8 ? 40 : 2 * FB_WIDTH);
+    int h = 1 + rand() % (rand() % 8 ? 40 : 2 * FB_HEIGHT);
+    return (Recti){{x, y}, {x + w, y + h}};
+}
+
+/* The last job holding the pixel, the way spatial_index_hit defines it */
+static int linear_hit(Pointi p)
+{
+    Recti pixel = {p, {p.x + 1, p.y + 1}};
+    if (p.x < 0 || p.y < 0 || p.x >= FB_WIDTH || p.y >= FB_HEIGHT)
+        return -1;
+    for (int j = JOB_COUNT - 1; j >= 0; j--)
+    {
+        Recti area = jobs[j].area;
+        if (p.x < area.top_left.x || p.x >= area.bottom_right.x || p.y < area.top_left.y || p.y >= area.bottom_right.y)
+            continue;
+        if (drawjob_is_primitive(&jobs[j]) && !primitive_touches_tile(&jobs[j], pixel))
+            continue;
+        return j;
+    }
+    return -1;
+}
+
+static int linear_query(Recti area)
+{
+    int count = 0;
+    area = recti_clamp(area, FB_WIDTH, FB_HEIGHT);
+    for (int j = 0; j < JOB_COUNT; j++)
+    {
+        Recti job = recti_clamp(jobs[j].area, FB_WIDTH, FB_HEIGHT);
+        if (job.top_left.x < area.bottom_right.x && area.top_left.x < job.bottom_right.x && job.top_left.y < area.bottom_right.y &&
+            area.top_left.y < job.bottom_right.y && !recti_is_empty(job) && !recti_is_empty(area))
+            expected[count++] = j;
+    }
+    return count;
+}
+
+int main(void)
+{
+    SpatialIndex index = {0};
+    Framebuffer fb;
+    int failures = 0;
+
+    srand(41);
+    for (int j = 0; j < JOB_COUNT; j++)
+    {
+        Recti area = random_area();
+        Pointf a = {area.top_left.x, area.top_left.y}, b = {area.bottom_right.x, area.bottom_right.y};
+        switch (j % 4)
+        {
+        case 0:
+            jobs[j] = drawjob_triangle(a, (Pointf){b.x, a.y + 10}, (Pointf){a.x + 5, b.y}, 0xFF00FF00);
+            break;
+        case 1:
+            jobs[j] = drawjob_circle((Pointf){(a.x + b.x) / 2, (a.y + b.y) / 2}, (b.y - a.y) / 2, 0xFF0000FF);
+            break;
+        default:
+            jobs[j] = drawjob_solid(area, 0xFF000000 | (uint32_t)rand());
+        }
+    }
+
+    if (spatial_index_build(&index, jobs, JOB_COUNT, FB_WIDTH, FB_HEIGHT) != 0)
+    {
+        printf("FAILED: build\n");
+        return 1;
+    }
+
+    /* Hit tests, outside the framebuffer too */
+    for (int s = 0; s < SAMPLES; s++)
+    {
+        Pointi p = {rand() % (FB_WIDTH + 20) - 10, rand() % (FB_HEIGHT + 20) - 10};
+        int hit = spatial_index_hit(&index, p), reference = linear_hit(p);
+        if (hit != reference)
+        {
+            printf("FAIL hit (%d,%d): job %d instead of %d\n", p.x, p.y, hit, reference);
+            failures++;
+            break;
+        }
+    }
+
+    /* Overlap queries, in submission order and without duplicates */
+    for (int s = 0; s < SAMPLES / 10 && !failures; s++)
+    {
+        Recti area = random_area();
+        int count = spatial_index_query(&index, area, found, JOB_COUNT), reference = linear_query(area);
+        if (count != reference || memcmp(found, expected, count * sizeof(int)) != 0)
+        {
+            printf("FAIL query (%d,%d)-(%d,%d): %d jobs instead of %d\n", area.top_left.x, area.top_left.y, area.bottom_right.x,
+                   area.bottom_right.y, count, reference);
+            failures++;
+        }
+    }
+
+    /* A full framebuffer query overflows a small buffer but still counts every job */
+    int inside = linear_query((Recti){{0, 0}, {FB_WIDTH, FB_HEIGHT}});
+    if (spatial_index_query(&index, (Recti){{-5, -5}, {FB_WIDTH + 5, FB_HEIGHT + 5}}, found, 10) != inside)
+    {
+        printf("FAIL overflow: wrong count\n");
+        failures++;
+    }
+
+    /* With solid jobs only, the job on top at a pixel is the color drawn there */
+    for (int j = 0; j < JOB_COUNT; j++)
+        if (drawjob_is_primitive(&jobs[j]))
+            jobs[j] = drawjob_solid(jobs[j].area, 0xFF000000 | (uint32_t)rand());
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) || spatial_index_build(&index, jobs, JOB_COUNT, FB_WIDTH, FB_HEIGHT) != 0)
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+    draw_multiple_bounded_safe(&fb, jobs, JOB_COUNT);
+    for (int y = 0; y < FB_HEIGHT && !failures; y++)
+    {
+        for (int x = 0; x < FB_WIDTH; x++)
+        {
+            int hit = spatial_index_hit(&index, (Pointi){x, y});
+            uint32_t color = hit < 0 ? 0xFF000000 : jobs[hit].params.color;
+            if (*framebuffer_pixel(&fb, x, y) != color)
+            {
+                printf("FAIL pixel (%d,%d): %08x but job %d is %08x\n", x, y, *framebuffer_pixel(&fb, x, y), hit, color);
+                failures++;
+                break;
+            }
+        }
+    }
+
+    spatial_index_free(&index);
+    framebuffer_destroy(&fb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -79,6 +79,7 @@ int main(int argc, char **argv)
         fprintf(stderr, "Failed to initialize SDL\n");
         return 1;
     }
+    Framebuffer *fb = &ctx.framebuffer;
 
     // 1) Test draw(): full-screen gradient
     DrawJob full_gradient = {
@@ -87,7 +88,7 @@ int main(int argc, char **argv)
         .userdata = NULL
     };
 
-    draw(full_gradient);
+    draw(fb, full_gradient);
     update(&ctx);
     printf("Showing full-screen gradient (draw)...\n");
     wait_ms(1000);
@@ -98,13 +99,13 @@ int main(int argc, char **argv)
 
     for (int dx = -20; dx <= 20; dx++)
     {
-        draw_pixel(cx + dx, cy, rgb(255, 255, 255));
-        draw_pixel(cx, cy + dx, rgb(255, 255, 255));
+        draw_pixel(fb, cx + dx, cy, rgb(255, 255, 255));
+        draw_pixel(fb, cx, cy + dx, rgb(255, 255, 255));
     }
 
     for (int y = cy - 10; y <= cy + 10; y++)
         for (int x = cx - 10; x <= cx + 10; x++)
-            safe_draw_pixel(x, y, rgb(255, 255, 0));
+            safe_draw_pixel(fb, x, y, rgb(255, 255, 0));
 
     update(&ctx);
     printf("Showing draw_pixel and safe_draw_pixel result...\n");
@@ -117,7 +118,7 @@ int main(int argc, char **argv)
         .userdata = NULL
     };
 
-    draw_bounded(red_rect);
+    draw_bounded(fb, red_rect);
     update(&ctx);
     printf("Showing draw_bounded (red rectangle)...\n");
     wait_ms(1000);
@@ -129,7 +130,7 @@ int main(int argc, char **argv)
         { .area = {{2*WIDTH/3,HEIGHT/2},{WIDTH,HEIGHT}}, .callback = solid_blue,  .userdata = NULL }
     };
 
-    draw_multiple_bounded(jobs_non_overlap, 3);
+    draw_multiple_bounded(fb, jobs_non_overlap, 3);
     update(&ctx);
     printf("Showing draw_multiple_bounded with non-overlapping jobs...\n");
     wait_ms(1000);
@@ -141,39 +142,39 @@ int main(int argc, char **argv)
         { .area = {{400,150},{900,550}}, .callback = solid_blue,  .userdata = NULL }
     };
 
-    draw_multiple_bounded_safe(jobs_overlap, 3);
+    draw_multiple_bounded_safe(fb, jobs_overlap, 3);
     update(&ctx);
     printf("Showing draw_multiple_bounded_safe with overlapping jobs...\n");
     wait_ms(1000);
 
     // 6) Test enqueue_draw_job() + process_queue()
-    draw(full_gradient);
+    draw(fb, full_gradient);
 
     DrawJob qjob1 = { .area = {{50,50},{350,300}}, .callback = solid_red,   .userdata = NULL };
     DrawJob qjob2 = { .area = {{200,150},{600,400}}, .callback = solid_green, .userdata = NULL };
     DrawJob qjob3 = { .area = {{650,100},{950,300}}, .callback = solid_blue,  .userdata = NULL };
 
-    enqueue_draw_job(qjob1);
-    enqueue_draw_job(qjob2);
-    enqueue_draw_job(qjob3);
+    enqueue_draw_job(fb, qjob1);
+    enqueue_draw_job(fb, qjob2);
+    enqueue_draw_job(fb, qjob3);
 
-    process_queue();
+    process_queue(fb);
     update(&ctx);
     printf("Showing process_queue (non-overlapping assumption)...\n");
     wait_ms(1000);
 
     // 7) Test enqueue_draw_job() + process_queue_safe()
-    draw(full_gradient);
+    draw(fb, full_gradient);
 
     DrawJob qjob4 = { .area = {{100,350},{600,650}}, .callback = solid_red,   .userdata = NULL };
     DrawJob qjob5 = { .area = {{200,400},{700,680}}, .callback = solid_green, .userdata = NULL };
     DrawJob qjob6 = { .area = {{300,450},{800,690}}, .callback = solid_blue,  .userdata = NULL };
 
-    enqueue_draw_job(qjob4);
-    enqueue_draw_job(qjob5);
-    enqueue_draw_job(qjob6);
+    enqueue_draw_job(fb, qjob4);
+    enqueue_draw_job(fb, qjob5);
+    enqueue_draw_job(fb, qjob6);
 
-    process_queue_safe();
+    process_queue_safe(fb);
     update(&ctx);
     printf("Showing process_queue_safe (overlapping jobs, last wins)...\n");
     wait_ms(3000);
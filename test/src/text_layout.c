@@ -0,0 +1,209 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of fonts, text layout and the shaped line cache.
+ */
+
+#define CANVAS_WIDTH 64
+#define CANVAS_HEIGHT 32
+
+static uint32_t canvas[CANVAS_WIDTH * CANVAS_HEIGHT];
+
+static void draw_text_job(const DrawJob *job)
+{
+    for (int i = 0; i < CANVAS_WIDTH * CANVAS_HEIGHT; i++)
+        canvas[i] = 0;
+
+    Recti area = recti_clamp(job->area, CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (int y = area.top_left.y; y < area.bottom_right.y; y++)
+        drawjob_draw_span(job, y, area.top_left.x, area.bottom_right.x, &canvas[y * CANVAS_WIDTH + area.top_left.x]);
+}
+
+/*
+ * Compares the canvas to a picture where '#' is the text color and anything else untouched.
+ */
+static int compare_picture(const char *name, const char *const *picture, int rows, int x, int y, uint32_t color)
+{
+    for (int row = 0; row < rows; row++)
+    {
+        for (int column = 0; picture[row][column]; column++)
+        {
+            uint32_t expected = picture[row][column] == '#' ? color : 0;
+            uint32_t actual = canvas[(y + row) * CANVAS_WIDTH + x + column];
+            if (actual != expected)
+            {
+                printf("FAIL %s: pixel (%d,%d) is %08x, expected %08x\n", name, x + column, y + row, actual, expected);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static const char *const hi_picture[] = {
+    "#...#..###..",
+    "#...#...#...",
+    "#...#...#...",
+    "#####...#...",
+    "#...#...#...",
+    "#...#...#...",
+    "#...#..###..",
+    "............"};
+
+static const char *const bdf_picture[] = {
+    ".....",
+    ".##..",
+    "#..#.",
+    "#..#.",
+    "....#"};
+
+static const char *const bdf_font =
+    "STARTFONT 2.1\n"
+    "FONT test\n"
+    "SIZE 6 75 75\n"
+    "FONTBOUNDINGBOX 4 5 0 -1\n"
+    "STARTPROPERTIES 2\n"
+    "FONT_ASCENT 4\n"
+    "FONT_DESCENT 1\n"
+    "ENDPROPERTIES\n"
+    "CHARS 2\n"
+    "STARTCHAR o\n"
+    "ENCODING 111\n"
+    "SWIDTH 500 0\n"
+    "DWIDTH 4 0\n"
+    "BBX 4 3 0 0\n"
+    "BITMAP\n"
+    "60\n"
+    "90\n"
+    "90\n"
+    "ENDCHAR\n"
+    "STARTCHAR snowman\n"
+    "ENCODING 9731\n"
+    "DWIDTH 4 0\n"
+    "BBX 1 1 0 0\n"
+    "BITMAP\n"
+    "80\n"
+    "ENDCHAR\n"
+    "STARTCHAR bar\n"
+    "ENCODING 124\n"
+    "DWIDTH 1 0\n"
+    "BBX 1 1 0 -1\n"
+    "BITMAP\n"
+    "80\n"
+    "ENDCHAR\n"
+    "ENDFONT\n";
+
+int main(void)
+{
+    int failures = 0;
+    Font font;
+    TextCache cache;
+
+    if (font_init_builtin(&font) || text_cache_init(&cache))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    DrawJob hi = text_draw_job(&cache, &font, "HI", 3, 5, 0xFFFFFF00);
+    if (hi.area.top_left.x != 3 || hi.area.top_left.y != 5 || hi.area.bottom_right.x != 15 || hi.area.bottom_right.y != 13)
+    {
+        printf("FAIL layout: area (%d,%d)-(%d,%d)\n", hi.area.top_left.x, hi.area.top_left.y, hi.area.bottom_right.x, hi.area.bottom_right.y);
+        failures++;
+    }
+    draw_text_job(&hi);
+    failures += compare_picture("builtin", hi_picture, 8, 3, 5, 0xFFFFFF00);
+
+    /* Same key hits the cache, a different color is a different line */
+    DrawJob again = text_draw_job(&cache, &font, "HI", 40, 1, 0xFFFFFF00);
+    DrawJob other = text_draw_job(&cache, &font, "HI", 3, 5, 0xFF00FF00);
+    if (again.params.text.line != hi.params.text.line || other.params.text.line == hi.params.text.line ||
+        cache.stats.hits != 1 || cache.stats.misses != 2)
+    {
+        printf("FAIL cache: hits %llu, misses %llu\n", (unsigned long long)cache.stats.hits, (unsigned long long)cache.stats.misses);
+        failures++;
+    }
+
+    DrawJob lines = text_draw_job(&cache, &font, "A\nBC", 0, 0, 0xFFFFFFFF);
+    if (lines.area.bottom_right.x != 12 || lines.area.bottom_right.y != 16)
+    {
+        printf("FAIL newline: area %dx%d\n", lines.area.bottom_right.x, lines.area.bottom_right.y);
+        failures++;
+    }
+
+    /* Lines unused during a frame are dropped when it ends */
+    text_cache_end_frame(&cache);
+    text_draw_job(&cache, &font, "HI", 0, 0, 0xFFFFFF00);
+    text_cache_end_frame(&cache);
+    if (cache.count != 1 || cache.stats.evictions != 2)
+    {
+        printf("FAIL eviction: %d lines cached, %llu evicted\n", cache.count, (unsigned long long)cache.stats.evictions);
+        failures++;
+    }
+
+    /* Evicting half of a large cache keeps the other half reachable and the table in place */
+    TextCache many;
+    if (text_cache_init(&many))
+    {
+        printf("FAIL eviction: cache init\n");
+        failures++;
+    }
+    else
+    {
+        char label[16];
+        for (int i = 0; i < 3000; i++)
+        {
+            snprintf(label, sizeof(label), "%d", i);
+            text_draw_job(&many, &font, label, 0, 0, 0xFFFFFFFF);
+        }
+        text_cache_end_frame(&many);
+        for (int i = 0; i < 3000; i += 2)
+        {
+            snprintf(label, sizeof(label), "%d", i);
+            text_draw_job(&many, &font, label, 0, 0, 0xFFFFFFFF);
+        }
+        TextCacheEntry *entries = many.entries;
+        text_cache_end_frame(&many);
+        for (int i = 0; i < 3000; i += 2)
+        {
+            snprintf(label, sizeof(label), "%d", i);
+            text_draw_job(&many, &font, label, 0, 0, 0xFFFFFFFF);
+        }
+        if (many.count != 1500 || many.entries != entries || many.stats.evictions != 1500 ||
+            many.stats.hits != 3000 || many.stats.misses != 3000)
+        {
+            printf("FAIL eviction: %d lines cached, %llu evicted, %llu hits, %llu misses, table %s\n", many.count,
+                   (unsigned long long)many.stats.evictions, (unsigned long long)many.stats.hits,
+                   (unsigned long long)many.stats.misses, many.entries != entries ? "reallocated" : "kept");
+            failures++;
+        }
+        text_cache_free(&many);
+    }
+
+    const char *path = "test/build/text_layout.bdf";
+    FILE *file = fopen(path, "w");
+    Font bdf;
+    if (!file || fputs(bdf_font, file) < 0 || fclose(file) || font_load_bdf(&bdf, path))
+    {
+        printf("FAIL bdf: loading %s\n", path);
+        failures++;
+    }
+    else
+    {
+        DrawJob text = text_draw_job(&cache, &bdf, "o|", 2, 2, 0xFF0000FF);
+        draw_text_job(&text);
+        failures += compare_picture("bdf", bdf_picture, 5, 2, 2, 0xFF0000FF);
+        if (bdf.line_height != 5 || text.area.bottom_right.x != 7)
+        {
+            printf("FAIL bdf: line height %d, right edge %d\n", bdf.line_height, text.area.bottom_right.x);
+            failures++;
+        }
+        font_free(&bdf);
+    }
+    remove(path);
+
+    text_cache_free(&cache);
+    font_free(&font);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,267 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of transformed jobs: the incremental span walk must draw the same pixels
+ * as mapping every pixel center through the inverse matrix, and composed modifiers must
+ * behave like the single transformation they describe.
+ */
+
+#define CANVAS 256
+#define UNDRAWN 0xDEADBEEF
+
+static uint32_t sprite_pixels[40 * 24];
+
+static uint32_t pattern_callback(int x, int y, void *userdata)
+{
+    (void)userdata;
+    return (uint32_t)(x * 73856093) ^ (uint32_t)(y * 19349663);
+}
+
+static void pattern_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++)
+        *dst++ = pattern_callback(x, y, userdata);
+}
+
+/* Leaves the pixels outside a disc unwritten, which must keep the canvas under them */
+static void disc_span(int y, int x0, int x1, uint32_t *dst, void *userdata)
+{
+    for (int x = x0; x < x1; x++, dst++)
+        if ((x - 40) * (x - 40) + (y - 42) * (y - 42) < 100)
+            *dst = pattern_callback(x, y, userdata);
+}
+
+static void draw_job(const DrawJob *job, uint32_t *canvas)
+{
+    for (int i = 0; i < CANVAS * CANVAS; i++)
+        canvas[i] = UNDRAWN;
+
+    Recti area = recti_clamp(job->area, CANVAS, CANVAS);
+    if (recti_is_empty(area))
+        return;
+
+    for (int y = area.top_left.y; y < area.bottom_right.y; y++)
+    {
+        // Random splits, so spans start and end everywhere inside the transformed area
+        int x = area.top_left.x;
+        while (x < area.bottom_right.x)
+        {
+            int end = x + 1 + rand() % 37;
+            if (end > area.bottom_right.x)
+                end = area.bottom_right.x;
+            drawjob_draw_span(job, y, x, end, &canvas[y * CANVAS + x]);
+            x = end;
+        }
+    }
+}
+
+/*
+ * Reference: full matrix multiply per pixel of the job's area, untransformed job sampled one pixel at a time.
+ * Pixels whose center maps within 1e-6 of a source pixel edge may round either way and are skipped.
+ */
+static int compare_reference(const char *name, const DrawJob *job, const DrawJob *untransformed)
+{
+    static uint32_t canvas[CANVAS * CANVAS];
+    draw_job(job, canvas);
+
+    const double (*m)[3] = job->transform.inverse;
+    Recti source = job->transform.source;
+
+    for (int y = 0; y < CANVAS; y++)
+    {
+        for (int x = 0; x < CANVAS; x++)
+        {
+            double sx = m[0][0] * (x + 0.5) + m[0][1] * (y + 0.5) + m[0][2];
+            double sy = m[1][0] * (x + 0.5) + m[1][1] * (y + 0.5) + m[1][2];
+            if (fabs(sx - round(sx)) < 1e-6 || fabs(sy - round(sy)) < 1e-6)
+                continue;
+
+            int ix = (int)floor(sx);
+            int iy = (int)floor(sy);
+            uint32_t expected = UNDRAWN;
+            if (x >= job->area.top_left.x && x < job->area.bottom_right.x &&
+                y >= job->area.top_left.y && y < job->area.bottom_right.y &&
+                ix >= source.top_left.x && ix < source.bottom_right.x &&
+                iy >= source.top_left.y && iy < source.bottom_right.y)
+                drawjob_draw_span(untransformed, iy, ix, ix + 1, &expected);
+
+            if (canvas[y * CANVAS + x] != expected)
+            {
+                printf("FAIL %s: pixel (%d,%d) is %08x, expected %08x\n", name, x, y, canvas[y * CANVAS + x], expected);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int compare_jobs(const char *name, const DrawJob *job, const DrawJob *expected_job)
+{
+    static uint32_t actual[CANVAS * CANVAS];
+    static uint32_t expected[CANVAS * CANVAS];
+    draw_job(job, actual);
+    draw_job(expected_job, expected);
+
+    for (int i = 0; i < CANVAS * CANVAS; i++)
+    {
+        if (actual[i] != expected[i])
+        {
+            printf("FAIL %s: pixel (%d,%d) is %08x, expected %08x\n", name, i % CANVAS, i / CANVAS, actual[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Splitting a row into spans must not move a single pixel, including the ones the reference skips.
+ */
+static int compare_splits(const char *name, const DrawJob *job)
+{
+    static uint32_t whole[CANVAS * CANVAS];
+    static uint32_t split[CANVAS * CANVAS];
+    for (int i = 0; i < CANVAS * CANVAS; i++)
+        whole[i] = UNDRAWN;
+
+    Recti area = recti_clamp(job->area, CANVAS, CANVAS);
+    for (int y = area.top_left.y; y < area.bottom_right.y; y++)
+        drawjob_draw_span(job, y, area.top_left.x, area.bottom_right.x, &whole[y * CANVAS + area.top_left.x]);
+    draw_job(job, split);
+
+    for (int i = 0; i < CANVAS * CANVAS; i++)
+    {
+        if (split[i] != whole[i])
+        {
+            printf("FAIL %s split: pixel (%d,%d) is %08x, whole row gives %08x\n", name, i % CANVAS, i / CANVAS, split[i], whole[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * The bounding box must contain every drawn pixel and every edge of it must be touched.
+ */
+static int check_bounds(const char *name, const DrawJob *job)
+{
+    static uint32_t canvas[CANVAS * CANVAS];
+    DrawJob unbounded = *job;
+    unbounded.area = (Recti){{0, 0}, {CANVAS, CANVAS}};
+    draw_job(&unbounded, canvas);
+
+    Recti drawn = {{CANVAS, CANVAS}, {0, 0}};
+    for (int y = 0; y < CANVAS; y++)
+    {
+        for (int x = 0; x < CANVAS; x++)
+        {
+            if (canvas[y * CANVAS + x] == UNDRAWN)
+                continue;
+            drawn.top_left.x = x < drawn.top_left.x ? x : drawn.top_left.x;
+            drawn.top_left.y = y < drawn.top_left.y ? y : drawn.top_left.y;
+            drawn.bottom_right.x = x + 1 > drawn.bottom_right.x ? x + 1 : drawn.bottom_right.x;
+            drawn.bottom_right.y = y + 1 > drawn.bottom_right.y ? y + 1 : drawn.bottom_right.y;
+        }
+    }
+
+    // Rounding may leave a one pixel row of the box empty where an edge passes exactly through pixel centers
+    Recti area = job->area;
+    if (drawn.top_left.x < area.top_left.x || drawn.top_left.y < area.top_left.y ||
+        drawn.bottom_right.x > area.bottom_right.x || drawn.bottom_right.y > area.bottom_right.y ||
+        drawn.top_left.x > area.top_left.x + 1 || drawn.top_left.y > area.top_left.y + 1 ||
+        drawn.bottom_right.x < area.bottom_right.x - 1 || drawn.bottom_right.y < area.bottom_right.y - 1)
+    {
+        printf("FAIL %s: drew (%d,%d)-(%d,%d), bounding box (%d,%d)-(%d,%d)\n", name,
+               drawn.top_left.x, drawn.top_left.y, drawn.bottom_right.x, drawn.bottom_right.y,
+               area.top_left.x, area.top_left.y, area.bottom_right.x, area.bottom_right.y);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failures = 0;
+    Font font;
+    TextCache cache;
+    if (font_init_builtin(&font) || text_cache_init(&cache))
+    {
+        printf("FAILED: text initialization\n");
+        return 1;
+    }
+
+    for (int i = 0; i < 40 * 24; i++)
+        sprite_pixels[i] = (uint32_t)i * 2654435761u;
+
+    Bitmap sprite_bitmap = {40, 24, sprite_pixels};
+    Recti area = {{20, 30}, {60, 54}};
+    Pointf center = {40, 42};
+
+    DrawJob sources[] = {
+        create_bitmap_draw_job(sprite_bitmap, 20, 30),
+        drawjob_solid(area, 0xFF336699),
+        drawjob_linear_gradient(area, (Pointf){20, 30}, 0xFF000000, (Pointf){60, 54}, 0xFFFFFFFF),
+        {.area = area, .callback = pattern_callback},
+        {.area = area, .span_callback = pattern_span},
+        {.area = area, .span_callback = disc_span},
+        drawjob_triangle((Pointf){22.3, 31.1}, (Pointf){58.7, 36.2}, (Pointf){30.4, 53.9}, 0xFF884422),
+        drawjob_line((Pointf){21, 33}, 0xFF00FF00, (Pointf){57, 50}, 0xFF0000FF, 3),
+        drawjob_circle(center, 9.5, 0xFFFF8000),
+        text_draw_job(&cache, &font, "Hi!", 28, 36, 0xFF40C0FF)};
+    const char *names[] = {"bitmap", "solid", "gradient", "callback", "span callback", "partial span", "triangle", "line", "circle", "text"};
+    // Jobs leaving pixels unwritten don't touch every edge of their bounding box
+    const int fills[] = {1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+
+    for (int s = 0; s < (int)(sizeof(sources) / sizeof(sources[0])); s++)
+    {
+        const DrawJob *source = &sources[s];
+        char name[64];
+
+        for (int i = 0; i < 24; i++)
+        {
+            double angle = i * 0.2731;
+            DrawJob job = drawjob_rotate_around_point(*source, angle, center);
+            job = drawjob_shear(job, 0.1 * (i % 5) - 0.2, 0.05 * (i % 3));
+            job = drawjob_shift(job, (Pointi){60, 50});
+
+            snprintf(name, sizeof(name), "%s rotated %d", names[s], i);
+            failures += compare_reference(name, &job, source);
+            if (fills[s])
+                failures += check_bounds(name, &job);
+            failures += compare_splits(name, &job);
+        }
+
+        DrawJob scaled = drawjob_transform(*source, (TransformationMatrix){{{2.5, 0.3}, {-0.2, 1.75}}});
+        snprintf(name, sizeof(name), "%s scaled", names[s]);
+        failures += compare_reference(name, &scaled, source);
+        failures += compare_splits(name, &scaled);
+
+        // Integer shifts take the span path and must reproduce the original pixels
+        DrawJob shifted = drawjob_shift(*source, (Pointi){-7, 13});
+        snprintf(name, sizeof(name), "%s shifted", names[s]);
+        failures += compare_reference(name, &shifted, source);
+
+        // A quarter turn there and back composes to the identity
+        DrawJob there_and_back = drawjob_rotate_around_point(*source, M_PI / 2, center);
+        there_and_back = drawjob_rotate_around_point(there_and_back, -M_PI / 2, center);
+        snprintf(name, sizeof(name), "%s round trip", names[s]);
+        failures += compare_jobs(name, &there_and_back, source);
+    }
+
+    // Clipping the area of a transformed job only restricts where it draws
+    DrawJob rotated = drawjob_rotate_around_point(sources[0], 0.5, center);
+    DrawJob clipped = rotated;
+    clipped.area = (Recti){{35, 35}, {45, 45}};
+    failures += compare_reference("clipped", &clipped, &sources[0]);
+
+    DrawJob flat = drawjob_transform(sources[0], (TransformationMatrix){{{1, 2}, {2, 4}}});
+    if (!recti_is_empty(flat.area))
+    {
+        printf("FAIL singular: expected an empty area\n");
+        failures++;
+    }
+
+    text_cache_free(&cache);
+    font_free(&font);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
@@ -0,0 +1,114 @@
+#include "../../include/renderer.h"
+
+/*
+ * Headless check of the traversal orders of draw and draw_bounded: every order, schedule and block size draws every
+ * pixel of the clamped area exactly once and nothing outside it, on OpenMP and on a worker pool.
+ */
+
+#define FB_WIDTH 211
+#define FB_HEIGHT 157
+#define SENTINEL 0xDEADBEEFu
+
+static int visits[FB_WIDTH * FB_HEIGHT];
+
+static uint32_t pixel_hash(int x, int y, void *userdata)
+{
+    (void)userdata;
+    __atomic_add_fetch(&visits[y * FB_WIDTH + x], 1, __ATOMIC_RELAXED);
+    return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+}
+
+static int check_area(Framebuffer *fb, Recti area, const char *name)
+{
+    Recti clamped = recti_clamp(area, FB_WIDTH, FB_HEIGHT);
+    for (int y = 0; y < FB_HEIGHT; y++)
+        for (int x = 0; x < FB_WIDTH; x++)
+        {
+            int inside = x >= clamped.top_left.x && x < clamped.bottom_right.x && y >= clamped.top_left.y &&
+                         y < clamped.bottom_right.y;
+            uint32_t expected = inside ? pixel_hash(x, y, NULL) : SENTINEL;
+            if (fb->pixels[y * FB_WIDTH + x] != expected || visits[y * FB_WIDTH + x] != 2 * inside)
+            {
+                printf("FAIL %s: pixel (%d,%d) is %08x after %d visits\n", name, x, y, fb->pixels[y * FB_WIDTH + x],
+                       visits[y * FB_WIDTH + x]);
+                return 1;
+            }
+        }
+    return 0;
+}
+
+int main(void)
+{
+    const char *order_names[] = {"rows", "tiles", "morton"};
+    const char *schedule_names[] = {"dynamic", "guided", "static"};
+    const int block_sizes[] = {0, 1, 5, 32, 300};
+    WorkerPool pool;
+    WorkerPoolConfig config = {.thread_count = 4};
+    Framebuffer fb;
+    int failures = 0;
+
+    if (framebuffer_init(&fb, FB_WIDTH, FB_HEIGHT) || worker_pool_init(&pool, &config))
+    {
+        printf("FAILED: initialization\n");
+        return 1;
+    }
+
+    /* Z-order of a 4x4 grid of blocks */
+    TraversalPlan plan = {0};
+    const int z_order[16] = {0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15};
+    traversal_plan_build(&plan, (Traversal){TRAVERSAL_MORTON, TRAVERSAL_DYNAMIC, 8}, (Recti){{0, 0}, {32, 30}}, 1);
+    for (int b = 0; b < 16; b++)
+        if (plan.block_count != 16 || plan.morton[b] != z_order[b])
+        {
+            printf("FAIL morton: block %d is %d, expected %d\n", b, plan.morton[b], z_order[b]);
+            failures++;
+            break;
+        }
+    traversal_plan_free(&plan);
+
+    /* Areas covering the framebuffer, inside it, and sticking out of it */
+    const Recti areas[] = {{{0, 0}, {FB_WIDTH, FB_HEIGHT}},
+                           {{17, 3}, {150, 140}},
+                           {{-40, -9}, {90, 61}},
+                           {{100, 100}, {400, 300}},
+                           {{5, 5}, {6, 150}}};
+
+    srand(5);
+    for (int use_pool = 0; use_pool < 2 && !failures; use_pool++)
+    {
+        fb.pool = use_pool ? &pool : NULL;
+        for (int order = TRAVERSAL_ROWS; order <= TRAVERSAL_MORTON; order++)
+            for (int schedule = TRAVERSAL_DYNAMIC; schedule <= TRAVERSAL_STATIC; schedule++)
+                for (int s = 0; s < (int)(sizeof(block_sizes) / sizeof(block_sizes[0])); s++)
+                    for (int a = 0; a < (int)(sizeof(areas) / sizeof(areas[0])); a++)
+                    {
+                        char name[96];
+                        snprintf(name, sizeof(name), "%s %s, blocks of %d, area %d%s", order_names[order],
+                                 schedule_names[schedule], block_sizes[s], a, use_pool ? " on a worker pool" : "");
+
+                        fb.traversal = (Traversal){(TraversalOrder)order, (TraversalSchedule)schedule, block_sizes[s]};
+                        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++)
+                            fb.pixels[i] = SENTINEL;
+                        memset(visits, 0, sizeof(visits));
+
+                        DrawJob job = {.area = areas[a], .callback = pixel_hash};
+                        if (a == 0)
+                            draw(&fb, job);
+                        else
+                            draw_bounded(&fb, job);
+
+                        /* check_area calls the callback once more for every pixel inside */
+                        if (check_area(&fb, areas[a], name))
+                        {
+                            failures++;
+                            break;
+                        }
+                    }
+    }
+
+    fb.pool = NULL;
+    worker_pool_shutdown(&pool);
+    framebuffer_destroy(&fb);
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures != 0;
+}
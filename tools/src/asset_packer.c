@@ -0,0 +1,105 @@
+#include "../../include/renderer.h"
+
+/*
+ * Packs BMP files into an asset pack. Every image is converted to premultiplied ARGB and named after its file,
+ * without directories and extension.
+ *
+ * Usage: asset_packer output.pak image.bmp...
+ */
+
+// File name without directories and extension
+static int asset_name(const char *path, char *name)
+{
+    const char *start = path;
+    for (const char *p = path; *p; p++)
+        if (*p == '/' || *p == '\\')
+            start = p + 1;
+
+    const char *dot = strrchr(start, '.');
+    size_t length = dot ? (size_t)(dot - start) : strlen(start);
+    if (length == 0 || length >= ASSET_PACK_NAME_SIZE)
+        return 1;
+
+    memcpy(name, start, length);
+    name[length] = 0;
+    return 0;
+}
+
+static int load_bmp(const char *path, Bitmap *bitmap)
+{
+    SDL_Surface *loaded = SDL_LoadBMP(path);
+    SDL_Surface *surface = loaded ? SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0) : NULL;
+    if (loaded)
+        SDL_FreeSurface(loaded);
+    if (!surface)
+        return 1;
+
+    *bitmap = (Bitmap){surface->w, surface->h, malloc((size_t)surface->w * surface->h * sizeof(uint32_t))};
+    if (bitmap->bitmap_argb && SDL_LockSurface(surface) == 0)
+    {
+        for (int y = 0; y < surface->h; y++)
+        {
+            const uint32_t *row = (const uint32_t *)((const uint8_t *)surface->pixels + (size_t)y * surface->pitch);
+            for (int x = 0; x < surface->w; x++)
+                bitmap->bitmap_argb[(size_t)y * surface->w + x] = color_premultiply(row[x]);
+        }
+        SDL_UnlockSurface(surface);
+    }
+    else
+    {
+        free(bitmap->bitmap_argb);
+        bitmap->bitmap_argb = NULL;
+    }
+    SDL_FreeSurface(surface);
+    return bitmap->bitmap_argb == NULL;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s output.pak image.bmp...\n", argv[0]);
+        return 1;
+    }
+
+    int count = argc - 2;
+    Bitmap *bitmaps = calloc(count, sizeof(Bitmap));
+    char (*names)[ASSET_PACK_NAME_SIZE] = calloc(count, ASSET_PACK_NAME_SIZE);
+    const char **name_list = calloc(count, sizeof(char *));
+    if (!bitmaps || !names || !name_list)
+        return 1;
+
+    int failed = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < count && !failed; i++)
+    {
+        const char *path = argv[i + 2];
+        if (asset_name(path, names[i]) != 0)
+        {
+            fprintf(stderr, "%s: name must have 1 to %d characters\n", path, ASSET_PACK_NAME_SIZE - 1);
+            failed = 1;
+        }
+        else if (load_bmp(path, &bitmaps[i]) != 0)
+        {
+            fprintf(stderr, "%s: %s\n", path, SDL_GetError());
+            failed = 1;
+        }
+        name_list[i] = names[i];
+        bytes += (size_t)bitmaps[i].width * bitmaps[i].height * sizeof(uint32_t);
+    }
+
+    if (!failed && asset_pack_write(argv[1], name_list, bitmaps, count) != 0)
+    {
+        fprintf(stderr, "%s: could not be written, are the names all different?\n", argv[1]);
+        failed = 1;
+    }
+    if (!failed)
+        printf("packed %d images, %zu bytes of pixels, into %s\n", count, bytes, argv[1]);
+
+    for (int i = 0; i < count; i++)
+        free(bitmaps[i].bitmap_argb);
+    free(bitmaps);
+    free(names);
+    free(name_list);
+    return failed;
+}